@@ -1732,8 +1732,8 @@ GObject* AbaqusImport::build_part(AbaqusModel::PART* pg)
 						Q[1][0] = e1.y; Q[1][1] = e2.y; Q[1][2] = e3.y;
 						Q[2][0] = e1.z; Q[2][1] = e2.z; Q[2][2] = e3.z;
 
-						el.m_Qactive = true;
-						el.m_Q = Q;
+						el.SetLocalAxesActive(true);
+						el.SetLocalAxes(Q);
 					}
 				}
 			}
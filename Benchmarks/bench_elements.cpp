@@ -0,0 +1,138 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+
+
+// bench_elements.cpp: measures the memory that a mesh's elements use, for blocks
+// of tetrahedral elements.
+//
+// usage: bench_elements [M1 M2 ...]
+//   Mi : approximate size of a mesh, in millions of elements (default 1 5 10).
+//        Each mesh is an N x N x N block of hexahedra that are split into six tets.
+//////////////////////////////////////////////////////////////////////
+
+#include <MeshLib/FEMesh.h>
+#include <MeshLib/FEElementLibrary.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+static double elapsed(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//-----------------------------------------------------------------------------
+static void BuildTetBlock(FEMesh& mesh, int N)
+{
+	// the six tets of a hexahedron that share its diagonal 0-6
+	const int tet[6][4] = {
+		{ 0, 1, 2, 6 }, { 0, 2, 3, 6 }, { 0, 3, 7, 6 },
+		{ 0, 7, 4, 6 }, { 0, 4, 5, 6 }, { 0, 5, 1, 6 } };
+
+	int n1 = N + 1;
+	mesh.Create(n1*n1*n1, 6*N*N*N);
+
+	for (int k = 0; k < n1; ++k)
+		for (int j = 0; j < n1; ++j)
+			for (int i = 0; i < n1; ++i)
+			{
+				FENode& node = mesh.Node((k*n1 + j)*n1 + i);
+				node.r = vec3d(i, j, k);
+			}
+
+	int ne = 0;
+	for (int k = 0; k < N; ++k)
+		for (int j = 0; j < N; ++j)
+			for (int i = 0; i < N; ++i)
+			{
+				int m[8];
+				m[0] = (k*n1 + j)*n1 + i; m[1] = m[0] + 1; m[2] = m[0] + n1 + 1; m[3] = m[0] + n1;
+				m[4] = m[0] + n1*n1;      m[5] = m[4] + 1; m[6] = m[4] + n1 + 1; m[7] = m[4] + n1;
+
+				for (int l = 0; l < 6; ++l)
+				{
+					FEElement& el = mesh.Element(ne++);
+					el.SetType(FE_TET4);
+					el.m_gid = 0;
+					for (int n = 0; n < 4; ++n) el.m_node[n] = m[tet[l][n]];
+				}
+			}
+}
+
+//-----------------------------------------------------------------------------
+static double perElement(const FEMesh& mesh)
+{
+	return (double)mesh.ElementMemorySize() / mesh.Elements();
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	std::vector<double> sizes;
+	for (int i = 1; i < argc; ++i) sizes.push_back(atof(argv[i]));
+	if (sizes.empty()) sizes = { 1, 5, 10 };
+
+	FEElementLibrary::InitLibrary();
+
+	// the per-element columns are in bytes, the total is in MB
+	printf("sizeof(FEElement) = %d bytes\n", (int)sizeof(FEElement));
+	printf("%10s %10s %10s %10s %10s %10s %10s\n", "elements", "created", "compacted", "fibers", "total", "build", "compact");
+	for (double size : sizes)
+	{
+		int N = (int)(std::cbrt(size*1.0e6/6.0) + 0.5);
+		if (N < 1)
+		{
+			fprintf(stderr, "invalid mesh size: %g\n", size);
+			return 1;
+		}
+
+		FEMesh mesh;
+		auto t0 = std::chrono::steady_clock::now();
+		BuildTetBlock(mesh, N);
+		double tbuild = elapsed(t0);
+		double created = perElement(mesh);
+
+		// this is what RebuildMesh does before it updates the topology
+		t0 = std::chrono::steady_clock::now();
+		mesh.CompactElements();
+		double tcompact = elapsed(t0);
+		double compacted = perElement(mesh);
+		double total = mesh.ElementMemorySize() / 1048576.0;
+
+		// the fibers are stored in a side table that is only allocated when set
+		for (int i = 0; i < mesh.Elements(); ++i) mesh.Element(i).SetFiber(vec3d(1, 0, 0));
+		double fibers = perElement(mesh);
+
+		printf("%10d %10.1f %10.1f %10.1f %10.1f %10.3f %10.3f\n", mesh.Elements(), created, compacted, fibers, total, tbuild, tcompact);
+		fflush(stdout);
+	}
+
+	return 0;
+}
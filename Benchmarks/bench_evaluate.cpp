@@ -0,0 +1,160 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+
+// bench_evaluate.cpp: times the evaluation of the plot fields (FEPostModel::Evaluate)
+// for a synthetic model made of an N x N x N block of hexahedral elements.
+//
+// usage: bench_evaluate [N] [threads] [repeats]
+//   N       : number of elements along each side of the block (default 100, i.e. 1M elements)
+//   threads : number of threads used for the evaluation (0 = OpenMP default)
+//   repeats : each field is evaluated this many times and the average is reported (default 3)
+//////////////////////////////////////////////////////////////////////
+
+#include <PostLib/FEPostModel.h>
+#include <PostLib/FEPostMesh.h>
+#include <PostLib/FEDataManager.h>
+#include <PostLib/FEMeshData_T.h>
+#include <PostLib/FEMaterial.h>
+#include <PostLib/constants.h>
+#include <MeshLib/FEElementLibrary.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Post;
+
+//-----------------------------------------------------------------------------
+static double elapsed(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//-----------------------------------------------------------------------------
+// Build a model with a single state. The data fields are the same ones the plot
+// file reader creates for a model with a displacement and a pressure field.
+static bool BuildModel(FEPostModel& fem, int N)
+{
+	int n1 = N + 1;
+	int nodes = n1*n1*n1;
+	int elems = N*N*N;
+
+	FEMaterial mat;
+	fem.AddMaterial(mat);
+
+	FEPostMesh* pm = new FEPostMesh;
+	pm->Create(nodes, elems);
+
+	for (int k = 0; k < n1; ++k)
+		for (int j = 0; j < n1; ++j)
+			for (int i = 0; i < n1; ++i)
+			{
+				FENode& node = pm->Node((k*n1 + j)*n1 + i);
+				node.r = vec3d(i, j, k);
+			}
+
+	int ne = 0;
+	for (int k = 0; k < N; ++k)
+		for (int j = 0; j < N; ++j)
+			for (int i = 0; i < N; ++i)
+			{
+				FEElement& el = static_cast<FEElement&>(pm->ElementRef(ne++));
+				el.SetType(FE_HEX8);
+				el.m_MatID = 0;
+
+				int* n = el.m_node;
+				n[0] = (k*n1 + j)*n1 + i; n[1] = n[0] + 1; n[2] = n[0] + n1 + 1; n[3] = n[0] + n1;
+				n[4] = n[0] + n1*n1;      n[5] = n[4] + 1; n[6] = n[4] + n1 + 1; n[7] = n[4] + n1;
+			}
+
+	pm->BuildMesh();
+	fem.AddMesh(pm);
+	fem.UpdateBoundingBox();
+
+	FEDataManager* pdm = fem.GetDataManager();
+	pdm->AddDataField(new FEDataField_T<Post::FENodeData<vec3f> >("displacement"));
+	pdm->AddDataField(new FEDataField_T<Post::FEElementData<float, DATA_ITEM> >("pressure"));
+	pdm->AddDataField(new FEStrainDataField("Lagrange strain", FEStrainDataField::LAGRANGE));
+	pdm->AddDataField(new FEDataField_T<FENodePosition>("position"));
+	pdm->AddDataField(new FEDataField_T<FENodeInitPos >("initial position"));
+	fem.SetDisplacementField(BUILD_FIELD(CLASS_NODE, 0, 0));
+
+	FEState* ps = new FEState(0.f, &fem, pm);
+	fem.AddState(ps);
+
+	// a smooth deformation, so that the strains are not trivial
+	Post::FENodeData<vec3f>& u = dynamic_cast<Post::FENodeData<vec3f>&>(ps->m_Data[0]);
+	for (int i = 0; i < nodes; ++i)
+	{
+		vec3d r = pm->Node(i).r;
+		u[i] = vec3f(0.01f*(float)(r.x*r.y), 0.02f*(float)r.z, -0.01f*(float)r.x);
+	}
+
+	Post::FEElementData<float, DATA_ITEM>& p = dynamic_cast<Post::FEElementData<float, DATA_ITEM>&>(ps->m_Data[1]);
+	for (int i = 0; i < elems; ++i) p.add(i, (float)(i % 1000));
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	int N       = (argc > 1 ? atoi(argv[1]) : 100);
+	int threads = (argc > 2 ? atoi(argv[2]) :   0);
+	int repeats = (argc > 3 ? atoi(argv[3]) :   3);
+	if ((N <= 0) || (repeats <= 0))
+	{
+		fprintf(stderr, "usage: bench_evaluate [N] [threads] [repeats]\n");
+		return 1;
+	}
+
+	FEElementLibrary::InitLibrary();
+	FEPostModel::SetEvalThreads(threads);
+
+	auto t0 = std::chrono::steady_clock::now();
+	FEPostModel fem;
+	BuildModel(fem, N);
+	FEPostMesh& mesh = *fem.GetFEMesh(0);
+	printf("model: %d elements, %d nodes (built in %.3f s)\n", mesh.Elements(), mesh.Nodes(), elapsed(t0));
+	printf("threads: %d\n\n", threads);
+
+	FEDataManager& dm = *fem.GetDataManager();
+	printf("%-24s %12s\n", "field", "time (s)");
+	for (int i = 0; i < dm.DataFields(); ++i)
+	{
+		FEDataField* pd = *dm.DataField(i);
+		int nfield = pd->GetFieldID();
+
+		// the first evaluation also allocates the state's value buffers, so don't time it
+		fem.Evaluate(nfield, 0, true);
+
+		t0 = std::chrono::steady_clock::now();
+		for (int n = 0; n < repeats; ++n) fem.Evaluate(nfield, 0, true);
+		printf("%-24s %12.3f\n", pd->GetName().c_str(), elapsed(t0) / repeats);
+	}
+
+	return 0;
+}
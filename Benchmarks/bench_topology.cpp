@@ -0,0 +1,139 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+
+// bench_topology.cpp: times the mesh topology updates (element, face and edge
+// neighbors and the face-element table) for blocks of hexahedral elements.
+//
+// usage: bench_topology [M1 M2 ...]
+//   Mi : approximate size of a mesh, in millions of elements (default 1 5 10 25 50).
+//        Each mesh is an N x N x N block, where N is the cube root of the size.
+//////////////////////////////////////////////////////////////////////
+
+#include <MeshLib/FEMesh.h>
+#include <MeshLib/FEElementLibrary.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// This gives access to the (protected) update functions that RebuildMesh calls.
+class FETopologyMesh : public FEMesh
+{
+public:
+	using FEMesh::UpdateElementNeighbors;
+	using FEMesh::UpdateFaceElementTable;
+	using FEMesh::UpdateFaceNeighbors;
+	using FEMesh::UpdateEdgeNeighbors;
+};
+
+//-----------------------------------------------------------------------------
+static double elapsed(std::chrono::steady_clock::time_point t0)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+//-----------------------------------------------------------------------------
+static void BuildHexBlock(FETopologyMesh& mesh, int N)
+{
+	int n1 = N + 1;
+	mesh.Create(n1*n1*n1, N*N*N);
+
+	for (int k = 0; k < n1; ++k)
+		for (int j = 0; j < n1; ++j)
+			for (int i = 0; i < n1; ++i)
+			{
+				FENode& node = mesh.Node((k*n1 + j)*n1 + i);
+				node.r = vec3d(i, j, k);
+			}
+
+	int ne = 0;
+	for (int k = 0; k < N; ++k)
+		for (int j = 0; j < N; ++j)
+			for (int i = 0; i < N; ++i)
+			{
+				FEElement& el = mesh.Element(ne++);
+				el.SetType(FE_HEX8);
+				el.m_gid = 0;
+
+				int* n = el.m_node;
+				n[0] = (k*n1 + j)*n1 + i; n[1] = n[0] + 1; n[2] = n[0] + n1 + 1; n[3] = n[0] + n1;
+				n[4] = n[0] + n1*n1;      n[5] = n[4] + 1; n[6] = n[4] + n1 + 1; n[7] = n[4] + n1;
+			}
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	std::vector<double> sizes;
+	for (int i = 1; i < argc; ++i) sizes.push_back(atof(argv[i]));
+	if (sizes.empty()) sizes = { 1, 5, 10, 25, 50 };
+
+	FEElementLibrary::InitLibrary();
+
+	printf("%10s %10s %10s %10s %10s %10s %10s\n", "elements", "faces", "rebuild", "elem nbrs", "face-elem", "face nbrs", "edge nbrs");
+	for (double size : sizes)
+	{
+		int N = (int)(std::cbrt(size*1.0e6) + 0.5);
+		if (N < 1)
+		{
+			fprintf(stderr, "invalid mesh size: %g\n", size);
+			return 1;
+		}
+
+		FETopologyMesh mesh;
+		BuildHexBlock(mesh, N);
+
+		// the full rebuild, as done after importing a mesh
+		auto t0 = std::chrono::steady_clock::now();
+		mesh.RebuildMesh();
+		double trebuild = elapsed(t0);
+
+		// the individual updates, on the mesh that now has its faces and edges
+		t0 = std::chrono::steady_clock::now();
+		mesh.UpdateElementNeighbors();
+		double telem = elapsed(t0);
+
+		t0 = std::chrono::steady_clock::now();
+		mesh.UpdateFaceElementTable();
+		double tfaceElem = elapsed(t0);
+
+		t0 = std::chrono::steady_clock::now();
+		mesh.UpdateFaceNeighbors();
+		double tface = elapsed(t0);
+
+		t0 = std::chrono::steady_clock::now();
+		mesh.UpdateEdgeNeighbors();
+		double tedge = elapsed(t0);
+
+		printf("%10d %10d %10.3f %10.3f %10.3f %10.3f %10.3f\n", mesh.Elements(), mesh.Faces(), trebuild, telem, tfaceElem, tface, tedge);
+		fflush(stdout);
+	}
+
+	return 0;
+}
@@ -1377,7 +1377,7 @@ void FEBioExport2::WriteGeometrySection()
 		for (int j=0; j<pm->Elements(); ++j)
 		{
 			FEElement_& e = pm->ElementRef(j);
-			if (e.m_Qactive) {
+			if (e.LocalAxesActive()) {
 				bdata = true;
 				break;
 			}
@@ -1667,7 +1667,7 @@ void FEBioExport2::WriteGeometryElementData()
 			if (pmat) ptiso = dynamic_cast<FETransverselyIsotropic*>(pmat->GetMaterialProperties());
 
 			elem.set_attribute(nid, e.m_nid);
-			if (e.IsShell() || e.m_Qactive || (ptiso && (ptiso->GetFiberMaterial()->m_naopt == FE_FIBER_USER)) || (ND > 0))
+			if (e.IsShell() || e.LocalAxesActive() || (ptiso && (ptiso->GetFiberMaterial()->m_naopt == FE_FIBER_USER)) || (ND > 0))
 			{
 				m_xml.add_branch(elem, false);
 				if (e.IsShell()) m_xml.add_leaf("thickness", e.m_h, e.Nodes());
@@ -1675,13 +1675,13 @@ void FEBioExport2::WriteGeometryElementData()
 				// export fiber direction, otherwise export local material orientation
 				if (ptiso && (ptiso->GetFiberMaterial()->m_naopt == FE_FIBER_USER))
 				{
-					vec3d a = T.LocalToGlobalNormal(e.m_fiber);
+					vec3d a = T.LocalToGlobalNormal(e.Fiber());
 					m_xml.add_leaf("fiber", a);
 				}
-				else if (e.m_Qactive) 
+				else if (e.LocalAxesActive()) 
 				{
-					// e.m_Q is in local coordinates, so transform it to global coordinates
-					mat3d& Q = e.m_Q;
+					// e.LocalAxes() is in local coordinates, so transform it to global coordinates
+					mat3d Q = e.LocalAxes();
 					vec3d a(Q[0][0], Q[1][0], Q[2][0]);
 					vec3d d(Q[0][1], Q[1][1], Q[2][1]);
 					a = T.LocalToGlobalNormal(a);
@@ -384,7 +384,7 @@ bool FEBioExport25::PrepareExport(FEProject& prj)
 		for (int j=0; j<pm->Elements(); ++j)
 		{
 			FEElement_& e = pm->ElementRef(j);
-			if (e.m_Qactive) {
+			if (e.LocalAxesActive()) {
 				m_bdata = true;
 				break;
 			}
@@ -3043,7 +3043,7 @@ void FEBioExport25::WriteMeshDataMaterialFibers()
 				for (int j=0; j<NE; ++j)
 				{
 					FEElement_& e = pm->ElementRef(elSet.elem[j]);
-					vec3d a = T.LocalToGlobalNormal(e.m_fiber);
+					vec3d a = T.LocalToGlobalNormal(e.Fiber());
 					el.set_attribute(nid, j+1);
 					el.value(a);
 					m_xml.add_leaf(el, false);
@@ -3072,7 +3072,7 @@ void FEBioExport25::WriteMeshDataMaterialAxes()
 		for (int j=0; j<NE; ++j)
 		{
 			FEElement_& el = pm->ElementRef(elSet.elem[j]);
-			if (el.m_Qactive) { bwrite = true; break; }
+			if (el.LocalAxesActive()) { bwrite = true; break; }
 		}
 
 		// okay, let's get to work
@@ -3090,10 +3090,10 @@ void FEBioExport25::WriteMeshDataMaterialAxes()
 				for (int j=0; j<NE; ++j)
 				{
 					FEElement_& e = pm->ElementRef(elSet.elem[j]);
-					if (e.m_Qactive)
+					if (e.LocalAxesActive())
 					{
-						// e.m_Q is in local coordinates, so transform it to global coordinates
-						mat3d& Q = e.m_Q;
+						// e.LocalAxes() is in local coordinates, so transform it to global coordinates
+						mat3d Q = e.LocalAxes();
 						vec3d a(Q[0][0], Q[1][0], Q[2][0]);
 						vec3d d(Q[0][1], Q[1][1], Q[2][1]);
 						a = T.LocalToGlobalNormal(a);
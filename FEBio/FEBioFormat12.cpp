@@ -233,13 +233,15 @@ bool FEBioFormat12::ParseGeometrySection(XMLTag& tag)
 							c.Normalize();
 
 							// assign to element
-							mat3d& m = el.m_Q;
+							mat3d m;
 							m.zero();
 							m[0][0] = a.x; m[0][1] = b.x; m[0][2] = c.x;
 							m[1][0] = a.y; m[1][1] = b.y; m[1][2] = c.y;
 							m[2][0] = a.z; m[2][1] = b.z; m[2][2] = c.z;
 
-							el.m_fiber = a;
+							el.SetLocalAxes(m);
+
+							el.SetFiber(a);
 						}
 						else if (tag == "mat_axis")
 						{
@@ -266,13 +268,14 @@ bool FEBioFormat12::ParseGeometrySection(XMLTag& tag)
 							c.Normalize();
 
 							// assign to element
-							mat3d& m = el.m_Q;
+							mat3d m;
 							m.zero();
 							m[0][0] = a.x; m[0][1] = b.x; m[0][2] = c.x;
 							m[1][0] = a.y; m[1][1] = b.y; m[1][2] = c.y;
 							m[2][0] = a.z; m[2][1] = b.z; m[2][2] = c.z;
 
-							el.m_Qactive = true;
+							el.SetLocalAxes(m);
+							el.SetLocalAxesActive(true);
 						}
 						else if (tag == "thickness")
 						{
@@ -284,7 +287,9 @@ bool FEBioFormat12::ParseGeometrySection(XMLTag& tag)
 						{
 							FEElement& el = pm->Element(id);
 							if (!el.IsBeam()) return false;
-							tag.value(el.m_a0);
+							double a0 = 0.0;
+							tag.value(a0);
+							el.SetTrussArea(a0);
 						}
 						else ParseUnknownTag(tag);
 
@@ -309,13 +309,15 @@ void FEBioFormat2::ParseGeometryElementData(FEBioModel::Part& part, XMLTag& tag)
 					c.Normalize();
 
 					// assign to element
-					mat3d& m = el.m_Q;
+					mat3d m;
 					m.zero();
 					m[0][0] = a.x; m[0][1] = b.x; m[0][2] = c.x;
 					m[1][0] = a.y; m[1][1] = b.y; m[1][2] = c.y;
 					m[2][0] = a.z; m[2][1] = b.z; m[2][2] = c.z;
 
-					el.m_fiber = a;
+					el.SetLocalAxes(m);
+
+					el.SetFiber(a);
 				}
 				else if (tag == "mat_axis")
 				{
@@ -340,13 +342,14 @@ void FEBioFormat2::ParseGeometryElementData(FEBioModel::Part& part, XMLTag& tag)
 					c.Normalize();
 
 					// assign to element
-					mat3d& m = el.m_Q;
+					mat3d m;
 					m.zero();
 					m[0][0] = a.x; m[0][1] = b.x; m[0][2] = c.x;
 					m[1][0] = a.y; m[1][1] = b.y; m[1][2] = c.y;
 					m[2][0] = a.z; m[2][1] = b.z; m[2][2] = c.z;
 
-					el.m_Qactive = true;
+					el.SetLocalAxes(m);
+					el.SetLocalAxesActive(true);
 				}
 				else if (tag == "thickness")
 				{
@@ -356,7 +359,9 @@ void FEBioFormat2::ParseGeometryElementData(FEBioModel::Part& part, XMLTag& tag)
 				else if (tag == "area")
 				{
 					if (!el.IsBeam()) return throw XMLReader::InvalidTag(tag);;
-					tag.value(el.m_a0);
+					double a0 = 0.0;
+					tag.value(a0);
+					el.SetTrussArea(a0);
 				}
 				else if (tag.isleaf())
 				{
@@ -684,9 +684,9 @@ bool FEBioFormat25::ParseMeshDataSection(XMLTag& tag)
 			{
 				e0.m_h[k] = e1.m_h[k];
 			}
-            e0.m_Q = e1.m_Q;
-            e0.m_Qactive = e1.m_Qactive;
-            e0.m_fiber = e1.m_fiber;
+            e0.SetLocalAxes(e1.LocalAxes());
+            e0.SetLocalAxesActive(e1.LocalAxesActive());
+            e0.SetFiber(e1.Fiber());
 		}
 	}
 
@@ -792,10 +792,10 @@ bool FEBioFormat25::ParseElementData(XMLTag& tag)
 					// make sure they are unit vectors
 					b.Normalize();
 					c.Normalize();
-					el.m_Q = mat3d(a.x, b.x, c.x,
+					el.SetLocalAxes(mat3d(a.x, b.x, c.x,
 						a.y, b.y, c.y,
-						a.z, b.z, c.z);
-					el.m_fiber = a;
+						a.z, b.z, c.z));
+					el.SetFiber(a);
 				}
 				++tag;
 			} while (!tag.isend());
@@ -832,10 +832,10 @@ bool FEBioFormat25::ParseElementData(XMLTag& tag)
 					a.Normalize();
 					c = a ^ d; c.Normalize();
 					b = c ^ a; b.Normalize();
-					el.m_Q = mat3d(a.x, b.x, c.x,
+					el.SetLocalAxes(mat3d(a.x, b.x, c.x,
 						a.y, b.y, c.y,
-						a.z, b.z, c.z);
-					el.m_Qactive = true;
+						a.z, b.z, c.z));
+					el.SetLocalAxesActive(true);
 				}
 				++tag;
 			} while (!tag.isend());
@@ -98,3 +98,17 @@ void CCmdGroup::SetViewState(VIEW_STATE state)
 	CCommand::SetViewState(state);
 	for (int i = 0; i < m_Cmd.size(); i++) m_Cmd[i]->SetViewState(state);
 }
+
+size_t CCmdGroup::GetMemorySize()
+{
+	size_t size = 0;
+	for (int i = 0; i < (int)m_Cmd.size(); i++) size += m_Cmd[i]->GetMemorySize();
+	return size;
+}
+
+bool CCmdGroup::Spill()
+{
+	bool b = false;
+	for (int i = 0; i < (int)m_Cmd.size(); i++) b |= m_Cmd[i]->Spill();
+	return b;
+}
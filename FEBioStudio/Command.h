@@ -69,6 +69,12 @@ public:
 	virtual void SetViewState(VIEW_STATE state);
 	VIEW_STATE GetViewState();
 
+	// the memory (in bytes) that the command holds on to for undo/redo
+	virtual size_t GetMemorySize() { return 0; }
+
+	// move the undo/redo data to disk. Returns false if nothing was moved.
+	virtual bool Spill() { return false; }
+
 protected:
 	// doc/view state variables
 	VIEW_STATE	m_state;
@@ -101,6 +107,10 @@ public:
 
 	void SetViewState(VIEW_STATE state) override;
 
+	size_t GetMemorySize() override;
+
+	bool Spill() override;
+
 protected:
 	CCmdPtrArray	m_Cmd;	// array of pointer to commands
 };
@@ -31,6 +31,8 @@ SOFTWARE.*/
 #include <GeomLib/GObject.h>
 
 std::string CBasicCmdManager::m_err;
+size_t CBasicCmdManager::m_memBudget = (size_t)1024*1024*1024;	// 1 GB
+bool CBasicCmdManager::m_spillToDisk = false;
 
 CBasicCmdManager::CBasicCmdManager()
 {
@@ -44,11 +46,13 @@ CBasicCmdManager::~CBasicCmdManager()
 void CBasicCmdManager::AddCommand(CCommand* pcmd)
 {
 	// push the command
-	m_Undo.push(pcmd);
+	m_Undo.push_back(pcmd);
 
 	// clear the redo stack
 	int N = (int)m_Redo.size();
-	for (int i = 0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	for (int i = 0; i<N; i++) { delete m_Redo.back(); m_Redo.pop_back(); }
+
+	CheckMemoryBudget();
 }
 
 bool CBasicCmdManager::DoCommand(CCommand* pcmd)
@@ -78,11 +82,13 @@ bool CBasicCmdManager::DoCommand(CCommand* pcmd)
 	}
 
 	// add it to the undo stack
-	m_Undo.push(pcmd);
+	m_Undo.push_back(pcmd);
 
 	// clear the redo stack
 	int N = (int)m_Redo.size();
-	for (int i = 0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	for (int i = 0; i<N; i++) { delete m_Redo.back(); m_Redo.pop_back(); }
+
+	CheckMemoryBudget();
 
 	return true;
 }
@@ -92,13 +98,13 @@ void CBasicCmdManager::UndoCommand()
 	if (m_Undo.empty() == false)
 	{
 		// pop the command from the undo stack
-		CCommand* pcmd = m_Undo.top(); m_Undo.pop();
+		CCommand* pcmd = m_Undo.back(); m_Undo.pop_back();
 
 		// unexecute it
 		pcmd->UnExecute();
 
 		// push it on the redo stack
-		m_Redo.push(pcmd);
+		m_Redo.push_back(pcmd);
 	}
 }
 
@@ -107,13 +113,13 @@ void CBasicCmdManager::RedoCommand()
 	if (m_Redo.empty() == false)
 	{
 		// pop the command from the redo stack
-		CCommand* pcmd = m_Redo.top(); m_Redo.pop();
+		CCommand* pcmd = m_Redo.back(); m_Redo.pop_back();
 
 		// execute it
 		pcmd->Execute();
 
 		// push it on the undo stack
-		m_Undo.push(pcmd);
+		m_Undo.push_back(pcmd);
 	}
 }
 
@@ -121,15 +127,63 @@ void CBasicCmdManager::Clear()
 {
 	// clear undo stack
 	int N = (int)m_Undo.size();
-	for (int i = 0; i<N; i++) { delete m_Undo.top(); m_Undo.pop(); }
+	for (int i = 0; i<N; i++) { delete m_Undo.back(); m_Undo.pop_back(); }
 
 	// clear redo stack
 	N = (int)m_Redo.size();
-	for (int i = 0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	for (int i = 0; i<N; i++) { delete m_Redo.back(); m_Redo.pop_back(); }
+}
+
+void CBasicCmdManager::SetMemoryBudget(size_t maxBytes) { m_memBudget = maxBytes; }
+size_t CBasicCmdManager::GetMemoryBudget() { return m_memBudget; }
+
+void CBasicCmdManager::SetSpillToDisk(bool b) { m_spillToDisk = b; }
+bool CBasicCmdManager::GetSpillToDisk() { return m_spillToDisk; }
+
+size_t CBasicCmdManager::GetMemorySize()
+{
+	size_t total = 0;
+	for (size_t i = 0; i < m_Undo.size(); ++i) total += m_Undo[i]->GetMemorySize();
+	for (size_t i = 0; i < m_Redo.size(); ++i) total += m_Redo[i]->GetMemorySize();
+	return total;
 }
 
-const char* CBasicCmdManager::GetUndoCmdName() { return (m_Undo.size() ? m_Undo.top()->GetName() : 0); }
-const char* CBasicCmdManager::GetRedoCmdName() { return (m_Redo.size() ? m_Redo.top()->GetName() : 0); }
+// Keeps the memory used by the undo and redo stacks under the budget. If allowed,
+// the data of the oldest commands is moved to disk first. After that, the oldest
+// commands are removed from the undo stack. The last command is always kept.
+void CBasicCmdManager::CheckMemoryBudget()
+{
+	if (m_memBudget == 0) return;
+
+	size_t total = GetMemorySize();
+	if (total <= m_memBudget) return;
+
+	if (m_spillToDisk)
+	{
+		// the front of each stack holds the commands that are furthest away
+		for (size_t i = 0; (i < m_Undo.size()) && (total > m_memBudget); ++i)
+		{
+			size_t oldSize = m_Undo[i]->GetMemorySize();
+			if (m_Undo[i]->Spill()) total -= oldSize - m_Undo[i]->GetMemorySize();
+		}
+
+		for (size_t i = 0; (i < m_Redo.size()) && (total > m_memBudget); ++i)
+		{
+			size_t oldSize = m_Redo[i]->GetMemorySize();
+			if (m_Redo[i]->Spill()) total -= oldSize - m_Redo[i]->GetMemorySize();
+		}
+	}
+
+	while ((total > m_memBudget) && (m_Undo.size() > 1))
+	{
+		CCommand* pcmd = m_Undo.front(); m_Undo.pop_front();
+		total -= pcmd->GetMemorySize();
+		delete pcmd;
+	}
+}
+
+const char* CBasicCmdManager::GetUndoCmdName() { return (m_Undo.size() ? m_Undo.back()->GetName() : 0); }
+const char* CBasicCmdManager::GetRedoCmdName() { return (m_Redo.size() ? m_Redo.back()->GetName() : 0); }
 
 //////////////////////////////////////////////////////////////////////
 // CCommandManager
@@ -192,11 +246,13 @@ bool CCommandManager::DoCommand(CCommand* pcmd)
 	}
 		
 	// add it to the undo stack
-	m_Undo.push(pcmd);
+	m_Undo.push_back(pcmd);
 
 	// clear the redo stack
 	int N = (int)m_Redo.size();
-	for (int i=0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	for (int i=0; i<N; i++) { delete m_Redo.back(); m_Redo.pop_back(); }
+
+	CheckMemoryBudget();
 
 	return true;
 }
@@ -204,7 +260,7 @@ bool CCommandManager::DoCommand(CCommand* pcmd)
 void CCommandManager::UndoCommand()
 {
 	// pop the command from the undo stack
-	CCommand* pcmd = m_Undo.top(); m_Undo.pop();
+	CCommand* pcmd = m_Undo.back(); m_Undo.pop_back();
 
 	// reset the view state
 	m_pDoc->SetViewState(pcmd->GetViewState());
@@ -213,13 +269,13 @@ void CCommandManager::UndoCommand()
 	pcmd->UnExecute();
 
 	// push it on the redo stack
-	m_Redo.push(pcmd);
+	m_Redo.push_back(pcmd);
 }
 
 void CCommandManager::RedoCommand()
 {
 	// pop the command from the redo stack
-	CCommand* pcmd = m_Redo.top(); m_Redo.pop();
+	CCommand* pcmd = m_Redo.back(); m_Redo.pop_back();
 
 	// reset the view state
 	m_pDoc->SetViewState(pcmd->GetViewState());
@@ -228,5 +284,5 @@ void CCommandManager::RedoCommand()
 	pcmd->Execute();
 
 	// push it on the undo stack
-	m_Undo.push(pcmd);
+	m_Undo.push_back(pcmd);
 }
@@ -25,13 +25,15 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #pragma once
-#include <stack>
+#include <deque>
 #include <string>
 
 class CCommand;
 class CGLDocument;
 
-typedef std::stack<CCommand*> CCmdStack;
+// The back of the deque is the top of the stack. A deque is used so that the
+// oldest commands can be removed when the memory budget is exceeded.
+typedef std::deque<CCommand*> CCmdStack;
 
 class CBasicCmdManager
 {
@@ -55,10 +57,28 @@ public:
 	const char* GetUndoCmdName();
 	const char* GetRedoCmdName();
 
+	// approximate memory (in bytes) used by the commands on both stacks
+	size_t GetMemorySize();
+
+public:
+	// max memory (in bytes) the undo and redo stacks can use before old commands are removed (0 = no budget)
+	static void SetMemoryBudget(size_t maxBytes);
+	static size_t GetMemoryBudget();
+
+	// when set, the undo data of old commands is written to disk before commands are removed
+	static void SetSpillToDisk(bool b);
+	static bool GetSpillToDisk();
+
+protected:
+	void CheckMemoryBudget();
+
 protected:
 	CCmdStack	m_Undo;	// the undo stack
 	CCmdStack	m_Redo;	// the redo stack
 
+	static size_t	m_memBudget;
+	static bool		m_spillToDisk;
+
 public:
 	static const std::string& GetErrorString() { return m_err; }
 	void SetErrorString(const std::string& err) { m_err = err; }
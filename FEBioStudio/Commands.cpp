@@ -36,6 +36,29 @@ SOFTWARE.*/
 #include <GeomLib/MeshLayer.h>
 #include <MeshLib/FEMeshBuilder.h>
 
+//-----------------------------------------------------------------------------
+// approximate memory (in bytes) used by the item arrays of a surface mesh
+static size_t SurfaceMeshMemorySize(FESurfaceMesh* mesh)
+{
+	if (mesh == nullptr) return 0;
+	size_t size = 0;
+	size += (size_t) mesh->Nodes()*sizeof(FENode);
+	size += (size_t) mesh->Edges()*sizeof(FEEdge);
+	size += (size_t) mesh->Faces()*sizeof(FEFace);
+	return size;
+}
+
+//-----------------------------------------------------------------------------
+// approximate memory (in bytes) used by the meshes of an object
+static size_t ObjectMemorySize(GObject* po)
+{
+	if (po == nullptr) return 0;
+	size_t size = FEMeshDelta::MemorySize(po->GetFEMesh());
+	GSurfaceMeshObject* pso = dynamic_cast<GSurfaceMeshObject*>(po);
+	if (pso) size += SurfaceMeshMemorySize(pso->GetSurfaceMesh());
+	return size;
+}
+
 //////////////////////////////////////////////////////////////////////
 // CCmdAddObject
 //////////////////////////////////////////////////////////////////////
@@ -1472,6 +1495,7 @@ CCmdSelectElements::CCmdSelectElements(FEMesh* pm, int* pe, int N, bool badd) :
 
 	// store the elements selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (i = 0; i<M; ++i) m_ptag[i] = pm->Element(i).IsSelected();
 
 	// store the elements we need to select
@@ -1498,6 +1522,7 @@ CCmdSelectElements::CCmdSelectElements(FEMesh* pm, vector<int>& el, bool badd) :
 
 	// store the elements selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (i = 0; i<M; ++i) m_ptag[i] = pm->Element(i).IsSelected();
 
 	// store the elements we need to select
@@ -1556,6 +1581,7 @@ CCmdUnselectElements::CCmdUnselectElements(FEMesh* mesh, int* pe, int N) : CComm
 
 	// store the elements selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Element(i).IsSelected();
 
 	// store the elements we need to select
@@ -1575,6 +1601,7 @@ CCmdUnselectElements::CCmdUnselectElements(FEMesh* mesh, const vector<int>& elem
 
 	// store the elements selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Element(i).IsSelected();
 
 	// store the elements we need to select
@@ -1624,6 +1651,7 @@ CCmdSelectFaces::CCmdSelectFaces(FEMeshBase* pm, int* pf, int N, bool badd) : CC
 
 	// store the faces selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (i = 0; i<M; ++i) m_ptag[i] = pm->Face(i).IsSelected();
 
 	// store the faces we need to select
@@ -1650,6 +1678,7 @@ CCmdSelectFaces::CCmdSelectFaces(FEMeshBase* pm, vector<int>& fl, bool badd) : C
 
 	// store the faces selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (i = 0; i<M; ++i) m_ptag[i] = pm->Face(i).IsSelected();
 
 	// store the faces we need to select
@@ -1704,6 +1733,7 @@ CCmdUnselectFaces::CCmdUnselectFaces(FEMeshBase* pm, int* pf, int N) : CCommand(
 	// store the faces selection state
 	int M = pm->Faces();
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Face(i).IsSelected();
 
 	// store the faces we need to select
@@ -1720,6 +1750,7 @@ CCmdUnselectFaces::CCmdUnselectFaces(FEMeshBase* pm, const vector<int>& face) :
 	// store the faces selection state
 	int M = pm->Faces();
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Face(i).IsSelected();
 
 	// store the faces we need to select
@@ -1765,6 +1796,7 @@ CCmdSelectFEEdges::CCmdSelectFEEdges(FELineMesh* pm, int* pe, int N, bool badd)
 
 	// store the edges selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Edge(i).IsSelected();
 
 	// store the faces we need to select
@@ -1790,6 +1822,7 @@ CCmdSelectFEEdges::CCmdSelectFEEdges(FELineMesh* pm, vector<int>& el, bool badd)
 
 	// store the edge selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Edge(i).IsSelected();
 
 	// store the edges we need to select
@@ -1843,6 +1876,7 @@ CCmdUnselectFEEdges::CCmdUnselectFEEdges(FELineMesh* pm, int* pe, int N) : CComm
 
 	// store the edges selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Edge(i).IsSelected();
 
 	// store the edges we need to select
@@ -1862,6 +1896,7 @@ CCmdUnselectFEEdges::CCmdUnselectFEEdges(FELineMesh* pm, const vector<int>& edge
 
 	// store the edges selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Edge(i).IsSelected();
 
 	// store the edges we need to select
@@ -1908,6 +1943,7 @@ CCmdSelectFENodes::CCmdSelectFENodes(FELineMesh* pm, int* pn, int N, bool badd)
 
 	// store the nodes selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (i = 0; i<M; ++i) m_ptag[i] = pm->Node(i).IsSelected();
 
 	// store the nodes we need to select
@@ -1934,6 +1970,7 @@ CCmdSelectFENodes::CCmdSelectFENodes(FELineMesh* pm, vector<int>& nl, bool badd)
 
 	// store the nodes selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (i = 0; i<M; ++i) m_ptag[i] = pm->Node(i).IsSelected();
 
 	// store the nodes we need to select
@@ -1987,6 +2024,7 @@ CCmdUnselectNodes::CCmdUnselectNodes(FELineMesh* pm, int* pn, int N) : CCommand(
 
 	// store the nodes selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Node(i).IsSelected();
 
 	// store the nodes we need to select
@@ -2005,6 +2043,7 @@ CCmdUnselectNodes::CCmdUnselectNodes(FELineMesh* pm, const vector<int>& node) :
 
 	// store the nodes selection state
 	m_ptag = new bool[M];
+	m_ntag = M;
 	for (int i = 0; i<M; ++i) m_ptag[i] = pm->Node(i).IsSelected();
 
 	// store the nodes we need to select
@@ -2139,12 +2178,16 @@ void CCmdDeleteFESelection::Execute()
 		// make sure you select the object
 		m_pobj->Select();
 	}
+	else m_delta.Expand(m_pnew, m_pold);
 
 	// set the object's mesh
 	m_pobj->ReplaceFEMesh(m_pnew, false);
 
 	// swap meshes
 	FEMesh* pm = m_pnew; m_pnew = m_pold; m_pold = pm;
+
+	// only keep the difference with the active mesh
+	m_delta.Compress(m_pnew, m_pold);
 }
 
 //-----------------------------------------------------------------------------
@@ -2152,11 +2195,21 @@ void CCmdDeleteFESelection::Execute()
 //! \todo this function does not restore the original GMeshObject
 void CCmdDeleteFESelection::UnExecute()
 {
+	m_delta.Expand(m_pnew, m_pold);
+
 	// set the object's mesh
 	m_pobj->ReplaceFEMesh(m_pnew);
 
 	// swap meshes
 	FEMesh* pm = m_pnew; m_pnew = m_pold; m_pold = pm;
+
+	// only keep the difference with the active mesh
+	m_delta.Compress(m_pnew, m_pold);
+}
+
+size_t CCmdDeleteFESelection::GetMemorySize()
+{
+	return (m_delta.IsCompressed() ? m_delta.MemorySize() : FEMeshDelta::MemorySize(m_pnew));
 }
 
 //=============================================================================
@@ -2193,6 +2246,11 @@ void CCmdDeleteFESurfaceSelection::Execute()
 	FESurfaceMesh* pm = m_pnew; m_pnew = m_pold; m_pold = pm;
 }
 
+size_t CCmdDeleteFESurfaceSelection::GetMemorySize()
+{
+	return SurfaceMeshMemorySize(m_pnew);
+}
+
 //-----------------------------------------------------------------------------
 //! Undo the delete FE selection
 //! \todo this function does not restore the original GMeshObject
@@ -2744,6 +2802,7 @@ void CCmdApplyFEModifier::Execute()
 		// make sure the new mesh is selected
 		if (m_pobj) m_pobj->Select();
 	}
+	else m_delta.Expand(m_pnew, m_pold);
 
 	if (m_pnew)
 	{
@@ -2765,6 +2824,9 @@ void CCmdApplyFEModifier::Execute()
 		// swap old and new
 		// we do this so that we can always delete m_pnew
 		FEMesh* pm = m_pnew; m_pnew = m_pold; m_pold = pm;
+
+		// only keep the difference with the active mesh
+		m_delta.Compress(m_pnew, m_pold);
 	}
 }
 
@@ -2773,15 +2835,25 @@ void CCmdApplyFEModifier::UnExecute()
 	// get the FEModel
 	if (m_pnew)
 	{
+		m_delta.Expand(m_pnew, m_pold);
+
 		// replace the old mesh with the new
 		m_pobj->ReplaceFEMesh(m_pnew);
 
 		// swap old and new
 		// we do this so that we can always delete m_pnew
 		FEMesh* pm = m_pnew; m_pnew = m_pold; m_pold = pm;
+
+		// only keep the difference with the active mesh
+		m_delta.Compress(m_pnew, m_pold);
 	}
 }
 
+size_t CCmdApplyFEModifier::GetMemorySize()
+{
+	return (m_delta.IsCompressed() ? m_delta.MemorySize() : FEMeshDelta::MemorySize(m_pnew));
+}
+
 
 //=============================================================================
 // CCmdApplySurfaceModifier
@@ -2862,6 +2934,11 @@ void CCmdApplySurfaceModifier::UnExecute()
 	}
 }
 
+size_t CCmdApplySurfaceModifier::GetMemorySize()
+{
+	return SurfaceMeshMemorySize(m_pnew);
+}
+
 //=============================================================================
 // CCmdChangeFEMesh
 //-----------------------------------------------------------------------------
@@ -2877,9 +2954,13 @@ CCmdChangeFEMesh::CCmdChangeFEMesh(GObject* po, FEMesh* pm, bool bup) : CCommand
 void CCmdChangeFEMesh::Execute()
 {
 	FEMesh* pm = m_po->GetFEMesh();
+	m_delta.Expand(m_pnew, pm);
 	m_po->ReplaceFEMesh(m_pnew, m_update);
 
 	m_pnew = pm;
+
+	// only keep the difference with the active mesh
+	m_delta.Compress(m_pnew, m_po->GetFEMesh());
 }
 
 void CCmdChangeFEMesh::UnExecute()
@@ -2887,6 +2968,11 @@ void CCmdChangeFEMesh::UnExecute()
 	Execute();
 }
 
+size_t CCmdChangeFEMesh::GetMemorySize()
+{
+	return (m_delta.IsCompressed() ? m_delta.MemorySize() : FEMeshDelta::MemorySize(m_pnew));
+}
+
 //=============================================================================
 // CCmdChangeFESurfaceMesh
 //-----------------------------------------------------------------------------
@@ -2918,6 +3004,11 @@ void CCmdChangeFESurfaceMesh::UnExecute()
 	Execute();
 }
 
+size_t CCmdChangeFESurfaceMesh::GetMemorySize()
+{
+	return SurfaceMeshMemorySize(m_pnew);
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // CCmdChangeView
@@ -3062,6 +3153,12 @@ void CCmdSwapObjects::UnExecute()
 	m_oml = nullptr;
 }
 
+size_t CCmdSwapObjects::GetMemorySize()
+{
+	// the object that is not in the model belongs to this command
+	return ObjectMemorySize(m_oml ? m_pold : m_pnew);
+}
+
 //-----------------------------------------------------------------------------
 // CCmdConvertToMultiBlock
 //-----------------------------------------------------------------------------
@@ -3114,6 +3211,11 @@ void CCmdConvertToMultiBlock::UnExecute()
 	Execute();
 }
 
+size_t CCmdConvertToMultiBlock::GetMemorySize()
+{
+	return ObjectMemorySize(m_pnew);
+}
+
 //-----------------------------------------------------------------------------
 // CCmdAddModifier
 //-----------------------------------------------------------------------------
@@ -3445,6 +3547,12 @@ void CCmdDeleteGObject::UnExecute()
 	m_poml = nullptr;
 }
 
+size_t CCmdDeleteGObject::GetMemorySize()
+{
+	// the object is only held by this command after it was deleted
+	return (m_poml ? ObjectMemorySize(m_po) : 0);
+}
+
 //-----------------------------------------------------------------------------
 // CCmdDeleteFSObject
 //-----------------------------------------------------------------------------
@@ -42,6 +42,7 @@ SOFTWARE.*/
 #include <MeshTools/FESurfaceModifier.h>
 #include <GeomLib/GSurfaceMeshObject.h>
 #include <GLLib/GLCamera.h>
+#include <MeshLib/FEMeshDelta.h>
 
 class ObjectMeshList;
 class MeshLayer;
@@ -739,9 +740,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FEMesh*	m_pm;
 	bool*	m_ptag;	// old selecion state of elements
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pel;	// array of element indics we need to select
 	bool	m_badd; // add to selection or not
 	int		m_N;	// nr of elements to select
@@ -759,9 +763,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FEMesh* m_mesh;
 	bool*	m_ptag;	// old selecion state of elements
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pel;	// array of element indics we need to select
 	bool	m_badd; // add to selection or not
 	int		m_N;	// nr of elements to select
@@ -779,9 +786,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FEMeshBase*	m_pm;
 	bool*	m_ptag;	// old selecion state of faces
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pface;// array of face indics we need to select
 	bool	m_badd; // add to selection or not
 	int		m_N;	// nr of faces to select
@@ -799,9 +809,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FEMeshBase* m_pm;
 	bool*	m_ptag;	// old selecion state of faces
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pface;	// array of face indics we need to select
 	bool	m_badd; // add to selection or not
 	int		m_N;	// nr of faces to select
@@ -819,9 +832,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FELineMesh*	m_pm;
 	bool*	m_ptag;	// old selecion state of edges
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pedge;// array of edge indices we need to select
 	bool	m_badd; // add to selection or not
 	int		m_N;	// nr of edges to select
@@ -839,9 +855,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FELineMesh*	m_pm;
 	bool*	m_ptag;		// old selecion state of edges
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pedge;	// array of edge indices we need to select
 	bool	m_badd;		// add to selection or not
 	int		m_N;		// nr of faces to select
@@ -859,9 +878,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FELineMesh*	m_pm;
 	bool*	m_ptag;	// old selecion state of nodes
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pn;	// array of node indices we need to select
 	bool	m_badd; // add to selection or not
 	int		m_N;	// nr of nodes to select
@@ -879,9 +901,12 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_ntag*sizeof(bool) + m_N*sizeof(int); }
+
 protected:
 	FELineMesh* m_mesh;
 	bool*	m_ptag;	// old selecion state of nodes
+	int		m_ntag;	// nr of items in m_ptag
 	int*	m_pn;	// array of nodes indices we need to select
 	bool	m_badd; // add to selection or not
 	int		m_N;	// nr of nodes to select
@@ -963,10 +988,14 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+	bool Spill() override { return m_delta.Spill(); }
+
 protected:
 	GMeshObject*	m_pobj;
 	FEMesh*			m_pold;
 	FEMesh*			m_pnew;
+	FEMeshDelta		m_delta;	// stores the inactive mesh as a difference with the active one
 	int		m_nitem;
 };
 
@@ -981,6 +1010,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+
 protected:
 	GSurfaceMeshObject*	m_pobj;
 	FESurfaceMesh*		m_pold;
@@ -1042,6 +1073,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_elemList.size()*sizeof(int); }
+
 protected:
 	FEMesh*			m_mesh;
 	vector<int>		m_elemList;
@@ -1056,6 +1089,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_faceList.size()*sizeof(int); }
+
 protected:
 	FESurfaceMesh*	m_mesh;
 	vector<int>		m_faceList;
@@ -1071,6 +1106,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_item.size()*sizeof(int); }
+
 protected:
 	CModelDocument*	m_doc;
 	vector<int>	m_item;
@@ -1088,6 +1125,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_item.size()*sizeof(int); }
+
 protected:
 	CModelDocument*	m_doc;
 	int			m_nitem;
@@ -1105,6 +1144,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override { return m_item.size()*sizeof(int); }
+
 protected:
 	CModelDocument*	m_doc;
 	vector<int>	m_item;
@@ -1124,10 +1165,14 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+	bool Spill() override { return m_delta.Spill(); }
+
 protected:
 	GObject*		m_pobj;
 	FEMesh*			m_pold;	// old, unmodified mesh
 	FEMesh*			m_pnew;	// new, modified mesh
+	FEMeshDelta		m_delta;	// stores the inactive mesh as a difference with the active one
 	FEModifier*		m_pmod;
 	FEGroup*		m_psel;
 };
@@ -1143,6 +1188,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+
 protected:
 	GObject*			m_pobj;
 	FESurfaceMesh*		m_pold;	// old, unmodified mesh
@@ -1162,10 +1209,14 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+	bool Spill() override { return m_delta.Spill(); }
+
 protected:
 	bool		m_update;
 	GObject*	m_po;
 	FEMesh*		m_pnew;
+	FEMeshDelta	m_delta;	// stores the inactive mesh as a difference with the active one
 };
 
 //-----------------------------------------------------------------------------
@@ -1178,6 +1229,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+
 protected:
 	bool				m_update;
 	GSurfaceMeshObject*	m_po;
@@ -1253,6 +1306,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+
 protected:
 	GModel*		m_model;
 	GObject*	m_pold;	// the original object
@@ -1271,6 +1326,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+
 protected:
 	GModel*		m_model;
 	GObject*	m_pold;	// the original object
@@ -1429,6 +1486,8 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t GetMemorySize() override;
+
 protected:
 	GModel*			m_gm;
 	GObject*		m_po;
@@ -32,7 +32,6 @@ SOFTWARE.*/
 #include <QMessageBox>
 #include <QPainter>
 #include "DlgFormula.h"
-#include <MathLib/MathParser.h>
 #include <FEMLib/FESurfaceLoad.h>
 #include <FEMLib/FEMultiMaterial.h>
 #include <FEMLib/FEBodyLoad.h>
@@ -1169,7 +1168,6 @@ void CCurveEditor::on_math_triggered()
 		QString math = dlg.GetMath();
 		std::string smath = math.toStdString();
 
-		CMathParser m;
 		bool insertMode = dlg.Insert();
 		if (insertMode == false) plc->Clear();
 		plc->SetName(smath.c_str());
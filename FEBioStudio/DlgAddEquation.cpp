@@ -103,9 +103,14 @@ public:
 
 		QDialogButtonBox* bb = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
 
+		// note on the equations
+		QLabel* note = new QLabel("The equations can use the variables x, y, z (nodal position) and t (time). An equation that cannot be parsed evaluates to 0.");
+		note->setWordWrap(true);
+
 		QVBoxLayout* l = new QVBoxLayout;
 		l->addLayout(f);
 		l->addWidget(stack);
+		l->addWidget(note);
 		l->addWidget(bb);
 
 		dlg->setLayout(l);
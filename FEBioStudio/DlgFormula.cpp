@@ -138,23 +138,26 @@ std::vector<LOADPOINT> CDlgFormula::GetPoints()
 	int samples = GetSamples();
 
 	std::vector<LOADPOINT> pts;
+	if (samples <= 0) return pts;
+
+	// compile the expression
+	std::vector<std::string> vars(1, "t");
 	CMathParser m;
-	int ierr;
-	LOADPOINT pt;
-	for (int i = 0; i<samples; ++i)
-	{
-		pt.time = fmin + i*(fmax - fmin) / (samples - 1);
-		m.set_variable("t", pt.time);
+	CMathProgram prg;
+	if (m.compile(smath.c_str(), vars, prg) == false) return pts;
 
-		pt.load = m.eval(smath.c_str(), ierr);
+	// evaluate all the samples at once
+	std::vector<double> t(samples), f(samples);
+	for (int i = 0; i<samples; ++i) t[i] = fmin + i*(fmax - fmin) / (samples - 1);
 
-		pts.push_back(pt);
+	const double* x = &t[0];
+	if (prg.eval(samples, &x, &f[0]) != 0) return pts;
 
-		if (ierr != 0)
-		{
-			pts.clear();
-			break;
-		}
+	pts.resize(samples);
+	for (int i = 0; i<samples; ++i)
+	{
+		pts[i].time = t[i];
+		pts[i].load = f[i];
 	}
 
 	return pts;
@@ -28,6 +28,8 @@ SOFTWARE.*/
 #include "DlgImportXPLT.h"
 #include <QRadioButton>
 #include <QLineEdit>
+#include <QCheckBox>
+#include <QSpinBox>
 #include <QDialogButtonBox>
 #include <QBoxLayout>
 #include <QLabel>
@@ -102,6 +104,9 @@ public:
 	QRadioButton* pb2;
 	QRadioButton* pb3;
 	QLineEdit* pitems;
+	QCheckBox* pondemand;
+	QSpinBox* pcache;
+	QCheckBox* pmap;
 
 public:
 	void setupUi(QDialog* parent)
@@ -119,6 +124,18 @@ public:
 		pv->addWidget(pitems = new QLineEdit);
 		pv->addWidget(new QLabel("(e.g.:1,2,3:6,10:100:5)"));
 
+		pv->addWidget(pondemand = new QCheckBox("Read state data on demand"));
+
+		QHBoxLayout* ph = new QHBoxLayout;
+		ph->addWidget(new QLabel("Max memory for state data (MB):"));
+		ph->addWidget(pcache = new QSpinBox);
+		pcache->setRange(0, 1000000);
+		pcache->setSpecialValueText("no limit");
+		pcache->setEnabled(false);
+		pv->addLayout(ph);
+
+		pv->addWidget(pmap = new QCheckBox("Use a memory-mapped file (local files only)"));
+
 		QDialogButtonBox* bb = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
 
 		pv->addWidget(bb);
@@ -127,6 +144,7 @@ public:
 		QObject::connect(bb, SIGNAL(accepted()), parent, SLOT(accept()));
 		QObject::connect(bb, SIGNAL(rejected()), parent, SLOT(reject()));
 		QObject::connect(pitems, SIGNAL(textEdited(const QString&)), pb3, SLOT(click()));
+		QObject::connect(pondemand, SIGNAL(toggled(bool)), pcache, SLOT(setEnabled(bool)));
 	}
 };
 
@@ -134,6 +152,11 @@ CDlgImportXPLT::CDlgImportXPLT(QWidget* parent) : QDialog(parent), ui(new Ui::CD
 {
 	ui->setupUi(this);
 	setWindowTitle("Import XPLT");
+
+	m_nop = 0;
+	m_bondemand = false;
+	m_cacheSize = 0;
+	m_bmap = false;
 }
 
 void CDlgImportXPLT::accept()
@@ -142,6 +165,10 @@ void CDlgImportXPLT::accept()
 	if (ui->pb2->isChecked()) m_nop = 1;
 	if (ui->pb3->isChecked()) m_nop = 2;
 
+	m_bondemand = ui->pondemand->isChecked();
+	m_cacheSize = (m_bondemand ? ui->pcache->value() : 0);
+	m_bmap = ui->pmap->isChecked();
+
 	std::string s = ui->pitems->text().toStdString();
 	char buf[256] = {0}; 
 	strcpy(buf, s.c_str());
@@ -42,6 +42,9 @@ public:
 public:
 	int					m_nop;
 	std::vector<int>	m_item;
+	bool				m_bondemand;
+	int					m_cacheSize;	// max memory for state data in MB (0 = no limit)
+	bool				m_bmap;			// read the file through a memory-mapped view
 
 private:
 	Ui::CDlgImportXPLT* ui;
@@ -27,6 +27,7 @@ SOFTWARE.*/
 #include "stdafx.h"
 #include "DlgRAWImport.h"
 #include <QLineEdit>
+#include <QComboBox>
 #include <QBoxLayout>
 #include <QFormLayout>
 #include <QDialogButtonBox>
@@ -38,6 +39,7 @@ public:
 	QLineEdit*	nx;
 	QLineEdit*	ny;
 	QLineEdit*	nz;
+	QComboBox*	type;
 
 	QLineEdit*	x0;
 	QLineEdit*	y0;
@@ -55,6 +57,11 @@ public:
 		ny = new QLineEdit; ny->setValidator(new QIntValidator(1, 4096));
 		nz = new QLineEdit; nz->setValidator(new QIntValidator(1, 4096));
 
+		type = new QComboBox;
+		type->addItem("8-bit");
+		type->addItem("16-bit");
+		type->addItem("32-bit float");
+
 		x0 = new QLineEdit; x0->setValidator(new QDoubleValidator);
 		y0 = new QLineEdit; y0->setValidator(new QDoubleValidator);
 		z0 = new QLineEdit; z0->setValidator(new QDoubleValidator);
@@ -67,6 +74,7 @@ public:
 		form->addRow("nx", nx);
 		form->addRow("ny", ny);
 		form->addRow("nz", nz);
+		form->addRow("pixel type", type);
 		form->addRow("x0", x0);
 		form->addRow("y0", y0);
 		form->addRow("z0", z0);
@@ -97,6 +105,9 @@ void CDlgRAWImport::accept()
 	m_ny = ui->ny->text().toInt();
 	m_nz = ui->nz->text().toInt();
 
+	const int bits[] = { 8, 16, 32 };
+	m_nbits = bits[ui->type->currentIndex()];
+
 	m_x0 = ui->x0->text().toDouble();
 	m_y0 = ui->y0->text().toDouble();
 	m_z0 = ui->z0->text().toDouble();
@@ -50,6 +50,7 @@ SOFTWARE.*/
 #include "CColorButton.h"
 #include <GLWLib/convert.h>
 #include <PostLib/Palette.h>
+#include <PostLib/FEPostModel.h>
 #include "RepositoryPanel.h"
 #include "units.h"
 #include "DlgSetRepoFolder.h"
@@ -95,6 +96,7 @@ public:
 		addEnumProperty(&m_ntrans, "Object transparency mode")->setEnumValues(QStringList() << "None" << "Selected only" << "Unselected only");
 		addEnumProperty(&m_nobjcol, "Object color")->setEnumValues(QStringList() << "Default" << "Object");
 		addBoolProperty(&m_dozsorting, "Improved Transparency");
+		addBoolProperty(&m_bvbo, "Use vertex buffers");
 	}
 
 public:
@@ -107,6 +109,7 @@ public:
 	int		m_ntrans;
 	int		m_nobjcol;
 	bool	m_dozsorting;
+	bool	m_bvbo;
 };
 
 //-----------------------------------------------------------------------------
@@ -152,6 +155,9 @@ public:
 		addBoolProperty(&m_showNewDialog, "Show New dialog box");
 		addProperty("Recent projects list", CProperty::Action)->info = QString("Clear");
 		addIntProperty(&m_autoSaveInterval, "AutoSave Interval (s)");
+		addIntProperty(&m_evalThreads, "Post-processing threads (0 = all)")->setIntRange(0, 256);
+		addIntProperty(&m_undoBudget, "Undo memory budget (MB, 0 = unlimited)")->setIntRange(0, 1024*1024);
+		addBoolProperty(&m_undoSpill, "Move old undo data to disk");
 	}
 
 	void SetPropertyValue(int i, const QVariant& v) override
@@ -174,6 +180,9 @@ public:
 	int		m_theme;
 	bool	m_showNewDialog;
 	int		m_autoSaveInterval;
+	int		m_evalThreads;
+	int		m_undoBudget;
+	bool	m_undoSpill;
 };
 
 //-----------------------------------------------------------------------------
@@ -947,6 +956,7 @@ CDlgSettings::CDlgSettings(CMainWindow* pwnd) : ui(new Ui::CDlgSettings(this, pw
 	ui->m_display->m_ntrans = view.m_transparencyMode;
 	ui->m_display->m_nobjcol = view.m_objectColor;
 	ui->m_display->m_dozsorting = view.m_bzsorting;
+	ui->m_display->m_bvbo = view.m_bvbo;
 
 	ui->m_physics->m_showRigidBodies = view.m_brigid;
 	ui->m_physics->m_showRigidJoints = view.m_bjoint;
@@ -962,6 +972,9 @@ CDlgSettings::CDlgSettings(CMainWindow* pwnd) : ui(new Ui::CDlgSettings(this, pw
 	ui->m_ui->m_theme = pwnd->currentTheme();
 	ui->m_ui->m_showNewDialog = pwnd->showNewDialog();
 	ui->m_ui->m_autoSaveInterval = pwnd->autoSaveInterval();
+	ui->m_ui->m_evalThreads = Post::FEPostModel::GetEvalThreads();
+	ui->m_ui->m_undoBudget = (int)(CBasicCmdManager::GetMemoryBudget() >> 20);
+	ui->m_ui->m_undoSpill = CBasicCmdManager::GetSpillToDisk();
 
 	ui->m_select->m_bconnect = view.m_bconn;
 	ui->m_select->m_ntagInfo = view.m_ntagInfo;
@@ -1051,6 +1064,7 @@ void CDlgSettings::apply()
 	view.m_transparencyMode = ui->m_display->m_ntrans;
 	view.m_objectColor = ui->m_display->m_nobjcol;
 	view.m_bzsorting = ui->m_display->m_dozsorting;
+	view.m_bvbo = ui->m_display->m_bvbo;
 
 	view.m_brigid = ui->m_physics->m_showRigidBodies;
 	view.m_bjoint = ui->m_physics->m_showRigidJoints;
@@ -1084,6 +1098,9 @@ void CDlgSettings::apply()
 	m_pwnd->setCurrentTheme(ui->m_ui->m_theme);
 	m_pwnd->setShowNewDialog(ui->m_ui->m_showNewDialog);
 	m_pwnd->setAutoSaveInterval(ui->m_ui->m_autoSaveInterval);
+	Post::FEPostModel::SetEvalThreads(ui->m_ui->m_evalThreads);
+	CBasicCmdManager::SetMemoryBudget((size_t)ui->m_ui->m_undoBudget << 20);
+	CBasicCmdManager::SetSpillToDisk(ui->m_ui->m_undoSpill);
 
 	// update units
 	int newUnit = ui->m_unit->m_unit;
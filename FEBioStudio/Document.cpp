@@ -114,6 +114,7 @@ void VIEW_SETTINGS::Defaults()
 	m_bline_smooth = true;
 	m_bpoint_smooth = true;
 	m_bzsorting = true;
+	m_bvbo = true;
 
 	m_snapToGrid = true;
 	m_snapToNode = false;
@@ -763,7 +764,7 @@ void CGLDocument::LoadResources(IArchive& ar)
 
 //-----------------------------------------------------------------------------
 // import image data
-Post::CImageModel* CGLDocument::ImportImage(const std::string& fileName, int nx, int ny, int nz, BOX box)
+Post::CImageModel* CGLDocument::ImportImage(const std::string& fileName, int nx, int ny, int nz, BOX box, int nbits)
 {
 	static int n = 1;
 
@@ -771,7 +772,7 @@ Post::CImageModel* CGLDocument::ImportImage(const std::string& fileName, int nx,
 	string relFile = FSDir::makeRelative(fileName, "$(ProjectDir)");
 
 	Post::CImageModel* po = new Post::CImageModel(nullptr);
-	if (po->LoadImageData(relFile, nx, ny, nz, box) == false)
+	if (po->LoadImageData(relFile, nx, ny, nz, box, nbits) == false)
 	{
 		delete po;
 		return nullptr;
@@ -251,7 +251,7 @@ public:
 	FileWriter* GetFileWriter();
 
 	// import image data
-	Post::CImageModel* ImportImage(const std::string& fileName, int nx, int ny, int nz, BOX box);
+	Post::CImageModel* ImportImage(const std::string& fileName, int nx, int ny, int nz, BOX box, int nbits = 8);
 
 	// --- Command history functions ---
 	bool CanUndo();
@@ -33,8 +33,10 @@ SOFTWARE.*/
 #include <PostLib/PostView.h>
 #include <FSCore/FSDir.h>
 #include <MeshLib/FEElementLibrary.h>
+#include <XPLTLib/xpltFileFilter.h>
 #include <QSplashScreen>
 #include <QDebug>
+#include <QDir>
 
 #ifdef __APPLE__
 #include <QFileOpenEvent>
@@ -65,6 +67,98 @@ public:
 
 #endif
 
+//-----------------------------------------------------------------------------
+// Writes a subset of plot files without starting the UI:
+//
+// FEBioStudio -xpltfilter [options] input output
+//
+// options:
+//  -stride n    : only write every n-th state
+//  -first n     : first state to write (zero-based)
+//  -last n      : last state to write (zero-based)
+//  -keeplast    : always write the last state
+//  -var name    : write this variable (can be repeated, default is all variables)
+//  -dom n       : write this domain (zero-based, can be repeated, default is all domains)
+//  -compress    : compress the new file
+//
+// When input is a directory, all the plot files it contains are written to the output directory.
+static int xpltFilter(int argc, char* argv[])
+{
+	Post::xpltFileFilter filter;
+	int first = 0, last = -1;
+	vector<string> files;
+	for (int i = 2; i < argc; ++i)
+	{
+		const char* sz = argv[i];
+		bool bval = (i + 1 < argc);
+		if      ((strcmp(sz, "-stride") == 0) && bval) filter.SetStateStride(atoi(argv[++i]));
+		else if ((strcmp(sz, "-first" ) == 0) && bval) first = atoi(argv[++i]);
+		else if ((strcmp(sz, "-last"  ) == 0) && bval) last = atoi(argv[++i]);
+		else if ((strcmp(sz, "-var"   ) == 0) && bval) filter.AddVariable(argv[++i]);
+		else if ((strcmp(sz, "-dom"   ) == 0) && bval) filter.AddDomain(atoi(argv[++i]));
+		else if  (strcmp(sz, "-keeplast") == 0) filter.SetKeepLastState(true);
+		else if  (strcmp(sz, "-compress") == 0) filter.SetCompression(true);
+		else if (sz[0] == '-')
+		{
+			fprintf(stderr, "Invalid option: %s\n", sz);
+			return 1;
+		}
+		else files.push_back(sz);
+	}
+	filter.SetStateRange(first, last);
+
+	if (files.size() != 2)
+	{
+		fprintf(stderr, "usage: FEBioStudio -xpltfilter [-stride n] [-first n] [-last n] [-keeplast] [-var name] [-dom n] [-compress] input output\n");
+		return 1;
+	}
+
+	// collect the files that need to be filtered
+	vector< pair<string, string> > jobs;
+	QFileInfo in(QString::fromStdString(files[0]));
+	if (in.isDir())
+	{
+		QDir outDir(QString::fromStdString(files[1]));
+		if ((outDir.exists() == false) && (outDir.mkpath(".") == false))
+		{
+			fprintf(stderr, "Failed creating directory %s\n", files[1].c_str());
+			return 1;
+		}
+
+		QDir inDir(in.absoluteFilePath());
+		if (inDir.absolutePath() == outDir.absolutePath())
+		{
+			fprintf(stderr, "The output directory must be different from the input directory.\n");
+			return 1;
+		}
+
+		QStringList plotFiles = inDir.entryList(QStringList() << "*.xplt", QDir::Files, QDir::Name);
+		for (int i = 0; i < plotFiles.size(); ++i)
+		{
+			jobs.push_back(pair<string, string>(
+				inDir.absoluteFilePath(plotFiles[i]).toStdString(),
+				outDir.absoluteFilePath(plotFiles[i]).toStdString()));
+		}
+	}
+	else jobs.push_back(pair<string, string>(files[0], files[1]));
+
+	int nerrors = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const char* szin = jobs[i].first.c_str();
+		const char* szout = jobs[i].second.c_str();
+		if (filter.Apply(szin, szout))
+			printf("%s: %d states written to %s\n", szin, filter.States(), szout);
+		else
+		{
+			fprintf(stderr, "%s: %s\n", szin, filter.GetErrorMessage());
+			nerrors++;
+		}
+	}
+
+	return (nerrors == 0 ? 0 : 1);
+}
+
 // starting point of application
 int main(int argc, char* argv[])
 {
@@ -72,6 +166,9 @@ int main(int argc, char* argv[])
 	FEElementLibrary::InitLibrary();
 	Post::Initialize();
 
+	// commands that run without the UI
+	if ((argc > 1) && (strcmp(argv[1], "-xpltfilter") == 0)) return xpltFilter(argc, argv);
+
 #ifndef __APPLE__
 
 	QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
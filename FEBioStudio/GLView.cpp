@@ -1777,6 +1777,7 @@ void CGLView::RenderPostView(CPostDocument* postDoc)
 		glm->m_scaleNormals = vs.m_scaleNormals;
 		glm->m_brenderPlotObjects = vs.m_bjoint;
 		glm->m_doZSorting = vs.m_bzsorting;
+		glm->m_useVertexBuffers = vs.m_bvbo;
 
 		glMatrixMode(GL_MODELVIEW);
 		glPushMatrix();
@@ -2990,13 +2991,13 @@ void CGLView::RenderLocalMaterialAxes()
 						if (pgm) pmat = pgm->GetMaterialProperties();
 
 						rel.m_nelem = j;
-						if (el.m_Qactive)
+						if (el.LocalAxesActive())
 						{
 							vec3d c(0, 0, 0);
 							for (int k = 0; k<el.Nodes(); ++k) c += pm->NodePosition(el.m_node[k]);
 							c /= el.Nodes();
 
-							mat3d Q = el.m_Q;
+							mat3d Q = el.LocalAxes();
 							vec3d q;
 							for (int k = 0; k<3; ++k) {
 								q = vec3d(Q[0][k], Q[1][k], Q[2][k]);
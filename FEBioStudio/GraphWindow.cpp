@@ -607,23 +607,32 @@ void MathPlot::draw(QPainter& p)
 
 	p.setPen(QPen(m_col, 2));
 
+	std::vector<std::string> vars(1, "x");
 	CMathParser mp;
+	CMathProgram prg;
+	if (mp.compile(m_math.c_str(), vars, prg) == false) return;
 
 	QRectF vr = m_graph->m_viewRect;
 	QRect sr = m_graph->ScreenRect();
 
-	QPoint p0, p1;
-	int ierr = 0;
-	for (int i=sr.left(); i < sr.right(); i += 2)
+	// evaluate the function at all the sample points
+	int n = 0;
+	std::vector<double> x, y;
+	for (int i=sr.left(); i < sr.right(); i += 2, ++n)
 	{
-		double x = vr.left() + (i - sr.left())*(vr.right() - vr.left())/ (sr.right() - sr.left());
-		mp.set_variable("x", x);
+		x.push_back(vr.left() + (i - sr.left())*(vr.right() - vr.left())/ (sr.right() - sr.left()));
+	}
+	if (n == 0) return;
+	y.resize(n);
+	const double* px = &x[0];
+	prg.eval(n, &px, &y[0]);
 
-		double y = mp.eval(m_math.c_str(), ierr);
-		
-		p1 = m_graph->ViewToScreen(QPointF(x,y));
+	QPoint p0, p1;
+	for (int i=0; i<n; ++i)
+	{
+		p1 = m_graph->ViewToScreen(QPointF(x[i], y[i]));
 
-		if (i != sr.left())
+		if (i != 0)
 		{
 			p.drawLine(p0, p1);
 		}
@@ -56,6 +56,7 @@ SOFTWARE.*/
 #include <FEBio/FEBioExport3.h>
 #include "FEBioJob.h"
 #include <PostLib/ColorMap.h>
+#include <PostLib/FEPostModel.h>
 #include <FSCore/FSDir.h>
 #include <QInputDialog>
 #include "DlgCheck.h"
@@ -813,6 +814,9 @@ void CMainWindow::OpenPostFile(const QString& fileName, CModelDocument* modelDoc
 				{
 					xplt->SetReadStateFlag(dlg.m_nop);
 					xplt->SetReadStatesList(dlg.m_item);
+					xplt->SetReadStatesOnDemand(dlg.m_bondemand);
+					xplt->SetMemoryMapping(dlg.m_bmap);
+					doc->GetFEModel()->SetStateCacheSize((size_t)dlg.m_cacheSize * 1024 * 1024);
 				}
 				else
 				{
@@ -1585,6 +1589,9 @@ void CMainWindow::writeSettings()
 	settings.setValue("showMaterialAxes", vs.m_blma);
 	settings.setValue("fiberScaleFactor", vs.m_fiber_scale);
 	settings.setValue("showFibersOnHiddenParts", vs.m_showHiddenFibers);
+	settings.setValue("useVertexBuffers", vs.m_bvbo);
+	settings.setValue("undoMemoryBudget", (int)(CBasicCmdManager::GetMemoryBudget() >> 20));
+	settings.setValue("undoSpillToDisk", CBasicCmdManager::GetSpillToDisk());
 	QRect rt;
 	rt = CCurveEditor::preferredSize(); if (rt.isValid()) settings.setValue("curveEditorSize", rt);
 	rt = CGraphWindow::preferredSize(); if (rt.isValid()) settings.setValue("graphWindowSize", rt);
@@ -1592,6 +1599,7 @@ void CMainWindow::writeSettings()
 
 	settings.beginGroup("PostSettings");
 	settings.setValue("defaultMap", Post::ColorMapManager::GetDefaultMap());
+	settings.setValue("evalThreads", Post::FEPostModel::GetEvalThreads());
 	settings.endGroup();
 
 	settings.beginGroup("FolderSettings");
@@ -1662,6 +1670,9 @@ void CMainWindow::readSettings()
 	vs.m_blma = settings.value("showMaterialAxes", vs.m_blma).toBool();
 	vs.m_fiber_scale = settings.value("fiberScaleFactor", vs.m_fiber_scale).toDouble();
 	vs.m_showHiddenFibers = settings.value("showFibersOnHiddenParts", vs.m_showHiddenFibers).toBool();
+	vs.m_bvbo = settings.value("useVertexBuffers", vs.m_bvbo).toBool();
+	CBasicCmdManager::SetMemoryBudget((size_t)settings.value("undoMemoryBudget", (int)(CBasicCmdManager::GetMemoryBudget() >> 20)).toInt() << 20);
+	CBasicCmdManager::SetSpillToDisk(settings.value("undoSpillToDisk", CBasicCmdManager::GetSpillToDisk()).toBool());
 	Units::SetUnitSystem(ui->m_defaultUnits);
 
 	QRect rt;
@@ -1674,6 +1685,7 @@ void CMainWindow::readSettings()
 
 	settings.beginGroup("PostSettings");
 	Post::ColorMapManager::SetDefaultMap(settings.value("defaultMap", Post::ColorMapManager::JET).toInt());
+	Post::FEPostModel::SetEvalThreads(settings.value("evalThreads", 0).toInt());
 	settings.endGroup();
 
 	settings.beginGroup("FolderSettings");
@@ -55,6 +55,7 @@ public:
 	QComboBox*		m_domain;
 	QComboBox*		m_matList;
 
+	QComboBox*	m_method;
 	QLineEdit*	m_maxIters;
 	QLineEdit*	m_tol;
 	QLineEdit*	m_sor;
@@ -97,6 +98,10 @@ public:
 		QFormLayout* f = new QFormLayout;
 		f->setMargin(0);
 		f->addRow("Material:", m_matList = new QComboBox);
+		f->addRow("Solver:", m_method = new QComboBox);
+		m_method->addItem("SOR relaxation");
+		m_method->addItem("Conjugate gradient");
+		m_method->setCurrentIndex(LaplaceSolver::CONJUGATE_GRADIENT);
 		f->addRow("Max iterations:", m_maxIters = new QLineEdit); m_maxIters->setText(QString::number(1000));
 		f->addRow("Tolerance:", m_tol = new QLineEdit); m_tol->setText(QString::number(1e-4));
 		f->addRow("SOR parameter:", m_sor = new QLineEdit); m_sor->setText(QString::number(1.0));
@@ -304,7 +309,9 @@ void CScalarFieldTool::OnApply()
 	int maxIter = ui->m_maxIters->text().toInt();
 	double tol = ui->m_tol->text().toDouble();
 	double w = ui->m_sor->text().toDouble();
+	int method = ui->m_method->currentIndex();
 
+	wnd->AddLogEntry(QString("solver        = %1\n").arg(ui->m_method->currentText()));
 	wnd->AddLogEntry(QString("max iters     = %1\n").arg(maxIter));
 	wnd->AddLogEntry(QString("tolerance     = %1\n").arg(tol));
 	wnd->AddLogEntry(QString("SOR parameter = %1\n").arg(w));
@@ -314,6 +321,7 @@ void CScalarFieldTool::OnApply()
 	L.SetMaxIterations(maxIter);
 	L.SetTolerance(tol);
 	L.SetRelaxation(w);
+	L.SetMethod(method);
 	bool b = L.Solve(pm, val, bn, 1);
 	int niters = L.GetIterationCount();
 	wnd->AddLogEntry(QString("%1").arg(b ? "Converged!\n" : "NOT converged!\n"));
@@ -70,7 +70,7 @@ void CTimelinePanel::Update(bool reset)
 				FEPostModel& fem = *doc->GetFEModel();
 				vector<double> data(fem.GetStates());
 				int nstates = fem.GetStates();
-				for (int i = 0; i < nstates; ++i) data[i] = fem.GetState(i)->m_time;
+				for (int i = 0; i < nstates; ++i) data[i] = fem.GetTimeValue(i);
 
 				ui->timeline->setTimePoints(data);
 
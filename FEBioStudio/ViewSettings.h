@@ -75,6 +75,7 @@ struct VIEW_SETTINGS
 	bool	m_bline_smooth;		//!< line smoothing flag
 	bool	m_bpoint_smooth;	//!< point smoothing flag
 	bool	m_bzsorting;
+	bool	m_bvbo;			//!< use vertex buffers for rendering
 
 	bool	m_snapToGrid;		//!< snap to grid
 	bool	m_snapToNode;		//!< snap to nodes
@@ -1444,7 +1444,7 @@ void CMainWindow::on_actionImportImage_triggered()
 		{
 			BOX box(dlg.m_x0, dlg.m_y0, dlg.m_z0, dlg.m_x0 + dlg.m_w, dlg.m_y0 + dlg.m_h, dlg.m_z0 + dlg.m_d);
 
-			Post::CImageModel* po = doc->ImportImage(sfile, dlg.m_nx, dlg.m_ny, dlg.m_nz, box);
+			Post::CImageModel* po = doc->ImportImage(sfile, dlg.m_nx, dlg.m_ny, dlg.m_nz, box, dlg.m_nbits);
 			if (po == nullptr)
 			{
 				QMessageBox::critical(this, "FEBio Studio", "Failed importing image data.");
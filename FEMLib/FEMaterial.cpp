@@ -576,7 +576,7 @@ vec3d FEOldFiberMaterial::GetFiberVector(FEElementRef& el)
 	break;
 	case FE_FIBER_USER:
 	{
-		return el->m_fiber;
+		return el->Fiber();
 	}
 	break;
 	case FE_FIBER_ANGLES:
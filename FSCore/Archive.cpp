@@ -394,8 +394,10 @@ IArchive::IOResult IArchive::read(std::vector<int>& v)
 
 	int nsize = pc->nsize / sizeof(int);
 	v.resize(nsize);
+	if (nsize == 0) return IO_OK;
 	int nread = (int)fread(&v[0], sizeof(int), nsize, m_fp);
 	if (nread != nsize) return IO_ERROR;
+	if (m_bswap) bswapv(&v[0], nsize);
 	return IO_OK;
 }
 
@@ -405,8 +407,22 @@ IArchive::IOResult IArchive::read(std::vector<double>& v)
 
 	int nsize = pc->nsize / sizeof(double);
 	v.resize(nsize);
+	if (nsize == 0) return IO_OK;
 	int nread = (int)fread(&v[0], sizeof(double), nsize, m_fp);
 	if (nread != nsize) return IO_ERROR;
+	if (m_bswap) bswapv(&v[0], nsize);
+	return IO_OK;
+}
+
+IArchive::IOResult IArchive::read(std::vector<char>& v)
+{
+	CHUNK* pc = m_Chunk.top();
+
+	int nsize = pc->nsize;
+	v.resize(nsize);
+	if (nsize == 0) return IO_OK;
+	int nread = (int)fread(&v[0], sizeof(char), nsize, m_fp);
+	if (nread != nsize) return IO_ERROR;
 	return IO_OK;
 }
 
@@ -34,6 +34,8 @@ SOFTWARE.*/
 #include <stack>
 #include <list>
 #include <string>
+#include <vector>
+#include <utility>
 #include "memtool.h"
 using namespace std;
 
@@ -150,11 +152,18 @@ public:
 	IOResult read(bool*   pb, int n) { int nr = (int) fread(pb, sizeof(bool  ), n, m_fp); if (nr != n) return IO_ERROR; return IO_OK; }
 	IOResult read(float*  pf, int n) { int nr = (int) fread(pf, sizeof(float ), n, m_fp); if (nr != n) return IO_ERROR; if (m_bswap) bswapv(pf, n); return IO_OK; }
 	IOResult read(double* pg, int n) { int nr = (int) fread(pg, sizeof(double), n, m_fp); if (nr != n) return IO_ERROR; if (m_bswap) bswapv(pg, n); return IO_OK; }
-	IOResult read(vec3d*  pv, int n) { for (int i=0; i<n; ++i) read(pv[i]); return IO_OK; }
+	IOResult read(vec3d*  pv, int n)
+	{
+		// read all components with one call
+		std::vector<double> d(3*n);
+		if ((n > 0) && (read(&d[0], 3*n) != IO_OK)) return IO_ERROR;
+		for (int i=0; i<n; ++i) pv[i] = vec3d(d[3*i], d[3*i+1], d[3*i+2]);
+		return IO_OK;
+	}
 
-	IOResult read(vec3d& r) { read(r.x); read(r.y); read(r.z); return IO_OK; }
-	IOResult read(vec2i& r) { read(r.x); read(r.y); return IO_OK; }
-	IOResult read(quatd& q) { read(q.x); read(q.y); read(q.z); read(q.w); return IO_OK; }
+	IOResult read(vec3d& r) { double d[3]; if (read(d, 3) != IO_OK) return IO_ERROR; r = vec3d(d[0], d[1], d[2]); return IO_OK; }
+	IOResult read(vec2i& r) { int d[2]; if (read(d, 2) != IO_OK) return IO_ERROR; r.x = d[0]; r.y = d[1]; return IO_OK; }
+	IOResult read(quatd& q) { double d[4]; if (read(d, 4) != IO_OK) return IO_ERROR; q.x = d[0]; q.y = d[1]; q.z = d[2]; q.w = d[3]; return IO_OK; }
 	IOResult read(GLColor& c) { int nr = (int) fread(&c, sizeof(GLColor), 1, m_fp); if (nr != 1) return IO_ERROR; return IO_OK; }
 
 	IOResult read(mat3d& a) 
@@ -192,8 +201,10 @@ public:
 		return IO_OK;
 	}
 
+	// read the entire chunk into an array
 	IOResult read(std::vector<int>& v);
 	IOResult read(std::vector<double>& v);
+	IOResult read(std::vector<char>& v);
 
 	// conversion to FILE* 
 	operator FILE* () { return m_fp; }
@@ -360,27 +371,22 @@ template <typename T>
 class OLeaf<vector<T> > : public OChunk
 {
 public:
-	OLeaf(unsigned int nid, const vector<T>& a) : OChunk(nid)
-	{
-		m_nsize = (int)a.size();
-		assert(m_nsize > 0);
-		m_pd = new T[m_nsize];
-		memcpy(m_pd, &a[0], sizeof(T)*m_nsize);
-	}
-	~OLeaf() { delete m_pd; }
+	OLeaf(unsigned int nid, const vector<T>& a) : OChunk(nid), m_d(a) { assert(m_d.empty() == false); }
 
-	int Size() { return sizeof(T)*m_nsize; }
+	// takes over the array, so that large arrays are not copied
+	OLeaf(unsigned int nid, vector<T>&& a) : OChunk(nid) { m_d.swap(a); assert(m_d.empty() == false); }
+
+	int Size() { return (int)(sizeof(T)*m_d.size()); }
 	void Write(IOFileStream* fp)
 	{
 		fp->Write(&m_nID, sizeof(unsigned int), 1);
 		unsigned int nsize = Size();
 		fp->Write(&nsize, sizeof(unsigned int), 1);
-		fp->Write(m_pd, sizeof(T), m_nsize);
+		if (m_d.empty() == false) fp->Write(&m_d[0], sizeof(T), m_d.size());
 	}
 
 protected:
-	T*		m_pd;
-	int		m_nsize;
+	vector<T>	m_d;
 };
 
 class OArchive  
@@ -426,6 +432,12 @@ public:
 		m_pChunk->AddChild(new OLeaf<T>(nid, o));
 	}
 
+	// write an array as one chunk. The array is moved into the archive.
+	template <typename T> void WriteChunk(unsigned int nid, vector<T>&& a)
+	{
+		m_pChunk->AddChild(new OLeaf<vector<T> >(nid, std::move(a)));
+	}
+
 protected:
 	IOFileStream	m_fp;		// the file pointer
 
@@ -279,6 +279,10 @@ SOFTWARE.*/
 #define CID_MESH_NODE_GID			0x00090101
 #define CID_MESH_NODE_POSITION		0x00090102
 
+// bulk arrays for all nodes (since 3.12)
+#define CID_MESH_NODE_GID_ARRAY			0x00090110
+#define CID_MESH_NODE_POSITION_ARRAY	0x00090111
+
 #define CID_MESH_ELEMENT			0x00090200
 #define CID_MESH_ELEMENT_TYPE		0x00090201
 #define CID_MESH_ELEMENT_GID		0x00090202
@@ -289,6 +293,15 @@ SOFTWARE.*/
 #define CID_MESH_ELEMENT_Q_ACTIVE	0x00090207
 #define CID_MESH_ELEMENT_Q			0x00090208
 
+// bulk arrays for all elements (since 3.12)
+#define CID_MESH_ELEMENT_TYPE_ARRAY		0x00090210
+#define CID_MESH_ELEMENT_GID_ARRAY		0x00090211
+#define CID_MESH_ELEMENT_NODES_ARRAY	0x00090212
+#define CID_MESH_ELEMENT_FIBER_ARRAY	0x00090213
+#define CID_MESH_SHELL_THICKNESS_ARRAY	0x00090214
+#define CID_MESH_ELEMENT_Q_ACTIVE_ARRAY	0x00090215
+#define CID_MESH_ELEMENT_Q_ARRAY		0x00090216
+
 #define CID_MESH_FACE				0x00090300
 #define CID_MESH_FACE_TYPE			0x00090301
 #define CID_MESH_FACE_GID			0x00090302
@@ -296,11 +309,22 @@ SOFTWARE.*/
 #define CID_MESH_FACE_SMOOTHID		0x00090304
 #define CID_MESH_FACE_EDGES			0x00090305
 
+// bulk arrays for all faces (since 3.12)
+#define CID_MESH_FACE_TYPE_ARRAY		0x00090310
+#define CID_MESH_FACE_GID_ARRAY			0x00090311
+#define CID_MESH_FACE_NODES_ARRAY		0x00090312
+#define CID_MESH_FACE_SMOOTHID_ARRAY	0x00090313
+
 #define CID_MESH_EDGE				0x00090400
 #define CID_MESH_EDGE_TYPE			0x00090401
 #define CID_MESH_EDGE_GID			0x00090402
 #define CID_MESH_EDGE_NODES			0x00090403
 
+// bulk arrays for all edges (since 3.12)
+#define CID_MESH_EDGE_TYPE_ARRAY		0x00090410
+#define CID_MESH_EDGE_GID_ARRAY			0x00090411
+#define CID_MESH_EDGE_NODES_ARRAY		0x00090412
+
 #define CID_MESH_DATA_SECTION		0x00090500
 #define CID_MESH_ELEM_DATA			0x00090501
 #define CID_MESH_DATA_NAME			0x00090502
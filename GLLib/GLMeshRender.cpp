@@ -31,6 +31,7 @@ SOFTWARE.*/
 #include <MeshLib/quad8.h>
 #include <MeshTools/GLMesh.h>
 #include <GLLib/glx.h>
+#include <GLLib/GLVertexBuffer.h>
 
 //-----------------------------------------------------------------------------
 extern int ET_HEX[12][2];
@@ -1637,6 +1638,115 @@ void GLMeshRender::RenderFEFace(FEFace& face, FEMeshBase* pm)
 	}
 }
 
+//-----------------------------------------------------------------------------
+// triangulation of the faces (same as the corresponding glx functions)
+static const int TRI_QUAD4[2][3] = { { 0,1,2 },{ 2,3,0 } };
+static const int TRI_QUAD8[6][3] = { { 7,0,4 },{ 4,1,5 },{ 5,2,6 },{ 6,3,7 },{ 7,4,5 },{ 7,5,6 } };
+static const int TRI_QUAD9[8][3] = { { 0,4,8 },{ 8,7,0 },{ 4,1,5 },{ 5,8,4 },{ 7,8,6 },{ 6,3,7 },{ 8,5,2 },{ 2,6,8 } };
+static const int TRI_TRI3 [1][3] = { { 0,1,2 } };
+static const int TRI_TRI6 [4][3] = { { 0,3,5 },{ 1,4,3 },{ 2,5,4 },{ 3,4,5 } };
+static const int TRI_TRI7 [6][3] = { { 0,3,6 },{ 1,6,3 },{ 1,4,6 },{ 2,6,4 },{ 2,5,6 },{ 0,6,5 } };
+static const int TRI_TRI10[9][3] = { { 0,3,7 },{ 1,5,4 },{ 2,8,6 },{ 9,7,3 },{ 9,3,4 },{ 9,4,5 },{ 9,5,6 },{ 9,6,8 },{ 9,8,7 } };
+
+// get the triangulation of a face
+static const int* FaceTriangles(int faceType, int& nt)
+{
+	switch (faceType)
+	{
+	case FE_FACE_QUAD4: nt = 2; return TRI_QUAD4[0];
+	case FE_FACE_QUAD8: nt = 6; return TRI_QUAD8[0];
+	case FE_FACE_QUAD9: nt = 8; return TRI_QUAD9[0];
+	case FE_FACE_TRI3 : nt = 1; return TRI_TRI3 [0];
+	case FE_FACE_TRI6 : nt = 4; return TRI_TRI6 [0];
+	case FE_FACE_TRI7 : nt = 6; return TRI_TRI7 [0];
+	case FE_FACE_TRI10: nt = 9; return TRI_TRI10[0];
+	default:
+		assert(false);
+	}
+	nt = 0;
+	return 0;
+}
+
+bool GLMeshRender::AddFaceToBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf)
+{
+	// subdivided faces and thick shells are not buffered
+	if (m_ndivs != 1) return false;
+	if (m_bShell2Solid && pm->ElementRef(face.m_elem[0].eid).IsShell()) return false;
+
+	int nt = 0;
+	const int* T = FaceTriangles(face.m_type, nt);
+	if (T == 0) return false;
+
+	// get the nodal data
+	vec3d r[FEFace::MAX_NODES]; pm->FaceNodePosition(face, r);
+	vec3f n[FEFace::MAX_NODES]; pm->FaceNodeNormals(face, n);
+	float t[FEFace::MAX_NODES]; pm->FaceNodeTexCoords(face, t);
+
+	for (int i = 0; i < 3 * nt; ++i)
+	{
+		int k = T[i];
+		buf.AddVertex(r[k], n[k], t[k]);
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+int GLMeshRender::UpdateFaceInBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf, int nvert, unsigned int attr)
+{
+	int nt = 0;
+	const int* T = FaceTriangles(face.m_type, nt);
+
+	if (attr & GLVertexBuffer::POSITION)
+	{
+		vec3d r[FEFace::MAX_NODES]; pm->FaceNodePosition(face, r);
+		for (int i = 0; i < 3 * nt; ++i) buf.SetPosition(nvert + i, r[T[i]]);
+	}
+
+	if (attr & GLVertexBuffer::NORMAL)
+	{
+		vec3f n[FEFace::MAX_NODES]; pm->FaceNodeNormals(face, n);
+		for (int i = 0; i < 3 * nt; ++i) buf.SetNormal(nvert + i, n[T[i]]);
+	}
+
+	if (attr & GLVertexBuffer::TEXCOORD)
+	{
+		float t[FEFace::MAX_NODES]; pm->FaceNodeTexCoords(face, t);
+		for (int i = 0; i < 3 * nt; ++i) buf.SetTexCoord(nvert + i, t[T[i]]);
+	}
+
+	return 3 * nt;
+}
+
+//-----------------------------------------------------------------------------
+bool GLMeshRender::AddFaceOutlineToBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf)
+{
+	// only linear faces are buffered
+	if ((face.m_type != FE_FACE_TRI3) && (face.m_type != FE_FACE_QUAD4)) return false;
+	if (m_bShell2Solid && pm->ElementRef(face.m_elem[0].eid).IsShell()) return false;
+
+	int N = face.Nodes();
+	for (int i = 0; i < N; ++i)
+	{
+		buf.AddVertex(pm->Node(face.n[i]).r);
+		buf.AddVertex(pm->Node(face.n[(i + 1) % N]).r);
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+int GLMeshRender::UpdateFaceOutlineInBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf, int nvert)
+{
+	int N = face.Nodes();
+	for (int i = 0; i < N; ++i)
+	{
+		buf.SetPosition(nvert + 2*i    , pm->Node(face.n[i]).r);
+		buf.SetPosition(nvert + 2*i + 1, pm->Node(face.n[(i + 1) % N]).r);
+	}
+	return 2 * N;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 void GLMeshRender::RenderThickShell(FEFace &face, FECoreMesh* pm)
 {
@@ -35,6 +35,7 @@ class FELineMesh;
 class FECoreMesh;
 class FEMeshBase;
 class GLMesh;
+class GLVertexBuffer;
 
 class GLMeshRender
 {
@@ -99,6 +100,23 @@ public:
 
 	void RenderFaceOutline(FEFace& face, FECoreMesh* pm, int ndivs);
 
+public:
+	// Add the triangles of a face to a vertex buffer (which must store normals and texture coordinates).
+	// Returns false if the face cannot be buffered and must be rendered with RenderFace instead.
+	bool AddFaceToBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf);
+
+	// Update the given attributes (see GLVertexBuffer::Attributes) of a face that was added to a buffer 
+	// with AddFaceToBuffer, starting at vertex nvert. Returns the number of vertices of the face.
+	int UpdateFaceInBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf, int nvert, unsigned int attr);
+
+	// Add the outline of a face to a line buffer. Returns false if the face cannot 
+	// be buffered and must be rendered with RenderFaceOutline instead.
+	bool AddFaceOutlineToBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf);
+
+	// Update the positions of a face outline that was added with AddFaceOutlineToBuffer, 
+	// starting at vertex nvert. Returns the number of vertices of the outline.
+	int UpdateFaceOutlineInBuffer(FEFace& face, FECoreMesh* pm, GLVertexBuffer& buf, int nvert);
+
 private:
 	// special render routines for thick shells
 	void RenderThickShell(FEFace& face, FECoreMesh* pm);
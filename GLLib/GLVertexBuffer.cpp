@@ -0,0 +1,281 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "stdafx.h"
+#ifdef WIN32
+#include <Windows.h>
+#include <gl/GL.h>
+#endif
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#endif
+#ifdef LINUX
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#endif
+#include "GLVertexBuffer.h"
+
+// The Windows headers only declare OpenGL 1.1, so buffer objects are only used
+// when the buffer functions are declared by the system headers.
+#if defined(GL_VERSION_1_5) && !defined(WIN32)
+#define USE_BUFFER_OBJECTS
+#endif
+
+// indices into the dirty range table
+enum { DIRTY_POS, DIRTY_NRM, DIRTY_TEX, DIRTY_COL };
+
+GLVertexBuffer::GLVertexBuffer(Primitive prim, unsigned int attributes)
+{
+	m_prim = prim;
+	m_attr = attributes;
+	m_dynamic = 0;
+	m_nverts = 0;
+	m_bupdate = true;
+	m_vbo = 0;
+	for (int i = 0; i < 4; ++i) { m_dirty[i][0] = 0; m_dirty[i][1] = -1; }
+}
+
+GLVertexBuffer::~GLVertexBuffer()
+{
+	DeleteBuffer();
+}
+
+void GLVertexBuffer::Create(Primitive prim, unsigned int attributes)
+{
+	m_prim = prim;
+	m_attr = attributes;
+	Clear();
+}
+
+void GLVertexBuffer::Clear()
+{
+	m_pos.clear();
+	m_nrm.clear();
+	m_tex.clear();
+	m_col.clear();
+	m_nverts = 0;
+	m_bupdate = true;
+	for (int i = 0; i < 4; ++i) { m_dirty[i][0] = 0; m_dirty[i][1] = -1; }
+}
+
+void GLVertexBuffer::Modified(unsigned int attributes, int first, int last)
+{
+	if (last < 0) last = m_nverts - 1;
+	if (last < first) return;
+
+	const unsigned int attr[4] = { POSITION, NORMAL, TEXCOORD, COLOR };
+	for (int i = 0; i < 4; ++i)
+	{
+		if (attributes & attr[i])
+		{
+			int* r = m_dirty[i];
+			if (r[1] < r[0]) { r[0] = first; r[1] = last; }
+			else
+			{
+				if (first < r[0]) r[0] = first;
+				if (last  > r[1]) r[1] = last;
+			}
+		}
+	}
+}
+
+void GLVertexBuffer::Reserve(size_t n)
+{
+	m_pos.reserve(3 * n);
+	if (m_attr & NORMAL  ) m_nrm.reserve(3 * n);
+	if (m_attr & TEXCOORD) m_tex.reserve(n);
+	if (m_attr & COLOR   ) m_col.reserve(4 * n);
+}
+
+void GLVertexBuffer::Resize(int n)
+{
+	m_pos.assign(3 * n, 0.f);
+	if (m_attr & NORMAL  ) m_nrm.assign(3 * n, 0.f);
+	if (m_attr & TEXCOORD) m_tex.assign(n, 0.f);
+	if (m_attr & COLOR   ) m_col.assign(4 * n, 255);
+	m_nverts = n;
+	m_bupdate = true;
+	for (int i = 0; i < 4; ++i) { m_dirty[i][0] = 0; m_dirty[i][1] = -1; }
+}
+
+void GLVertexBuffer::AddVertex(const vec3d& r)
+{
+	m_pos.push_back((float)r.x);
+	m_pos.push_back((float)r.y);
+	m_pos.push_back((float)r.z);
+	if (m_attr & NORMAL) { m_nrm.push_back(0.f); m_nrm.push_back(0.f); m_nrm.push_back(1.f); }
+	if (m_attr & TEXCOORD) m_tex.push_back(0.f);
+	if (m_attr & COLOR) { m_col.push_back(0); m_col.push_back(0); m_col.push_back(0); m_col.push_back(255); }
+	m_nverts++;
+	m_bupdate = true;
+}
+
+void GLVertexBuffer::AddVertex(const vec3d& r, const vec3f& n, float t)
+{
+	m_pos.push_back((float)r.x);
+	m_pos.push_back((float)r.y);
+	m_pos.push_back((float)r.z);
+	if (m_attr & NORMAL) { m_nrm.push_back(n.x); m_nrm.push_back(n.y); m_nrm.push_back(n.z); }
+	if (m_attr & TEXCOORD) m_tex.push_back(t);
+	if (m_attr & COLOR) { m_col.push_back(0); m_col.push_back(0); m_col.push_back(0); m_col.push_back(255); }
+	m_nverts++;
+	m_bupdate = true;
+}
+
+void GLVertexBuffer::AddVertex(const vec3d& r, const vec3f& n, const GLColor& c)
+{
+	m_pos.push_back((float)r.x);
+	m_pos.push_back((float)r.y);
+	m_pos.push_back((float)r.z);
+	if (m_attr & NORMAL) { m_nrm.push_back(n.x); m_nrm.push_back(n.y); m_nrm.push_back(n.z); }
+	if (m_attr & TEXCOORD) m_tex.push_back(0.f);
+	if (m_attr & COLOR) { m_col.push_back(c.r); m_col.push_back(c.g); m_col.push_back(c.b); m_col.push_back(c.a); }
+	m_nverts++;
+	m_bupdate = true;
+}
+
+void GLVertexBuffer::DeleteBuffer()
+{
+#ifdef USE_BUFFER_OBJECTS
+	if (m_vbo) glDeleteBuffers(1, &m_vbo);
+#endif
+	m_vbo = 0;
+
+	// The data of the static attributes only existed in the buffer object,
+	// so the vertices are gone unless all the data is still in memory.
+	if (HasVertexData() == false) Clear();
+	m_bupdate = true;
+}
+
+bool GLVertexBuffer::HasVertexData() const
+{
+	size_t nv = (size_t)m_nverts;
+	if (m_pos.size() != 3 * nv) return false;
+	if ((m_attr & NORMAL  ) && (m_nrm.size() != 3 * nv)) return false;
+	if ((m_attr & TEXCOORD) && (m_tex.size() != nv)) return false;
+	if ((m_attr & COLOR   ) && (m_col.size() != 4 * nv)) return false;
+	return true;
+}
+
+void GLVertexBuffer::Render()
+{
+	if (m_nverts == 0) return;
+
+	// size (in bytes) of the vertex attributes
+	// (Note that the data of static attributes is no longer in memory after it was uploaded.)
+	size_t nv = (size_t)m_nverts;
+	size_t npos = 3 * nv * sizeof(float);
+	size_t nnrm = (m_attr & NORMAL   ? 3 * nv * sizeof(float) : 0);
+	size_t ntex = (m_attr & TEXCOORD ? nv * sizeof(float) : 0);
+	size_t ncol = (m_attr & COLOR    ? 4 * nv : 0);
+
+	const char* ppos = (const char*)(m_pos.empty() ? 0 : &m_pos[0]);
+	const char* pnrm = (const char*)(m_nrm.empty() ? 0 : &m_nrm[0]);
+	const char* ptex = (const char*)(m_tex.empty() ? 0 : &m_tex[0]);
+	const char* pcol = (const char*)(m_col.empty() ? 0 : &m_col[0]);
+
+#ifdef USE_BUFFER_OBJECTS
+	if (m_vbo == 0)
+	{
+		// all the data must be uploaded again, which is only possible if it's still in memory
+		if (HasVertexData() == false) { Clear(); return; }
+		glGenBuffers(1, &m_vbo);
+		m_bupdate = true;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	if (m_bupdate)
+	{
+		// copy all attributes to the buffer, one after the other
+		glBufferData(GL_ARRAY_BUFFER, npos + nnrm + ntex + ncol, 0, (m_dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW));
+		glBufferSubData(GL_ARRAY_BUFFER, 0, npos, ppos);
+		if (nnrm) glBufferSubData(GL_ARRAY_BUFFER, npos, nnrm, pnrm);
+		if (ntex) glBufferSubData(GL_ARRAY_BUFFER, npos + nnrm, ntex, ptex);
+		if (ncol) glBufferSubData(GL_ARRAY_BUFFER, npos + nnrm + ntex, ncol, pcol);
+
+		// the data now lives on the GPU, so we only keep a copy of the dynamic attributes
+		if ((m_dynamic & POSITION) == 0) std::vector<float>().swap(m_pos);
+		if ((m_dynamic & NORMAL  ) == 0) std::vector<float>().swap(m_nrm);
+		if ((m_dynamic & TEXCOORD) == 0) std::vector<float>().swap(m_tex);
+		if ((m_dynamic & COLOR   ) == 0) std::vector<unsigned char>().swap(m_col);
+		m_bupdate = false;
+	}
+	else
+	{
+		// only upload the modified ranges of the dynamic attributes
+		const size_t offset[4] = { 0, npos, npos + nnrm, npos + nnrm + ntex };
+		const char*  data[4] = { ppos, pnrm, ptex, pcol };
+		const size_t size[4] = { 3*sizeof(float), 3*sizeof(float), sizeof(float), 4 };
+		for (int i = 0; i < 4; ++i)
+		{
+			int* r = m_dirty[i];
+			if ((r[1] >= r[0]) && data[i])
+			{
+				size_t n0 = r[0] * size[i];
+				size_t n1 = (r[1] + 1) * size[i];
+				glBufferSubData(GL_ARRAY_BUFFER, offset[i] + n0, n1 - n0, data[i] + n0);
+			}
+		}
+	}
+	for (int i = 0; i < 4; ++i) { m_dirty[i][0] = 0; m_dirty[i][1] = -1; }
+
+	// from here on, the pointers are offsets into the buffer
+	ppos = 0;
+	pnrm = ppos + npos;
+	ptex = pnrm + nnrm;
+	pcol = ptex + ntex;
+#endif
+
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, ppos);
+
+	if (m_attr & NORMAL)
+	{
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glNormalPointer(GL_FLOAT, 0, pnrm);
+	}
+
+	if (m_attr & TEXCOORD)
+	{
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(1, GL_FLOAT, 0, ptex);
+	}
+
+	if (m_attr & COLOR)
+	{
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(4, GL_UNSIGNED_BYTE, 0, pcol);
+	}
+
+	glDrawArrays((m_prim == TRIANGLES ? GL_TRIANGLES : GL_LINES), 0, m_nverts);
+
+	glPopClientAttrib();
+
+#ifdef USE_BUFFER_OBJECTS
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+}
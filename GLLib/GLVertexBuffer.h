@@ -0,0 +1,138 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <MathLib/math3d.h>
+#include <FSCore/color.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// A vertex buffer stores the vertex data (positions and optionally normals, 
+// texture coordinates and colors) of a list of triangles or lines so that it can
+// be rendered with a single draw call. The data is uploaded to a buffer object 
+// once and only sent to the GPU again after the buffer was rebuilt. Attributes
+// that change often (e.g. positions and texture coordinates during animations) 
+// can be marked dynamic. These can be modified in place and only the modified 
+// range of that attribute is uploaded again. When buffer objects are not available, 
+// client-side vertex arrays are used instead.
+class GLVertexBuffer
+{
+public:
+	// type of primitive
+	enum Primitive {
+		TRIANGLES,
+		LINES
+	};
+
+	// vertex attributes (the position is always stored)
+	enum Attributes {
+		NORMAL   = 1,
+		TEXCOORD = 2,
+		COLOR    = 4,
+		POSITION = 8
+	};
+
+public:
+	GLVertexBuffer(Primitive prim = TRIANGLES, unsigned int attributes = 0);
+	~GLVertexBuffer();
+
+	// set the primitive type and vertex attributes. This clears the buffer.
+	void Create(Primitive prim, unsigned int attributes);
+
+	// clear all vertex data
+	void Clear();
+
+	// allocate memory for a number of vertices
+	void Reserve(size_t n);
+
+	// Set the number of vertices. The vertex data must then be set with the Set functions
+	// below. Since each vertex is written separately, this can be used to fill the buffer in parallel.
+	void Resize(int n);
+
+	// add a vertex. Note that after the buffer was rendered, it must be cleared 
+	// before new vertices can be added.
+	void AddVertex(const vec3d& r);
+	void AddVertex(const vec3d& r, const vec3f& n, float t);
+	void AddVertex(const vec3d& r, const vec3f& n, const GLColor& c);
+
+	// number of vertices
+	int Vertices() const { return m_nverts; }
+
+	// Set the attributes that can be modified after the buffer was rendered.
+	// The data of these attributes is kept in memory after it was uploaded.
+	void SetDynamic(unsigned int attributes) { m_dynamic = attributes; }
+	unsigned int GetDynamic() const { return m_dynamic; }
+
+	// Modify the data of a vertex. This can only be used for dynamic attributes
+	// (or before the buffer was rendered). Call Modified afterwards.
+	void SetPosition(int i, const vec3d& r) { float* p = &m_pos[3*i]; p[0] = (float)r.x; p[1] = (float)r.y; p[2] = (float)r.z; }
+	void SetPosition(int i, const vec3f& r) { float* p = &m_pos[3*i]; p[0] = r.x; p[1] = r.y; p[2] = r.z; }
+	void SetNormal  (int i, const vec3f& n) { float* p = &m_nrm[3*i]; p[0] = n.x; p[1] = n.y; p[2] = n.z; }
+	void SetTexCoord(int i, float t) { m_tex[i] = t; }
+	void SetColor   (int i, const GLColor& c) { unsigned char* p = &m_col[4*i]; p[0] = c.r; p[1] = c.g; p[2] = c.b; p[3] = c.a; }
+
+	// Mark the data of the vertices [first, last] of the given attributes as modified
+	// (last = -1 for all remaining vertices). Only the modified ranges are uploaded.
+	void Modified(unsigned int attributes, int first = 0, int last = -1);
+
+	// render the buffer
+	void Render();
+
+	// release the buffer object (requires a current rendering context). 
+	// The buffer must be rebuilt before it can be rendered again.
+	void DeleteBuffer();
+
+private:
+	// see if the data of all attributes is in memory
+	bool HasVertexData() const;
+
+	GLVertexBuffer(const GLVertexBuffer&) {}
+	void operator = (const GLVertexBuffer&) {}
+
+private:
+	Primitive		m_prim;
+	unsigned int	m_attr;
+	unsigned int	m_dynamic;	// attributes that can be modified after rendering
+	int				m_nverts;	// nr of vertices added since last Clear
+	bool			m_bupdate;	// all vertex data needs to be uploaded
+
+	// modified vertex range [first, last] of position, normal, texcoord and color
+	int		m_dirty[4][2];
+
+	std::vector<float>			m_pos;	// vertex positions
+	std::vector<float>			m_nrm;	// vertex normals
+	std::vector<float>			m_tex;	// vertex texture coordinates
+	std::vector<unsigned char>	m_col;	// vertex colors (rgba)
+
+	unsigned int	m_vbo;	// buffer object ID (0 if not created)
+};
+
+//-----------------------------------------------------------------------------
+// combine a value with a key that identifies the content of a vertex buffer
+inline void hash_combine(size_t& key, size_t v)
+{
+	key ^= v + 0x9e3779b9 + (key << 6) + (key >> 2);
+}
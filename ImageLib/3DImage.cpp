@@ -28,11 +28,17 @@ SOFTWARE.*/
 #include "3DImage.h"
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 
 #ifdef WIN32
+#include <Windows.h>
 #include <memory>
 #else
 #include <memory.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 //-----------------------------------------------------------------------------
@@ -47,6 +53,28 @@ int closest_pow2(int n)
 	return p;
 }
 
+//-----------------------------------------------------------------------------
+// pixel type from number of bits
+static int pixelTypeFromBits(int nbits)
+{
+	switch (nbits)
+	{
+	case 16: return C3DImage::UINT_16;
+	case 32: return C3DImage::REAL_32;
+	}
+	return C3DImage::UINT_8;
+}
+
+static int bytesPerVoxel(int ntype)
+{
+	switch (ntype)
+	{
+	case C3DImage::UINT_16: return 2;
+	case C3DImage::REAL_32: return 4;
+	}
+	return 1;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -55,6 +83,13 @@ C3DImage::C3DImage()
 {
 	m_pb = 0;
 	m_cx = m_cy = m_cz = 0;
+	m_ntype = UINT_8;
+	m_bps = 1;
+	m_map = 0;
+	m_hmap = 0;
+	m_mapSize = 0;
+	m_dmin = 0.0; m_dmax = 255.0;
+	SetDisplayRange(0.0, 255.0);
 }
 
 C3DImage::~C3DImage()
@@ -64,66 +99,216 @@ C3DImage::~C3DImage()
 
 void C3DImage::CleanUp()
 {
-	delete [] m_pb;
+	if (m_map)
+	{
+#ifdef WIN32
+		UnmapViewOfFile(m_map);
+		CloseHandle((HANDLE)m_hmap);
+#else
+		munmap(m_map, m_mapSize);
+#endif
+		m_map = 0;
+		m_hmap = 0;
+		m_mapSize = 0;
+	}
+	else delete [] m_pb;
 	m_pb = 0;
 	m_cx = m_cy = m_cz = 0;
 }
 
-bool C3DImage::Create(int nx, int ny, int nz)
+bool C3DImage::Create(int nx, int ny, int nz, int pixelType)
 {
+	int bps = bytesPerVoxel(pixelType);
+
 	// reallocate data if necessary
-	if (nx*ny*nz != m_cx*m_cy*m_cz)
+	if ((m_map != 0) || ((size_t)nx*ny*nz*bps != (size_t)m_cx*m_cy*m_cz*m_bps))
 	{
 		CleanUp();
 
-		m_pb = new Byte[nx*ny*nz];
+		m_pb = new Byte[(size_t)nx*ny*nz*bps];
 		if (m_pb == 0) return false;
 	}
 
 	m_cx = nx;
 	m_cy = ny;
 	m_cz = nz;
+	m_ntype = pixelType;
+	m_bps = bps;
+
+	// set the default range for this pixel type
+	switch (m_ntype)
+	{
+	case UINT_8 : m_dmin = 0.0; m_dmax = 255.0; break;
+	case UINT_16: m_dmin = 0.0; m_dmax = 65535.0; break;
+	case REAL_32: m_dmin = 0.0; m_dmax = 1.0; break;
+	}
+	SetDisplayRange(m_dmin, m_dmax);
 
 	return true;
 }
 
 bool C3DImage::LoadFromFile(const char* szfile, int nbits)
 {
+	// make sure the buffer has the right type
+	if (Create(m_cx, m_cy, m_cz, pixelTypeFromBits(nbits)) == false) return false;
+
 	FILE* fp = fopen(szfile, "rb");
 	if (fp == 0) return false;
 
-	size_t nsize = m_cx*m_cy*m_cz;
-	if (nbits == 16)
+	size_t nsize = (size_t)m_cx*m_cy*m_cz;
+	size_t nread = fread(m_pb, m_bps, nsize, fp);
+
+	// cleanup
+	fclose(fp);
+
+	if (nsize != nread) return false;
+
+	UpdateValueRange();
+
+	return true;
+}
+
+bool C3DImage::MapFile(const char* szfile, int nx, int ny, int nz, int nbits)
+{
+	CleanUp();
+
+	int ntype = pixelTypeFromBits(nbits);
+	int bps = bytesPerVoxel(ntype);
+	size_t nsize = (size_t)nx*ny*nz*bps;
+
+	// The mapping is copy-on-write, so the image can still be modified
+	// without changing the file.
+#ifdef WIN32
+	HANDLE hf = CreateFileA(szfile, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (hf != INVALID_HANDLE_VALUE)
 	{
-		word* m_ptmp = new word[nsize];
-		size_t nread = fread(m_ptmp, sizeof(word), nsize, fp);
-		for(size_t i=0; i<nsize; i++)
-			m_pb[i] = m_ptmp[i] >> 8;
-		delete [] m_ptmp;
-		if (nsize != nread) return false;
+		LARGE_INTEGER fs;
+		if (GetFileSizeEx(hf, &fs) && ((size_t)fs.QuadPart >= nsize) && (nsize > 0))
+		{
+			HANDLE hm = CreateFileMappingA(hf, 0, PAGE_WRITECOPY, 0, 0, 0);
+			if (hm)
+			{
+				void* p = MapViewOfFile(hm, FILE_MAP_COPY, 0, 0, nsize);
+				if (p) { m_map = p; m_hmap = hm; }
+				else CloseHandle(hm);
+			}
+		}
+		CloseHandle(hf);
 	}
-	else
+#else
+	int fd = open(szfile, O_RDONLY);
+	if (fd >= 0)
 	{
-		size_t nread = fread(m_pb, 1, nsize, fp);
-		if (nsize != nread) return false;
+		struct stat st;
+		if ((fstat(fd, &st) == 0) && ((size_t)st.st_size >= nsize) && (nsize > 0))
+		{
+			void* p = mmap(0, nsize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) m_map = p;
+		}
+		close(fd);
 	}
+#endif
 
-	// cleanup
-	fclose(fp);
+	// if the mapping failed, we read the file
+	if (m_map == 0)
+	{
+		if (Create(nx, ny, nz, ntype) == false) return false;
+		return LoadFromFile(szfile, nbits);
+	}
+
+	m_pb = (Byte*)m_map;
+	m_mapSize = nsize;
+	m_cx = nx;
+	m_cy = ny;
+	m_cz = nz;
+	m_ntype = ntype;
+	m_bps = bps;
+
+	// Scanning the whole file would page all of it in, so the range is
+	// estimated from a subset of the rows.
+	UpdateValueRange(true);
 
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Find the range of the image values and use it as the display range.
+// 8-bit images always use the full range. If sampled is set, only up to
+// MAX_SAMPLES slices, and up to MAX_SAMPLES rows of those, are visited. Values
+// outside the estimated range are clamped by the display mapping.
+void C3DImage::UpdateValueRange(bool sampled)
+{
+	if (m_ntype == UINT_8)
+	{
+		m_dmin = 0.0;
+		m_dmax = 255.0;
+	}
+	else
+	{
+		const int MAX_SAMPLES = 64;
+		int NZ = m_cz;
+		int NY = m_cy;
+		int dk = 1, dj = 1;
+		if (sampled)
+		{
+			dk = (NZ + MAX_SAMPLES - 1) / MAX_SAMPLES;
+			dj = (NY + MAX_SAMPLES - 1) / MAX_SAMPLES;
+			if (dk < 1) dk = 1;
+			if (dj < 1) dj = 1;
+		}
+
+		int nk = (NZ + dk - 1) / dk;
+		size_t nrow = (size_t)m_cx;
+		float vmin = 0.f, vmax = 0.f;
+		if (NZ > 0) vmin = vmax = voxel(0, 0, 0);
+		#pragma omp parallel shared(vmin, vmax)
+		{
+			float tmin = vmin, tmax = vmax;
+			#pragma omp for
+			for (int n = 0; n < nk; ++n)
+			{
+				int k = n*dk;
+				for (int j = 0; j < NY; j += dj)
+				{
+					size_t m0 = nrow*((size_t)k*NY + j);
+					for (size_t m = m0; m < m0 + nrow; ++m)
+					{
+						float v = (m_ntype == UINT_16 ? (float)((word*)m_pb)[m] : ((float*)m_pb)[m]);
+						if (v < tmin) tmin = v;
+						if (v > tmax) tmax = v;
+					}
+				}
+			}
+
+			#pragma omp critical
+			{
+				if (tmin < vmin) vmin = tmin;
+				if (tmax > vmax) vmax = tmax;
+			}
+		}
+		m_dmin = vmin;
+		m_dmax = vmax;
+	}
+
+	SetDisplayRange(m_dmin, m_dmax);
+}
+
+void C3DImage::SetDisplayRange(double vmin, double vmax)
+{
+	m_vmin = vmin;
+	m_vmax = vmax;
+	m_off = (float)vmin;
+	m_scale = (vmax > vmin ? (float)(255.0 / (vmax - vmin)) : 0.f);
+}
+
 // BitBlt assumes that the 3D and 2D images have the same resolution !
 void C3DImage::BitBlt(CImage& im, int nslice)
 {
-	// go to the beginning of the slice
-	Byte* ps = m_pb + nslice*m_cx*m_cy;
 	Byte* pd = im.GetBytes();
 
 	// copy image data
-	int n = m_cx*m_cy;
-	for (int i=0; i<n; i++) *pd++ = *ps++;
+	for (int j = 0; j < m_cy; ++j)
+		for (int i = 0; i < m_cx; ++i) *pd++ = value(i, j, nslice);
 }
 
 void C3DImage::StretchBlt(CImage& im, int nslice)
@@ -136,7 +321,6 @@ void C3DImage::StretchBlt(CImage& im, int nslice)
 	int i0 = 0;
 	int j0 = 0;
 
-	Byte* p0, *p1, *p2, *p3;
 	int h0, h1, h2, h3;
 	int w = 0, h = 0;
 
@@ -151,21 +335,16 @@ void C3DImage::StretchBlt(CImage& im, int nslice)
 
 		while (y*(m_cy-1)>(j0+1)*(ny-1)) { j0++; h -= (ny-1); }
 
-		p0 = nslice*m_cx*m_cy + m_pb + (j0*m_cx);
-		p1 = p0 + 1;
-		p2 = p0 + m_cx;
-		p3 = p2 + 1;
-
 		for (int x=0; x<nx; x++)
 		{
-			while (x*(m_cx-1)>(i0+1)*(nx-1)) { i0++; w -= (nx-1); p0++; p1++; p2++; p3++; }
+			while (x*(m_cx-1)>(i0+1)*(nx-1)) { i0++; w -= (nx-1); }
 
 			h0 = (Hx - w)*(Hy - h);
 			h1 = w*(Hy - h);
 			h2 = (Hx - w)*h;
 			h3 = w*h;
 
-			*pd++ = (h0*p0[0] + h1*p1[0] + h2*p2[0] + h3*p3[0])/H;
+			*pd++ = (h0*value(i0, j0, nslice) + h1*value(i0 + 1, j0, nslice) + h2*value(i0, j0 + 1, nslice) + h3*value(i0 + 1, j0 + 1, nslice))/H;
 
 			w += (m_cx-1);
 		}
@@ -196,8 +375,6 @@ Byte C3DImage::Value(double fx, double fy, int nz)
 {
 	double r, s;
 
-	Byte* pb = m_pb + nz*m_cx*m_cy;
-
 	int ix = (int) ((m_cx-1)*fx);
 	int iy = (int) ((m_cy-1)*fy);
 
@@ -205,64 +382,61 @@ Byte C3DImage::Value(double fx, double fy, int nz)
 	if (iy == (m_cy - 1)) { iy--; s = 1; } else s = 2*(((m_cy-1)*fy) - iy)-1;
 
 	double h;
-	h  = (1-r)*(1-s)*pb[ix   +  iy   *m_cx];
-	h += (1+r)*(1-s)*pb[ix+1 +  iy   *m_cx];
-	h += (1+r)*(1+s)*pb[ix+1 + (iy+1)*m_cx];
-	h += (1-r)*(1+s)*pb[ix   + (iy+1)*m_cx];
+	h  = (1-r)*(1-s)*voxel(ix  , iy  , nz);
+	h += (1+r)*(1-s)*voxel(ix+1, iy  , nz);
+	h += (1+r)*(1+s)*voxel(ix+1, iy+1, nz);
+	h += (1-r)*(1+s)*voxel(ix  , iy+1, nz);
 
-	return (Byte)(0.25*h);
+	return ToByte((float)(0.25*h));
 }
 
 Byte C3DImage::Peek(double r, double s, double t)
 {
-	static int n1,n2,n3,n4,n5,n6,n7,n8;
-	static double h1,h2,h3,h4,h5,h6,h7,h8;
-
-	if (r < 0) r = 0; if (r > 1) r = 1;
-	if (s < 0) s = 0; if (s > 1) s = 1;
-	if (t < 0) t = 0; if (t > 1) t = 1;
+	if (r < 0) r = 0;
+	if (r > 1) r = 1;
+	if (s < 0) s = 0;
+	if (s > 1) s = 1;
+	if (t < 0) t = 0;
+	if (t > 1) t = 1;
 
 	int i = (int)(r*(m_cx-1)); if (i == (m_cx - 1)) i = m_cx - 2;
 	int j = (int)(s*(m_cy-1)); if (j == (m_cy - 1)) j = m_cy - 2;
 	int k = (int)(t*(m_cz-1)); if (k == (m_cz - 1)) k = m_cz - 2;
+	if (i < 0) i = 0;
+	if (j < 0) j = 0;
+	if (k < 0) k = 0;
 
 	r = 2.0*(r*(m_cx-1) - i) - 1.0;
 	s = 2.0*(s*(m_cy-1) - j) - 1.0;
 	t = 2.0*(t*(m_cz-1) - k) - 1.0;
 
-	n1 = i + j*m_cx + k*m_cx*m_cy;
-	n2 = n1 + 1;
-	n3 = n2 + m_cx;
-	n4 = n3 - 1;
-	n5 = n1 + (m_cz > 1 ? m_cx*m_cy : 0);
-	n6 = n5 + 1;
-	n7 = n6 + m_cx;
-	n8 = n7 - 1;
-
-	h1 = (1-r)*(1-s)*(1-t);
-	h2 = (1+r)*(1-s)*(1-t);
-	h3 = (1+r)*(1+s)*(1-t);
-	h4 = (1-r)*(1+s)*(1-t);
-	h5 = (1-r)*(1-s)*(1+t);
-	h6 = (1+r)*(1-s)*(1+t);
-	h7 = (1+r)*(1+s)*(1+t);
-	h8 = (1-r)*(1+s)*(1+t);
-	
-	Byte* pb = m_pb;
-
-	return (Byte)((h1*pb[n1]+h2*pb[n2]+h3*pb[n3]+h4*pb[n4]+h5*pb[n5]+h6*pb[n6]+h7*pb[n7]+h8*pb[n8])*0.125);
+	int i1 = (m_cx > 1 ? i + 1 : i);
+	int j1 = (m_cy > 1 ? j + 1 : j);
+	int k1 = (m_cz > 1 ? k + 1 : k);
+
+	double h1 = (1-r)*(1-s)*(1-t);
+	double h2 = (1+r)*(1-s)*(1-t);
+	double h3 = (1+r)*(1+s)*(1-t);
+	double h4 = (1-r)*(1+s)*(1-t);
+	double h5 = (1-r)*(1-s)*(1+t);
+	double h6 = (1+r)*(1-s)*(1+t);
+	double h7 = (1+r)*(1+s)*(1+t);
+	double h8 = (1-r)*(1+s)*(1+t);
+
+	double v = h1*voxel(i, j , k ) + h2*voxel(i1, j , k ) + h3*voxel(i1, j1, k ) + h4*voxel(i, j1, k )
+	         + h5*voxel(i, j , k1) + h6*voxel(i1, j , k1) + h7*voxel(i1, j1, k1) + h8*voxel(i, j1, k1);
+
+	return ToByte((float)(v*0.125));
 }
 
 
 void C3DImage::Histogram(int* pdf)
 {
-	int i;
-	for (i=0; i<256; i++) pdf[i] = 0;
-
-	Byte* pb = m_pb;
-	int nsize = m_cx*m_cy*m_cz;
+	for (int i=0; i<256; i++) pdf[i] = 0;
 
-	for (i=0; i<nsize; i++) pdf[ *pb++ ]++;
+	for (int k = 0; k < m_cz; ++k)
+		for (int j = 0; j < m_cy; ++j)
+			for (int i = 0; i < m_cx; ++i) pdf[value(i, j, k)]++;
 }
 
 void C3DImage::GetSliceX(CImage& im, int n)
@@ -270,15 +444,11 @@ void C3DImage::GetSliceX(CImage& im, int n)
 	// create image data
 	if ((im.Width() != m_cy) || (im.Height() != m_cz)) im.Create(m_cy, m_cz);
 
-	Byte* ps;
 	Byte* pd = im.GetBytes();
 
 	// copy image data
 	for (int z=0; z<m_cz; z++)
-	{
-		ps = m_pb + z*m_cx*m_cy + n;
-		for (int y=0; y<m_cy; y++, ps += m_cx)	*pd++ = *ps;
-	}
+		for (int y=0; y<m_cy; y++) *pd++ = value(n, y, z);
 }
 
 void C3DImage::GetSliceY(CImage& im, int n)
@@ -286,15 +456,11 @@ void C3DImage::GetSliceY(CImage& im, int n)
 	// create image data
 	if ((im.Width() != m_cx) || (im.Height() != m_cz)) im.Create(m_cx, m_cz);
 
-	Byte* ps;
 	Byte* pd = im.GetBytes();
 
 	// copy image data
 	for (int z=0; z<m_cz; z++)
-	{
-		ps = m_pb + z*m_cx*m_cy + n*m_cx;
-		for (int x=0; x<m_cx; x++, ps++) *pd++ = *ps;
-	}
+		for (int x=0; x<m_cx; x++) *pd++ = value(x, n, z);
 }
 
 void C3DImage::GetSliceZ(CImage& im, int n)
@@ -304,25 +470,26 @@ void C3DImage::GetSliceZ(CImage& im, int n)
 
 	// copy image data
 	Byte* pd = im.GetBytes();
-	Byte* ps = m_pb + n*m_cx*m_cy;
-
-	for (int i=0; i<m_cx*m_cy; i++, ps++) *pd++ = *ps;
+	for (int y = 0; y < m_cy; y++)
+		for (int x = 0; x < m_cx; x++) *pd++ = value(x, y, n);
 }
 
 void C3DImage::GetSampledSliceX(CImage& im, double f)
 {
 	// create image data
-	if ((im.Width() != m_cy) || (im.Height() != m_cz)) im.Create(m_cy, m_cz);
+	if (im.Width()*im.Height() == 0) im.Create(m_cy, m_cz);
+	int W = im.Width();
+	int H = im.Height();
 
 	Byte* pd = im.GetBytes();
 
 	// copy image data
-	for (int z = 0; z<m_cz; z++)
+	for (int z = 0; z<H; z++)
 	{
-		double fz = z / (double) (m_cz - 1.0);
-		for (int y = 0; y<m_cy; y++)
+		double fz = (H > 1 ? z / (double) (H - 1.0) : 0.0);
+		for (int y = 0; y<W; y++)
 		{
-			double fy = y / (double) (m_cy - 1.0);
+			double fy = (W > 1 ? y / (double) (W - 1.0) : 0.0);
 			*pd++ = Peek(f, fy, fz);
 		}
 	}
@@ -331,17 +498,19 @@ void C3DImage::GetSampledSliceX(CImage& im, double f)
 void C3DImage::GetSampledSliceY(CImage& im, double f)
 {
 	// create image data
-	if ((im.Width() != m_cx) || (im.Height() != m_cz)) im.Create(m_cx, m_cz);
+	if (im.Width()*im.Height() == 0) im.Create(m_cx, m_cz);
+	int W = im.Width();
+	int H = im.Height();
 
 	Byte* pd = im.GetBytes();
 
 	// copy image data
-	for (int z = 0; z<m_cz; z++)
+	for (int z = 0; z<H; z++)
 	{
-		double fz = z / (double)(m_cz - 1.0);
-		for (int x = 0; x<m_cx; x++)
+		double fz = (H > 1 ? z / (double)(H - 1.0) : 0.0);
+		for (int x = 0; x<W; x++)
 		{
-			double fx = x / (double)(m_cx - 1.0);
+			double fx = (W > 1 ? x / (double)(W - 1.0) : 0.0);
 			*pd++ = Peek(fx, f, fz);
 		}
 	}
@@ -350,17 +519,19 @@ void C3DImage::GetSampledSliceY(CImage& im, double f)
 void C3DImage::GetSampledSliceZ(CImage& im, double f)
 {
 	// create image data
-	if ((im.Width() != m_cx) || (im.Height() != m_cy)) im.Create(m_cx, m_cy);
+	if (im.Width()*im.Height() == 0) im.Create(m_cx, m_cy);
+	int W = im.Width();
+	int H = im.Height();
 
 	// copy image data
 	Byte* pd = im.GetBytes();
 
-	for (int y = 0; y<m_cy; y++)
+	for (int y = 0; y<H; y++)
 	{
-		double fy = y / (double)(m_cy - 1.0);
-		for (int x = 0; x<m_cx; x++)
+		double fy = (H > 1 ? y / (double)(H - 1.0) : 0.0);
+		for (int x = 0; x<W; x++)
 		{
-			double fx = x / (double)(m_cx - 1.0);
+			double fx = (W > 1 ? x / (double)(W - 1.0) : 0.0);
 			*pd++ = Peek(fx, fy, f);
 		}
 	}
@@ -368,19 +539,24 @@ void C3DImage::GetSampledSliceZ(CImage& im, double f)
 
 void C3DImage::Invert()
 {
-	int n = m_cx*m_cy*m_cz;
-	for (int i=0; i<n; i++) m_pb[i] = 255 - m_pb[i];
+	size_t n = (size_t)m_cx*m_cy*m_cz;
+	switch (m_ntype)
+	{
+	case UINT_8 : for (size_t i = 0; i < n; i++) m_pb[i] = 255 - m_pb[i]; break;
+	case UINT_16: { word* pw = (word*)m_pb; for (size_t i = 0; i < n; i++) pw[i] = 65535 - pw[i]; } break;
+	case REAL_32: { float* pf = (float*)m_pb; for (size_t i = 0; i < n; i++) pf[i] = -pf[i]; } break;
+	}
+	UpdateValueRange();
 }
 
 void C3DImage::Zero()
 {
-	int n = m_cx*m_cy*m_cz;
-	for (int i=0; i<n; i++) m_pb[i] = 0;
+	memset(m_pb, 0, (size_t)m_cx*m_cy*m_cz*m_bps);
 }
 
 void C3DImage::FlipZ()
 {
-	int nsize = m_cx*m_cy;
+	size_t nsize = (size_t)m_cx*m_cy*m_bps;
 	Byte* buf = new Byte[nsize];
 	for (int i = 0; i < m_cz / 2; ++i)
 	{
@@ -392,4 +568,3 @@ void C3DImage::FlipZ()
 	}
     delete[] buf;
 }
-
@@ -26,20 +26,32 @@ SOFTWARE.*/
 
 #pragma once
 #include "Image.h"
+#include <stddef.h>
 
 //-----------------------------------------------------------------------------
-// A class for representing 3D image stacks
+// A class for representing 3D image stacks.
+// The voxels are stored in their native type (8-bit, 16-bit or float). The
+// display range maps the voxel values to the 0-255 range that is used for
+// rendering, so the window can be changed without reloading the data.
 class C3DImage
 {
+public:
+	enum PixelType { UINT_8, UINT_16, REAL_32 };
+
 public:
 	C3DImage();
 	virtual ~C3DImage();
 	void CleanUp();
 
-	bool Create(int nx, int ny, int nz);
+	bool Create(int nx, int ny, int nz, int pixelType = UINT_8);
 
+	// read the data from file (nbits = 8, 16, or 32 (float))
 	bool LoadFromFile(const char* szfile, int nbits);
 
+	// map the file into memory instead of reading it. Falls back to LoadFromFile
+	// if the file cannot be mapped.
+	bool MapFile(const char* szfile, int nx, int ny, int nz, int nbits);
+
 	void BitBlt(CImage& im, int nslice);
 	void StretchBlt(CImage& im, int nslice);
 	void StretchBlt(C3DImage& im);
@@ -48,33 +60,80 @@ public:
 	int Height() { return m_cy; }
 	int Depth () { return m_cz; }
 
-	Byte& value(int i, int j, int k) { return m_pb[m_cx*(k*m_cy + j) + i]; }
+	int PixelType() const { return m_ntype; }
+	int BytesPerVoxel() const { return m_bps; }
+
+	// the voxel value in its native type
+	float voxel(int i, int j, int k) const
+	{
+		size_t n = (size_t)m_cx*((size_t)k*m_cy + j) + i;
+		switch (m_ntype)
+		{
+		case UINT_16: return (float)((word*)m_pb)[n];
+		case REAL_32: return ((float*)m_pb)[n];
+		default:
+			return (float)m_pb[n];
+		}
+	}
+
+	// the voxel value mapped to the display range
+	Byte value(int i, int j, int k) const { return ToByte(voxel(i, j, k)); }
 	Byte Value(double fx, double fy, int nz);
 	Byte Peek(double fx, double fy, double fz);
 
+	// map a native value to the display range
+	Byte ToByte(float v) const
+	{
+		float f = (v - m_off)*m_scale;
+		return (f <= 0.f ? 0 : (f >= 255.f ? 255 : (Byte)f));
+	}
+
+	// the range of the voxel values in the image
+	void GetValueRange(double& vmin, double& vmax) const { vmin = m_dmin; vmax = m_dmax; }
+
+	// the range of voxel values that is mapped to 0 - 255
+	void SetDisplayRange(double vmin, double vmax);
+	void GetDisplayRange(double& vmin, double& vmax) const { vmin = m_vmin; vmax = m_vmax; }
+
 	void Histogram(int* pdf);
 
 	void GetSliceX(CImage& im, int n);
 	void GetSliceY(CImage& im, int n);
 	void GetSliceZ(CImage& im, int n);
 
+	// If the image was already created, the slice is resampled to its size
 	void GetSampledSliceX(CImage& im, double f);
 	void GetSampledSliceY(CImage& im, double f);
 	void GetSampledSliceZ(CImage& im, double f);
 
 	void Invert();
 
+	// raw voxel data
 	Byte* GetBytes() { return m_pb; }
 
 	void Zero();
 
 	void FlipZ();
 
+protected:
+	void UpdateValueRange(bool sampled = false);
+
 protected:
 	Byte*	m_pb;	// image data
 	int		m_cx;
 	int		m_cy;
 	int		m_cz;
+
+	int		m_ntype;	// pixel type
+	int		m_bps;		// bytes per voxel
+
+	double	m_dmin, m_dmax;		// range of image data
+	double	m_vmin, m_vmax;		// display range
+	float	m_off, m_scale;		// display mapping: (v - m_off)*m_scale
+
+	void*	m_map;		// file mapping (data is not owned when set)
+	void*	m_hmap;		// mapping handle (Windows only)
+	size_t	m_mapSize;
 };
 
 //-----------------------------------------------------------------------------
@@ -0,0 +1,433 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "stdafx.h"
+#include "BrickedImage.h"
+#include <assert.h>
+#include <string.h>
+
+//-----------------------------------------------------------------------------
+// default size of the brick cache
+static const size_t DEFAULT_CACHE_SIZE = (size_t)512 * 1024 * 1024;
+
+//-----------------------------------------------------------------------------
+CBrickedImage::CBrickedImage()
+{
+	m_im = nullptr;
+	m_bs = DEFAULT_BRICK_SIZE;
+	m_cacheSize = DEFAULT_CACHE_SIZE;
+	m_usedSize = 0;
+	m_stamp = 0;
+	m_lastKey = 0;
+	m_lastBrick = nullptr;
+}
+
+CBrickedImage::~CBrickedImage()
+{
+	Clear();
+}
+
+void CBrickedImage::Clear()
+{
+	m_im = nullptr;
+	m_level.clear();
+	m_brick.clear();
+	m_usedSize = 0;
+	m_stamp = 0;
+	m_lastKey = 0;
+	m_lastBrick = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+void CBrickedImage::Create(C3DImage* im, int brickSize)
+{
+	Clear();
+	m_im = im;
+	m_bs = (brickSize > 1 ? brickSize : DEFAULT_BRICK_SIZE);
+	if (im == nullptr) return;
+
+	// keep halving the resolution until the level fits in a single brick
+	int nx = im->Width();
+	int ny = im->Height();
+	int nz = im->Depth();
+	int l = 0;
+	while (true)
+	{
+		LEVEL lev;
+		lev.nx = ((nx - 1) >> l) + 1;
+		lev.ny = ((ny - 1) >> l) + 1;
+		lev.nz = ((nz - 1) >> l) + 1;
+		lev.bx = (lev.nx + m_bs - 1) / m_bs;
+		lev.by = (lev.ny + m_bs - 1) / m_bs;
+		lev.bz = (lev.nz + m_bs - 1) / m_bs;
+		m_level.push_back(lev);
+
+		if ((lev.bx == 1) && (lev.by == 1) && (lev.bz == 1)) break;
+		l++;
+	}
+}
+
+//-----------------------------------------------------------------------------
+int CBrickedImage::FindLevel(int maxSize) const
+{
+	for (int l = 0; l < (int)m_level.size(); ++l)
+	{
+		const LEVEL& lev = m_level[l];
+		if ((lev.nx <= maxSize) && (lev.ny <= maxSize) && (lev.nz <= maxSize)) return l;
+	}
+	return (int)m_level.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+void CBrickedImage::SetCacheSize(size_t bytes)
+{
+	m_cacheSize = bytes;
+	Trim(m_cacheSize);
+}
+
+//-----------------------------------------------------------------------------
+float CBrickedImage::voxel(int l, int i, int j, int k)
+{
+	// level 0 is the image itself
+	if (l == 0) return m_im->voxel(i, j, k);
+
+	int bi = i / m_bs, bj = j / m_bs, bk = k / m_bs;
+	const float* pb = GetBrick(l, bi, bj, bk);
+	int li = i - bi*m_bs;
+	int lj = j - bj*m_bs;
+	int lk = k - bk*m_bs;
+	return pb[(lk*m_bs + lj)*m_bs + li];
+}
+
+//-----------------------------------------------------------------------------
+// Find the brick in the cache or build it.
+const float* CBrickedImage::GetBrick(int l, int bi, int bj, int bk)
+{
+	assert((l > 0) && (l < (int)m_level.size()));
+	unsigned long long key = ((unsigned long long)l << 48) | ((unsigned long long)bk << 32) | ((unsigned long long)bj << 16) | (unsigned long long)bi;
+	if (m_lastBrick && (key == m_lastKey)) return m_lastBrick;
+
+	std::map<unsigned long long, BRICK>::iterator it = m_brick.find(key);
+	if (it == m_brick.end())
+	{
+		// Build the brick before it is inserted, since this can load (and evict)
+		// bricks of the finer levels.
+		BRICK b;
+		b.data.resize((size_t)m_bs*m_bs*m_bs);
+		BuildBrick(l, bi, bj, bk, &b.data[0]);
+
+		// make room for the new brick
+		size_t bytes = (size_t)m_bs*m_bs*m_bs*sizeof(float);
+		Trim(m_cacheSize > bytes ? m_cacheSize - bytes : 0);
+
+		it = m_brick.insert(std::make_pair(key, BRICK())).first;
+		it->second.data.swap(b.data);
+		m_usedSize += bytes;
+	}
+	it->second.stamp = ++m_stamp;
+
+	m_lastKey = key;
+	m_lastBrick = &it->second.data[0];
+	return m_lastBrick;
+}
+
+//-----------------------------------------------------------------------------
+// Remove the least recently used bricks until the cache does not exceed maxBytes.
+void CBrickedImage::Trim(size_t maxBytes)
+{
+	size_t bytes = (size_t)m_bs*m_bs*m_bs*sizeof(float);
+	while ((m_usedSize > maxBytes) && (m_brick.empty() == false))
+	{
+		std::map<unsigned long long, BRICK>::iterator oldest = m_brick.begin();
+		for (std::map<unsigned long long, BRICK>::iterator it = m_brick.begin(); it != m_brick.end(); ++it)
+		{
+			if (it->second.stamp < oldest->second.stamp) oldest = it;
+		}
+		m_brick.erase(oldest);
+		m_usedSize -= bytes;
+	}
+	m_lastBrick = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// Each voxel of level l is the average of the 2x2x2 block of voxels of level l-1 it
+// covers, so that every level only reads the previous one. Level 1 reads the image.
+void CBrickedImage::BuildBrick(int l, int bi, int bj, int bk, float* pd)
+{
+	const LEVEL& lev = m_level[l];
+	int bs = m_bs;
+
+	// the voxels of the previous level covered by this brick
+	const float* src = nullptr;
+	int NX, NY, NZ;
+	int sx = 0, sy = 0, sz = 0;
+	std::vector<float> block;
+	if (l == 1)
+	{
+		NX = m_im->Width();
+		NY = m_im->Height();
+		NZ = m_im->Depth();
+	}
+	else
+	{
+		const LEVEL& prv = m_level[l - 1];
+		NX = prv.nx;
+		NY = prv.ny;
+		NZ = prv.nz;
+
+		// copy the (up to) eight bricks of the previous level into one block
+		int bs2 = 2 * bs;
+		block.assign((size_t)bs2*bs2*bs2, 0.f);
+		for (int dk = 0; dk < 2; ++dk)
+			for (int dj = 0; dj < 2; ++dj)
+				for (int di = 0; di < 2; ++di)
+				{
+					int ci = 2 * bi + di, cj = 2 * bj + dj, ck = 2 * bk + dk;
+					if ((ci >= prv.bx) || (cj >= prv.by) || (ck >= prv.bz)) continue;
+
+					const float* pc = GetBrick(l - 1, ci, cj, ck);
+					for (int lk = 0; lk < bs; ++lk)
+						for (int lj = 0; lj < bs; ++lj)
+						{
+							const float* ps = pc + (lk*bs + lj)*bs;
+							float* pt = &block[0] + ((size_t)(dk*bs + lk)*bs2 + dj*bs + lj)*bs2 + di*bs;
+							for (int li = 0; li < bs; ++li) pt[li] = ps[li];
+						}
+				}
+		src = &block[0];
+		sx = 2 * bi*bs;
+		sy = 2 * bj*bs;
+		sz = 2 * bk*bs;
+	}
+
+#pragma omp parallel for default(shared)
+	for (int lk = 0; lk < bs; ++lk)
+	{
+		int k = bk*bs + lk;
+		for (int lj = 0; lj < bs; ++lj)
+		{
+			int j = bj*bs + lj;
+			float* p = pd + (lk*bs + lj)*bs;
+			for (int li = 0; li < bs; ++li, ++p)
+			{
+				int i = bi*bs + li;
+				if ((i >= lev.nx) || (j >= lev.ny) || (k >= lev.nz)) { *p = 0.f; continue; }
+
+				int i0 = 2*i, i1 = i0 + 2; if (i1 > NX) i1 = NX;
+				int j0 = 2*j, j1 = j0 + 2; if (j1 > NY) j1 = NY;
+				int k0 = 2*k, k1 = k0 + 2; if (k1 > NZ) k1 = NZ;
+
+				double sum = 0.0;
+				for (int z = k0; z < k1; ++z)
+					for (int y = j0; y < j1; ++y)
+						for (int x = i0; x < i1; ++x)
+						{
+							if (src) sum += src[((size_t)(z - sz)*2*bs + (y - sy))*2*bs + (x - sx)];
+							else sum += m_im->voxel(x, y, z);
+						}
+
+				*p = (float)(sum / ((i1 - i0)*(j1 - j0)*(k1 - k0)));
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// trilinear interpolation at a level (same as C3DImage::Peek)
+Byte CBrickedImage::Peek(int l, double r, double s, double t)
+{
+	const LEVEL& lev = m_level[l];
+	int nx = lev.nx, ny = lev.ny, nz = lev.nz;
+
+	if (r < 0) r = 0;
+	if (r > 1) r = 1;
+	if (s < 0) s = 0;
+	if (s > 1) s = 1;
+	if (t < 0) t = 0;
+	if (t > 1) t = 1;
+
+	int i = (int)(r*(nx - 1)); if (i > nx - 2) i = nx - 2; if (i < 0) i = 0;
+	int j = (int)(s*(ny - 1)); if (j > ny - 2) j = ny - 2; if (j < 0) j = 0;
+	int k = (int)(t*(nz - 1)); if (k > nz - 2) k = nz - 2; if (k < 0) k = 0;
+	int i1 = (nx > 1 ? i + 1 : i);
+	int j1 = (ny > 1 ? j + 1 : j);
+	int k1 = (nz > 1 ? k + 1 : k);
+
+	double fr = (nx > 1 ? r*(nx - 1) - i : 0.0);
+	double fs = (ny > 1 ? s*(ny - 1) - j : 0.0);
+	double ft = (nz > 1 ? t*(nz - 1) - k : 0.0);
+
+	double v = 0.0;
+	v += (1 - fr)*(1 - fs)*(1 - ft)*voxel(l, i , j , k );
+	v += (    fr)*(1 - fs)*(1 - ft)*voxel(l, i1, j , k );
+	v += (    fr)*(    fs)*(1 - ft)*voxel(l, i1, j1, k );
+	v += (1 - fr)*(    fs)*(1 - ft)*voxel(l, i , j1, k );
+	v += (1 - fr)*(1 - fs)*(    ft)*voxel(l, i , j , k1);
+	v += (    fr)*(1 - fs)*(    ft)*voxel(l, i1, j , k1);
+	v += (    fr)*(    fs)*(    ft)*voxel(l, i1, j1, k1);
+	v += (1 - fr)*(    fs)*(    ft)*voxel(l, i , j1, k1);
+
+	return m_im->ToByte((float)v);
+}
+
+//-----------------------------------------------------------------------------
+void CBrickedImage::GetSampledSliceX(CImage& im, double f, int l)
+{
+	if (l == 0) { m_im->GetSampledSliceX(im, f); return; }
+
+	int W = im.Width();
+	int H = im.Height();
+	Byte* pd = im.GetBytes();
+	for (int z = 0; z < H; z++)
+	{
+		double fz = (H > 1 ? z / (double)(H - 1.0) : 0.0);
+		for (int y = 0; y < W; y++)
+		{
+			double fy = (W > 1 ? y / (double)(W - 1.0) : 0.0);
+			*pd++ = Peek(l, f, fy, fz);
+		}
+	}
+}
+
+void CBrickedImage::GetSampledSliceY(CImage& im, double f, int l)
+{
+	if (l == 0) { m_im->GetSampledSliceY(im, f); return; }
+
+	int W = im.Width();
+	int H = im.Height();
+	Byte* pd = im.GetBytes();
+	for (int z = 0; z < H; z++)
+	{
+		double fz = (H > 1 ? z / (double)(H - 1.0) : 0.0);
+		for (int x = 0; x < W; x++)
+		{
+			double fx = (W > 1 ? x / (double)(W - 1.0) : 0.0);
+			*pd++ = Peek(l, fx, f, fz);
+		}
+	}
+}
+
+void CBrickedImage::GetSampledSliceZ(CImage& im, double f, int l)
+{
+	if (l == 0) { m_im->GetSampledSliceZ(im, f); return; }
+
+	int W = im.Width();
+	int H = im.Height();
+	Byte* pd = im.GetBytes();
+	for (int y = 0; y < H; y++)
+	{
+		double fy = (H > 1 ? y / (double)(H - 1.0) : 0.0);
+		for (int x = 0; x < W; x++)
+		{
+			double fx = (W > 1 ? x / (double)(W - 1.0) : 0.0);
+			*pd++ = Peek(l, fx, fy, f);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Copy the layers [k0, k1) of a level into an image, brick by brick. Integer
+// values are rounded. Only the bricks that intersect these layers are loaded.
+bool CBrickedImage::GetLayers(int l, int k0, int k1, C3DImage& im)
+{
+	if ((m_im == nullptr) || (l < 0) || (l >= (int)m_level.size())) return false;
+
+	const LEVEL& lev = m_level[l];
+	if (k0 < 0) k0 = 0;
+	if (k1 > lev.nz) k1 = lev.nz;
+	if (k1 <= k0) return false;
+
+	int type = m_im->PixelType();
+	int nz = k1 - k0;
+	if ((im.Width() != lev.nx) || (im.Height() != lev.ny) || (im.Depth() != nz) || (im.PixelType() != type))
+	{
+		if (im.Create(lev.nx, lev.ny, nz, type) == false) return false;
+	}
+
+	double vmin, vmax;
+	m_im->GetDisplayRange(vmin, vmax);
+	im.SetDisplayRange(vmin, vmax);
+
+	Byte* pb = im.GetBytes();
+
+	// level 0 is the image itself
+	if (l == 0)
+	{
+		size_t nslice = (size_t)lev.nx*lev.ny*m_im->BytesPerVoxel();
+		memcpy(pb, m_im->GetBytes() + nslice*k0, nslice*nz);
+		return true;
+	}
+
+	for (int bk = k0 / m_bs; bk <= (k1 - 1) / m_bs; ++bk)
+		for (int bj = 0; bj < lev.by; ++bj)
+			for (int bi = 0; bi < lev.bx; ++bi)
+			{
+				const float* ps = GetBrick(l, bi, bj, bk);
+
+				int ni = lev.nx - bi*m_bs; if (ni > m_bs) ni = m_bs;
+				int nj = lev.ny - bj*m_bs; if (nj > m_bs) nj = m_bs;
+				int lk0 = k0 - bk*m_bs; if (lk0 < 0) lk0 = 0;
+				int lk1 = k1 - bk*m_bs; if (lk1 > m_bs) lk1 = m_bs;
+				for (int lk = lk0; lk < lk1; ++lk)
+					for (int lj = 0; lj < nj; ++lj)
+					{
+						const float* p = ps + (lk*m_bs + lj)*m_bs;
+						size_t n = (size_t)lev.nx*((size_t)(bk*m_bs + lk - k0)*lev.ny + bj*m_bs + lj) + bi*m_bs;
+						switch (type)
+						{
+						case C3DImage::UINT_8 : for (int li = 0; li < ni; ++li) pb[n + li] = (Byte)(p[li] + 0.5f); break;
+						case C3DImage::UINT_16: for (int li = 0; li < ni; ++li) ((word*)pb)[n + li] = (word)(p[li] + 0.5f); break;
+						case C3DImage::REAL_32: for (int li = 0; li < ni; ++li) ((float*)pb)[n + li] = p[li]; break;
+						}
+					}
+			}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void CBrickedImage::StretchBlt(C3DImage& im, int l)
+{
+	if (l == 0) { m_im->StretchBlt(im); return; }
+
+	int nx = im.Width();
+	int ny = im.Height();
+	int nz = im.Depth();
+	Byte* pb = im.GetBytes();
+	for (int k = 0; k < nz; ++k)
+	{
+		double t = (nz > 1 ? k / (double)(nz - 1) : 0.0);
+		for (int j = 0; j < ny; ++j)
+		{
+			double s = (ny > 1 ? j / (double)(ny - 1) : 0.0);
+			for (int i = 0; i < nx; ++i, ++pb)
+			{
+				double r = (nx > 1 ? i / (double)(nx - 1) : 0.0);
+				*pb = Peek(l, r, s, t);
+			}
+		}
+	}
+}
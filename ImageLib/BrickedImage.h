@@ -0,0 +1,118 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include "3DImage.h"
+#include <map>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// A multi-resolution view of a (usually memory-mapped) 3D image.
+// Level 0 is the image itself. Each following level halves the resolution. The
+// coarser levels are divided into cubic bricks that are only computed when they
+// are accessed, and are kept in a cache of limited size. This way, a very large
+// image can be queried at a lower resolution without ever holding it in memory.
+class CBrickedImage
+{
+public:
+	enum { DEFAULT_BRICK_SIZE = 64 };
+
+public:
+	CBrickedImage();
+	~CBrickedImage();
+
+	// build the pyramid for this image. The image is not owned.
+	void Create(C3DImage* im, int brickSize = DEFAULT_BRICK_SIZE);
+	void Clear();
+
+	C3DImage* GetImage() { return m_im; }
+
+	// resolution levels
+	int Levels() const { return (int)m_level.size(); }
+	int Width (int l) const { return m_level[l].nx; }
+	int Height(int l) const { return m_level[l].ny; }
+	int Depth (int l) const { return m_level[l].nz; }
+
+	// the finest level that does not exceed maxSize in any direction
+	int FindLevel(int maxSize) const;
+
+	// the voxel value at a level. This loads the brick if necessary.
+	float voxel(int l, int i, int j, int k);
+	Byte value(int l, int i, int j, int k) { return m_im->ToByte(voxel(l, i, j, k)); }
+
+	// Sample a slice from a level. The image must have been created. Only the
+	// bricks that intersect the slice are loaded.
+	void GetSampledSliceX(CImage& im, double f, int l);
+	void GetSampledSliceY(CImage& im, double f, int l);
+	void GetSampledSliceZ(CImage& im, double f, int l);
+
+	// Copy the layers k0 <= k < k1 of a level into an image (of the same pixel
+	// type and display range), so that a level can be processed a slab at a time.
+	bool GetLayers(int l, int k0, int k1, C3DImage& im);
+
+	// resample a level to the size of im (as C3DImage::StretchBlt)
+	void StretchBlt(C3DImage& im, int l);
+
+	int BrickSize() const { return m_bs; }
+
+	// maximum memory used by the cached bricks (in bytes)
+	void SetCacheSize(size_t bytes);
+	size_t CacheSize() const { return m_cacheSize; }
+
+	int LoadedBricks() const { return (int)m_brick.size(); }
+
+private:
+	struct LEVEL
+	{
+		int	nx, ny, nz;		// dimensions
+		int	bx, by, bz;		// number of bricks
+	};
+
+	struct BRICK
+	{
+		std::vector<float>	data;
+		unsigned int		stamp;	// last access
+	};
+
+	const float* GetBrick(int l, int bi, int bj, int bk);
+	void BuildBrick(int l, int bi, int bj, int bk, float* pd);
+	void Trim(size_t maxBytes);
+	Byte Peek(int l, double r, double s, double t);
+
+private:
+	C3DImage*	m_im;
+	int			m_bs;	// brick size
+	std::vector<LEVEL>	m_level;
+
+	std::map<unsigned long long, BRICK>	m_brick;
+	size_t			m_cacheSize;
+	size_t			m_usedSize;
+	unsigned int	m_stamp;
+
+	// last accessed brick
+	unsigned long long	m_lastKey;
+	const float*		m_lastBrick;
+};
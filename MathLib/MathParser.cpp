@@ -34,6 +34,29 @@ SOFTWARE.*/
 #include "string.h"
 #include "ctype.h"
 
+// the functions that can be used in expressions
+typedef double (*MATH_FNC)(double);
+static const char* fncName[] = { "cos", "sin", "tan", "ln", "log", "sqrt", "exp" };
+static MATH_FNC    fncPtr [] = {  cos,   sin,   tan,   log,  log10,  sqrt,   exp  };
+static const int   MAX_FNC = sizeof(fncPtr) / sizeof(MATH_FNC);
+
+// find a function by name (returns -1 if not found)
+static int find_function(const char* szname)
+{
+	for (int i = 0; i < MAX_FNC; ++i)
+		if (strcmp(szname, fncName[i]) == 0) return i;
+	return -1;
+}
+
+// nr of points that are evaluated together by CMathProgram::eval
+const int MATH_BLOCK = 64;
+
+// don't evaluate in parallel for fewer points than this
+const int MATH_MIN_PARALLEL = 4096;
+
+// programs that need a larger stack allocate it on the heap
+const int MATH_SMALL_STACK = 32;
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -149,15 +172,8 @@ double CMathParser::prim()
 			{
 				// check for functions
 
-				double (*fnc)(double) = 0;
-
-				if (strcmp(string_value, "cos" )==0) fnc = cos;
-				if (strcmp(string_value, "sin" )==0) fnc = sin;
-				if (strcmp(string_value, "tan" )==0) fnc = tan;
-				if (strcmp(string_value, "ln"  )==0) fnc = log;
-				if (strcmp(string_value, "log" )==0) fnc = log10;
-				if (strcmp(string_value, "sqrt")==0) fnc = sqrt;
-				if (strcmp(string_value, "exp" )==0) fnc = exp;
+				int nf = find_function(string_value);
+				MATH_FNC fnc = (nf >= 0 ? fncPtr[nf] : 0);
 
 				get_token();
 
@@ -186,6 +202,163 @@ double CMathParser::prim()
 	}
 }
 
+//-----------------------------------------------------------------------------
+bool CMathParser::compile(const char* szexpr, const std::vector<std::string>& vars, CMathProgram& prg)
+{
+	prg.clear();
+	prg.m_nvar = (int) vars.size();
+
+	m_szexpr = szexpr;
+	m_nerrs = 0;
+	m_prg = &prg;
+	m_vars = &vars;
+	m_depth = 0;
+
+	// compile the expression
+	compile_expr();
+
+	m_prg = 0;
+	m_vars = 0;
+
+	if (m_nerrs > 0)
+	{
+		prg.clear();
+		return false;
+	}
+
+	prg.m_expr = szexpr;
+	prg.m_vars = vars;
+	prg.m_table = m_table;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void CMathParser::emit(int code, int arg)
+{
+	CMathProgram::OP op = { code, arg };
+	m_prg->m_op.push_back(op);
+
+	// keep track of the stack size
+	if ((code == CMathProgram::OP_CONST) || (code == CMathProgram::OP_VAR))
+	{
+		m_depth++;
+		if (m_depth > m_prg->m_nstack) m_prg->m_nstack = m_depth;
+	}
+	else if ((code != CMathProgram::OP_NEG) && (code != CMathProgram::OP_FNC)) m_depth--;
+}
+
+//-----------------------------------------------------------------------------
+void CMathParser::compile_expr()
+{
+	compile_term();
+
+	for(;;)
+		switch(curr_tok)
+		{
+		case PLUS : compile_term(); emit(CMathProgram::OP_ADD); break;
+		case MINUS: compile_term(); emit(CMathProgram::OP_SUB); break;
+		default:
+			return;
+		}
+}
+
+//-----------------------------------------------------------------------------
+void CMathParser::compile_term()
+{
+	compile_power();
+
+	for(;;)
+		switch(curr_tok)
+		{
+		case MUL: compile_power(); emit(CMathProgram::OP_MUL); break;
+		case DIV: compile_power(); emit(CMathProgram::OP_DIV); break;
+		default:
+			return;
+		}
+}
+
+//-----------------------------------------------------------------------------
+void CMathParser::compile_power()
+{
+	compile_prim();
+
+	for (;;)
+		switch(curr_tok)
+		{
+		case POW: compile_prim(); emit(CMathProgram::OP_POW); break;
+		default:
+			return;
+		}
+}
+
+//-----------------------------------------------------------------------------
+void CMathParser::compile_prim()
+{
+	get_token();
+
+	switch (curr_tok)
+	{
+	case NUMBER:
+		{
+			emit(CMathProgram::OP_CONST, (int) m_prg->m_const.size());
+			m_prg->m_const.push_back(number_value);
+			get_token();
+		}
+		break;
+	case NAME:
+		{
+			// see if this is a variable of the program
+			for (int i = 0; i < (int) m_vars->size(); ++i)
+			{
+				if ((*m_vars)[i] == string_value)
+				{
+					emit(CMathProgram::OP_VAR, i);
+					get_token();
+					return;
+				}
+			}
+
+			// see if it's a constant
+			std::map<std::string, double>::iterator it = m_table.find(string_value);
+			if (it != m_table.end())
+			{
+				emit(CMathProgram::OP_CONST, (int) m_prg->m_const.size());
+				m_prg->m_const.push_back(it->second);
+				get_token();
+				return;
+			}
+
+			// check for functions
+			int nf = find_function(string_value);
+			get_token();
+
+			if (nf >= 0)
+			{
+				if (curr_tok != LP) { error("'(' expected"); return; }
+				compile_expr();
+				if (curr_tok != RP) { error("')' expected"); return; }
+				emit(CMathProgram::OP_FNC, nf);
+				get_token(); // eat ')'
+			}
+			else error("unknown variable or function name");
+		}
+		break;
+	case MINUS:
+		compile_prim();
+		emit(CMathProgram::OP_NEG);
+		break;
+	case LP:
+		{
+			compile_expr();
+			if (curr_tok != RP) { error("')' expected"); return; }
+			get_token();	// eat ')'
+		}
+		break;
+	default:
+		error("primary expected");
+	}
+}
+
 CMathParser::Token_value CMathParser::get_token()
 {
 	// remove leading whitespace
@@ -249,3 +422,169 @@ void CMathParser::get_name(char* str)
 	str[n] = 0;
 }
 
+
+//=============================================================================
+// CMathProgram
+//=============================================================================
+
+CMathProgram::CMathProgram()
+{
+	m_nvar = 0;
+	m_nstack = 0;
+}
+
+//-----------------------------------------------------------------------------
+void CMathProgram::clear()
+{
+	m_op.clear();
+	m_const.clear();
+	m_nvar = 0;
+	m_nstack = 0;
+	m_expr.clear();
+	m_vars.clear();
+	m_table.clear();
+}
+
+//-----------------------------------------------------------------------------
+double CMathProgram::eval_expression(const double* x, int& ierr) const
+{
+	CMathParser math;
+	for (std::map<std::string, double>::const_iterator it = m_table.begin(); it != m_table.end(); ++it)
+		math.set_variable(it->first.c_str(), it->second);
+	for (int i = 0; i < m_nvar; ++i) math.set_variable(m_vars[i].c_str(), x[i]);
+	return math.eval(m_expr.c_str(), ierr);
+}
+
+//-----------------------------------------------------------------------------
+double CMathProgram::eval(const double* x, int& ierr) const
+{
+	ierr = 0;
+	if (m_op.empty()) return 0.0;
+
+	double buf[MATH_SMALL_STACK];
+	std::vector<double> heap;
+	double* s = buf;
+	if (m_nstack > MATH_SMALL_STACK) { heap.resize(m_nstack); s = &heap[0]; }
+
+	int n = -1;
+	const OP* op = &m_op[0];
+	int nop = (int) m_op.size();
+	for (int i = 0; i < nop; ++i)
+	{
+		switch (op[i].code)
+		{
+		case OP_CONST: s[++n] = m_const[op[i].arg]; break;
+		case OP_VAR  : s[++n] = x[op[i].arg]; break;
+		case OP_ADD  : s[n - 1] += s[n]; n--; break;
+		case OP_SUB  : s[n - 1] -= s[n]; n--; break;
+		case OP_MUL  : s[n - 1] *= s[n]; n--; break;
+		case OP_DIV  : 
+			// a division by zero is handled by the parser
+			if (s[n] == 0.0) return eval_expression(x, ierr);
+			s[n - 1] /= s[n];
+			n--; 
+			break;
+		case OP_POW  : s[n - 1] = pow(s[n - 1], s[n]); n--; break;
+		case OP_NEG  : s[n] = -s[n]; break;
+		case OP_FNC  : s[n] = fncPtr[op[i].arg](s[n]); break;
+		}
+	}
+	return s[0];
+}
+
+//-----------------------------------------------------------------------------
+// The points are processed in blocks. Each instruction is applied to all the
+// points of a block before the next one is executed, so that the interpreter
+// overhead is shared by the block and the inner loops can be vectorized.
+int CMathProgram::eval(int n, const double* const* x, double* val) const
+{
+	if (m_op.empty())
+	{
+		for (int i = 0; i < n; ++i) val[i] = 0.0;
+		return 0;
+	}
+
+	int nblocks = (n + MATH_BLOCK - 1) / MATH_BLOCK;
+	int nop = (int) m_op.size();
+	int nerrs = 0;
+
+#pragma omp parallel if (n >= MATH_MIN_PARALLEL)
+	{
+		// each thread has its own stack
+		std::vector<double> stack((size_t)m_nstack*MATH_BLOCK);
+		std::vector<double*> s(m_nstack);
+		for (int k = 0; k < m_nstack; ++k) s[k] = &stack[(size_t)k*MATH_BLOCK];
+
+#pragma omp for reduction(+:nerrs)
+		for (int b = 0; b < nblocks; ++b)
+		{
+			int i0 = b*MATH_BLOCK;
+			int m = (i0 + MATH_BLOCK <= n ? MATH_BLOCK : n - i0);
+
+			// points with a division by zero
+			char zero[MATH_BLOCK] = { 0 };
+			int nzero = 0;
+
+			int ns = -1;
+			for (int i = 0; i < nop; ++i)
+			{
+				const OP& op = m_op[i];
+				double* a = s[ns > 0 ? ns - 1 : 0];
+				double* c = s[ns > 0 ? ns : 0];
+				switch (op.code)
+				{
+				case OP_CONST:
+					{
+						double v = m_const[op.arg];
+						double* d = s[++ns];
+						for (int j = 0; j < m; ++j) d[j] = v;
+					}
+					break;
+				case OP_VAR:
+					{
+						const double* xj = x[op.arg] + i0;
+						double* d = s[++ns];
+						for (int j = 0; j < m; ++j) d[j] = xj[j];
+					}
+					break;
+				case OP_ADD: for (int j = 0; j < m; ++j) a[j] += c[j]; ns--; break;
+				case OP_SUB: for (int j = 0; j < m; ++j) a[j] -= c[j]; ns--; break;
+				case OP_MUL: for (int j = 0; j < m; ++j) a[j] *= c[j]; ns--; break;
+				case OP_DIV:
+					for (int j = 0; j < m; ++j)
+					{
+						if (c[j] != 0.0) a[j] /= c[j]; else { a[j] = 1.0; zero[j] = 1; nzero++; }
+					}
+					ns--;
+					break;
+				case OP_POW: for (int j = 0; j < m; ++j) a[j] = pow(a[j], c[j]); ns--; break;
+				case OP_NEG: for (int j = 0; j < m; ++j) c[j] = -c[j]; break;
+				case OP_FNC:
+					{
+						MATH_FNC f = fncPtr[op.arg];
+						for (int j = 0; j < m; ++j) c[j] = f(c[j]);
+					}
+					break;
+				}
+			}
+
+			for (int j = 0; j < m; ++j) val[i0 + j] = s[0][j];
+
+			// these points are evaluated by the parser
+			if (nzero > 0)
+			{
+				std::vector<double> xj(m_nvar);
+				for (int j = 0; j < m; ++j)
+				{
+					if (zero[j] == 0) continue;
+					for (int k = 0; k < m_nvar; ++k) xj[k] = x[k][i0 + j];
+					int ierr = 0;
+					val[i0 + j] = eval_expression(m_nvar > 0 ? &xj[0] : nullptr, ierr);
+					nerrs += ierr;
+				}
+			}
+		}
+	}
+
+	return nerrs;
+}
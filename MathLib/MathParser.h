@@ -26,8 +26,66 @@ SOFTWARE.*/
 
 #pragma once
 #include <string>
+#include <vector>
 #include <map>
 
+//-----------------------------------------------------------------------------
+// An expression that was compiled by CMathParser::compile. The expression is
+// stored as a list of instructions for a small stack machine and its variables
+// are replaced by slots, so that it can be evaluated many times without parsing
+// the expression string again. Evaluation does not modify the program, so it
+// can be done from multiple threads.
+class CMathProgram
+{
+public:
+	enum OpCode { OP_CONST, OP_VAR, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW, OP_NEG, OP_FNC };
+
+	struct OP
+	{
+		int	code;	// op code
+		int	arg;	// index of constant (OP_CONST), variable slot (OP_VAR) or function (OP_FNC)
+	};
+
+public:
+	CMathProgram();
+
+	// see if the program was compiled successfully
+	bool IsValid() const { return (m_op.empty() == false); }
+
+	// number of variable slots
+	int Variables() const { return m_nvar; }
+
+	// evaluate the program. x contains the values of the variables. 
+	// ierr returns the number of errors (i.e. divisions by zero). The result
+	// is the same as CMathParser::eval, also when errors occur.
+	double eval(const double* x, int& ierr) const;
+
+	// evaluate the program for n points. x[i] points to the n values of variable i.
+	// Returns the number of errors.
+	int eval(int n, const double* const* x, double* val) const;
+
+private:
+	void clear();
+
+	// Evaluate the expression string with CMathParser::eval. This is done when a
+	// division by zero occurs, since eval then abandons the rest of the expression,
+	// which a stack machine cannot reproduce.
+	double eval_expression(const double* x, int& ierr) const;
+
+private:
+	std::vector<OP>		m_op;		// instructions
+	std::vector<double>	m_const;	// constants
+	int		m_nvar;		// number of variables
+	int		m_nstack;	// required stack size (max depth found when compiling)
+
+	std::string						m_expr;		// the expression string
+	std::vector<std::string>		m_vars;		// the variable names
+	std::map<std::string, double>	m_table;	// the parser's constants and variables
+
+	friend class CMathParser;
+};
+
+//-----------------------------------------------------------------------------
 class CMathParser  
 {
 protected:
@@ -45,6 +103,12 @@ public:
 
 	double eval(const char* szexpr, int& ierr);
 
+	// Compile the expression into a program. The names in vars are the variables
+	// of the program and their slots are their positions in vars. Any other
+	// names must be constants or variables of the parser, and their current
+	// values are stored in the program. Returns false if the expression has errors.
+	bool compile(const char* szexpr, const std::vector<std::string>& vars, CMathProgram& prg);
+
 	const char* error_str() { return m_szerr; }
 
 protected:
@@ -53,6 +117,14 @@ protected:
 	double prim();	// handle primaries
 	double power();	// power
 	Token_value get_token();
+
+	// compile functions (same grammar as above)
+	void compile_expr();
+	void compile_term();
+	void compile_power();
+	void compile_prim();
+	void emit(int code, int arg = 0);
+
 	double error(const char* str);
 
 	double get_number();
@@ -70,4 +142,9 @@ protected:
 	char	m_szerr[256];
 
 	int		m_nerrs;
+
+	// data used while compiling
+	CMathProgram*					m_prg;
+	const std::vector<std::string>*	m_vars;
+	int								m_depth;
 };
@@ -26,6 +26,7 @@ SOFTWARE.*/
 
 #include "FEElement.h"
 #include "FEElementLibrary.h"
+#include "FEElementStore.h"
 #include "tet4.h"
 #include "penta6.h"
 #include "penta15.h"
@@ -55,8 +56,45 @@ FEElement_::FEElement_()
 	m_MatID = 0;
 	m_tex = 0.0f;
 
-	m_Q.unit(); m_Qactive = false;
-	m_a0 = 0;
+	m_attr = nullptr;
+	m_store = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// The element arrays are not copied, since the derived classes manage these.
+FEElement_::FEElement_(const FEElement_& el) : FEItem(el)
+{
+	m_node = 0;
+	m_nbr = 0;
+	m_face = 0;
+	m_h = 0;
+
+	m_lid = el.m_lid;
+	m_MatID = el.m_MatID;
+	m_tex = el.m_tex;
+	m_traits = el.m_traits;
+
+	m_attr = (el.m_attr ? new FEElemAttributes(*el.m_attr) : nullptr);
+	m_store = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+FEElement_::~FEElement_()
+{
+	// attributes of elements in a store are owned by the store
+	if (m_store == nullptr) delete m_attr;
+}
+
+//-----------------------------------------------------------------------------
+FEElement_& FEElement_::operator = (const FEElement_& el)
+{
+	FEItem::operator = (el);
+	m_lid = el.m_lid;
+	m_MatID = el.m_MatID;
+	m_tex = el.m_tex;
+	m_traits = el.m_traits;
+	CopyAttributes(el);
+	return *this;
 }
 
 //-----------------------------------------------------------------------------
@@ -67,6 +105,65 @@ void FEElement_::SetType(int ntype)
 	assert(m_traits);
 }
 
+//-----------------------------------------------------------------------------
+FEElemAttributes& FEElement_::Attributes()
+{
+	if (m_attr == nullptr)
+	{
+		m_attr = (m_store ? m_store->AllocAttributes() : new FEElemAttributes);
+	}
+	return *m_attr;
+}
+
+//-----------------------------------------------------------------------------
+void FEElement_::CopyAttributes(const FEElement_& el)
+{
+	if (el.m_attr) Attributes() = *el.m_attr;
+	else if (m_attr) *m_attr = FEElemAttributes();
+}
+
+//-----------------------------------------------------------------------------
+// The setters don't allocate attributes for the default values.
+void FEElement_::SetFiber(const vec3d& a)
+{
+	if ((m_attr == nullptr) && (a.x == 0.0) && (a.y == 0.0) && (a.z == 0.0)) return;
+	Attributes().m_fiber = a;
+}
+
+//-----------------------------------------------------------------------------
+mat3d FEElement_::LocalAxes() const
+{
+	if (m_attr) return m_attr->m_Q;
+	mat3d Q; Q.unit();
+	return Q;
+}
+
+//-----------------------------------------------------------------------------
+void FEElement_::SetLocalAxes(const mat3d& Q)
+{
+	if (m_attr == nullptr)
+	{
+		bool isUnit = true;
+		for (int i = 0; i < 9; ++i) if (Q(i / 3, i % 3) != (i % 4 == 0 ? 1.0 : 0.0)) isUnit = false;
+		if (isUnit) return;
+	}
+	Attributes().m_Q = Q;
+}
+
+//-----------------------------------------------------------------------------
+void FEElement_::SetLocalAxesActive(bool b)
+{
+	if ((m_attr == nullptr) && (b == false)) return;
+	Attributes().m_Qactive = b;
+}
+
+//-----------------------------------------------------------------------------
+void FEElement_::SetTrussArea(double a0)
+{
+	if ((m_attr == nullptr) && (a0 == 0.0)) return;
+	Attributes().m_a0 = a0;
+}
+
 //-----------------------------------------------------------------------------
 // Check comparison between two elements
 bool FEElement_::operator != (FEElement_& e)
@@ -672,10 +769,7 @@ void FEElement_::copy(const FEElement_& el)
 	m_traits = el.m_traits;
 	m_nid = el.m_nid;
 
-	m_fiber = el.m_fiber;
-	m_Q = el.m_Q;
-	m_Qactive = el.m_Qactive;
-	m_a0 = el.m_a0;
+	CopyAttributes(el);
 //	m_edata = el.m_edata;
 
 	for (int i=0; i<Nodes(); ++i) m_node[i] = el.m_node[i];
@@ -781,44 +875,182 @@ void FEElement_::iso_coord(int n, double q[3])
 //=============================================================================
 // FEElement
 //-----------------------------------------------------------------------------
+// Elements that are not shells point to this buffer instead of storing a thickness.
+static double noThickness[FEElement::MAX_NODES] = { 0 };
+
+//-----------------------------------------------------------------------------
+// number of ints that are stored for an element: 6 neighbors, 6 faces, and the nodes
+int FEElement::IndexSize(const FEElemTraits* traits)
+{
+	return 12 + (traits ? traits->nodes : MAX_NODES);
+}
+
+//-----------------------------------------------------------------------------
+// number of thickness values that are stored for an element
+int FEElement::ThicknessSize(const FEElemTraits* traits)
+{
+	return ((traits && (traits->nclass == ELEM_SHELL)) ? traits->nodes : 0);
+}
+
+//-----------------------------------------------------------------------------
+// The element's data is allocated when its type is set or when it is added to a mesh.
 FEElement::FEElement()
 { 
-	m_node = _node;
-	m_nbr = _nbr;
-	m_face = _face;
-	m_h	= _h;
 	m_nid = -1;
+}
+
+//-----------------------------------------------------------------------------
+FEElement::FEElement(const FEElement& el) : FEElement_(el)
+{
+	if (el.m_nbr == 0) return;
 
-	for (int i=0; i<MAX_NODES; ++i) m_node[i] = -1;
-	for (int i=0; i<6; ++i) { m_nbr[i] = m_face[i] = -1; }
-	for (int i=0; i<9; ++i) m_h[i] = 0.0;
+	Allocate(m_traits);
+
+	// this copies the neighbors, faces and nodes
+	int n = IndexSize(m_traits);
+	for (int i=0; i<n; ++i) m_nbr[i] = el.m_nbr[i];
+	int nh = ThicknessSize(m_traits);
+	for (int i=0; i<nh; ++i) m_h[i] = el.m_h[i];
 }
 
 //-----------------------------------------------------------------------------
-FEElement::FEElement(const FEElement& el)
+FEElement::FEElement(FEElement&& el) noexcept
 {
-	m_node = _node;
-	m_nbr = _nbr;
-	m_face = _face;
-	m_h	= _h;
+	FEItem::operator = (el);
+	m_lid = el.m_lid;
+	m_MatID = el.m_MatID;
+	m_tex = el.m_tex;
+	m_traits = el.m_traits;
 
-	copy(el);
+	m_node = el.m_node;
+	m_nbr = el.m_nbr;
+	m_face = el.m_face;
+	m_h = el.m_h;
+	m_attr = el.m_attr;
+	m_store = el.m_store;
 
-	for (int i=0; i<6; ++i) { m_nbr[i] = el.m_nbr[i]; m_face[i] = el.m_face[i]; }
-	for (int i=0; i<9; ++i) m_h[i] = el.m_h[i];
+	el.m_node = 0;
+	el.m_nbr = 0;
+	el.m_face = 0;
+	el.m_h = 0;
+	el.m_attr = nullptr;
+	el.m_store = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+FEElement::~FEElement()
+{
+	// the data of elements in a store is owned by the store
+	if (m_store == nullptr)
+	{
+		delete [] m_nbr;
+		if (m_h != noThickness) delete [] m_h;
+	}
 }
 
 //-----------------------------------------------------------------------------
 FEElement& FEElement::operator = (const FEElement& el)
 {
-	copy(el);
+	if (this == &el) return *this;
+
+	Allocate(el.m_traits);
+	FEElement_::operator = (el);
 
-	for (int i=0; i<6; ++i) { m_nbr[i] = el.m_nbr[i]; m_face[i] = el.m_face[i]; }
-	for (int i=0; i<9; ++i) m_h[i] = el.m_h[i];
+	// this copies the neighbors, faces and nodes
+	int n = IndexSize(m_traits);
+	for (int i=0; i<n; ++i) m_nbr[i] = (el.m_nbr ? el.m_nbr[i] : -1);
+	int nh = ThicknessSize(m_traits);
+	for (int i=0; i<nh; ++i) m_h[i] = el.m_h[i];
 
 	return *this;
 }
 
+//-----------------------------------------------------------------------------
+void FEElement::SetType(int ntype)
+{
+	const FEElemTraits* traits = FEElementLibrary::GetTraits(ntype);
+	assert(traits);
+	if ((traits != m_traits) || (m_nbr == 0)) Allocate(traits);
+	m_traits = traits;
+}
+
+//-----------------------------------------------------------------------------
+// Make sure the element's arrays are large enough for an element with the given 
+// traits. The data that fits is kept. Note that the arrays may be larger than 
+// needed, since they are only reallocated when they need to grow.
+void FEElement::Allocate(const FEElemTraits* traits)
+{
+	int n0 = (m_nbr ? IndexSize(m_traits) : 0);
+	int n1 = IndexSize(traits);
+	if (n1 > n0)
+	{
+		int* d = (m_store ? m_store->AllocIndices(n1) : new int[n1]);
+		for (int i = 0; i < n0; ++i) d[i] = m_nbr[i];
+		for (int i = n0; i < n1; ++i) d[i] = -1;
+		if (m_store == nullptr) delete [] m_nbr;
+
+		m_nbr = d;
+		m_face = d + 6;
+		m_node = d + 12;
+	}
+
+	bool hasThickness = (m_h && (m_h != noThickness));
+	int h0 = (hasThickness ? ThicknessSize(m_traits) : 0);
+	int h1 = ThicknessSize(traits);
+	if ((h1 == 0) || (h1 > h0))
+	{
+		double* h = noThickness;
+		if (h1 > 0)
+		{
+			h = (m_store ? m_store->AllocThickness(h1) : new double[h1]);
+			for (int i = 0; i < h0; ++i) h[i] = m_h[i];
+			for (int i = h0; i < h1; ++i) h[i] = 0.0;
+		}
+		if (hasThickness && (m_store == nullptr)) delete [] m_h;
+		m_h = h;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Copy the element's data into a store. The element's old data is released if the
+// element owned it.
+void FEElement::MoveTo(FEElementStore* store)
+{
+	int n = IndexSize(m_traits);
+	int* d = store->AllocIndices(n);
+	if (m_nbr) for (int i = 0; i < n; ++i) d[i] = m_nbr[i];
+	else for (int i = 0; i < n; ++i) d[i] = -1;
+
+	int nh = ThicknessSize(m_traits);
+	double* h = noThickness;
+	if (nh > 0)
+	{
+		h = store->AllocThickness(nh);
+		for (int i = 0; i < nh; ++i) h[i] = (m_h ? m_h[i] : 0.0);
+	}
+
+	FEElemAttributes* a = nullptr;
+	if (m_attr)
+	{
+		a = store->AllocAttributes();
+		*a = *m_attr;
+	}
+
+	if (m_store == nullptr)
+	{
+		delete [] m_nbr;
+		if (m_h != noThickness) delete [] m_h;
+		delete m_attr;
+	}
+
+	m_nbr = d;
+	m_face = d + 6;
+	m_node = d + 12;
+	m_h = h;
+	m_attr = a;
+	m_store = store;
+}
+
 int ET_QUAD[4][2] = {
 	{ 0, 1 },
 	{ 1, 2 },
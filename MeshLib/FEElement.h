@@ -92,6 +92,21 @@ struct FEElemTraits
 	int	edges;	// number of edges (only for shell elements)
 };
 
+//-----------------------------------------------------------------------------
+// Element attributes that only some elements define. These are only stored for
+// the elements that set them.
+struct FEElemAttributes
+{
+	FEElemAttributes() { m_Q.unit(); m_Qactive = false; m_a0 = 0.0; }
+
+	vec3d	m_fiber;	//!< fiber orientation
+	mat3d	m_Q;		//!< local material orientation
+	bool	m_Qactive;	//!< active local material orientation
+	double	m_a0;		//!< cross-sectional area (only used by truss elements)
+};
+
+class FEElementStore;
+
 //-----------------------------------------------------------------------------
 // The FEElement_ class defines the data interface to the element data. 
 // Specialized element classes are then defined by deriving from this base class.
@@ -106,9 +121,18 @@ public:
 	//! constructor
 	FEElement_();
 
+	//! copy constructor
+	FEElement_(const FEElement_& el);
+
+	//! destructor
+	~FEElement_();
+
+	//! assignment operator
+	FEElement_& operator = (const FEElement_& el);
+
 public:
 	//! Set the element type
-	void SetType(int ntype);
+	virtual void SetType(int ntype);
 
 	int Type () const { return m_traits->ntype; }
 	int Shape() const { return m_traits->nshape; }
@@ -171,10 +195,31 @@ public: // for shells
 	//! Get the face of a shell
 	void GetShellFace(FEFace& f) const;
 
+public: // optional element attributes
+	vec3d Fiber() const { return (m_attr ? m_attr->m_fiber : vec3d(0, 0, 0)); }
+	void SetFiber(const vec3d& a);
+
+	mat3d LocalAxes() const;
+	void SetLocalAxes(const mat3d& Q);
+
+	bool LocalAxesActive() const { return (m_attr ? m_attr->m_Qactive : false); }
+	void SetLocalAxesActive(bool b);
+
+	double TrussArea() const { return (m_attr ? m_attr->m_a0 : 0.0); }
+	void SetTrussArea(double a0);
+
+	bool HasAttributes() const { return (m_attr != nullptr); }
+
 protected:
 	// help class for copy-ing element data
 	void copy(const FEElement_& el);
 
+	// copy the attributes of another element
+	void CopyAttributes(const FEElement_& el);
+
+	// return the attributes, allocating them if needed
+	FEElemAttributes& Attributes();
+
 public:
 	int*		m_node;		//!< pointer to node data
 	int*		m_nbr;		//!< neighbour elements
@@ -186,19 +231,20 @@ public:
 	int			m_MatID;	// material id
 	float		m_tex;		// element texture coordinate
 
-public:
-	vec3d	m_fiber;	//!< fiber orientation \todo maybe I can add an element attribute section
-	mat3d	m_Q;		//!< local material orientation
-	bool	m_Qactive;	//!< active local material orientation
-	double	m_a0;		//!< cross-sectional area (only used by truss elements)
-	
 protected:
 	const FEElemTraits* m_traits;	// element traits
+	FEElemAttributes*	m_attr;		// element attributes (null if the element does not define any)
+	FEElementStore*		m_store;	// store that owns the element data (null if the element owns it)
 };
 
 //-----------------------------------------------------------------------------
 // The FEElement class can be used to represent a general purpose element. 
 // This class can represent an element of all different types. 
+// The element data is sized for the element type. Elements of an FEMesh keep their
+// data in the mesh's FEElementStore, other elements allocate it themselves. 
+// Elements that are not shells don't store a thickness: their m_h points to a 
+// shared buffer, so values written to it are not kept.
+// Elements of a mesh that don't have a type yet have room for MAX_NODES nodes.
 class FEElement : public FEElement_
 {
 public:
@@ -211,14 +257,30 @@ public:
 	//! copy constructor
 	FEElement(const FEElement& el);
 
+	//! move constructor
+	FEElement(FEElement&& el) noexcept;
+
+	//! destructor
+	~FEElement();
+
 	//! assignment operator
 	FEElement& operator = (const FEElement& el);
 
+	//! Set the element type
+	void SetType(int ntype) override;
+
 private:
-	int		_node[MAX_NODES];	//!< nodal id's
-	int		_nbr[6];			//!< neighbour elements
-	int		_face[6];			//!< faces (-1 for interior faces)
-	double 	_h[9];				//!< element thickness (only used by shells)
+	// make room for the data of an element with the given traits
+	void Allocate(const FEElemTraits* traits);
+
+	// copy the element's data into a store
+	void MoveTo(FEElementStore* store);
+
+	// number of ints (neighbors, faces, and nodes) and doubles (thickness) that are stored for an element type
+	static int IndexSize(const FEElemTraits* traits);
+	static int ThicknessSize(const FEElemTraits* traits);
+
+	friend class FEElementStore;
 };
 
 //=============================================================================
@@ -266,6 +328,8 @@ public:
 		m_node = _node;
 		for (int i = 0; i<T::Nodes; ++i) m_node[i] = el.m_node[i];
 		m_nbr = _nbr;
+		m_face = _face;
+		m_h = _h;
 	}
 
 	void operator = (const FEElementBase& el)
@@ -0,0 +1,177 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "FEElementStore.h"
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// The blocks double in size with the pool, but they are never larger than 8 MB
+// (unless a single allocation needs more).
+template <typename T> T* FEElementStore::Pool<T>::Alloc(size_t n)
+{
+	if (m_block.empty() || (m_used + n > m_size))
+	{
+		const size_t minBlock = 256;
+		const size_t maxBlock = std::max((size_t)(8 << 20) / sizeof(T), minBlock);
+		size_t m = std::min(std::max(m_total, minBlock), maxBlock);
+		if (m < n) m = n;
+		m_block.push_back(new T[m]);
+		m_size = m;
+		m_used = 0;
+		m_total += m;
+	}
+	T* p = m_block.back() + m_used;
+	m_used += n;
+	return p;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T> void FEElementStore::Pool<T>::Reserve(size_t n)
+{
+	assert(m_block.empty());
+	if (n == 0) return;
+	m_block.push_back(new T[n]);
+	m_size = n;
+	m_used = 0;
+	m_total = n;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T> void FEElementStore::Pool<T>::Clear()
+{
+	for (size_t i = 0; i < m_block.size(); ++i) delete [] m_block[i];
+	m_block.clear();
+	m_used = m_size = m_total = 0;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T> void FEElementStore::Pool<T>::Swap(Pool<T>& p)
+{
+	m_block.swap(p.m_block);
+	std::swap(m_used, p.m_used);
+	std::swap(m_size, p.m_size);
+	std::swap(m_total, p.m_total);
+}
+
+//=============================================================================
+FEElementStore::FEElementStore()
+{
+}
+
+//-----------------------------------------------------------------------------
+FEElementStore::~FEElementStore()
+{
+	Clear();
+}
+
+//-----------------------------------------------------------------------------
+void FEElementStore::Clear()
+{
+	m_index.Clear();
+	m_h.Clear();
+	m_attr.Clear();
+}
+
+//-----------------------------------------------------------------------------
+// Elements can be created in parallel loops, so the allocations are serialized.
+int* FEElementStore::AllocIndices(int n)
+{
+	int* p = nullptr;
+	#pragma omp critical (FEElementStore_Alloc)
+	p = m_index.Alloc(n);
+	return p;
+}
+
+//-----------------------------------------------------------------------------
+double* FEElementStore::AllocThickness(int n)
+{
+	double* p = nullptr;
+	#pragma omp critical (FEElementStore_Alloc)
+	p = m_h.Alloc(n);
+	return p;
+}
+
+//-----------------------------------------------------------------------------
+FEElemAttributes* FEElementStore::AllocAttributes()
+{
+	FEElemAttributes* p = nullptr;
+	#pragma omp critical (FEElementStore_Alloc)
+	p = m_attr.Alloc(1);
+	*p = FEElemAttributes();
+	return p;
+}
+
+//-----------------------------------------------------------------------------
+void FEElementStore::Add(FEElement& el)
+{
+	if (el.m_store != this) el.MoveTo(this);
+}
+
+//-----------------------------------------------------------------------------
+void FEElementStore::Add(std::vector<FEElement>& el, int n0)
+{
+	int N = (int)el.size();
+	for (int i = n0; i < N; ++i) Add(el[i]);
+}
+
+//-----------------------------------------------------------------------------
+bool FEElementStore::Compact(std::vector<FEElement>& el)
+{
+	// count the data that the elements use
+	size_t ni = 0, nh = 0, na = 0;
+	for (size_t i = 0; i < el.size(); ++i)
+	{
+		const FEElement& ei = el[i];
+		ni += FEElement::IndexSize(ei.m_traits);
+		nh += FEElement::ThicknessSize(ei.m_traits);
+		if (ei.m_attr) na++;
+	}
+
+	// only compact if at least an eighth of the memory is released
+	size_t used = ni*sizeof(int) + nh*sizeof(double) + na*sizeof(FEElemAttributes);
+	size_t size = MemorySize();
+	if ((size == 0) || (used + size / 8 > size)) return false;
+
+	FEElementStore tmp;
+	tmp.m_index.Reserve(ni);
+	tmp.m_h.Reserve(nh);
+	tmp.m_attr.Reserve(na);
+	for (size_t i = 0; i < el.size(); ++i) el[i].MoveTo(&tmp);
+
+	// the new blocks now belong to this store, and the old ones are released with tmp
+	m_index.Swap(tmp.m_index);
+	m_h.Swap(tmp.m_h);
+	m_attr.Swap(tmp.m_attr);
+	for (size_t i = 0; i < el.size(); ++i) el[i].m_store = this;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+size_t FEElementStore::MemorySize() const
+{
+	return m_index.Capacity()*sizeof(int) + m_h.Capacity()*sizeof(double) + m_attr.Capacity()*sizeof(FEElemAttributes);
+}
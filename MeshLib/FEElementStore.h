@@ -0,0 +1,103 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include "FEElement.h"
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// The FEElementStore class holds the element data of a mesh. The neighbor, face
+// and node indices of all elements are allocated from one pool of integers, the
+// shell thicknesses from a pool of doubles, and the element attributes (fibers,
+// local axes, truss areas) from a third pool. An element only takes the room its
+// type needs, and thicknesses and attributes are only stored for the elements 
+// that have them. 
+// The memory is released when the store is cleared. Compact() copies the data 
+// of the elements into one block per pool, so that it is laid out in element order.
+class FEElementStore
+{
+	// The items of a pool are allocated from blocks that grow with the pool.
+	template <typename T> class Pool
+	{
+	public:
+		Pool() { m_used = m_size = m_total = 0; }
+		~Pool() { Clear(); }
+
+		T* Alloc(size_t n);
+
+		// allocate a single block of n items (the pool must be empty)
+		void Reserve(size_t n);
+
+		void Clear();
+
+		void Swap(Pool& p);
+
+		// number of items allocated
+		size_t Capacity() const { return m_total; }
+
+	private:
+		std::vector<T*>	m_block;	// allocated blocks
+		size_t	m_used;		// items used in the last block
+		size_t	m_size;		// size of the last block
+		size_t	m_total;	// total number of items in all blocks
+	};
+
+public:
+	FEElementStore();
+	~FEElementStore();
+
+	// release all data
+	void Clear();
+
+	// move the data of an element into this store
+	void Add(FEElement& el);
+
+	// move the data of the elements, starting at element n0, into this store
+	void Add(std::vector<FEElement>& el, int n0 = 0);
+
+	// Copy the data of the elements into one block per pool and release the 
+	// old blocks. This is only done when it releases enough memory. Returns true
+	// if the data was moved.
+	bool Compact(std::vector<FEElement>& el);
+
+	// memory allocated by the store (in bytes)
+	size_t MemorySize() const;
+
+public: // used by FEElement
+	int* AllocIndices(int n);
+	double* AllocThickness(int n);
+	FEElemAttributes* AllocAttributes();
+
+private:
+	// a store cannot be copied
+	FEElementStore(const FEElementStore&);
+	void operator = (const FEElementStore&);
+
+private:
+	Pool<int>				m_index;	// neighbor, face and node indices
+	Pool<double>			m_h;		// shell thicknesses
+	Pool<FEElemAttributes>	m_attr;		// element attributes
+};
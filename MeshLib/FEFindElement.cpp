@@ -27,168 +27,90 @@ SOFTWARE.*/
 #include "FEFindElement.h"
 #include "FECoreMesh.h"
 #include "MeshTools.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
 
-FEFindElement::OCTREE_BOX::OCTREE_BOX()
-{
-	m_elem = -1;
-	m_level = -1;
-}
-
-FEFindElement::OCTREE_BOX::~OCTREE_BOX()
-{
-	for (size_t i = 0; i<m_child.size(); ++i) delete m_child[i];
-	m_child.clear();
-}
+//-----------------------------------------------------------------------------
+// max nr of elements in a leaf
+const int BVH_LEAF_SIZE = 4;
 
-void FEFindElement::OCTREE_BOX::split(int levels)
-{
-	m_level = levels;
-	if (m_level == 0) return;
-
-	double x0 = m_box.x0, x1 = m_box.x1;
-	double y0 = m_box.y0, y1 = m_box.y1;
-	double z0 = m_box.z0, z1 = m_box.z1;
-
-	double dx = x1 - x0;
-	double dy = y1 - y0;
-	double dz = z1 - z0;
-
-	m_child.clear();
-	for (int i = 0; i<2; i++)
-		for (int j = 0; j<2; j++)
-			for (int k = 0; k <2; k++)
-			{
-				double xa = x0 + i*dx*0.5, xb = x0 + (i + 1)*dx*0.5;
-				double ya = y0 + j*dy*0.5, yb = y0 + (j + 1)*dy*0.5;
-				double za = z0 + k*dz*0.5, zb = z0 + (k + 1)*dz*0.5;
+// max depth of the hierarchy (which is balanced, so this is plenty)
+const int BVH_MAX_DEPTH = 64;
 
-				BOX b(xa, ya, za, xb, yb, zb);
-				double R = b.GetMaxExtent();
-				b.Inflate(R*0.0001);
+// max nr of candidate elements that are sorted during a search
+const int BVH_MAX_CANDIDATES = 64;
 
-				OCTREE_BOX* box = new OCTREE_BOX;
-				box->m_box = b;
+// min nr of points for processing a batch in parallel
+const int BATCH_MIN_PARALLEL = 256;
 
-				m_child.push_back(box);
-			}
+// round outward, so that the float box contains the double box
+static inline float roundDown(double v) { float f = (float)v; return (f > v ? nextafterf(f, -FLT_MAX) : f); }
+static inline float roundUp  (double v) { float f = (float)v; return (f < v ? nextafterf(f,  FLT_MAX) : f); }
 
-	for (int i = 0; i<(int)m_child.size(); ++i)
-	{
-		m_child[i]->split(levels - 1);
-	}
+// spread the lower 10 bits of n so that there are two zero bits between each bit
+static inline unsigned int spreadBits(unsigned int n)
+{
+	n &= 0x3FF;
+	n = (n | (n << 16)) & 0x030000FF;
+	n = (n | (n <<  8)) & 0x0300F00F;
+	n = (n | (n <<  4)) & 0x030C30C3;
+	n = (n | (n <<  2)) & 0x09249249;
+	return n;
 }
 
-void FEFindElement::OCTREE_BOX::Add(BOX& b, int nelem)
+// see if a point is inside a box
+template <class T> static inline bool isInside(const T& b, const vec3f& x)
 {
-	if (m_level == 0)
-	{
-		if (m_box.Intersects(b))
-		{
-			OCTREE_BOX* box = new OCTREE_BOX;
-			box->m_box = b;
-			box->m_elem = nelem;
-			box->m_level = -1;
-			m_child.push_back(box);
-			return;
-		}
-	}
-	else
-	{
-		for (size_t i = 0; i<m_child.size(); ++i)
-		{
-			m_child[i]->Add(b, nelem);
-		}
-	}
+	return ((x.x >= b.r0[0]) && (x.x <= b.r1[0]) &&
+			(x.y >= b.r0[1]) && (x.y <= b.r1[1]) &&
+			(x.z >= b.r0[2]) && (x.z <= b.r1[2]));
 }
 
-
-FEFindElement::OCTREE_BOX* FEFindElement::OCTREE_BOX::Find(const vec3f& r)
+//-----------------------------------------------------------------------------
+FEFindElement::FEFindElement(FECoreMesh& mesh) : m_mesh(mesh)
 {
-	if (m_level == 0)
-	{
-		bool inside = m_box.IsInside(r);
-		return (inside ? this : 0);
-	}
-
-	// try to find the child
-	for (size_t i = 0; i<m_child.size(); ++i)
-	{
-		OCTREE_BOX* c = m_child[i];
-		OCTREE_BOX* ret = c->Find(r);
-		if (ret) return ret;
-	}
-
-	return 0;
+	m_nframe = -1;
+	m_NE = 0;
 }
 
-
-FEFindElement::OCTREE_BOX* FEFindElement::FindBox(const vec3f& r)
+void FEFindElement::Init(int nframe)
 {
-	// make sure it's in the master box
-	if (m_bound.IsInside(r) == false) return 0;
-
-	// try to find the child
-	OCTREE_BOX* b = &m_bound;
-	do
-	{
-		if (b->m_level == 0)
-		{
-			bool inside = b->IsInside(r);
-			return (inside ? b : 0);
-		}
-
-		bool bfound = false;
-		for (size_t i = 0; i<b->m_child.size(); ++i)
-		{
-			OCTREE_BOX* c = b->m_child[i];
-			if (c->IsInside(r))
-			{
-				b = c;
-				bfound = true;
-				break;
-			}
-		}
-
-		assert(bfound);
-		if (bfound == false) break;
-	} while (1);
-
-	return 0;
+	vector<bool> dummy;
+	Init(dummy, nframe);
 }
 
-FEFindElement::FEFindElement(FECoreMesh& mesh) : m_mesh(mesh)
+void FEFindElement::Init(vector<bool>& flags, int nframe)
 {
-	m_nframe = -1;
+	m_nframe = nframe;
+
+	// The hierarchy only depends on which elements are included, so if these did
+	// not change, we only need to update the boxes.
+	if (m_node.empty() || (m_NE != m_mesh.Elements()) || (flags != m_flags))
+	{
+		Build(flags);
+	}
+	else
+	{
+		UpdateBoxes();
+		Refit();
+	}
 }
 
-void FEFindElement::InitReferenceFrame(vector<bool>& flags)
+//-----------------------------------------------------------------------------
+void FEFindElement::Build(vector<bool>& flags)
 {
-	assert(m_nframe == 0);
+	m_node.clear();
+	m_elem.clear();
+	m_elemBox.clear();
+	m_flags = flags;
+	m_NE = m_mesh.Elements();
 
-	// calculate bounding box for the entire mesh
 	int NN = m_mesh.Nodes();
 	int NE = m_mesh.Elements();
 	if ((NN == 0) || (NE == 0)) return;
 
-	vec3f r = to_vec3f(m_mesh.Node(0).r);
-	BOX box(r, r);
-	for (int i = 1; i<m_mesh.Nodes(); ++i)
-	{
-		r = to_vec3f(m_mesh.Node(i).r);
-		box += r;
-	}
-	double R = box.GetMaxExtent();
-	box.Inflate(R*0.001);
-
-	// split this box recursively
-	m_bound.m_box = box;
-
-	int l = (int)(log(NE) / log(8.0));
-	if (l < 0) l = 0;
-	if (l > 3) l = 3;
-	m_bound.split(l);
-
-	// calculate bounding boxes for all elements
+	// collect the elements
 	int cflags = (int)flags.size();
 	for (int i = 0; i<NE; ++i)
 	{
@@ -201,165 +123,347 @@ void FEFindElement::InitReferenceFrame(vector<bool>& flags)
 			if ((mid >= 0) && (mid < cflags)) badd = flags[mid];
 		}
 
-		if (badd)
-		{
-			int ne = e.Nodes();
-
-			// do a quick bounding box test
-			vec3f r0 = to_vec3f(m_mesh.Node(e.m_node[0]).r);
-			vec3f r1 = r0;
-			BOX box(r0, r1);
-			for (int j = 1; j<ne; ++j)
-			{
-				vec3f rj = to_vec3f(m_mesh.Node(e.m_node[j]).r);
-				box += rj;
-			}
-			double R = box.GetMaxExtent();
-			box.Inflate(R*0.001);
+		if (badd) m_elem.push_back(i);
+	}
+	if (m_elem.empty()) return;
+
+	// calculate the bounding boxes
+	UpdateBoxes();
+
+	// sort the elements along a Morton curve through the box centers
+	int ne = (int)m_elem.size();
+	vector< std::pair<unsigned int, int> > code(ne);
+	double W = (m_box.Width () > 0 ? m_box.Width () : 1.0);
+	double H = (m_box.Height() > 0 ? m_box.Height() : 1.0);
+	double D = (m_box.Depth () > 0 ? m_box.Depth () : 1.0);
+#pragma omp parallel for
+	for (int i = 0; i<ne; ++i)
+	{
+		const ELEM_BOX& b = m_elemBox[i];
+		double x = (0.5*(b.r0[0] + b.r1[0]) - m_box.x0) / W;
+		double y = (0.5*(b.r0[1] + b.r1[1]) - m_box.y0) / H;
+		double z = (0.5*(b.r0[2] + b.r1[2]) - m_box.z0) / D;
+		unsigned int ix = (unsigned int)(x*1023.0);
+		unsigned int iy = (unsigned int)(y*1023.0);
+		unsigned int iz = (unsigned int)(z*1023.0);
+		code[i].first = (spreadBits(ix) << 2) | (spreadBits(iy) << 1) | spreadBits(iz);
+		code[i].second = i;
+	}
+	std::sort(code.begin(), code.end());
 
-			// add it to the octree
-			m_bound.Add(box, i);
-		}
+	vector<int> elem(ne);
+	vector<ELEM_BOX> elemBox(ne);
+	for (int i = 0; i<ne; ++i)
+	{
+		elem[i] = m_elem[code[i].second];
+		elemBox[i] = m_elemBox[code[i].second];
 	}
+	m_elem.swap(elem);
+	m_elemBox.swap(elemBox);
+
+	// build the tree and calculate the node boxes
+	m_node.reserve(2 * (ne / BVH_LEAF_SIZE + 1));
+	BuildNode(0, ne);
+	Refit();
 }
 
-void FEFindElement::InitCurrentFrame(vector<bool>& flags)
+//-----------------------------------------------------------------------------
+// Create the nodes for the elements [n0, n1). Returns the index of the node.
+int FEFindElement::BuildNode(int n0, int n1)
 {
-	assert(m_nframe == 1);
+	int n = (int)m_node.size();
+	m_node.push_back(NODE());
+	if (n1 - n0 <= BVH_LEAF_SIZE)
+	{
+		m_node[n].m_first = n0;
+		m_node[n].m_count = n1 - n0;
+	}
+	else
+	{
+		int mid = (n0 + n1) / 2;
+		BuildNode(n0, mid);
+		int right = BuildNode(mid, n1);
+		m_node[n].m_first = right;
+		m_node[n].m_count = 0;
+	}
+	return n;
+}
 
-	// calculate bounding box for the entire mesh
+//-----------------------------------------------------------------------------
+// Calculate the bounding box of the mesh and of the elements.
+void FEFindElement::UpdateBoxes()
+{
 	int NN = m_mesh.Nodes();
-	int NE = m_mesh.Elements();
-	if ((NN == 0) || (NE == 0)) return;
-
 	vec3d r = m_mesh.Node(0).r;
 	BOX box(r, r);
-	for (int i = 1; i<m_mesh.Nodes(); ++i)
+	for (int i = 1; i<NN; ++i)
 	{
 		r = m_mesh.Node(i).r;
 		box += r;
 	}
 	double R = box.GetMaxExtent();
 	box.Inflate(R*0.001);
+	m_box = box;
+
+	int ne = (int)m_elem.size();
+	m_elemBox.resize(ne);
+#pragma omp parallel for
+	for (int i = 0; i<ne; ++i)
+	{
+		FEElement_& e = m_mesh.ElementRef(m_elem[i]);
+		int nn = e.Nodes();
+
+		vec3d r0 = m_mesh.Node(e.m_node[0]).r;
+		BOX box(r0, r0);
+		for (int j = 1; j<nn; ++j) box += m_mesh.Node(e.m_node[j]).r;
+		double R = box.GetMaxExtent();
+		box.Inflate(R*0.001);
+
+		ELEM_BOX& b = m_elemBox[i];
+		b.r0[0] = roundDown(box.x0); b.r1[0] = roundUp(box.x1);
+		b.r0[1] = roundDown(box.y0); b.r1[1] = roundUp(box.y1);
+		b.r0[2] = roundDown(box.z0); b.r1[2] = roundUp(box.z1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Update the node boxes from the element boxes. Children are always stored
+// after their parent, so the nodes are processed in reverse order.
+void FEFindElement::Refit()
+{
+	for (int n = (int)m_node.size() - 1; n >= 0; --n)
+	{
+		NODE& node = m_node[n];
+		if (node.m_count > 0)
+		{
+			const ELEM_BOX& b0 = m_elemBox[node.m_first];
+			for (int k = 0; k<3; ++k) { node.r0[k] = b0.r0[k]; node.r1[k] = b0.r1[k]; }
+			for (int i = 1; i<node.m_count; ++i)
+			{
+				const ELEM_BOX& b = m_elemBox[node.m_first + i];
+				for (int k = 0; k<3; ++k)
+				{
+					if (b.r0[k] < node.r0[k]) node.r0[k] = b.r0[k];
+					if (b.r1[k] > node.r1[k]) node.r1[k] = b.r1[k];
+				}
+			}
+		}
+		else
+		{
+			const NODE& a = m_node[n + 1];
+			const NODE& b = m_node[node.m_first];
+			for (int k = 0; k<3; ++k)
+			{
+				node.r0[k] = (a.r0[k] < b.r0[k] ? a.r0[k] : b.r0[k]);
+				node.r1[k] = (a.r1[k] > b.r1[k] ? a.r1[k] : b.r1[k]);
+			}
+		}
+	}
+}
 
-	// split this box recursively
-	m_bound.m_box = box;
+//-----------------------------------------------------------------------------
+// If the point lies in several elements, the one with the lowest index is returned.
+// Therefore, the candidates are collected first and then tested in order.
+bool FEFindElement::FindElement(const vec3f& x, int& nelem, double r[3])
+{
+	assert((m_nframe == 0) || (m_nframe == 1));
+	nelem = -1;
+	if (m_node.empty() || (m_box.IsInside(x) == false)) return false;
 
-	int l = (int)(log(NE) / log(8.0));
-	if (l < 0) l = 0;
-	if (l > 3) l = 3;
-	m_bound.split(l);
+	int cand[BVH_MAX_CANDIDATES];
+	int nc = 0;
 
-	// calculate bounding boxes for all elements
-	int cflags = (int)flags.size();
-	for (int i = 0; i<NE; ++i)
+	int stack[BVH_MAX_DEPTH];
+	int ns = 0;
+	stack[ns++] = 0;
+	while (ns > 0)
 	{
-		FEElement_& e = m_mesh.ElementRef(i);
+		int n = stack[--ns];
+		const NODE& node = m_node[n];
+		if (isInside(node, x) == false) continue;
 
-		bool badd = true;
-		if (flags.empty() == false)
+		if (node.m_count == 0)
 		{
-			int mid = e.m_MatID;
-			if ((mid >= 0) && (mid < cflags)) badd = flags[mid];
+			assert(ns + 2 <= BVH_MAX_DEPTH);
+			stack[ns++] = node.m_first;
+			stack[ns++] = n + 1;
+			continue;
 		}
 
-		if (badd)
+		for (int i = node.m_first; i < node.m_first + node.m_count; ++i)
 		{
-			int ne = e.Nodes();
-
 			// do a quick bounding box test
-			vec3d r0 = m_mesh.Node(e.m_node[0]).r;
-			vec3d r1 = r0;
-			BOX box(r0, r1);
-			for (int j = 1; j<ne; ++j)
+			if (isInside(m_elemBox[i], x))
 			{
-				vec3d rj = m_mesh.Node(e.m_node[j]).r;
-				box += rj;
+				if (nc == BVH_MAX_CANDIDATES) return FindElementSlow(x, nelem, r);
+
+				// insert sorted
+				int nid = m_elem[i];
+				int j = nc++;
+				for (; (j > 0) && (cand[j - 1] > nid); --j) cand[j] = cand[j - 1];
+				cand[j] = nid;
 			}
-			double R = box.GetMaxExtent();
-			box.Inflate(R*0.001);
+		}
+	}
 
-			// add it to the octree
-			m_bound.Add(box, i);
+	// do a more complete search
+	for (int i = 0; i < nc; ++i)
+	{
+		if (ProjectInside(cand[i], x, r))
+		{
+			nelem = cand[i];
+			return true;
 		}
 	}
-}
 
-void FEFindElement::Init(int nframe)
-{
-	vector<bool> dummy;
-	m_nframe = nframe;
-	if (m_nframe == 0) InitReferenceFrame(dummy);
-	else InitCurrentFrame(dummy);
+	return false;
 }
 
-void FEFindElement::Init(vector<bool>& flags, int nframe)
+//-----------------------------------------------------------------------------
+// see if the element was included when the hierarchy was built
+bool FEFindElement::IsSelected(int nelem)
 {
-	m_nframe = nframe;
-	if (m_nframe == 0) InitReferenceFrame(flags);
-	else InitCurrentFrame(flags);
+	if (m_flags.empty()) return true;
+	int mid = m_mesh.ElementRef(nelem).m_MatID;
+	if ((mid >= 0) && (mid < (int)m_flags.size())) return m_flags[mid];
+	return true;
 }
 
-bool FEFindElement::FindInReferenceFrame(const vec3f& x, int& nelem, double r[3])
+//-----------------------------------------------------------------------------
+// try the hint and its neighbors
+bool FEFindElement::FindNear(const vec3f& x, int hint, int& nelem, double r[3])
 {
-	assert(m_nframe == 0);
+	if ((hint < 0) || (hint >= m_NE)) return false;
 
-	vec3f y[FEElement::MAX_NODES];
-	OCTREE_BOX* b = FindBox(x);
-	if (b == 0) return false;
-	assert(b->m_level == 0);
+	if (IsSelected(hint) && ProjectInside(hint, x, r)) { nelem = hint; return true; }
 
-	int NE = (int)b->m_child.size();
-	for (int i = 0; i<NE; ++i)
+	FEElement_& el = m_mesh.ElementRef(hint);
+	int nn = (el.IsSolid() ? el.Faces() : (el.IsShell() ? el.Edges() : 0));
+	for (int i = 0; i < nn; ++i)
 	{
-		OCTREE_BOX* c = b->m_child[i];
-		assert(c->m_level == -1);
+		int nbr = el.m_nbr[i];
+		if ((nbr >= 0) && (nbr < m_NE) && IsSelected(nbr) && ProjectInside(nbr, x, r))
+		{
+			nelem = nbr;
+			return true;
+		}
+	}
+	return false;
+}
 
-		int nid = c->m_elem; assert(nid >= 0);
+//-----------------------------------------------------------------------------
+bool FEFindElement::FindElement(const vec3f& x, int hint, int& nelem, double r[3])
+{
+	assert((m_nframe == 0) || (m_nframe == 1));
+	if (m_node.empty() || (m_box.IsInside(x) == false)) { nelem = -1; return false; }
+	if (FindNear(x, hint, nelem, r)) return true;
+	return FindElement(x, nelem, r);
+}
 
-		FEElement_& e = m_mesh.ElementRef(nid);
-		nelem = nid;
+//-----------------------------------------------------------------------------
+int FEFindElement::FindElements(int n, const vec3f* x, int* nelem, double* r)
+{
+	int nfound = 0;
+#pragma omp parallel for if (n >= BATCH_MIN_PARALLEL) reduction(+:nfound)
+	for (int i = 0; i < n; ++i)
+	{
+		int ne = -1;
+		if (FindElement(x[i], nelem[i], ne, r + 3*i)) nfound++;
+		nelem[i] = ne;
+	}
+	return nfound;
+}
 
-		// do a quick bounding box test
-		if (c->m_box.IsInside(x))
+//-----------------------------------------------------------------------------
+int FEFindElement::Interpolate(int n, const vec3f* x, int* nelem, const float* v, float* val)
+{
+	int nfound = 0;
+#pragma omp parallel for if (n >= BATCH_MIN_PARALLEL) reduction(+:nfound)
+	for (int i = 0; i < n; ++i)
+	{
+		int ne = -1;
+		double q[3];
+		val[i] = 0.f;
+		if (FindElement(x[i], nelem[i], ne, q))
 		{
-			// do a more complete search
-			if (ProjectInsideReferenceElement(m_mesh, e, x, r)) return true;
+			FEElement_& el = m_mesh.ElementRef(ne);
+			float ve[FEElement::MAX_NODES];
+			int nn = el.Nodes();
+			for (int j = 0; j < nn; ++j) ve[j] = v[el.m_node[j]];
+			val[i] = el.eval(ve, q[0], q[1], q[2]);
+			nfound++;
 		}
+		nelem[i] = ne;
 	}
+	return nfound;
+}
 
-	nelem = -1;
-	return false;
+int FEFindElement::Interpolate(int n, const vec3f* x, int* nelem, const vec3f* v, vec3f* val)
+{
+	int nfound = 0;
+#pragma omp parallel for if (n >= BATCH_MIN_PARALLEL) reduction(+:nfound)
+	for (int i = 0; i < n; ++i)
+	{
+		int ne = -1;
+		double q[3];
+		val[i] = vec3f(0.f, 0.f, 0.f);
+		if (FindElement(x[i], nelem[i], ne, q))
+		{
+			FEElement_& el = m_mesh.ElementRef(ne);
+			vec3f ve[FEElement::MAX_NODES];
+			int nn = el.Nodes();
+			for (int j = 0; j < nn; ++j) ve[j] = v[el.m_node[j]];
+			val[i] = el.eval(ve, q[0], q[1], q[2]);
+			nfound++;
+		}
+		nelem[i] = ne;
+	}
+	return nfound;
 }
 
-bool FEFindElement::FindInCurrentFrame(const vec3f& x, int& nelem, double r[3])
+//-----------------------------------------------------------------------------
+bool FEFindElement::ProjectInside(int nelem, const vec3f& x, double r[3])
 {
-	assert(m_nframe == 1);
+	FEElement_& e = m_mesh.ElementRef(nelem);
+	return (m_nframe == 0 ? ProjectInsideReferenceElement(m_mesh, e, x, r) : ProjectInsideElement(m_mesh, e, x, r));
+}
 
-	vec3f y[FEElement::MAX_NODES];
-	OCTREE_BOX* b = FindBox(x);
-	if (b == 0) return false;
-	assert(b->m_level == 0);
+//-----------------------------------------------------------------------------
+// Used when there are too many candidates to sort: tests all candidates and keeps
+// the lowest element index.
+bool FEFindElement::FindElementSlow(const vec3f& x, int& nelem, double r[3])
+{
+	nelem = -1;
 
-	int NE = (int)b->m_child.size();
-	for (int i = 0; i<NE; ++i)
+	int stack[BVH_MAX_DEPTH];
+	int ns = 0;
+	stack[ns++] = 0;
+	double q[3];
+	while (ns > 0)
 	{
-		OCTREE_BOX* c = b->m_child[i];
-		assert(c->m_level == -1);
-
-		int nid = c->m_elem; assert(nid >= 0);
+		int n = stack[--ns];
+		const NODE& node = m_node[n];
+		if (isInside(node, x) == false) continue;
 
-		FEElement_& e = m_mesh.ElementRef(nid);
-		nelem = nid;
+		if (node.m_count == 0)
+		{
+			stack[ns++] = node.m_first;
+			stack[ns++] = n + 1;
+			continue;
+		}
 
-		// do a quick bounding box test
-		if (c->m_box.IsInside(x))
+		for (int i = node.m_first; i < node.m_first + node.m_count; ++i)
 		{
-			// do a more complete search
-			if (ProjectInsideElement(m_mesh, e, x, r)) return true;
+			int nid = m_elem[i];
+			if ((nelem >= 0) && (nid > nelem)) continue;
+
+			if (isInside(m_elemBox[i], x) && ProjectInside(nid, x, q))
+			{
+				nelem = nid;
+				r[0] = q[0]; r[1] = q[1]; r[2] = q[2];
+			}
 		}
 	}
 
-	nelem = -1;
-	return false;
+	return (nelem >= 0);
 }
@@ -26,60 +26,85 @@ SOFTWARE.*/
 
 #pragma once
 #include <FSCore/box.h>
+#include <vector>
 
 class FECoreMesh;
 
+//-----------------------------------------------------------------------------
+// Finds the element that contains a point. The element bounding boxes are kept in
+// a bounding volume hierarchy that is stored in flat arrays. The elements are
+// sorted along a Morton curve and the tree is built by splitting this list in
+// halves, so its topology only depends on the number of elements. When Init is
+// called again for the same elements (e.g. for a new state), the boxes are just
+// refitted. FindElement does not modify the object, so it can be called from
+// multiple threads.
+// The batch functions process many points in parallel. Each point can come with
+// the element of a nearby point (e.g. the previous point along a path). That
+// element and its neighbors are tried first, so that the hierarchy only needs to
+// be searched when the point moved further away.
 class FEFindElement
 {
-public:
-	class OCTREE_BOX
-	{
-	public:
-		BOX					m_box;
-		vector<OCTREE_BOX*>	m_child;
-		int					m_elem;
-		int					m_level;
-
-	public:
-		OCTREE_BOX();
-		~OCTREE_BOX();
-
-		void split(int levels);
-
-		OCTREE_BOX* Find(const vec3f& r);
-
-		bool IsInside(const vec3f& r) const { return m_box.IsInside(r); }
-
-		void Add(BOX& b, int nelem);
-	};
-
 public:
 	FEFindElement(FECoreMesh& mesh);
 
 	void Init(int nframe = 0);
-	void Init(vector<bool>& flags, int nframe = 0);
+	void Init(std::vector<bool>& flags, int nframe = 0);
 
 	bool FindElement(const vec3f& x, int& nelem, double r[3]);
 
-	BOX BoundingBox() const { return m_bound.m_box; }
+	// Same, but the element hint (or its neighbors) is tried first. If the point
+	// lies in the hint, it is returned even if an element with a lower index also
+	// contains the point.
+	bool FindElement(const vec3f& x, int hint, int& nelem, double r[3]);
 
-private:
-	void InitReferenceFrame(vector<bool>& flags);
-	void InitCurrentFrame(vector<bool>& flags);
+	// Find the elements of n points. On input, nelem holds the element hints (or -1),
+	// on output the elements (or -1 if the point was not found). The iso-parametric
+	// coordinates are returned in r (3 per point). Returns the nr of points found.
+	int FindElements(int n, const vec3f* x, int* nelem, double* r);
+
+	// Same as FindElements, but returns the nodal values v interpolated at the points.
+	int Interpolate(int n, const vec3f* x, int* nelem, const float* v, float* val);
+	int Interpolate(int n, const vec3f* x, int* nelem, const vec3f* v, vec3f* val);
 
-	bool FindInReferenceFrame(const vec3f& x, int& nelem, double r[3]);
-	bool FindInCurrentFrame(const vec3f& x, int& nelem, double r[3]);
+	BOX BoundingBox() const { return m_box; }
 
 private:
-	OCTREE_BOX* FindBox(const vec3f& r);
+	// a node of the hierarchy. The left child of an interior node directly
+	// follows it, the right child is stored in m_next. A leaf stores the range
+	// [m_first, m_first + m_count) of the element list.
+	struct NODE
+	{
+		float	r0[3], r1[3];
+		int		m_first;	// first element (leaf) or right child (interior)
+		int		m_count;	// number of elements (0 for interior nodes)
+	};
+
+	// bounding box of an element
+	struct ELEM_BOX
+	{
+		float	r0[3], r1[3];
+	};
+
+	void Build(std::vector<bool>& flags);
+	int BuildNode(int n0, int n1);
+	void UpdateBoxes();
+	void Refit();
+
+	bool ProjectInside(int nelem, const vec3f& x, double r[3]);
+	bool IsSelected(int nelem);
+	bool FindNear(const vec3f& x, int hint, int& nelem, double r[3]);
+	bool FindElementSlow(const vec3f& x, int& nelem, double r[3]);
 
 private:
-	OCTREE_BOX	m_bound;
 	FECoreMesh&	m_mesh;
 	int			m_nframe;	// = 0 reference, 1 = current
-};
 
-inline bool FEFindElement::FindElement(const vec3f& x, int& nelem, double r[3])
-{
-	return (m_nframe == 0 ? FindInReferenceFrame(x, nelem, r) : FindInCurrentFrame(x, nelem, r));
-}
+	BOX						m_box;		// bounding box of the mesh
+	std::vector<NODE>		m_node;		// the hierarchy (root is first)
+	std::vector<int>		m_elem;		// element indices, in leaf order
+	std::vector<ELEM_BOX>	m_elemBox;	// element boxes, in leaf order
+
+	// the element selection the hierarchy was built for
+	std::vector<bool>	m_flags;
+	int					m_NE;
+};
@@ -29,9 +29,7 @@ SOFTWARE.*/
 #include "triangulate.h"
 #include "FESurfaceMesh.h"
 #include "MeshMetrics.h"
-#include "FENodeElementList.h"
-#include "FENodeFaceList.h"
-#include "FENodeEdgeList.h"
+#include "FENodeKeyTable.h"
 #include "MeshTools/FENodeData.h"
 #include "MeshTools/FESurfaceData.h"
 #include "MeshTools/FEElementData.h"
@@ -179,8 +177,9 @@ FEMesh::FEMesh(FEMesh& m)
 	for (int i=0; i<Nodes(); ++i) m_Node[i] = m.m_Node[i];
 
 	// create the elements
-	m_Elem.resize(m.Elements());
+	ResizeElems(m.Elements());
 	for (int i = 0; i<Elements(); ++i) m_Elem[i] = m.m_Elem[i];
+	CompactElements();
 
 	// create the faces
 	m_Face.resize(m.Faces());
@@ -214,6 +213,7 @@ void FEMesh::Clear()
 	m_Edge.clear();
 	m_Face.clear();
 	m_Elem.clear();
+	m_elemStore.Clear();
 	m_Node.clear();
 
 	ClearMeshData();
@@ -234,7 +234,7 @@ void FEMesh::Create(int nodes, int elems, int faces, int edges)
 {
 	// allocate storage
 	if (nodes > 0) { if (nodes) m_Node.resize(nodes); else m_Node.clear(); }
-	if (elems > 0) { if (elems) m_Elem.resize(elems); else m_Elem.clear(); }
+	if (elems > 0) ResizeElems(elems);
 	if (faces > 0) { if (faces) m_Face.resize(faces); else m_Face.clear(); }
 	if (edges > 0) { if (edges) m_Edge.resize(edges); else m_Edge.clear(); }
 
@@ -261,9 +261,25 @@ void FEMesh::ResizeFaces(int newSize)
 }
 
 //-----------------------------------------------------------------------------
+// New elements don't have a type yet, so they get room for the largest element.
+// CompactElements releases the unused room after the element types are set.
 void FEMesh::ResizeElems(int newSize)
 {
+	int n0 = (int)m_Elem.size();
 	m_Elem.resize(newSize);
+	m_elemStore.Add(m_Elem, n0);
+}
+
+//-----------------------------------------------------------------------------
+void FEMesh::CompactElements()
+{
+	m_elemStore.Compact(m_Elem);
+}
+
+//-----------------------------------------------------------------------------
+size_t FEMesh::ElementMemorySize() const
+{
+	return m_Elem.capacity()*sizeof(FEElement) + m_elemStore.MemorySize();
 }
 
 //-----------------------------------------------------------------------------
@@ -601,6 +617,9 @@ void FEMesh::RebuildElementData()
 	assert(ValidateElements());
 #endif
 
+	// release the element storage that was not used when the elements were created
+	CompactElements();
+
 	// Make sure all gids are sequential
 	UpdateElementPartitions();
 
@@ -722,6 +741,27 @@ bool FEMesh::ValidateEdges() const
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// helper function that returns the topology key of a face
+static FENodeKey faceKey(const FEFace& f)
+{
+	if (f.Shape() == FE_FACE_QUAD) return FENodeKey(f.n[0], f.n[1], f.n[2], f.n[3]);
+	else return FENodeKey(f.n[0], f.n[1], f.n[2]);
+}
+
+//-----------------------------------------------------------------------------
+// helper function that calculates the topology key of face j of a solid element.
+// Returns the number of nodes of the face.
+static int elementFaceKey(const FEElement& el, int j, FENodeKey& key)
+{
+	int ln[FEFace::MAX_NODES];
+	int nn = el.GetLocalFaceIndices(j, ln);
+	const int* n = el.m_node;
+	if ((nn == 4) || (nn == 8) || (nn == 9)) key = FENodeKey(n[ln[0]], n[ln[1]], n[ln[2]], n[ln[3]]);
+	else key = FENodeKey(n[ln[0]], n[ln[1]], n[ln[2]]);
+	return nn;
+}
+
 //-----------------------------------------------------------------------------
 // This function finds the element neighbours.
 //
@@ -731,9 +771,10 @@ void FEMesh::UpdateElementNeighbors()
 	int elems = Elements();
 
 	// reset all element neighbor and face ptrs
+#pragma omp parallel for
 	for (int i = 0; i < elems; i++)
 	{
-		FEElement_& el = ElementRef(i);
+		FEElement& el = m_Elem[i];
 		el.m_ntag = i;
 		for (int j = 0; j < 6; ++j)
 		{
@@ -742,112 +783,91 @@ void FEMesh::UpdateElementNeighbors()
 		}
 	}
 
-	// calculate the node-element table
-	FENodeElementList NET;
-	NET.Build(this);
-
-	// set up the element's neighbour pointers
-	FEEdge edge;
-	int nbrf, nbre;
-	FEFace f1, f2, f3;
+	// build a table of the faces of the solid elements and the edges of the shell elements
+	// (item 6*i + j refers to face or edge j of element i)
+	FENodeKeyTable table;
+	table.Build(6 * elems, [this](int n, FENodeKey& key) {
+		FEElement& el = m_Elem[n / 6];
+		int j = n % 6;
+		if (j < el.Faces())
+		{
+			elementFaceKey(el, j, key);
+			return true;
+		}
+		if (j < el.Edges())
+		{
+			FEEdge e = el.GetEdge(j);
+			key = FENodeKey(e.n[0], e.n[1]);
+			return true;
+		}
+		return false;
+	});
 
 	// assign neighbor elements
+#pragma omp parallel for schedule(dynamic, 4096)
 	for (int i = 0; i < elems; i++)
 	{
-		FEElement_* pe = ElementPtr(i);
+		FEElement& el = m_Elem[i];
+
 		// do the solid elements
-		int n = pe->Faces();
+		// (faces match if they have the same corner nodes and the same number of nodes)
+		FENodeKey k1, k2;
+		int n = el.Faces();
 		for (int j = 0; j < n; j++)
 		{
-			if (pe->m_nbr[j] == -1)
-			{
-				pe->GetFace(j, f1);
-
-				// find the neighbour element
-				int inode = f1.n[0];
-				int nval = NET.Valence(inode);
-				bool bfound = false;
-				for (int k = 0; k < nval; k++)
-				{
-					int nbe = NET.ElementIndex(inode, k);
-					FEElement_* pne = ElementPtr(nbe);
-					if (pne != pe)
-					{
-						nbrf = pne->Faces();
-						int l;
-						for (l = 0; l < nbrf; l++)
-						{
-							pne->GetFace(l, f2);
-							if (f1 == f2)
-							{
-								bfound = true;
-								break;
-							}
-						}
-
-						if (bfound)
-						{
-							pe->m_nbr[j] = nbe;
-							pne->m_nbr[l] = i;
-							break;
-						}
-					}
-				}
-			}
+			int n1 = elementFaceKey(el, j, k1);
+			int m = table.Find(k1, [&](int item) {
+				int k = item / 6;
+				if (k == i) return false;
+				FEElement& ek = m_Elem[k];
+				if (item % 6 >= ek.Faces()) return false;
+				int n2 = elementFaceKey(ek, item % 6, k2);
+				return ((n1 == n2) && (k1 == k2));
+			});
+			if (m >= 0) el.m_nbr[j] = m / 6;
 		}
 
 		// do the shell elements
-		n = pe->Edges();
+		n = el.Edges();
 		for (int j = 0; j < n; j++)
 		{
-			if (pe->m_nbr[j] == -1)
-			{
-				edge = pe->GetEdge(j);
-
-				// find the neighbour element
-				int inode = edge.n[0];
-				int nval = NET.Valence(inode);
-				bool bfound = false;
-				for (int k = 0; k < nval; k++)
-				{
-					FEElement_* pne = NET.Element(inode, k);
-					if ((pne != pe) && (pe->is_equal(*pne) == false))
-					{
-						nbre = pne->Edges();
-						for (int l = 0; l < nbre; l++)
-							if (edge == pne->GetEdge(l))
-							{
-								pe->m_nbr[j] = NET.ElementIndex(inode, k);
-								pne->m_nbr[l] = i;
-								break;
-							}
-					}
-				}
-			}
+			FEEdge edge = el.GetEdge(j);
+			int m = table.Find(FENodeKey(edge.n[0], edge.n[1]), [&](int item) {
+				int k = item / 6;
+				if (k == i) return false;
+				FEElement& ek = m_Elem[k];
+				if (item % 6 >= ek.Edges()) return false;
+				if (el.is_equal(ek)) return false;
+				return (edge == ek.GetEdge(item % 6));
+			});
+			if (m >= 0) el.m_nbr[j] = m / 6;
 		}
+	}
+
+	// do the beam elements
+	vector<int> beams;
+	for (int i = 0; i < elems; ++i) if (m_Elem[i].IsType(FE_BEAM2)) beams.push_back(i);
+	int NB = (int)beams.size();
+	if (NB == 0) return;
 
-		// do the beam elements
-		if (pe->IsType(FE_BEAM2))
+	// build a table of the beam nodes (item 2*i + j refers to node j of beam i)
+	FENodeKeyTable beamTable;
+	beamTable.Build(2 * NB, [&](int n, FENodeKey& key) {
+		key = FENodeKey(m_Elem[beams[n / 2]].m_node[n % 2]);
+		return true;
+	});
+
+#pragma omp parallel for
+	for (int i = 0; i < NB; ++i)
+	{
+		FEElement& el = m_Elem[beams[i]];
+		for (int j = 0; j < 2; ++j)
 		{
-			for (int j = 0; j < 2; ++j)
-			{
-				pe->m_nbr[j] = -1;
-				pe->m_face[j] = -1;
-				int inode = pe->m_node[j];
-				int nval = NET.Valence(inode);
-				for (int k = 0; k < nval; ++k)
-				{
-					FEElement_* pne = NET.Element(inode, k);
-					if (pne != pe)
-					{
-						if ((pne->IsType(FE_BEAM2)) && ((pne->m_node[0] == pe->m_node[j]) || (pne->m_node[1] == pe->m_node[j])))
-						{
-							pe->m_nbr[j] = NET.ElementIndex(inode, k);
-							break;
-						}
-					}
-				}
-			}
+			int node = el.m_node[j];
+			int m = beamTable.Find(FENodeKey(node), [&](int item) {
+				return ((item / 2 != i) && (m_Elem[beams[item / 2]].m_node[item % 2] == node));
+			});
+			if (m >= 0) el.m_nbr[j] = beams[m / 2];
 		}
 	}
 }
@@ -931,6 +951,7 @@ void FEMesh::UpdateFaceElementTable()
 	if ((NF == 0) || (NE == 0)) return;
 
 	// clear all face-element connectivity
+#pragma omp parallel for
 	for (int i = 0; i<NF; ++i)
 	{
 		FEFace& f = Face(i);
@@ -938,110 +959,85 @@ void FEMesh::UpdateFaceElementTable()
 		f.m_elem[1].eid = -1;
 	}
 
+	// build a table of the mesh faces
+	FENodeKeyTable table;
+	table.Build(NF, [this](int n, FENodeKey& key) {
+		key = faceKey(Face(n));
+		return true;
+	});
+
+	// find the mesh face of each solid element face
+#pragma omp parallel for schedule(dynamic, 4096)
 	for (int i = 0; i<NE; ++i)
 	{
 		FEElement& el = Element(i);
-
-		// solid elements
+		FEFace f2;
 		int nf = el.Faces();
-		for (int i = 0; i<nf; ++i)
+		for (int k = 0; k<nf; ++k)
 		{
-			el.m_face[i] = -1;
-		}
-
-		// shell elements
-		int ne = el.Edges();
-		if (ne > 0)
-		{
-			el.m_face[0] = -1;
+			el.GetFace(k, f2);
+			el.m_face[k] = table.Find(faceKey(f2), [&](int n) { return (f2 == Face(n)); });
 		}
+		if (el.Edges() > 0) el.m_face[0] = -1;
 	}
 
-	// first build the node element table
-	FENodeElementList NET;
-	NET.Build(this);
-
-	// loop over all faces
-	FEFace f2;
-	for (int i = 0; i<NF; ++i)
+	// set the face-element connectivity of the solid elements
+	for (int i = 0; i<NE; ++i)
 	{
-		FEFace& face = Face(i);
-
-		int n0 = face.n[0];
-		int nval = NET.Valence(n0);
-		int m = 0;
-		for (int j=0; j<nval; ++j)
+		FEElement& el = Element(i);
+		int nf = el.Faces();
+		for (int k = 0; k<nf; ++k)
 		{
-			int eid = NET.ElementIndex(n0, j);
-			FEElement_* pej = ElementPtr(eid);
-
-			// solid elements
-			int n = pej->Faces();
-			for (int k = 0; k<n; ++k)
+			if (el.m_face[k] == -1) continue;
+			FEFace& face = Face(el.m_face[k]);
+			if (face.m_elem[0].eid == -1)
+			{
+				face.m_elem[0].eid = i;
+				face.m_elem[0].lid = k;
+			}
+			else if (face.m_elem[1].eid == -1)
 			{
-				if (pej->m_face[k] == -1)
+				// set the element with the lowest GID first
+				FEElement& e0 = Element(face.m_elem[0].eid);
+				if (e0.m_gid < el.m_gid)
 				{
-					pej->GetFace(k, f2);
-					if (f2 == face)
-					{
-//						assert(m<2);
-						if (m == 0)
-						{
-							face.m_elem[m  ].eid = eid;
-							face.m_elem[m++].lid = k;
-						}
-						else if (m < 2)
-						{
-							// set the element with the lowest GID first
-							FEElement_* p0 = ElementPtr(face.m_elem[0].eid);
-							if (p0->m_gid < pej->m_gid)
-							{
-								face.m_elem[m  ].eid = eid;
-								face.m_elem[m++].lid = k;
-							}
-							else
-							{
-								face.m_elem[m  ].eid = face.m_elem[0].eid;
-								face.m_elem[m++].lid = face.m_elem[0].lid;
-
-								face.m_elem[0].eid = eid;
-								face.m_elem[0].lid = k;
-							}
-						}
-						pej->m_face[k] = i;
-					}
+					face.m_elem[1].eid = i;
+					face.m_elem[1].lid = k;
+				}
+				else
+				{
+					face.m_elem[1] = face.m_elem[0];
+					face.m_elem[0].eid = i;
+					face.m_elem[0].lid = k;
 				}
 			}
 		}
+	}
 
-		// shells
-		for (int j=0; j<nval; ++j)
+	// shells are attached to the first matching face that is not attached to an element yet
+	// (Note that shells on top of solids have their own face.)
+	FEFace f2;
+	for (int i = 0; i<NE; ++i)
+	{
+		FEElement& el = Element(i);
+		if (el.Edges() > 0)
 		{
-			int eid = NET.ElementIndex(n0, j);
-			FEElement_* pej = ElementPtr(eid);
-
-			int n = pej->Edges();
-			if (n > 0)
+			el.GetShellFace(f2);
+			int fid = table.Find(faceKey(f2), [&](int n) { return (Face(n).m_elem[0].eid == -1) && (f2 == Face(n)); });
+			if (fid >= 0)
 			{
-				if (pej->m_face[0] == -1)
-				{
-					pej->GetShellFace(f2);
-					if (f2 == face)
-					{
-						if (m == 0) 
-						{	
-							face.m_elem[m  ].eid = eid;
-							face.m_elem[m++].lid = 0;
-							pej->m_face[0] = i;
-						}
-					}
-				}
+				FEFace& face = Face(fid);
+				face.m_elem[0].eid = i;
+				face.m_elem[0].lid = 0;
+				el.m_face[0] = fid;
 			}
 		}
-
-		assert(face.m_elem[0].eid != -1);
 	}
 
+#ifdef _DEBUG
+	for (int i = 0; i<NF; ++i) assert(Face(i).m_elem[0].eid != -1);
+#endif
+
 	MarkExteriorFaces();
 }
 
@@ -1104,39 +1100,41 @@ void FEMesh::UpdateFaceNeighbors()
 	}
 	while (S.empty() == false);
 
-	// build the node-face table
-	FENodeFaceList NFT;
-	NFT.Build(this);
+	// build a table of the face edges (item 4*i + j refers to edge j of face i)
+	FENodeKeyTable table;
+	table.Build(4 * NF, [this](int n, FENodeKey& key) {
+		const FEFace& f = Face(n / 4);
+		if (n % 4 >= f.Edges()) return false;
+		int en[4];
+		f.GetEdgeNodes(n % 4, en);
+		key = FENodeKey(en[0], en[1]);
+		return true;
+	});
 
 	// find all face neighbours
-	int n[4];
+#pragma omp parallel for schedule(dynamic, 4096)
 	for (int i = 0; i<NF; ++i)
 	{
 		FEFace* pf = FacePtr(i);
 
+		int n[4];
 		int ne = pf->Edges();
 		for (int j = 0; j<ne; ++j)
 		{
 			pf->GetEdgeNodes(j, n);
-			int nval = NFT.Valence(n[0]);
-			pf->m_nbr[j] = -1;
-			for (int k = 0; k<nval; ++k)
-			{
-				FEFace* pfn = NFT.Face(n[0], k);
-				if (pfn != pf)
+			int m = table.Find(FENodeKey(n[0], n[1]), [&](int item) {
+				if (item / 4 == i) return false;
+				FEFace* pfn = FacePtr(item / 4);
+
+				// See if the faces share an edge
+				if (pfn->HasEdge(n[0], n[1]) && (pf->m_ntag == pfn->m_ntag))
 				{
-					// See if the faces share an edge
-					if (pfn->HasEdge(n[0], n[1]) && (pf->m_ntag == pfn->m_ntag))
-					{
-						// see if they are both external or both internal
-						if (isValidFaceNeighbor(*pf, *pfn))
-						{
-							pf->m_nbr[j] = NFT.FaceIndex(n[0], k);
-							break;
-						}
-					}
+					// see if they are both external or both internal
+					if (isValidFaceNeighbor(*pf, *pfn)) return true;
 				}
-			}
+				return false;
+			});
+			pf->m_nbr[j] = (m >= 0 ? m / 4 : -1);
 		}
 	}
 }
@@ -1145,30 +1143,42 @@ void FEMesh::UpdateFaceNeighbors()
 // This function finds the edge neighbours.
 void FEMesh::UpdateEdgeNeighbors()
 {
-	FENodeEdgeList NET;
-	NET.Build(this, true);
+	int NE = Edges();
 
-	for (int i = 0; i<Edges(); ++i)
+	// build a table of the nodes of the exterior edges (item 2*i + j refers to node j of edge i)
+	FENodeKeyTable table;
+	table.Build(2 * NE, [this](int n, FENodeKey& key) {
+		const FEEdge& edge = Edge(n / 2);
+		if (edge.IsExterior() == false) return false;
+		key = FENodeKey(edge.n[n % 2]);
+		return true;
+	});
+
+#pragma omp parallel for
+	for (int i = 0; i<NE; ++i)
 	{
 		FEEdge& edge = Edge(i);
 		edge.m_nbr[0] = -1;
 		edge.m_nbr[1] = -1;
-	}
-
-	for (int i = 0; i<Edges(); ++i)
-	{
-		FEEdge& edge = Edge(i);
 		if (edge.IsExterior())
 		{
 			for (int j = 0; j<2; ++j)
 			{
 				int nj = edge.n[j]; assert(nj != -1);
-				int val = NET.Edges(nj);
-				if (val == 2)
+
+				// count the exterior edges that share this node
+				int val = 0, nk = -1;
+				table.Find(FENodeKey(nj), [&](int item) {
+					if (Edge(item / 2).n[item % 2] == nj)
+					{
+						val++;
+						if (item / 2 != i) nk = item / 2;
+					}
+					return false;
+				});
+
+				if ((val == 2) && (nk != -1))
 				{
-					assert((NET.EdgeIndex(nj, 0) == i) || (NET.EdgeIndex(nj, 1) == i));
-					int nk = NET.EdgeIndex(nj, 0);
-					if (nk == i) nk = NET.EdgeIndex(nj, 1); assert(nk != i);
 					assert(Edge(nk).IsExterior());
 					if (Edge(nk).m_gid == edge.m_gid)
 					{
@@ -1323,84 +1333,100 @@ void FEMesh::Save(OArchive &ar)
 	}
 	ar.EndChunk();
 
+	// The nodes, elements, faces and edges are written as bulk arrays, one
+	// chunk per attribute, which is much faster to read than a chunk per item.
+
 	// write the nodes
 	ar.BeginChunk(CID_MESH_NODE_SECTION);
+	if (nodes > 0)
 	{
-		FENode* pn = NodePtr();
-		for (int i=0; i<nodes; ++i, ++pn)
+		vector<int> gid(nodes);
+		vector<double> r(3 * nodes);
+		for (int i = 0; i < nodes; ++i)
 		{
-			ar.BeginChunk(CID_MESH_NODE);
-			{
-				ar.WriteChunk(CID_MESH_NODE_GID, pn->m_gid);
-				ar.WriteChunk(CID_MESH_NODE_POSITION, pn->r);
-			}
-			ar.EndChunk();
+			const FENode& node = m_Node[i];
+			gid[i] = node.m_gid;
+			r[3 * i    ] = node.r.x;
+			r[3 * i + 1] = node.r.y;
+			r[3 * i + 2] = node.r.z;
 		}
+		ar.WriteChunk(CID_MESH_NODE_GID_ARRAY     , std::move(gid));
+		ar.WriteChunk(CID_MESH_NODE_POSITION_ARRAY, std::move(r));
 	}
 	ar.EndChunk();
 
 	// write the elements
 	ar.BeginChunk(CID_MESH_ELEMENT_SECTION);
+	if (elems > 0)
 	{
-		for (int i=0; i<elems; ++i)
+		vector<int> type(elems), gid(elems), node;
+		vector<double> fiber(3 * elems), Q(9 * elems), h;
+		vector<char> Qactive(elems);
+		node.reserve(elems * 4);
+		for (int i = 0; i < elems; ++i)
 		{
-			FEElement_* pe = ElementPtr(i);
-
-			ar.BeginChunk(CID_MESH_ELEMENT);
-			{
-				int ntype = pe->Type();
-				ar.WriteChunk(CID_MESH_ELEMENT_TYPE    , ntype);
-				ar.WriteChunk(CID_MESH_ELEMENT_GID     , pe->m_gid);
-				ar.WriteChunk(CID_MESH_ELEMENT_NODES   , pe->m_node, pe->Nodes());
-				ar.WriteChunk(CID_MESH_ELEMENT_FIBER   , pe->m_fiber);
-				ar.WriteChunk(CID_MESH_ELEMENT_Q_ACTIVE, pe->m_Qactive);
-				ar.WriteChunk(CID_MESH_ELEMENT_Q       , pe->m_Q);
-				if (pe->IsShell())
-					ar.WriteChunk(CID_MESH_SHELL_THICKNESS , pe->m_h, pe->Nodes());
-//				ar.WriteChunk(CID_MESH_ELEMENT_MATERIAL, mid);
-			}
-			ar.EndChunk();
+			const FEElement& el = m_Elem[i];
+			int ne = el.Nodes();
+			type[i] = el.Type();
+			gid[i] = el.m_gid;
+			node.insert(node.end(), el.m_node, el.m_node + ne);
+			vec3d a = el.Fiber();
+			mat3d Qi = el.LocalAxes();
+			fiber[3 * i    ] = a.x;
+			fiber[3 * i + 1] = a.y;
+			fiber[3 * i + 2] = a.z;
+			Qactive[i] = (el.LocalAxesActive() ? 1 : 0);
+			for (int j = 0; j < 9; ++j) Q[9 * i + j] = Qi(j / 3, j % 3);
+			if (el.IsShell()) h.insert(h.end(), el.m_h, el.m_h + ne);
 		}
+		ar.WriteChunk(CID_MESH_ELEMENT_TYPE_ARRAY    , std::move(type));
+		ar.WriteChunk(CID_MESH_ELEMENT_GID_ARRAY     , std::move(gid));
+		ar.WriteChunk(CID_MESH_ELEMENT_NODES_ARRAY   , std::move(node));
+		ar.WriteChunk(CID_MESH_ELEMENT_FIBER_ARRAY   , std::move(fiber));
+		ar.WriteChunk(CID_MESH_ELEMENT_Q_ACTIVE_ARRAY, std::move(Qactive));
+		ar.WriteChunk(CID_MESH_ELEMENT_Q_ARRAY       , std::move(Q));
+		if (h.empty() == false) ar.WriteChunk(CID_MESH_SHELL_THICKNESS_ARRAY, std::move(h));
 	}
 	ar.EndChunk();
 
 	// write the faces
 	ar.BeginChunk(CID_MESH_FACE_SECTION);
+	if (faces > 0)
 	{
-		FEFace* pf = FacePtr();
-		for (int i=0; i<faces; ++i, ++pf)
+		vector<int> type(faces), gid(faces), sid(faces), node;
+		node.reserve(faces * 3);
+		for (int i = 0; i < faces; ++i)
 		{
-			ar.BeginChunk(CID_MESH_FACE);
-			{
-				int nn = pf->Nodes();
-				int ntype = pf->Type();
-				assert(ntype != FE_FACE_INVALID_TYPE);
-				ar.WriteChunk(CID_MESH_FACE_TYPE    , ntype);
-				ar.WriteChunk(CID_MESH_FACE_GID     , pf->m_gid);
-				ar.WriteChunk(CID_MESH_FACE_NODES   , pf->n, pf->Nodes());
-				ar.WriteChunk(CID_MESH_FACE_SMOOTHID, pf->m_sid);
-			}
-			ar.EndChunk();
+			const FEFace& face = m_Face[i];
+			assert(face.Type() != FE_FACE_INVALID_TYPE);
+			type[i] = face.Type();
+			gid[i] = face.m_gid;
+			sid[i] = face.m_sid;
+			node.insert(node.end(), face.n, face.n + face.Nodes());
 		}
+		ar.WriteChunk(CID_MESH_FACE_TYPE_ARRAY    , std::move(type));
+		ar.WriteChunk(CID_MESH_FACE_GID_ARRAY     , std::move(gid));
+		ar.WriteChunk(CID_MESH_FACE_NODES_ARRAY   , std::move(node));
+		ar.WriteChunk(CID_MESH_FACE_SMOOTHID_ARRAY, std::move(sid));
 	}
 	ar.EndChunk();
 
 	// write the edges
 	ar.BeginChunk(CID_MESH_EDGE_SECTION);
+	if (edges > 0)
 	{
-		FEEdge* pe = EdgePtr();
-		for (int i=0; i<edges; ++i, ++pe)
+		vector<int> type(edges), gid(edges), node;
+		node.reserve(edges * 2);
+		for (int i = 0; i < edges; ++i)
 		{
-			int nn = pe->Nodes();
-			int ntype = pe->Type();
-			ar.BeginChunk(CID_MESH_EDGE);
-			{
-				ar.WriteChunk(CID_MESH_EDGE_TYPE, ntype);
-				ar.WriteChunk(CID_MESH_EDGE_GID, pe->m_gid);
-				ar.WriteChunk(CID_MESH_EDGE_NODES, pe->n, nn);
-			}
-			ar.EndChunk();
+			const FEEdge& edge = m_Edge[i];
+			type[i] = edge.Type();
+			gid[i] = edge.m_gid;
+			node.insert(node.end(), edge.n, edge.n + edge.Nodes());
 		}
+		ar.WriteChunk(CID_MESH_EDGE_TYPE_ARRAY , std::move(type));
+		ar.WriteChunk(CID_MESH_EDGE_GID_ARRAY  , std::move(gid));
+		ar.WriteChunk(CID_MESH_EDGE_NODES_ARRAY, std::move(node));
 	}
 	ar.EndChunk();
 
@@ -1531,6 +1557,13 @@ void FEMesh::Save(OArchive &ar)
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Reads a bulk array chunk and checks that it has the expected size.
+template <typename T> static void ReadArray(IArchive& ar, vector<T>& a, size_t n, const char* szerr)
+{
+	if ((ar.read(a) != IArchive::IO_OK) || (a.size() != n)) throw ReadError(szerr);
+}
+
 //-----------------------------------------------------------------------------
 // Load mesh data from archive
 //
@@ -1603,6 +1636,18 @@ void FEMesh::Load(IArchive& ar)
 						++pn;
 						++n;
 					}
+					else if (nid == CID_MESH_NODE_GID_ARRAY)
+					{
+						vector<int> gid;
+						ReadArray(ar, gid, nodes, "error parsing CID_MESH_NODE_SECTION (FEMesh::Load)");
+						for (int i = 0; i < nodes; ++i) m_Node[i].m_gid = gid[i];
+					}
+					else if (nid == CID_MESH_NODE_POSITION_ARRAY)
+					{
+						vector<double> r;
+						ReadArray(ar, r, 3 * nodes, "error parsing CID_MESH_NODE_SECTION (FEMesh::Load)");
+						for (int i = 0; i < nodes; ++i) m_Node[i].r = vec3d(r[3 * i], r[3 * i + 1], r[3 * i + 2]);
+					}
 					ar.CloseChunk();
 				}
 			}
@@ -1610,6 +1655,8 @@ void FEMesh::Load(IArchive& ar)
 		case CID_MESH_ELEMENT_SECTION:
 			{
 				int n = 0;
+				bool btype = false;
+				const char* szerr = "error parsing CID_MESH_ELEMENT_SECTION (FEMesh::Load)";
 				FEElement* pe = &m_Elem[0];
 				while (IArchive::IO_OK == ar.OpenChunk())
 				{
@@ -1630,9 +1677,9 @@ void FEMesh::Load(IArchive& ar)
 									else ar.read(pe->m_node, pe->Nodes());
 								}
 								break;
-							case CID_MESH_ELEMENT_FIBER   : ar.read(pe->m_fiber); break;
-							case CID_MESH_ELEMENT_Q_ACTIVE: ar.read(pe->m_Qactive); break;
-							case CID_MESH_ELEMENT_Q       :  ar.read(pe->m_Q); break;
+							case CID_MESH_ELEMENT_FIBER   : { vec3d a; ar.read(a); pe->SetFiber(a); } break;
+							case CID_MESH_ELEMENT_Q_ACTIVE: { bool b; ar.read(b); pe->SetLocalAxesActive(b); } break;
+							case CID_MESH_ELEMENT_Q       : { mat3d Q; ar.read(Q); pe->SetLocalAxes(Q); } break;
 
 							case CID_MESH_SHELL_THICKNESS:
 								{
@@ -1649,6 +1696,75 @@ void FEMesh::Load(IArchive& ar)
 						++n;
 						++pe;
 					}
+					else if (nid == CID_MESH_ELEMENT_TYPE_ARRAY)
+					{
+						vector<int> type;
+						ReadArray(ar, type, elems, szerr);
+						for (int i = 0; i < elems; ++i) m_Elem[i].SetType(type[i]);
+						btype = true;
+					}
+					else if (nid == CID_MESH_ELEMENT_GID_ARRAY)
+					{
+						vector<int> gid;
+						ReadArray(ar, gid, elems, szerr);
+						for (int i = 0; i < elems; ++i) m_Elem[i].m_gid = gid[i];
+					}
+					else if (nid == CID_MESH_ELEMENT_NODES_ARRAY)
+					{
+						// the types are needed to know the nr of nodes of each element
+						if (btype == false) throw ReadError(szerr);
+						size_t size = 0;
+						for (int i = 0; i < elems; ++i) size += m_Elem[i].Nodes();
+
+						vector<int> node;
+						ReadArray(ar, node, size, szerr);
+						const int* pn = (node.empty() ? nullptr : &node[0]);
+						for (int i = 0; i < elems; ++i)
+						{
+							FEElement& el = m_Elem[i];
+							int ne = el.Nodes();
+							for (int j = 0; j < ne; ++j) el.m_node[j] = pn[j];
+							pn += ne;
+						}
+					}
+					else if (nid == CID_MESH_ELEMENT_FIBER_ARRAY)
+					{
+						vector<double> a;
+						ReadArray(ar, a, 3 * elems, szerr);
+						for (int i = 0; i < elems; ++i) m_Elem[i].SetFiber(vec3d(a[3 * i], a[3 * i + 1], a[3 * i + 2]));
+					}
+					else if (nid == CID_MESH_ELEMENT_Q_ACTIVE_ARRAY)
+					{
+						vector<char> a;
+						ReadArray(ar, a, elems, szerr);
+						for (int i = 0; i < elems; ++i) m_Elem[i].SetLocalAxesActive(a[i] != 0);
+					}
+					else if (nid == CID_MESH_ELEMENT_Q_ARRAY)
+					{
+						vector<double> a;
+						ReadArray(ar, a, 9 * elems, szerr);
+						for (int i = 0; i < elems; ++i) m_Elem[i].SetLocalAxes(mat3d(&a[9 * i]));
+					}
+					else if (nid == CID_MESH_SHELL_THICKNESS_ARRAY)
+					{
+						if (btype == false) throw ReadError(szerr);
+						size_t size = 0;
+						for (int i = 0; i < elems; ++i) if (m_Elem[i].IsShell()) size += m_Elem[i].Nodes();
+
+						vector<double> a;
+						ReadArray(ar, a, size, szerr);
+						const double* ph = (a.empty() ? nullptr : &a[0]);
+						for (int i = 0; i < elems; ++i)
+						{
+							FEElement& el = m_Elem[i];
+							if (el.IsShell())
+							{
+								int ne = el.Nodes();
+								for (int j = 0; (j < ne) && (j < 9); ++j) el.m_h[j] = ph[j];
+								ph += ne;
+							}
+						}
+					}
 					else assert(false);
 					ar.CloseChunk();
 				}
@@ -1658,10 +1774,72 @@ void FEMesh::Load(IArchive& ar)
 			{
 				int n = 0;
 				FEFace* pf = FacePtr();
+				bool btype = false;
+				const char* szerr = "error parsing CID_MESH_FACE_SECTION (FEMesh::Load)";
 				while (IArchive::IO_OK == ar.OpenChunk())
 				{
 					int nid = ar.GetChunkID();
-					if (nid != CID_MESH_FACE) throw ReadError("error parsing CID_MESH_FACE_SECTION (FEMesh::Load)");
+					if (nid == CID_MESH_FACE_TYPE_ARRAY)
+					{
+						vector<int> type;
+						ReadArray(ar, type, faces, szerr);
+						for (int i = 0; i < faces; ++i)
+						{
+							switch (type[i])
+							{
+							case FE_FACE_TRI3 :
+							case FE_FACE_QUAD4:
+							case FE_FACE_TRI6 :
+							case FE_FACE_QUAD8:
+							case FE_FACE_TRI7 :
+							case FE_FACE_QUAD9:
+							case FE_FACE_TRI10:
+								m_Face[i].SetType((FEFaceType)type[i]);
+								break;
+							default:
+								throw ReadError(szerr);
+							}
+						}
+						btype = true;
+						ar.CloseChunk();
+						continue;
+					}
+					else if (nid == CID_MESH_FACE_GID_ARRAY)
+					{
+						vector<int> gid;
+						ReadArray(ar, gid, faces, szerr);
+						for (int i = 0; i < faces; ++i) m_Face[i].m_gid = gid[i];
+						ar.CloseChunk();
+						continue;
+					}
+					else if (nid == CID_MESH_FACE_NODES_ARRAY)
+					{
+						if (btype == false) throw ReadError(szerr);
+						size_t size = 0;
+						for (int i = 0; i < faces; ++i) size += m_Face[i].Nodes();
+
+						vector<int> node;
+						ReadArray(ar, node, size, szerr);
+						const int* pn = (node.empty() ? nullptr : &node[0]);
+						for (int i = 0; i < faces; ++i)
+						{
+							FEFace& face = m_Face[i];
+							int nf = face.Nodes();
+							for (int j = 0; j < nf; ++j) face.n[j] = pn[j];
+							pn += nf;
+						}
+						ar.CloseChunk();
+						continue;
+					}
+					else if (nid == CID_MESH_FACE_SMOOTHID_ARRAY)
+					{
+						vector<int> sid;
+						ReadArray(ar, sid, faces, szerr);
+						for (int i = 0; i < faces; ++i) m_Face[i].m_sid = sid[i];
+						ar.CloseChunk();
+						continue;
+					}
+					else if (nid != CID_MESH_FACE) throw ReadError(szerr);
 
 					while (IArchive::IO_OK == ar.OpenChunk())
 					{
@@ -1723,10 +1901,60 @@ void FEMesh::Load(IArchive& ar)
 			{
 				int n = 0;
 				FEEdge* pe = EdgePtr();
+				bool btype = false;
+				const char* szerr = "error parsing CID_MESH_EDGE_SECTION (FEMesh::Load)";
 				while (IArchive::IO_OK == ar.OpenChunk())
 				{
 					int nid = ar.GetChunkID();
-					if (nid != CID_MESH_EDGE) throw ReadError("error parsing CID_MESH_EDGE_SECTION (FEMesh::Load)");
+					if (nid == CID_MESH_EDGE_TYPE_ARRAY)
+					{
+						vector<int> type;
+						ReadArray(ar, type, edges, szerr);
+						for (int i = 0; i < edges; ++i)
+						{
+							switch (type[i])
+							{
+							case FE_EDGE2:
+							case FE_EDGE3:
+							case FE_EDGE4:
+								m_Edge[i].SetType((FEEdgeType)type[i]);
+								break;
+							default:
+								throw ReadError(szerr);
+							}
+						}
+						btype = true;
+						ar.CloseChunk();
+						continue;
+					}
+					else if (nid == CID_MESH_EDGE_GID_ARRAY)
+					{
+						vector<int> gid;
+						ReadArray(ar, gid, edges, szerr);
+						for (int i = 0; i < edges; ++i) m_Edge[i].m_gid = gid[i];
+						ar.CloseChunk();
+						continue;
+					}
+					else if (nid == CID_MESH_EDGE_NODES_ARRAY)
+					{
+						if (btype == false) throw ReadError(szerr);
+						size_t size = 0;
+						for (int i = 0; i < edges; ++i) size += m_Edge[i].Nodes();
+
+						vector<int> node;
+						ReadArray(ar, node, size, szerr);
+						const int* pn = (node.empty() ? nullptr : &node[0]);
+						for (int i = 0; i < edges; ++i)
+						{
+							FEEdge& edge = m_Edge[i];
+							int ne = edge.Nodes();
+							for (int j = 0; j < ne; ++j) edge.n[j] = pn[j];
+							pn += ne;
+						}
+						ar.CloseChunk();
+						continue;
+					}
+					else if (nid != CID_MESH_EDGE) throw ReadError(szerr);
 
 					int ntype;
 					while (IArchive::IO_OK == ar.OpenChunk())
@@ -1891,6 +2119,7 @@ void FEMesh::ShallowCopy(FEMesh* pm)
 	m_Edge = pm->m_Edge;
 	m_Face = pm->m_Face;
 	m_Elem = pm->m_Elem;
+	m_elemStore.Add(m_Elem);
 
 	m_data = pm->m_data;
 
@@ -26,6 +26,7 @@ SOFTWARE.*/
 
 #pragma once
 #include "FECoreMesh.h"
+#include "FEElementStore.h"
 #include <MeshTools/FEGroup.h>
 #include <MeshTools/FEMeshData.h>
 #include <vector>
@@ -180,6 +181,12 @@ public:
 	// extract faces and return as new mesh
 	FEMesh* ExtractFaces(bool selectedOnly);
 
+	// release the element storage that is no longer used
+	void CompactElements();
+
+	// memory used by the elements (in bytes)
+	size_t ElementMemorySize() const;
+
 public:
 	int MeshDataFields() const;
 	FEMeshData* GetMeshDataField(int i);
@@ -208,7 +215,8 @@ public: // --- M E S H   Q U E R I E S ---
 
 protected:
 	// elements
-	std::vector<FEElement>	m_Elem;	//!< FE elements
+	FEElementStore			m_elemStore;	//!< storage for the element data
+	std::vector<FEElement>	m_Elem;			//!< FE elements
 
 	// mesh data (used for data evaluation)
 	Mesh_Data	m_data;
@@ -217,6 +225,7 @@ protected:
 	vector<FEMeshData*>		m_meshData;
 
 	friend class FEMeshBuilder;
+	friend class FEMeshDelta;
 };
 
 double bias(double b, double x);
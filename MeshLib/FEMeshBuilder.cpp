@@ -345,7 +345,7 @@ void FEMeshBuilder::Attach(FEMesh& fem)
 		}
 		++ng;
 
-		m_mesh.m_Elem.resize(elems);
+		m_mesh.ResizeElems(elems);
 		m_mesh.m_data.Clear();
 		for (i = 0; i<ne1; ++i)
 		{
@@ -649,7 +649,7 @@ FEMesh* FEMeshBuilder::DetachSelectedMesh()
 			++n;
 		}
 	}
-	m_mesh.m_Elem.resize(n);
+	m_mesh.ResizeElems(n);
 	m_mesh.m_data.Clear();
 
 	// tag nodes which will be kept
@@ -1385,6 +1385,9 @@ void FEMeshBuilder::AutoPartitionSurface()
 // This function builds the surface, edges and node of the mesh
 void FEMeshBuilder::RebuildMesh(double smoothingAngle, bool partitionMesh)
 {
+	// release the element storage that was not used when the elements were created
+	m_mesh.CompactElements();
+
 	// update the element neighbours
 	m_mesh.UpdateElementNeighbors();
 
@@ -0,0 +1,670 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "FEMeshDelta.h"
+#include "FEMesh.h"
+#include <string.h>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+// Maps the item numbers of the base mesh to the item numbers of the stored mesh
+// (-1 if the base item is not in the stored mesh).
+struct FEMeshDeltaMaps
+{
+	std::vector<int>	node;
+	std::vector<int>	edge;
+	std::vector<int>	face;
+	std::vector<int>	elem;
+};
+
+// map an item number. Negative numbers (i.e. no item) are kept.
+static inline int mapIndex(int n, const std::vector<int>& map)
+{
+	if (n < 0) return n;
+	return (n < (int)map.size() ? map[n] : -1);
+}
+
+// Faces and edges are numbered from one. If an item is not numbered by its position,
+// the mapped ID will not match, and the item is stored in full.
+static inline int mapID(int nid, const std::vector<int>& map)
+{
+	if (nid <= 0) return nid;
+	int n = mapIndex(nid - 1, map);
+	return (n < 0 ? n : n + 1);
+}
+
+//-----------------------------------------------------------------------------
+// FNV-1a hash, used to match items
+static inline unsigned long long hashBytes(const void* pd, size_t n, unsigned long long h = 14695981039346656037ULL)
+{
+	const unsigned char* c = (const unsigned char*)pd;
+	for (size_t i = 0; i < n; ++i) { h ^= c[i]; h *= 1099511628211ULL; }
+	return h;
+}
+
+static inline unsigned long long hashInt(int v, unsigned long long h) { return hashBytes(&v, sizeof(int), h); }
+
+// The key of an item identifies it independently of its position in the array.
+// If map is given, the item's nodes are mapped first. The group ID is not part of
+// the key, since the partitions are often renumbered when the mesh is rebuilt.
+template <typename T> static unsigned long long itemKey(const T& a, const std::vector<int>* map)
+{
+	return hashBytes(&a, sizeof(T));
+}
+
+template <> unsigned long long itemKey<FENode>(const FENode& a, const std::vector<int>* map)
+{
+	return hashInt(a.m_nid, hashBytes(&a.r, sizeof(vec3d)));
+}
+
+template <typename T> static unsigned long long nodeKey(const T& a, const std::vector<int>* map)
+{
+	unsigned long long h = hashInt(a.Type(), 14695981039346656037ULL);
+	int nn = a.Nodes();
+	for (int i = 0; i < nn; ++i) h = hashInt(map ? mapIndex(a.n[i], *map) : a.n[i], h);
+	return h;
+}
+
+template <> unsigned long long itemKey<FEEdge>(const FEEdge& a, const std::vector<int>* map) { return nodeKey(a, map); }
+template <> unsigned long long itemKey<FEFace>(const FEFace& a, const std::vector<int>* map) { return nodeKey(a, map); }
+
+template <> unsigned long long itemKey<FEElement>(const FEElement& a, const std::vector<int>* map)
+{
+	unsigned long long h = hashInt(a.Type(), 14695981039346656037ULL);
+	int ne = a.Nodes();
+	for (int i = 0; i < ne; ++i) h = hashInt(map ? mapIndex(a.m_node[i], *map) : a.m_node[i], h);
+	return h;
+}
+
+//-----------------------------------------------------------------------------
+// Map the item numbers that a base item refers to.
+template <typename T> static void remapItem(T& a, const FEMeshDeltaMaps& m) {}
+
+template <> void remapItem<FEEdge>(FEEdge& a, const FEMeshDeltaMaps& m)
+{
+	a.SetID(mapID(a.GetID(), m.edge));
+	int nn = a.Nodes();
+	for (int i = 0; i < nn; ++i) a.n[i] = mapIndex(a.n[i], m.node);
+	a.m_elem = mapIndex(a.m_elem, m.elem);
+	for (int i = 0; i < 2; ++i) a.m_nbr[i] = mapIndex(a.m_nbr[i], m.edge);
+	for (int i = 0; i < 2; ++i) a.m_face[i] = mapIndex(a.m_face[i], m.face);
+}
+
+template <> void remapItem<FEFace>(FEFace& a, const FEMeshDeltaMaps& m)
+{
+	a.SetID(mapID(a.GetID(), m.face));
+	int nn = a.Nodes();
+	for (int i = 0; i < nn; ++i) a.n[i] = mapIndex(a.n[i], m.node);
+	for (int i = 0; i < 4; ++i) a.m_nbr[i] = mapIndex(a.m_nbr[i], m.face);
+	for (int i = 0; i < 2; ++i) a.m_elem[i].eid = mapIndex(a.m_elem[i].eid, m.elem);
+	for (int i = 0; i < 4; ++i) a.m_edge[i] = mapIndex(a.m_edge[i], m.edge);
+}
+
+template <> void remapItem<FEElement>(FEElement& a, const FEMeshDeltaMaps& m)
+{
+	int ne = a.Nodes();
+	for (int i = 0; i < ne; ++i) a.m_node[i] = mapIndex(a.m_node[i], m.node);
+	for (int i = 0; i < 6; ++i) a.m_nbr[i] = mapIndex(a.m_nbr[i], m.elem);
+	for (int i = 0; i < 6; ++i) a.m_face[i] = mapIndex(a.m_face[i], m.face);
+}
+
+//-----------------------------------------------------------------------------
+// Compare two mesh items. By default, the raw memory is compared. The items have
+// a virtual table, but they are only compared to items of the same type.
+template <typename T> static bool sameItem(const T& a, const T& b)
+{
+	return (memcmp((const void*)&a, (const void*)&b, sizeof(T)) == 0);
+}
+
+// edges and faces are padded at the end, so we only compare up to the last member
+template <> bool sameItem<FEEdge>(const FEEdge& a, const FEEdge& b)
+{
+	size_t n = (const char*)(a.m_face + 2) - (const char*)&a;
+	return (memcmp((const void*)&a, (const void*)&b, n) == 0);
+}
+
+template <> bool sameItem<FEFace>(const FEFace& a, const FEFace& b)
+{
+	size_t n = (const char*)(a.m_edge + 4) - (const char*)&a;
+	return (memcmp((const void*)&a, (const void*)&b, n) == 0);
+}
+
+// Elements point to their data and have padding, so they are compared member-wise.
+// Only the members that are copied by the assignment operator are compared.
+template <> bool sameItem<FEElement>(const FEElement& a, const FEElement& b)
+{
+	if ((a.Type() != b.Type()) || (a.GetFEState() != b.GetFEState())) return false;
+	if ((a.m_gid != b.m_gid) || (a.m_nid != b.m_nid)) return false;
+	if ((a.m_lid != b.m_lid) || (a.m_MatID != b.m_MatID) || (a.m_tex != b.m_tex)) return false;
+	if ((a.LocalAxesActive() != b.LocalAxesActive()) || (a.TrussArea() != b.TrussArea())) return false;
+	vec3d fa = a.Fiber(), fb = b.Fiber();
+	if (memcmp(&fa, &fb, sizeof(vec3d)) != 0) return false;
+	mat3d Qa = a.LocalAxes(), Qb = b.LocalAxes();
+	if (memcmp(&Qa, &Qb, sizeof(mat3d)) != 0) return false;
+	if (memcmp(a.m_node, b.m_node, a.Nodes()*sizeof(int)) != 0) return false;
+	if (memcmp(a.m_nbr , b.m_nbr , 6*sizeof(int)) != 0) return false;
+	if (memcmp(a.m_face, b.m_face, 6*sizeof(int)) != 0) return false;
+	if (a.IsShell() && (memcmp(a.m_h, b.m_h, a.Nodes()*sizeof(double)) != 0)) return false;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// The selection state, tag and group ID of an item are stored separately, since
+// these are often the only differences with the base item.
+struct FEItemFlags
+{
+	int				index;
+	unsigned int	state;
+	int				tag;
+	int				gid;
+};
+
+template <typename T> static bool sameExceptFlags(const T& a, T b)
+{
+	b.SetFEState(a.GetFEState());
+	b.m_ntag = a.m_ntag;
+	b.m_gid = a.m_gid;
+	return sameItem(a, b);
+}
+
+template <typename T> static FEItemFlags getFlags(const T& a, int index)
+{
+	FEItemFlags f = { index, a.GetFEState(), a.m_ntag, a.m_gid };
+	return f;
+}
+
+template <typename T> static void setFlags(T& a, const FEItemFlags& f)
+{
+	a.SetFEState(f.state);
+	a.m_ntag = f.tag;
+	a.m_gid = f.gid;
+}
+
+// element data has no flags
+typedef decltype(Mesh_Data::m_data)		DataVector;
+typedef DataVector::value_type			DataItem;
+template <> bool sameExceptFlags<DataItem>(const DataItem& a, DataItem b) { return false; }
+template <> FEItemFlags getFlags<DataItem>(const DataItem& a, int index) { FEItemFlags f = { index, 0, 0, 0 }; return f; }
+template <> void setFlags<DataItem>(DataItem& a, const FEItemFlags& f) {}
+
+//-----------------------------------------------------------------------------
+template <typename T> static bool writeVector(FILE* fp, const std::vector<T>& v)
+{
+	size_t n = v.size();
+	if (fwrite(&n, sizeof(size_t), 1, fp) != 1) return false;
+	if ((n > 0) && (fwrite((const void*)&v[0], sizeof(T), n, fp) != n)) return false;
+	return true;
+}
+
+template <typename T> static bool readVector(FILE* fp, std::vector<T>& v)
+{
+	size_t n = 0;
+	if (fread(&n, sizeof(size_t), 1, fp) != 1) return false;
+	v.resize(n);
+	if ((n > 0) && (fread((void*)&v[0], sizeof(T), n, fp) != n)) return false;
+	return true;
+}
+
+// Elements don't contain their data, so they are written field by field. Only the
+// fields that are copied by the assignment operator are written.
+template <> bool writeVector<FEElement>(FILE* fp, const std::vector<FEElement>& v)
+{
+	size_t n = v.size();
+	if (fwrite(&n, sizeof(size_t), 1, fp) != 1) return false;
+	for (size_t i = 0; i < n; ++i)
+	{
+		const FEElement& el = v[i];
+		int d[8] = { el.Type(), (int)el.GetFEState(), el.m_gid, el.m_nid, el.m_ntag, el.m_lid, el.m_MatID, (el.HasAttributes() ? 1 : 0) };
+		size_t ne = el.Nodes();
+		if (fwrite(d, sizeof(int), 8, fp) != 8) return false;
+		if (fwrite(&el.m_tex, sizeof(float), 1, fp) != 1) return false;
+		if (fwrite(el.m_node, sizeof(int), ne, fp) != ne) return false;
+		if (fwrite(el.m_nbr , sizeof(int), 6 , fp) != 6 ) return false;
+		if (fwrite(el.m_face, sizeof(int), 6 , fp) != 6 ) return false;
+		if (el.IsShell() && (fwrite(el.m_h, sizeof(double), ne, fp) != ne)) return false;
+		if (el.HasAttributes())
+		{
+			FEElemAttributes a;
+			a.m_fiber = el.Fiber();
+			a.m_Q = el.LocalAxes();
+			a.m_Qactive = el.LocalAxesActive();
+			a.m_a0 = el.TrussArea();
+			if (fwrite(&a, sizeof(FEElemAttributes), 1, fp) != 1) return false;
+		}
+	}
+	return true;
+}
+
+template <> bool readVector<FEElement>(FILE* fp, std::vector<FEElement>& v)
+{
+	size_t n = 0;
+	if (fread(&n, sizeof(size_t), 1, fp) != 1) return false;
+	v.resize(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		FEElement& el = v[i];
+		int d[8];
+		if (fread(d, sizeof(int), 8, fp) != 8) return false;
+		if (fread(&el.m_tex, sizeof(float), 1, fp) != 1) return false;
+		el.SetType(d[0]);
+		el.SetFEState((unsigned int)d[1]);
+		el.m_gid = d[2];
+		el.m_nid = d[3];
+		el.m_ntag = d[4];
+		el.m_lid = d[5];
+		el.m_MatID = d[6];
+		size_t ne = el.Nodes();
+		if (fread(el.m_node, sizeof(int), ne, fp) != ne) return false;
+		if (fread(el.m_nbr , sizeof(int), 6 , fp) != 6 ) return false;
+		if (fread(el.m_face, sizeof(int), 6 , fp) != 6 ) return false;
+		if (el.IsShell() && (fread(el.m_h, sizeof(double), ne, fp) != ne)) return false;
+		if (d[7])
+		{
+			FEElemAttributes a;
+			if (fread(&a, sizeof(FEElemAttributes), 1, fp) != 1) return false;
+			el.SetFiber(a.m_fiber);
+			el.SetLocalAxes(a.m_Q);
+			el.SetLocalAxesActive(a.m_Qactive);
+			el.SetTrussArea(a.m_a0);
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// base class for the stored arrays
+class FEMeshDeltaArray
+{
+public:
+	// a run of items that are copied from the base array
+	struct RUN
+	{
+		int	first;	// index of first item in the stored array
+		int	base;	// index of first item in the base array
+		int	count;	// number of items
+	};
+
+public:
+	FEMeshDeltaArray() { m_size = 0; }
+	virtual ~FEMeshDeltaArray() {}
+
+	virtual size_t MemorySize() const = 0;
+
+	virtual bool Write(FILE* fp) = 0;
+	virtual bool Read(FILE* fp) = 0;
+
+	// Find the runs of items that are in both arrays, given the item keys of the
+	// stored array and the base array (computed with the same numbering). Each base
+	// item is used once. The base item after the last match is tried first, so that
+	// the runs are as long as possible.
+	void Align(const std::vector<unsigned long long>& key, const std::vector<unsigned long long>& baseKey)
+	{
+		m_run.clear();
+		m_size = (int)key.size();
+		int nb = (int)baseKey.size();
+
+		std::vector< std::pair<unsigned long long, int> > sorted(nb);
+		for (int i = 0; i < nb; ++i) sorted[i] = std::make_pair(baseKey[i], i);
+		std::sort(sorted.begin(), sorted.end());
+
+		// the first base item of each key that may still be unused
+		std::vector<int> cursor(nb, 0);
+		std::vector<bool> used(nb, false);
+
+		int next = 0;
+		for (int i = 0; i < m_size; ++i)
+		{
+			int j = -1;
+			if ((next < nb) && (used[next] == false) && (baseKey[next] == key[i])) j = next;
+			else
+			{
+				int g = (int)(std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(key[i], 0)) - sorted.begin());
+				int p = g + cursor[g < nb ? g : 0];
+				while ((p < nb) && (sorted[p].first == key[i]) && used[sorted[p].second]) p++;
+				if ((p == nb) || (sorted[p].first != key[i])) continue;
+				cursor[g] = p - g;
+				j = sorted[p].second;
+			}
+			used[j] = true;
+
+			if (m_run.empty() || (m_run.back().first + m_run.back().count != i) || (m_run.back().base + m_run.back().count != j))
+			{
+				RUN r = { i, j, 0 };
+				m_run.push_back(r);
+			}
+			m_run.back().count++;
+			next = j + 1;
+		}
+	}
+
+	// map the base item numbers to the stored item numbers
+	void BaseMap(int baseSize, std::vector<int>& map) const
+	{
+		map.assign(baseSize, -1);
+		for (size_t n = 0; n < m_run.size(); ++n)
+		{
+			const RUN& r = m_run[n];
+			for (int k = 0; k < r.count; ++k) map[r.base + k] = r.first + k;
+		}
+	}
+
+protected:
+	int					m_size;		// size of the original array
+	std::vector<RUN>	m_run;		// items copied from the base array
+};
+
+//-----------------------------------------------------------------------------
+// The items are written to disk as raw memory (except elements, see writeVector).
+// They are only read back by the same process, so the virtual tables are still valid.
+template <typename T> class FEMeshDeltaArray_T : public FEMeshDeltaArray
+{
+public:
+	// match the items with the base items. If nodeMap is given, it maps the base's
+	// node numbers to the node numbers of a.
+	void Align(const std::vector<T>& a, const std::vector<T>& base, const std::vector<int>* nodeMap)
+	{
+		std::vector<unsigned long long> key(a.size()), baseKey(base.size());
+		for (size_t i = 0; i < a.size(); ++i) key[i] = itemKey(a[i], nullptr);
+		for (size_t i = 0; i < base.size(); ++i) baseKey[i] = itemKey(base[i], nodeMap);
+		FEMeshDeltaArray::Align(key, baseKey);
+	}
+
+	// store the items of a that cannot be restored from the runs and release a
+	void Compress(std::vector<T>& a, const std::vector<T>& base, const FEMeshDeltaMaps& maps)
+	{
+		assert((int)a.size() == m_size);
+		m_index.clear();
+		m_items.clear();
+		m_flags.clear();
+
+		int i = 0;
+		for (size_t n = 0; n <= m_run.size(); ++n)
+		{
+			// the items before this run are not in the base array
+			int first = (n < m_run.size() ? m_run[n].first : m_size);
+			for (; i < first; ++i) { m_index.push_back(i); m_items.push_back(a[i]); }
+			if (n == m_run.size()) break;
+
+			const RUN& r = m_run[n];
+			for (int k = 0; k < r.count; ++k, ++i)
+			{
+				T b = base[r.base + k];
+				remapItem(b, maps);
+				if (sameItem(a[i], b)) continue;
+
+				if (sameExceptFlags(a[i], b))
+					m_flags.push_back(getFlags(a[i], i));
+				else { m_index.push_back(i); m_items.push_back(a[i]); }
+			}
+		}
+
+#ifdef _DEBUG
+		// make sure the array can be restored
+		std::vector<T> tmp;
+		Restore(tmp, base, maps);
+		assert(tmp.size() == a.size());
+		for (size_t n = 0; n < a.size(); ++n) assert(sameItem(tmp[n], a[n]));
+#endif
+
+		// release the memory of the original array
+		std::vector<T>().swap(a);
+	}
+
+	void Expand(std::vector<T>& a, const std::vector<T>& base, const FEMeshDeltaMaps& maps)
+	{
+		Restore(a, base, maps);
+		std::vector<int>().swap(m_index);
+		std::vector<T>().swap(m_items);
+		std::vector<FEItemFlags>().swap(m_flags);
+		std::vector<RUN>().swap(m_run);
+	}
+
+	size_t MemorySize() const override
+	{
+		return m_run.capacity()*sizeof(RUN) + m_index.capacity()*sizeof(int) + m_items.capacity()*sizeof(T) + m_flags.capacity()*sizeof(FEItemFlags);
+	}
+
+	bool Write(FILE* fp) override
+	{
+		if (writeVector(fp, m_index) == false) return false;
+		if (writeVector(fp, m_items) == false) return false;
+		if (writeVector(fp, m_flags) == false) return false;
+		std::vector<int>().swap(m_index);
+		std::vector<T>().swap(m_items);
+		std::vector<FEItemFlags>().swap(m_flags);
+		return true;
+	}
+
+	bool Read(FILE* fp) override
+	{
+		if (readVector(fp, m_index) == false) return false;
+		if (readVector(fp, m_items) == false) return false;
+		if (readVector(fp, m_flags) == false) return false;
+		return true;
+	}
+
+private:
+	void Restore(std::vector<T>& a, const std::vector<T>& base, const FEMeshDeltaMaps& maps) const
+	{
+		a.clear();
+		a.resize(m_size);
+		for (size_t n = 0; n < m_run.size(); ++n)
+		{
+			const RUN& r = m_run[n];
+			assert(r.base + r.count <= (int)base.size());
+			for (int k = 0; k < r.count; ++k)
+			{
+				T& ak = a[r.first + k];
+				ak = base[r.base + k];
+				remapItem(ak, maps);
+			}
+		}
+		for (size_t n = 0; n < m_index.size(); ++n) a[m_index[n]] = m_items[n];
+		for (size_t n = 0; n < m_flags.size(); ++n) setFlags(a[m_flags[n].index], m_flags[n]);
+	}
+
+private:
+	std::vector<int>			m_index;	// the positions of the stored items
+	std::vector<T>				m_items;	// the items that cannot be restored from the base array
+	std::vector<FEItemFlags>	m_flags;	// items that only differ in their flags
+};
+
+typedef FEMeshDeltaArray_T<FENode>		NodeArray;
+typedef FEMeshDeltaArray_T<FEEdge>		EdgeArray;
+typedef FEMeshDeltaArray_T<FEFace>		FaceArray;
+typedef FEMeshDeltaArray_T<FEElement>	ElemArray;
+typedef FEMeshDeltaArray_T<DataItem>	DataArray;
+
+//-----------------------------------------------------------------------------
+FEMeshDelta::FEMeshDelta()
+{
+	m_bcompressed = false;
+	m_fp = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+FEMeshDelta::~FEMeshDelta()
+{
+	Clear();
+}
+
+//-----------------------------------------------------------------------------
+void FEMeshDelta::Clear()
+{
+	for (size_t i = 0; i < m_array.size(); ++i) delete m_array[i];
+	m_array.clear();
+	if (m_fp) fclose(m_fp);
+	m_fp = nullptr;
+	m_bcompressed = false;
+}
+
+//-----------------------------------------------------------------------------
+// The nodes are matched first, so that the other items can be matched by their
+// (mapped) nodes. The maps of all arrays are needed to restore the items.
+void FEMeshDelta::Compress(FEMesh* mesh, FEMesh* base)
+{
+	assert(m_bcompressed == false);
+	Clear();
+	if ((mesh == nullptr) || (base == nullptr) || (mesh == base)) return;
+
+	NodeArray* nodes = new NodeArray;
+	EdgeArray* edges = new EdgeArray;
+	FaceArray* faces = new FaceArray;
+	ElemArray* elems = new ElemArray;
+	DataArray* data  = new DataArray;
+
+	FEMeshDeltaMaps maps;
+	nodes->Align(mesh->m_Node, base->m_Node, nullptr);
+	nodes->BaseMap((int)base->m_Node.size(), maps.node);
+
+	edges->Align(mesh->m_Edge, base->m_Edge, &maps.node);
+	faces->Align(mesh->m_Face, base->m_Face, &maps.node);
+	elems->Align(mesh->m_Elem, base->m_Elem, &maps.node);
+	data ->Align(mesh->m_data.m_data, base->m_data.m_data, nullptr);
+	edges->BaseMap((int)base->m_Edge.size(), maps.edge);
+	faces->BaseMap((int)base->m_Face.size(), maps.face);
+	elems->BaseMap((int)base->m_Elem.size(), maps.elem);
+
+	nodes->Compress(mesh->m_Node, base->m_Node, maps);
+	edges->Compress(mesh->m_Edge, base->m_Edge, maps);
+	faces->Compress(mesh->m_Face, base->m_Face, maps);
+	elems->Compress(mesh->m_Elem, base->m_Elem, maps);
+	data ->Compress(mesh->m_data.m_data, base->m_data.m_data, maps);
+
+	// release the element data
+	mesh->CompactElements();
+
+	m_array.push_back(nodes);
+	m_array.push_back(edges);
+	m_array.push_back(faces);
+	m_array.push_back(elems);
+	m_array.push_back(data);
+
+	m_bcompressed = true;
+}
+
+//-----------------------------------------------------------------------------
+void FEMeshDelta::Expand(FEMesh* mesh, FEMesh* base)
+{
+	if (m_bcompressed == false) return;
+	assert(mesh && base && (mesh != base));
+
+	// get the items back from disk
+	if (m_fp)
+	{
+		bool b = Reload();
+		assert(b);
+	}
+
+	NodeArray* nodes = static_cast<NodeArray*>(m_array[0]);
+	EdgeArray* edges = static_cast<EdgeArray*>(m_array[1]);
+	FaceArray* faces = static_cast<FaceArray*>(m_array[2]);
+	ElemArray* elems = static_cast<ElemArray*>(m_array[3]);
+	DataArray* data  = static_cast<DataArray*>(m_array[4]);
+
+	FEMeshDeltaMaps maps;
+	nodes->BaseMap((int)base->m_Node.size(), maps.node);
+	edges->BaseMap((int)base->m_Edge.size(), maps.edge);
+	faces->BaseMap((int)base->m_Face.size(), maps.face);
+	elems->BaseMap((int)base->m_Elem.size(), maps.elem);
+
+	nodes->Expand(mesh->m_Node, base->m_Node, maps);
+	edges->Expand(mesh->m_Edge, base->m_Edge, maps);
+	faces->Expand(mesh->m_Face, base->m_Face, maps);
+	elems->Expand(mesh->m_Elem, base->m_Elem, maps);
+	data ->Expand(mesh->m_data.m_data, base->m_data.m_data, maps);
+
+	// the restored elements own their data, so move it to the mesh
+	mesh->m_elemStore.Add(mesh->m_Elem);
+
+	Clear();
+}
+
+//-----------------------------------------------------------------------------
+bool FEMeshDelta::Spill()
+{
+	if ((m_bcompressed == false) || m_fp) return false;
+
+	// the file is removed automatically when it is closed
+	m_fp = tmpfile();
+	if (m_fp == nullptr) return false;
+
+	for (size_t i = 0; i < m_array.size(); ++i)
+	{
+		if (m_array[i]->Write(m_fp) == false)
+		{
+			// the items that were not written are still in memory,
+			// so we just read back the ones that were.
+			rewind(m_fp);
+			for (size_t j = 0; j < i; ++j) m_array[j]->Read(m_fp);
+			fclose(m_fp);
+			m_fp = nullptr;
+			return false;
+		}
+	}
+	fflush(m_fp);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool FEMeshDelta::Reload()
+{
+	if (m_fp == nullptr) return true;
+
+	rewind(m_fp);
+	bool bok = true;
+	for (size_t i = 0; i < m_array.size(); ++i)
+	{
+		if (m_array[i]->Read(m_fp) == false) bok = false;
+	}
+
+	fclose(m_fp);
+	m_fp = nullptr;
+
+	return bok;
+}
+
+//-----------------------------------------------------------------------------
+size_t FEMeshDelta::MemorySize() const
+{
+	size_t size = 0;
+	for (size_t i = 0; i < m_array.size(); ++i) size += m_array[i]->MemorySize();
+	return size;
+}
+
+//-----------------------------------------------------------------------------
+size_t FEMeshDelta::MemorySize(FEMesh* mesh)
+{
+	if (mesh == nullptr) return 0;
+	size_t size = 0;
+	size += (size_t) mesh->Nodes()*sizeof(FENode);
+	size += (size_t) mesh->Edges()*sizeof(FEEdge);
+	size += (size_t) mesh->Faces()*sizeof(FEFace);
+	size += mesh->ElementMemorySize();
+	size += mesh->GetMeshData().m_data.size()*sizeof(DataVector::value_type);
+	return size;
+}
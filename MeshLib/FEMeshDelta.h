@@ -0,0 +1,85 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <stdio.h>
+#include <stddef.h>
+#include <vector>
+
+class FEMesh;
+class FEMeshDeltaArray;
+
+//-----------------------------------------------------------------------------
+// This class stores the item arrays of a mesh (nodes, edges, faces, elements
+// and element data) as the difference with a base mesh. The items of each array
+// are matched with the items of the base array by their nodes, after the base's
+// node numbers are mapped to the mesh's. This way, the items that survive a
+// deletion are found even though their node numbers changed. For each array,
+// only the following is stored:
+// - the runs of matched items (as ranges into the base array)
+// - the items that were not matched, or that differ in other data (e.g. neighbors)
+// - the selection state, tag and group ID of the items that only differ in those
+// It is used by the commands to store the mesh that is not active: Compress
+// stores the difference of the mesh with the active mesh and releases its
+// arrays, and Expand restores them from the same active mesh. The mesh object
+// itself is not deleted, so pointers to it (and its data fields) stay valid.
+// The stored items can also be moved to a temporary file.
+class FEMeshDelta
+{
+public:
+	FEMeshDelta();
+	~FEMeshDelta();
+
+	// store the difference of mesh with base and release the arrays of mesh
+	void Compress(FEMesh* mesh, FEMesh* base);
+
+	// restore the arrays of mesh. base must be the same as when compressed
+	void Expand(FEMesh* mesh, FEMesh* base);
+
+	// see if a mesh is stored
+	bool IsCompressed() const { return m_bcompressed; }
+
+	// write the stored items to a temporary file and release the memory
+	bool Spill();
+
+	// see if the items were moved to disk
+	bool IsSpilled() const { return (m_fp != nullptr); }
+
+	// the memory used by the stored items
+	size_t MemorySize() const;
+
+	// the memory used by the item arrays of a mesh
+	static size_t MemorySize(FEMesh* mesh);
+
+private:
+	void Clear();
+	bool Reload();
+
+private:
+	std::vector<FEMeshDeltaArray*>	m_array;	// the stored arrays (nodes, edges, faces, elements, data)
+	bool	m_bcompressed;
+	FILE*	m_fp;		// temporary file with the spilled items
+};
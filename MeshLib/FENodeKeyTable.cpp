@@ -0,0 +1,126 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "FENodeKeyTable.h"
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+FENodeKey::FENodeKey(int n0, int n1)
+{
+	if (n0 < n1) { m_n[0] = n0; m_n[1] = n1; }
+	else { m_n[0] = n1; m_n[1] = n0; }
+	m_nodes = 2;
+}
+
+//-----------------------------------------------------------------------------
+FENodeKey::FENodeKey(int n0, int n1, int n2)
+{
+	m_n[0] = n0; m_n[1] = n1; m_n[2] = n2;
+	if (m_n[0] > m_n[1]) std::swap(m_n[0], m_n[1]);
+	if (m_n[1] > m_n[2]) std::swap(m_n[1], m_n[2]);
+	if (m_n[0] > m_n[1]) std::swap(m_n[0], m_n[1]);
+	m_nodes = 3;
+}
+
+//-----------------------------------------------------------------------------
+FENodeKey::FENodeKey(int n0, int n1, int n2, int n3)
+{
+	m_n[0] = n0; m_n[1] = n1; m_n[2] = n2; m_n[3] = n3;
+	if (m_n[0] > m_n[1]) std::swap(m_n[0], m_n[1]);
+	if (m_n[2] > m_n[3]) std::swap(m_n[2], m_n[3]);
+	if (m_n[0] > m_n[2]) std::swap(m_n[0], m_n[2]);
+	if (m_n[1] > m_n[3]) std::swap(m_n[1], m_n[3]);
+	if (m_n[1] > m_n[2]) std::swap(m_n[1], m_n[2]);
+	m_nodes = 4;
+}
+
+//-----------------------------------------------------------------------------
+bool FENodeKey::operator == (const FENodeKey& k) const
+{
+	if (m_nodes != k.m_nodes) return false;
+	for (int i = 0; i < m_nodes; ++i) if (m_n[i] != k.m_n[i]) return false;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int FENodeKey::Hash() const
+{
+	// FNV-1a style mixing of the node IDs
+	unsigned long long h = 14695981039346656037ULL;
+	for (int i = 0; i < m_nodes; ++i)
+	{
+		h ^= (unsigned int)m_n[i];
+		h *= 1099511628211ULL;
+	}
+	h ^= (h >> 32);
+	return (unsigned int)h;
+}
+
+//=============================================================================
+FENodeKeyTable::FENodeKeyTable()
+{
+}
+
+//-----------------------------------------------------------------------------
+void FENodeKeyTable::Clear()
+{
+	m_off.clear();
+	m_item.clear();
+}
+
+//-----------------------------------------------------------------------------
+void FENodeKeyTable::BuildBuckets(const std::vector<int>& node, const std::vector<unsigned int>& hash)
+{
+	Clear();
+
+	// find the number of buckets we need
+	int N = (int)node.size();
+	int maxNode = -1;
+	for (int i = 0; i < N; ++i) if (node[i] > maxNode) maxNode = node[i];
+	if (maxNode < 0) return;
+
+	// count the items in each bucket
+	m_off.assign(maxNode + 2, 0);
+	for (int i = 0; i < N; ++i)
+	{
+		if (node[i] >= 0) m_off[node[i] + 1]++;
+	}
+	for (int i = 0; i <= maxNode; ++i) m_off[i + 1] += m_off[i];
+
+	// Fill the buckets. The items are added in order, so that 
+	// each bucket is sorted by increasing item index.
+	m_item.resize(m_off[maxNode + 1]);
+	std::vector<int> pos(m_off.begin(), m_off.end() - 1);
+	for (int i = 0; i < N; ++i)
+	{
+		if (node[i] >= 0)
+		{
+			ITEM& it = m_item[pos[node[i]]++];
+			it.hash = hash[i];
+			it.item = i;
+		}
+	}
+}
@@ -0,0 +1,136 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// A key that identifies a mesh item (face, edge, or node) by its corner nodes.
+// The node IDs are stored in sorted order so that keys don't depend on the
+// orientation of the item. 
+class FENodeKey
+{
+public:
+	enum { MAX_NODES = 4 };
+
+public:
+	FENodeKey() { m_nodes = 0; }
+	FENodeKey(int n0) { m_n[0] = n0; m_nodes = 1; }
+	FENodeKey(int n0, int n1);
+	FENodeKey(int n0, int n1, int n2);
+	FENodeKey(int n0, int n1, int n2, int n3);
+
+	bool operator == (const FENodeKey& k) const;
+
+	int Nodes() const { return m_nodes; }
+
+	// return the smallest node ID of this key
+	int MinNode() const { return m_n[0]; }
+
+	// return the hash value of this key
+	unsigned int Hash() const;
+
+private:
+	int	m_n[MAX_NODES];
+	int	m_nodes;
+};
+
+//-----------------------------------------------------------------------------
+// The FENodeKeyTable class is a flat table that maps node keys to item indices.
+// It is used for building the mesh topology (element neighbors, face-element 
+// connectivity, etc.) without the need for node-element lists. 
+// The items are stored in a single array, bucketed by the smallest node of their 
+// key, and each item stores the hash of its key. Since the node numbering usually 
+// follows the element numbering, lookups tend to touch memory that is close together. 
+// The keys are evaluated in parallel, and lookups are thread-safe.
+// Note that the table only stores the hash values of the keys. It is up to the caller
+// to verify if an item with a matching hash actually matches the key. 
+class FENodeKeyTable
+{
+public:
+	FENodeKeyTable();
+
+	// Build the table. Calls key(i, k) for all items i in [0, items) to get the key 
+	// of the item. If key returns false, the item is not added. 
+	template <class KeyFnc> void Build(int items, KeyFnc key);
+
+	// Find an item with a matching key. The match(i) function is called for all items 
+	// with the same hash value (in order of increasing item index) until it returns true.
+	// Returns the item that matched, or -1 if no match was found.
+	template <class MatchFnc> int Find(const FENodeKey& key, MatchFnc match) const;
+
+	// clear the table
+	void Clear();
+
+private:
+	// sort the items into the buckets
+	void BuildBuckets(const std::vector<int>& node, const std::vector<unsigned int>& hash);
+
+private:
+	struct ITEM
+	{
+		unsigned int	hash;	// hash value of the item's key
+		int				item;	// item index
+	};
+
+	std::vector<int>	m_off;	// bucket offsets (one bucket per node)
+	std::vector<ITEM>	m_item;	// items, sorted by bucket
+};
+
+//-----------------------------------------------------------------------------
+template <class KeyFnc> void FENodeKeyTable::Build(int items, KeyFnc key)
+{
+	// evaluate all the keys
+	// (the node is set to -1 for items that are not added)
+	std::vector<int> node(items, -1);
+	std::vector<unsigned int> hash(items, 0);
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < items; ++i)
+	{
+		FENodeKey k;
+		if (key(i, k))
+		{
+			node[i] = k.MinNode();
+			hash[i] = k.Hash();
+		}
+	}
+
+	BuildBuckets(node, hash);
+}
+
+//-----------------------------------------------------------------------------
+template <class MatchFnc> int FENodeKeyTable::Find(const FENodeKey& key, MatchFnc match) const
+{
+	int n = key.MinNode();
+	if ((n < 0) || (n + 1 >= (int)m_off.size())) return -1;
+	unsigned int h = key.Hash();
+	for (int i = m_off[n]; i < m_off[n + 1]; ++i)
+	{
+		const ITEM& it = m_item[i];
+		if ((it.hash == h) && match(it.item)) return it.item;
+	}
+	return -1;
+}
@@ -1037,10 +1037,20 @@ vec3d Gradient(const FEMesh& mesh, const FEElement& el, int node, double* v)
 //-----------------------------------------------------------------------------
 // evaluate gradient at element nodes (i.e. Grad{Na(x_b)})
 vec3d ShapeGradient(const FEMesh& mesh, const FEElement_& el, int na, int nb)
+{
+	vec3d grad[FEElement::MAX_NODES];
+	ShapeGradients(mesh, el, nb, grad);
+	return grad[na];
+}
+
+//-----------------------------------------------------------------------------
+// evaluate the gradients of all shape functions at element node nb
+void ShapeGradients(const FEMesh& mesh, const FEElement_& el, int nb, vec3d* grad)
 {
 	const int MN = FEElement::MAX_NODES;
 	vec3d r[MN];
 	const int ne = el.Nodes();
+	for (int i = 0; i < ne; ++i) grad[i] = vec3d(0, 0, 0);
 	mesh.ElementNodeLocalPositions(el, r);
 
 	// shape function derivatives at node
@@ -1054,7 +1064,7 @@ vec3d ShapeGradient(const FEMesh& mesh, const FEElement_& el, int na, int nb)
 	case FE_TET15: G = GTET15[nb]; break;
 	case FE_TET20: G = GTET20[nb]; break;
 	default:
-		return vec3d(0, 0, 0);
+		return;
 	}
 
 	// Jacobian at node b
@@ -1068,13 +1078,13 @@ vec3d ShapeGradient(const FEMesh& mesh, const FEElement_& el, int na, int nb)
 	J = J.inverse();
 	J = J.transpose();
 
-	// shape function gradient
-	vec3d grad(0, 0, 0);
-	grad.x = J[0][0] * G[na][0] + J[0][1] * G[na][1] + J[0][2] * G[na][2];
-	grad.y = J[1][0] * G[na][0] + J[1][1] * G[na][1] + J[1][2] * G[na][2];
-	grad.z = J[2][0] * G[na][0] + J[2][1] * G[na][1] + J[2][2] * G[na][2];
-
-	return grad;
+	// shape function gradients
+	for (int a = 0; a < ne; ++a)
+	{
+		grad[a].x = J[0][0] * G[a][0] + J[0][1] * G[a][1] + J[0][2] * G[a][2];
+		grad[a].y = J[1][0] * G[a][0] + J[1][1] * G[a][1] + J[1][2] * G[a][2];
+		grad[a].z = J[2][0] * G[a][0] + J[2][1] * G[a][1] + J[2][2] * G[a][2];
+	}
 }
 
 // get the min edge length of an element
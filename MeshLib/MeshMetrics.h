@@ -74,6 +74,9 @@ vec3d Gradient(const FEMesh& mesh, const FEElement& el, int node, double* v);
 // evaluate gradient at element nodes (i.e. Grad{Na(x_b)})
 vec3d ShapeGradient(const FEMesh& mesh, const FEElement_& el, int na, int nb);
 
+// evaluate the gradients of all shape functions at element node nb (i.e. Grad{Na(x_b)} for all a)
+void ShapeGradients(const FEMesh& mesh, const FEElement_& el, int nb, vec3d* grad);
+
 // get the min edge length of an element
 double MinEdgeLength(const FEMesh& mesh, const FEElement& e);
 
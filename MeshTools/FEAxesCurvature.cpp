@@ -380,13 +380,14 @@ void FEAxesCurvature::ApplyCurvature(FEMesh* pm)
         vec3d c = vec3d(eigenVectors(0,2),eigenVectors(1,2), eigenVectors(2,2));
         
         FEElement& el = pm->Element(fel[i]);
-        mat3d& m = el.m_Q;
+        mat3d m;
         m.zero();
         m[0][0] = a.x; m[0][1] = b.x; m[0][2] = c.x;
         m[1][0] = a.y; m[1][1] = b.y; m[1][2] = c.y;
         m[2][0] = a.z; m[2][1] = b.z; m[2][2] = c.z;
     
-        el.m_Qactive = true;
+        el.SetLocalAxes(m);
+        el.SetLocalAxesActive(true);
     }
 }
 
@@ -460,8 +461,8 @@ void FEAxesCurvature::ApplyCurvaturePart(FEMesh* pm)
         }
         
         //assign same material axes
-        pm->Element(pel[i]).m_Q = pm->Element(fel[closestFace]).m_Q;
-        pm->Element(pel[i]).m_Qactive = true;
+        pm->Element(pel[i]).SetLocalAxes(pm->Element(fel[closestFace]).LocalAxes());
+        pm->Element(pel[i]).SetLocalAxesActive(true);
     }
     
 }
@@ -1351,15 +1351,16 @@ void FEModel::UpdateData()
 							r = vec3d(0,0,0);
 							for (int m = 0; m<ne; ++m) r += po->GetTransform().LocalToGlobal(pm->Node(e.m_node[m]).r);
 							r /= (double) ne;
-							e.m_fiber = pv->Value(r);
-							e.m_fiber.Normalize();
+							vec3d a = pv->Value(r);
+							a.Normalize();
+							e.SetFiber(a);
 						}
 					}
 					else
 					{
 						// NOTE: Don't zero it since this will overwrite the values
 						//       that are read from the FEBio input file.
-//						for (int n=0; n<NE; ++n) pm->Element(n).m_fiber = vec3d(0,0,0);
+//						for (int n=0; n<NE; ++n) pm->Element(n).SetFiber(vec3d(0,0,0));
 					}
 				}
 			}
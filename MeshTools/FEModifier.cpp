@@ -478,7 +478,7 @@ void FESetFiberOrientation::SetFiberVector(FEMesh *pm)
 	{
 		FEElement& el = pm->Element(i);
 		if (el.IsSelected() || (nsel==0))
-			el.m_fiber = r;
+			el.SetFiber(r);
 	}
 }
 
@@ -500,7 +500,7 @@ void FESetFiberOrientation::SetFiberNodes(FEMesh *pm)
 			r2 = pm->Node(el.m_node[ node1 ]).r;
 			n = r2 - r1;
 			n.Normalize();
-			el.m_fiber = n;
+			el.SetFiber(n);
 		}
 	}
 }
@@ -616,12 +616,13 @@ bool FESetAxesOrientation::SetAxesVectors(FEMesh *pm)
 		FEElement& el = pm->Element(i);
 		if (el.m_ntag == 1)
 		{
-			mat3d& m = el.m_Q;
+			mat3d m;
 			m.zero();
 			m[0][0] = a.x; m[0][1] = b.x; m[0][2] = c.x;
 			m[1][0] = a.y; m[1][1] = b.y; m[1][2] = c.y;
 			m[2][0] = a.z; m[2][1] = b.z; m[2][2] = c.z;
-			el.m_Qactive = true;
+			el.SetLocalAxes(m);
+			el.SetLocalAxesActive(true);
 		}
 	}
 
@@ -656,12 +657,13 @@ bool FESetAxesOrientation::SetAxesNodes(FEMesh *pm)
 			a.Normalize();
 			b.Normalize();
 			c.Normalize();
-			mat3d& m = el.m_Q;
+			mat3d m;
 			m.zero();
 			m[0][0] = a.x; m[0][1] = b.x; m[0][2] = c.x;
 			m[1][0] = a.y; m[1][1] = b.y; m[1][2] = c.y;
 			m[2][0] = a.z; m[2][1] = b.z; m[2][2] = c.z;
-			el.m_Qactive = true;
+			el.SetLocalAxes(m);
+			el.SetLocalAxesActive(true);
 		}
 	}
 
@@ -678,12 +680,13 @@ bool FESetAxesOrientation::SetAxesAngles(FEMesh *pm)
         FEElement& el = pm->Element(i);
         if (el.m_ntag == 1)
         {
-            mat3d& m = el.m_Q;
+            mat3d m;
             m.zero();
             m[0][0] = sin(phi)*cos(theta); m[0][1] = -sin(theta); m[0][2] = -cos(phi)*cos(theta);
             m[1][0] = sin(phi)*sin(theta); m[1][1] = cos(theta);  m[1][2] = -cos(phi)*sin(theta);
             m[2][0] = cos(phi);            m[2][1] = 0;           m[2][2] = sin(phi);
-            el.m_Qactive = true;
+            el.SetLocalAxes(m);
+            el.SetLocalAxesActive(true);
         }
     }
 
@@ -725,8 +728,8 @@ bool FESetAxesOrientation::SetAxesCopy(FEMesh *pm)
 		n = q.Find(c);
 		
 		FEElement& els = m_pms->Element(n);
-		el.m_Q = els.m_Q;
-		el.m_Qactive = els.m_Qactive;
+		el.SetLocalAxes(els.LocalAxes());
+		el.SetLocalAxesActive(els.LocalAxesActive());
 		
 		// if the element is a shell, we project the fiber on the shell
 		if (el.IsShell())
@@ -748,7 +751,9 @@ bool FESetAxesOrientation::SetAxesCopy(FEMesh *pm)
 			vec3d f = e1^e2;
 			f.Normalize();
 			
-			el.m_fiber -= f*(f*el.m_fiber);
+			vec3d a = el.Fiber();
+			a -= f*(f*a);
+			el.SetFiber(a);
 		}
 	}
 */
@@ -30,17 +30,34 @@ SOFTWARE.*/
 
 #include "stdafx.h"
 #include "FENNQuery.h"
-#include <stdlib.h>
+#include <algorithm>
+#include <limits>
 using namespace std;
 
-int cmp_node(const void* e1, const void* e2)
-{
-	FENNQuery::NODE& n1 = *((FENNQuery::NODE*)e1);
-	FENNQuery::NODE& n2 = *((FENNQuery::NODE*)e2);
+// max nr of points in a leaf
+const int LEAF_SIZE = 8;
+
+// max depth of the search stack
+const int MAX_STACK = 128;
 
-	return (n1.d1 > n2.d1 ? 1 : -1);
+// don't run batch queries in parallel for fewer points than this
+const int BATCH_MIN_PARALLEL = 256;
+
+static inline double coord(const vec3d& r, int n)
+{
+	return (n == 0 ? r.x : (n == 1 ? r.y : r.z));
 }
 
+// entry of the search stack: a node and a lower bound of the squared
+// distance of the query point to the points of that node. The bound is the 
+// sum of the squared offsets to the node's cell along each axis.
+struct NN_STACK
+{
+	int		node;
+	double	d2;
+	double	off[3];
+};
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -61,170 +78,249 @@ void FENNQuery::Init()
 {
 	assert(m_ps);
 
-	int i;
-	vec3d r0, r;
 	int N = (int) m_ps->size();
+	m_idx.resize(N);
+	for (int i=0; i<N; ++i) m_idx[i] = i;
 
-	// pick a random point as pivot
-	r0 = m_q1 = (*m_ps)[0];
+	m_tree.clear();
+	m_pt.clear();
+	if (N == 0) return;
 
-	// find the furtest node of this node
-	double dmax = 0, d;
-	for (i=0; i<N; ++i)
-	{
-		r = (*m_ps)[i];
-		d = (r - r0)*(r - r0);
-		if (d > dmax)
-		{
-			m_q1 = r;
-			dmax = d;
-		}
-	}
+	// a balanced tree has less than 2N/LEAF_SIZE nodes
+	m_tree.reserve(2*(N / LEAF_SIZE) + 1);
+	Build(0, N, 0);
 
-	// let's find the furthest node of this node
-	r0 = m_q2 = m_q1;
-	dmax = 0;
-	for (i=0; i<N; ++i)
-	{
-		r = (*m_ps)[i];
-		d = (r - r0)*(r - r0);
-		if (d > dmax)
-		{
-			m_q2 = r;
-			dmax = d;
-		}
-	}
+	// store the points in tree order, so leaves are contiguous in memory
+	m_pt.resize(N);
+	for (int i=0; i<N; ++i) m_pt[i] = (*m_ps)[m_idx[i]];
+}
 
-	// create the BK-"tree"
-	m_bk.resize(N);
-	for (i=0; i<N; ++i) 
+//-----------------------------------------------------------------------------
+// Build the (sub)tree for the points [first, first + count) and return its root.
+int FENNQuery::Build(int first, int count, int depth)
+{
+	int n = (int) m_tree.size();
+	NODE node;
+	node.m_first = first;
+	node.m_count = count;
+	node.m_axis  = -1;
+	node.m_right = -1;
+	node.m_split = 0.0;
+	m_tree.push_back(node);
+
+	if ((count <= LEAF_SIZE) || (depth >= MAX_STACK - 2)) return n;
+
+	// split along the largest extent of the points
+	const vector<vec3d>& pt = *m_ps;
+	int* idx = &m_idx[first];
+	vec3d r0 = pt[idx[0]], r1 = r0;
+	for (int i=1; i<count; ++i)
 	{
-		r = (*m_ps)[i];
-		m_bk[i].i = i;
-		m_bk[i].r = r;
-		m_bk[i].d1 = (m_q1 - r)*(m_q1 - r);
-		m_bk[i].d2 = (m_q2 - r)*(m_q2 - r);
+		const vec3d& r = pt[idx[i]];
+		if (r.x < r0.x) r0.x = r.x;
+		if (r.x > r1.x) r1.x = r.x;
+		if (r.y < r0.y) r0.y = r.y;
+		if (r.y > r1.y) r1.y = r.y;
+		if (r.z < r0.z) r0.z = r.z;
+		if (r.z > r1.z) r1.z = r.z;
 	}
+	vec3d d = r1 - r0;
+	int axis = 0;
+	if (d.y > d.x) axis = 1;
+	if (d.z > coord(d, axis)) axis = 2;
+
+	// all points coincide
+	if (coord(d, axis) <= 0.0) return n;
 
-	// sort the tree
-	qsort((NODE*) &m_bk[0], N, sizeof(NODE), cmp_node);
+	// partition at the median
+	int half = count / 2;
+	nth_element(idx, idx + half, idx + count, [&](int a, int b) {
+		return coord(pt[a], axis) < coord(pt[b], axis);
+	});
 
-	// set the initial search item
-	m_imin = 0;
+	m_tree[n].m_axis = axis;
+	m_tree[n].m_split = coord(pt[idx[half]], axis);
+
+	Build(first, half, depth + 1);
+	int right = Build(first + half, count - half, depth + 1);
+	m_tree[n].m_right = right;
+
+	return n;
 }
 
 //-----------------------------------------------------------------------------
 
-int FENNQuery::Find(vec3d x)
+int FENNQuery::Find(const vec3d& x) const
 {
-	double rmin1, rmin2, rmax1, rmax2;
-	double rmin1s, rmin2s, rmax1s, rmax2s;
-	double d, d1, d2, dmin;
-	vec3d r;
-
-	// set the initial search radii
-	d1 = sqrt((m_q1 - x)*(m_q1 - x)); 
-	rmin1 = 0;
-	rmax1 = 2*d1;
-
-	d2 = sqrt((m_q2 - x)*(m_q2 - x));
-	rmin2 = 0;
-	rmax2 = 2*d2;
-
-	// check the last found item
-	r = (*m_ps)[m_imin];
-	dmin = (r - x)*(r - x);
-	d = sqrt(dmin);
-	
-	// adjust search radii
-	if (d1 - d > rmin1) rmin1 = d1 - d;
-	if (d1 + d < rmax1) rmax1 = d1 + d;
-	rmin1s = rmin1*rmin1;
-	rmax1s = rmax1*rmax1;
-
-	if (d2 - d > rmin2) rmin2 = d2 - d;
-	if (d2 + d < rmax2) rmax2 = d2 + d;
-	rmin2s = rmin2*rmin2;
-	rmax2s = rmax2*rmax2;
-
-	// find the first item that satisfies d(i, q1) >= rmin1
-	int i0 = FindRadius(rmin1s);
-
-	for (int i=i0; i<(int) m_bk.size(); ++i)
+	double d2;
+	return Find(x, d2);
+}
+
+//-----------------------------------------------------------------------------
+
+int FENNQuery::Find(const vec3d& x, double& d2) const
+{
+	int imin = -1;
+	double dmin = numeric_limits<double>::max();
+	if (m_tree.empty()) { d2 = dmin; return -1; }
+
+	NN_STACK stack[MAX_STACK];
+	int ns = 0;
+	stack[0].node = 0; stack[0].d2 = 0.0;
+	stack[0].off[0] = stack[0].off[1] = stack[0].off[2] = 0.0;
+	ns++;
+	while (ns > 0)
 	{
-		NODE& n = m_bk[i];
-		if (n.d1 <= rmax1s)
+		--ns;
+		if (stack[ns].d2 > dmin) continue;
+
+		const NODE& node = m_tree[stack[ns].node];
+		if (node.m_axis < 0)
 		{
-			if ((n.d2 >= rmin2s) && (n.d2 <= rmax2s))
+			for (int i=node.m_first; i<node.m_first + node.m_count; ++i)
 			{
-				r = n.r;
-				d = (r - x)*(r - x);
-				if (d < dmin)
+				vec3d r = m_pt[i] - x;
+				double d = r*r;
+				if ((d < dmin) || ((d == dmin) && (m_idx[i] < imin)))
 				{
 					dmin = d;
-					d = sqrt(dmin);
-					m_imin = n.i;
-
-//					if (d1 - d > rmin1) rmin1 = d1 - d;
-					if (d1 + d < rmax1) rmax1 = d1 + d;
-//					rmin1s = rmin1*rmin1;
-					rmax1s = rmax1*rmax1;
-
-					if (d2 - d > rmin2) rmin2 = d2 - d;
-					if (d2 + d < rmax2) rmax2 = d2 + d;
-					rmin2s = rmin2*rmin2;
-					rmax2s = rmax2*rmax2;
+					imin = m_idx[i];
 				}
 			}
 		}
-		else break;
+		else
+		{
+			// visit the near side first
+			int n = stack[ns].node;
+			int a = node.m_axis;
+			double s = coord(x, a) - node.m_split;
+			NN_STACK& sfar = stack[ns];
+			NN_STACK& snear = stack[ns + 1];
+			snear = sfar;
+			snear.node = (s < 0.0 ? n + 1 : node.m_right);
+			sfar.node  = (s < 0.0 ? node.m_right : n + 1);
+			sfar.d2 += s*s - sfar.off[a]*sfar.off[a];
+			sfar.off[a] = s;
+			ns += 2;
+		}
 	}
 
-/*
-	// do it the hard way
-	int imin = 0;
-	r = m_ps->Node(imin).m_rt;
-	double d0 = (r - x)*(r - x);
-	for (i=0; i<m_ps->Nodes(); ++i)
+	d2 = dmin;
+	return imin;
+}
+
+//-----------------------------------------------------------------------------
+
+int FENNQuery::FindK(const vec3d& x, int k, int* idx, double* d2) const
+{
+	if ((k <= 0) || m_tree.empty()) return 0;
+
+	// the current k best points, sorted by distance (and index)
+	vector<double> dk(k);
+	vector<int> ik(k);
+	int nk = 0;
+
+	NN_STACK stack[MAX_STACK];
+	int ns = 0;
+	stack[0].node = 0; stack[0].d2 = 0.0;
+	stack[0].off[0] = stack[0].off[1] = stack[0].off[2] = 0.0;
+	ns++;
+	while (ns > 0)
 	{
-		r = m_ps->Node(i).m_rt;
-		d = (r - x)*(r - x);
-		if (d < d0)
+		--ns;
+		if ((nk == k) && (stack[ns].d2 > dk[k - 1])) continue;
+
+		const NODE& node = m_tree[stack[ns].node];
+		if (node.m_axis < 0)
 		{
-			d0 = d;
-			imin = i;
+			for (int i=node.m_first; i<node.m_first + node.m_count; ++i)
+			{
+				vec3d r = m_pt[i] - x;
+				double d = r*r;
+				int id = m_idx[i];
+				if ((nk == k) && ((d > dk[k - 1]) || ((d == dk[k - 1]) && (id > ik[k - 1])))) continue;
+
+				// insert into the sorted list
+				int j = (nk < k ? nk++ : k - 1);
+				while ((j > 0) && ((d < dk[j - 1]) || ((d == dk[j - 1]) && (id < ik[j - 1]))))
+				{
+					dk[j] = dk[j - 1];
+					ik[j] = ik[j - 1];
+					--j;
+				}
+				dk[j] = d;
+				ik[j] = id;
+			}
 		}
+		else
+		{
+			// visit the near side first
+			int n = stack[ns].node;
+			int a = node.m_axis;
+			double s = coord(x, a) - node.m_split;
+			NN_STACK& sfar = stack[ns];
+			NN_STACK& snear = stack[ns + 1];
+			snear = sfar;
+			snear.node = (s < 0.0 ? n + 1 : node.m_right);
+			sfar.node  = (s < 0.0 ? node.m_right : n + 1);
+			sfar.d2 += s*s - sfar.off[a]*sfar.off[a];
+			sfar.off[a] = s;
+			ns += 2;
+		}
+	}
+
+	for (int i=0; i<nk; ++i)
+	{
+		idx[i] = ik[i];
+		if (d2) d2[i] = dk[i];
 	}
-	assert(imin == m_imin);
-*/
-	return m_imin;
+	return nk;
 }
 
 //-----------------------------------------------------------------------------
 
-int FENNQuery::FindRadius(double r)
+int FENNQuery::FindRadius(const vec3d& x, double R, vector<int>& idx) const
 {
-	int N = (int) m_bk.size();
-	int L = N - 1;
-	int i0 = 0;
-	int i1 = L;
-	if (m_bk[i1].d1 < r) return N;
-	int i = i1 / 2;
-	do
+	idx.clear();
+	if (m_tree.empty()) return 0;
+
+	double R2 = R*R;
+	int stack[MAX_STACK];
+	int ns = 0;
+	stack[ns++] = 0;
+	while (ns > 0)
 	{
-		if (m_bk[i].d1 < r)
+		int n = stack[--ns];
+		const NODE& node = m_tree[n];
+		if (node.m_axis < 0)
 		{
-			i0 = i;
-			if (m_bk[i+1].d1 >= r) { ++i; break; }
+			for (int i=node.m_first; i<node.m_first + node.m_count; ++i)
+			{
+				vec3d r = m_pt[i] - x;
+				if (r*r <= R2) idx.push_back(m_idx[i]);
+			}
 		}
 		else
 		{
-			i1 = i;
-			if ((i==0) || (m_bk[i-1].d1 < r)) break;
+			double s = coord(x, node.m_axis) - node.m_split;
+			if (s <  0.0 || s*s <= R2) stack[ns++] = n + 1;
+			if (s >= 0.0 || s*s <= R2) stack[ns++] = node.m_right;
 		}
-		i = (i1 + i0) / 2;
 	}
-	while(i0 != i1);
 
-	return i;
+	sort(idx.begin(), idx.end());
+	return (int) idx.size();
+}
+
+//-----------------------------------------------------------------------------
+
+void FENNQuery::Find(int n, const vec3d* x, int* idx, double* d2) const
+{
+#pragma omp parallel for if (n >= BATCH_MIN_PARALLEL)
+	for (int i=0; i<n; ++i)
+	{
+		double d;
+		idx[i] = Find(x[i], d);
+		if (d2) d2[i] = d;
+	}
 }
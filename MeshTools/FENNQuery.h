@@ -29,17 +29,27 @@ SOFTWARE.*/
 #include <vector>
 
 //-----------------------------------------------------------------------------
-//! This class is a helper class to locate the neirest neighbour on a surface
+//! This class finds the nearest neighbours of a point in a point cloud.
+//! The points are stored in a KD-tree that is kept in flat arrays: a node's
+//! left child directly follows it, and the points of each node are a contiguous
+//! range of a copy of the point array that is sorted by the tree. The queries 
+//! do not modify the object, so they can be called from multiple threads.
+//! Ties are broken by the lowest point index, so the results are the same as
+//! those of a brute force search.
 
 class FENNQuery  
 {
 public:
+	// a node of the tree. An interior node splits its points along m_axis
+	// at m_split. Its right child is stored in m_right. A leaf stores the 
+	// range [m_first, m_first + m_count) of the sorted point array.
 	struct NODE
 	{
-		int		i;	// index of node
-		vec3d	r;	// position of node
-		double	d1;	// distance to pivot 1
-		double	d2;	// distance to pivot 2
+		double	m_split;	// split coordinate (interior)
+		int		m_axis;		// split axis, or -1 for a leaf
+		int		m_right;	// right child (interior)
+		int		m_first;	// first point
+		int		m_count;	// number of points
 	};
 
 public:
@@ -52,18 +62,34 @@ public:
 	//! attach to a surface
 	void Attach(std::vector<vec3d>* ps) { m_ps = ps; }
 
-	//! find the neirest neighbour of r
-	int Find(vec3d x);	
+	//! number of points in the tree
+	int Points() const { return (int) m_pt.size(); }
+
+	//! find the neirest neighbour of x (returns -1 if there are no points)
+	int Find(const vec3d& x) const;
+
+	//! same, but also returns the squared distance
+	int Find(const vec3d& x, double& d2) const;
+
+	//! find the k nearest neighbours of x, sorted by distance. The indices are 
+	//! stored in idx and, if not null, the squared distances in d2. 
+	//! Returns the number of points found (less than k if there are fewer points).
+	int FindK(const vec3d& x, int k, int* idx, double* d2 = 0) const;
+
+	//! find all the points within a distance R of x, sorted by point index.
+	//! Returns the number of points found.
+	int FindRadius(const vec3d& x, double R, std::vector<int>& idx) const;
+
+	//! find the nearest neighbours of n points in parallel. 
+	//! If d2 is not null, it returns the squared distances.
+	void Find(int n, const vec3d* x, int* idx, double* d2 = 0) const;
 
 protected:
-	int FindRadius(double r);
+	int Build(int first, int count, int depth);
 
 protected:
 	std::vector<vec3d>*	m_ps;	//!< the node array to search
-	std::vector<NODE>	m_bk;	// BK tree
-
-	vec3d	m_q1;	// pivot 1
-	vec3d	m_q2;	// pivot 2
-
-	int		m_imin;	// last found index
+	std::vector<NODE>	m_tree;	//!< the KD-tree nodes
+	std::vector<vec3d>	m_pt;	//!< points in tree order
+	std::vector<int>	m_idx;	//!< index in m_ps of each point in m_pt
 };
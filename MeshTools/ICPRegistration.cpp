@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include "ICPRegistration.h"
 #include <GeomLib/GObject.h>
 #include <MeshLib/FEMesh.h>
+#include "FENNQuery.h"
 
 GICPRegistration::GICPRegistration()
 {
@@ -67,13 +68,17 @@ Transform GICPRegistration::Register(GObject* ptrg, GObject* psrc, const double
 	// (stores the closest points in X to P)
 	vector<vec3d> Y(NP);
 
+	// the target points don't move, so we only need to build this once
+	FENNQuery q(&X);
+	q.Init();
+
 	// loop over max iteration
 	Transform Q;
 	double prev_err = 0.0;
 	for (int counter = 0; counter < maxIter; counter++)
 	{
 		// Compute the closest point set Y
-		ClosestPointSet(X, P, Y);
+		ClosestPointSet(q, X, P, Y);
 
 		// compute the registration
 		double err = 0;
@@ -96,11 +101,11 @@ Transform GICPRegistration::Register(GObject* ptrg, GObject* psrc, const double
 	return Q;
 }
 
-void GICPRegistration::ClosestPointSet(const vector<vec3d>& X, const vector<vec3d>& P, vector<vec3d>& Y)
+void GICPRegistration::ClosestPointSet(const FENNQuery& q, const vector<vec3d>& X, const vector<vec3d>& P, vector<vec3d>& Y)
 {
 	// get the vector sizes
-	int NX = (int) X.size();
 	int NP = (int) P.size();
+	if (NP == 0) return;
 
 	// make sure Y is the right size
 	// (must be same size as P)
@@ -108,20 +113,11 @@ void GICPRegistration::ClosestPointSet(const vector<vec3d>& X, const vector<vec3
 
 	// Find the closest node int X for each point in P
 	// and store in Y
+	vector<int> nn(NP);
+	q.Find(NP, &P[0], &nn[0]);
 	for (int i = 0; i<NP; i++)
 	{
-		double min_dist = 1e99;
-		const vec3d& Pi = P[i];
-		for(int j = 0; j<NX; j++)
-		{
-			const vec3d& Xj = X[j];
-			double dist = (Pi - Xj).Length();
-			if (dist < min_dist)
-			{
-				min_dist = dist;
-				Y[i] = Xj;
-			}
-		}
+		if (nn[i] >= 0) Y[i] = X[nn[i]];
 	}
 }
 
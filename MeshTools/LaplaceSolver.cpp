@@ -30,14 +30,17 @@ SOFTWARE.*/
 #include <MeshLib/FENodeNodeList.h>
 #include <MeshLib/FENodeElementList.h>
 #include <MeshLib/MeshMetrics.h>
+#include <algorithm>
 
 LaplaceSolver::LaplaceSolver()
 {
 	m_maxIters = 1000;
 	m_tol = 1e-4;
 	m_w = 1.0;
+	m_method = RELAXATION;
 
 	m_niters = 0;
+	m_relNorm = 0.0;
 }
 
 void LaplaceSolver::SetMaxIterations(int n)
@@ -55,6 +58,11 @@ void LaplaceSolver::SetRelaxation(double w)
 	m_w = w;
 }
 
+void LaplaceSolver::SetMethod(int method)
+{
+	m_method = method;
+}
+
 int LaplaceSolver::GetIterationCount() const
 {
 	return m_niters;
@@ -153,6 +161,19 @@ bool LaplaceSolver::Solve(FEMesh* pm, vector<double>& val, vector<int>& bn, int
 	}
 	assert(nc == nodeList.size());
 
+	if (m_method == CONJUGATE_GRADIENT)
+		return SolveCG(pm, val, bn, elist, Ve);
+	else
+		return SolveRelaxation(pm, val, bn, elemTag, Ve);
+}
+
+//-----------------------------------------------------------------------------
+// Solves the equations with successive over-relaxation. The matrix is not
+// assembled. Instead, the off-diagonal terms are stored on the node-node list.
+bool LaplaceSolver::SolveRelaxation(FEMesh* pm, vector<double>& val, vector<int>& bn, int elemTag, const vector<double>& Ve)
+{
+	int NN = pm->Nodes();
+
 	// create Node-Node list
 	FENodeNodeList NNL(pm);
 
@@ -283,3 +304,202 @@ bool LaplaceSolver::Solve(FEMesh* pm, vector<double>& val, vector<int>& bn, int
 
 	return (m_relNorm < m_tol);
 }
+
+//-----------------------------------------------------------------------------
+// sparse matrix-vector product y = A*x, with A stored in compressed row format
+static void spmv(const vector<int>& rowPtr, const vector<int>& col, const vector<double>& A, const vector<double>& x, vector<double>& y)
+{
+	int neq = (int)y.size();
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < neq; ++i)
+	{
+		double sum = 0.0;
+		for (int k = rowPtr[i]; k < rowPtr[i + 1]; ++k) sum += A[k] * x[col[k]];
+		y[i] = sum;
+	}
+}
+
+//-----------------------------------------------------------------------------
+static double dot(const vector<double>& a, const vector<double>& b)
+{
+	int n = (int)a.size();
+	double sum = 0.0;
+#pragma omp parallel for schedule(static) reduction(+:sum)
+	for (int i = 0; i < n; ++i) sum += a[i] * b[i];
+	return sum;
+}
+
+//-----------------------------------------------------------------------------
+// Assembles the element Laplacians of the free nodes in a compressed row matrix
+// and solves with the Jacobi-preconditioned conjugate gradient method.
+// The relative norm is the norm of the residual relative to that of the right-hand side.
+bool LaplaceSolver::SolveCG(FEMesh* pm, vector<double>& val, vector<int>& bn, const vector<int>& elist, const vector<double>& Ve)
+{
+	int NN = pm->Nodes();
+	int NE = (int)elist.size();
+
+	// number the free nodes
+	vector<int> eq(NN, -1);
+	int neq = 0;
+	for (int i = 0; i < NN; ++i)
+	{
+		if (bn[i] == 0) eq[i] = neq++;
+	}
+	m_relNorm = 0.0;
+	if (neq == 0) return true;
+
+	// count the elements of each node
+	vector<int> nodeOff(NN + 1, 0);
+	for (int i = 0; i < NE; ++i)
+	{
+		FEElement& el = pm->Element(elist[i]);
+		for (int j = 0; j < el.Nodes(); ++j) nodeOff[el.m_node[j] + 1]++;
+	}
+	for (int i = 0; i < NN; ++i) nodeOff[i + 1] += nodeOff[i];
+
+	// node-element list of the selected elements
+	vector<int> nodeElem(nodeOff[NN]);
+	vector<int> pos(nodeOff.begin(), nodeOff.end() - 1);
+	for (int i = 0; i < NE; ++i)
+	{
+		FEElement& el = pm->Element(elist[i]);
+		for (int j = 0; j < el.Nodes(); ++j) nodeElem[pos[el.m_node[j]]++] = elist[i];
+	}
+
+	// build the sparsity pattern. Each row stores the free nodes that
+	// share an element with the row's node, sorted by equation number.
+	vector<int> rowPtr(neq + 1, 0);
+	vector<int> col;
+	col.reserve(neq * 16);
+	vector<int> tag(NN, -1);
+	for (int i = 0; i < NN; ++i)
+	{
+		int r = eq[i];
+		if (r < 0) continue;
+
+		size_t n0 = col.size();
+		for (int j = nodeOff[i]; j < nodeOff[i + 1]; ++j)
+		{
+			FEElement& el = pm->Element(nodeElem[j]);
+			for (int k = 0; k < el.Nodes(); ++k)
+			{
+				int nk = el.m_node[k];
+				if ((eq[nk] >= 0) && (tag[nk] != i))
+				{
+					tag[nk] = i;
+					col.push_back(eq[nk]);
+				}
+			}
+		}
+		sort(col.begin() + n0, col.end());
+		rowPtr[r + 1] = (int)col.size();
+	}
+
+	// assemble the matrix and the right-hand side
+	vector<double> A(col.size(), 0.0);
+	vector<double> b(neq, 0.0);
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int n = 0; n < NE; ++n)
+	{
+		FEElement& el = pm->Element(elist[n]);
+		int ne = el.Nodes();
+
+		// shape function gradients, evaluated at the element nodes
+		vec3d G[FEElement::MAX_NODES][FEElement::MAX_NODES];
+		for (int k = 0; k < ne; ++k) FEMeshMetrics::ShapeGradients(*pm, el, k, G[k]);
+		double w = Ve[elist[n]] / ne;
+
+		for (int a = 0; a < ne; ++a)
+		{
+			int r = eq[el.m_node[a]];
+			if (r < 0) continue;
+
+			const int* c0 = &col[0] + rowPtr[r];
+			const int* c1 = &col[0] + rowPtr[r + 1];
+			for (int c = 0; c < ne; ++c)
+			{
+				double kab = 0.0;
+				for (int k = 0; k < ne; ++k) kab += G[k][a] * G[k][c];
+				kab *= w;
+
+				int nc = el.m_node[c];
+				if (eq[nc] >= 0)
+				{
+					int m = (int)(lower_bound(c0, c1, eq[nc]) - &col[0]);
+#pragma omp atomic
+					A[m] += kab;
+				}
+				else
+				{
+					double f = kab * val[nc];
+#pragma omp atomic
+					b[r] -= f;
+				}
+			}
+		}
+	}
+
+	// inverted diagonal for the preconditioner
+	vector<double> Dinv(neq, 1.0);
+	for (int i = 0; i < neq; ++i)
+	{
+		int m = (int)(lower_bound(col.begin() + rowPtr[i], col.begin() + rowPtr[i + 1], i) - col.begin());
+		if (A[m] != 0.0) Dinv[i] = 1.0 / A[m];
+	}
+
+	// initial guess
+	vector<double> x(neq);
+	for (int i = 0; i < NN; ++i)
+	{
+		if (eq[i] >= 0) x[eq[i]] = val[i];
+	}
+
+	// initial residual
+	vector<double> r(neq), z(neq), p(neq), q(neq);
+	spmv(rowPtr, col, A, x, q);
+	for (int i = 0; i < neq; ++i) r[i] = b[i] - q[i];
+
+	double bnorm = sqrt(dot(b, b));
+	if (bnorm == 0.0) bnorm = 1.0;
+
+	for (int i = 0; i < neq; ++i) p[i] = z[i] = Dinv[i] * r[i];
+	double rz = dot(r, z);
+	m_relNorm = sqrt(dot(r, r)) / bnorm;
+
+	bool bconv = (m_relNorm < m_tol);
+	while ((bconv == false) && (m_niters < m_maxIters))
+	{
+		spmv(rowPtr, col, A, p, q);
+		double pq = dot(p, q);
+
+		// the matrix should be positive definite
+		if (pq <= 0.0) break;
+
+		double alpha = rz / pq;
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < neq; ++i)
+		{
+			x[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+			z[i] = Dinv[i] * r[i];
+		}
+		m_niters++;
+
+		m_relNorm = sqrt(dot(r, r)) / bnorm;
+		bconv = (m_relNorm < m_tol);
+
+		double rzp = rz;
+		rz = dot(r, z);
+		double beta = rz / rzp;
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < neq; ++i) p[i] = z[i] + beta * p[i];
+	}
+
+	// copy the solution
+	for (int i = 0; i < NN; ++i)
+	{
+		if (eq[i] >= 0) val[i] = x[eq[i]];
+	}
+
+	return bconv;
+}
@@ -34,12 +34,20 @@ class FEMesh;
 //! This class solves the Laplace equation using an iterative method
 class LaplaceSolver
 {
+public:
+	// solution methods
+	enum SolverMethod {
+		RELAXATION,			// successive over-relaxation on the node-node graph
+		CONJUGATE_GRADIENT	// Jacobi-preconditioned CG on the assembled sparse matrix
+	};
+
 public:
 	LaplaceSolver();
 
 	void SetMaxIterations(int n);
 	void SetTolerance(double a);
 	void SetRelaxation(double w);
+	void SetMethod(int method);
 
 	// Solves the Laplace equation on the mesh.
 	// Input: val = initial values for all nodes
@@ -51,11 +59,16 @@ public: // output
 	int GetIterationCount() const;
 	double GetRelativeNorm() const;
 
+private:
+	bool SolveRelaxation(FEMesh* pm, vector<double>& val, vector<int>& bn, int elemTag, const vector<double>& Ve);
+	bool SolveCG(FEMesh* pm, vector<double>& val, vector<int>& bn, const vector<int>& elist, const vector<double>& Ve);
+
 private:
 	// input parameters
 	int		m_maxIters;	//!< max nr of iterations
 	double	m_tol;	//!< convergence tolerance
 	double	m_w;	//!< relaxation parameter
+	int		m_method;	//!< solution method
 
 	// output variables
 	int		m_niters;		//!< nr of iterations
@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include "SurfaceDistance.h"
 #include <MeshLib/FEMesh.h>
 #include <GeomLib/GObject.h>
+#include "FENNQuery.h"
 
 CSurfaceDistance::CSurfaceDistance()
 {
@@ -261,39 +262,27 @@ bool CSurfaceDistance::ClosestPoint(GObject* pso, GObject* pmo, vector<double>&
 
 	// get the number of nodes
 	int nodes = ps->Nodes();
+	dist.assign(nodes, 0.0);
+	if ((nodes == 0) || (pm->Nodes() == 0)) return true;
 
-	// repeat for all nodes
+	// build the search tree for the master nodes
+	vector<vec3d> rm(pm->Nodes());
+	for (int j=0; j<pm->Nodes(); ++j) rm[j] = pm->Node(j).r;
+	FENNQuery q(&rm);
+	q.Init();
+
+	// get the nodal coordinates in the local coordinates of the master object
+	vector<vec3d> ri(nodes);
 	for (int i=0; i<nodes; ++i)
 	{
-		FENode& nodei = ps->Node(i);
-
-		// get the global nodal coordinates
-		vec3d ri = pso->GetTransform().LocalToGlobal(nodei.r);
-
-		// convert it to the local coordinate in the master object
-		ri = pmo->GetTransform().GlobalToLocal(ri);
-
-		// repeat over all master nodes
-		double Dmin = 0.0;
-		for (int j=0; j<pm->Nodes(); ++j)
-		{
-			// get the position of the master node
-			vec3d& rj = pm->Node(j).r;
-
-			// separation vector
-			vec3d r = rj - ri;
-
-			// square length
-			double d2 = r*r;
-
-			if ((d2 < Dmin)||(j==0))
-			{
-				Dmin = d2;
-			}			
-		}
-
-		dist[i] = sqrt(Dmin);
+		vec3d r = pso->GetTransform().LocalToGlobal(ps->Node(i).r);
+		ri[i] = pmo->GetTransform().GlobalToLocal(r);
 	}
 
+	// find the closest master nodes
+	vector<int> nn(nodes);
+	q.Find(nodes, &ri[0], &nn[0], &dist[0]);
+	for (int i=0; i<nodes; ++i) dist[i] = sqrt(dist[i]);
+
 	return true;
 }
@@ -27,6 +27,7 @@ SOFTWARE.*/
 #include "stdafx.h"
 #include "TetOverlap.h"
 #include <MeshLib/FEMesh.h>
+#include <algorithm>
 
 struct TET
 {
@@ -76,31 +77,128 @@ bool TetOverlap::Apply(FEMesh* mesh, std::vector<pair<int, int> >& tetList)
 
 	// the list that will store the overlapping pairs
 	tetList.clear();
-	tetList.reserve(NE / 2);
+	if (NE == 0) return true;
 
+	// Get the (inflated) bounding boxes of all the tets. These are the boxes
+	// of the first tet of each pair that is tested.
+	vector<BOX> box(NE);
+	BOX meshBox;
+	double hmean = 0.0;
 	for (int i = 0; i < NE; ++i)
 	{
 		TET& a = tet[i];
+		BOX& bi = box[i];
+		for (int k = 0; k < 4; ++k) bi += a.r[k];
+		double R = bi.GetMaxExtent();
+		bi.Inflate(R*0.001);
 
-		BOX box;
-		for (int k = 0; k < 4; ++k) box += a.r[k];
-		double R = box.GetMaxExtent();
-		box.Inflate(R*0.001);
+		meshBox += bi;
+		hmean += bi.GetMaxExtent();
+	}
+	hmean /= NE;
+
+	// Put the boxes in a uniform grid, so that we only need to test tets that
+	// share a cell. The cell size is the average tet size, but we don't allow
+	// many more cells than tets.
+	double W = meshBox.Width(), H = meshBox.Height(), D = meshBox.Depth();
+	double h = hmean;
+	if (h <= 0.0) h = meshBox.GetMaxExtent();
+	if (h <= 0.0) h = 1.0;
+	int nx, ny, nz;
+	do
+	{
+		nx = (int)(W / h) + 1;
+		ny = (int)(H / h) + 1;
+		nz = (int)(D / h) + 1;
+		if ((double)nx*(double)ny*(double)nz <= 8.0*NE + 1.0) break;
+		h *= 1.5;
+	}
+	while (true);
+
+	// the cell range of each box
+	vector<int> cell(6 * NE);
+	for (int i = 0; i < NE; ++i)
+	{
+		const BOX& bi = box[i];
+		int* c = &cell[6 * i];
+		c[0] = (int)((bi.x0 - meshBox.x0) / h); if (c[0] >= nx) c[0] = nx - 1;
+		c[1] = (int)((bi.y0 - meshBox.y0) / h); if (c[1] >= ny) c[1] = ny - 1;
+		c[2] = (int)((bi.z0 - meshBox.z0) / h); if (c[2] >= nz) c[2] = nz - 1;
+		c[3] = (int)((bi.x1 - meshBox.x0) / h); if (c[3] >= nx) c[3] = nx - 1;
+		c[4] = (int)((bi.y1 - meshBox.y0) / h); if (c[4] >= ny) c[4] = ny - 1;
+		c[5] = (int)((bi.z1 - meshBox.z0) / h); if (c[5] >= nz) c[5] = nz - 1;
+	}
+
+	// build the list of tets in each cell
+	int NC = nx*ny*nz;
+	vector<int> cellStart(NC + 1, 0);
+	for (int i = 0; i < NE; ++i)
+	{
+		const int* c = &cell[6 * i];
+		for (int z = c[2]; z <= c[5]; ++z)
+			for (int y = c[1]; y <= c[4]; ++y)
+				for (int x = c[0]; x <= c[3]; ++x) cellStart[(z*ny + y)*nx + x + 1]++;
+	}
+	for (int i = 0; i < NC; ++i) cellStart[i + 1] += cellStart[i];
+	vector<int> cellTets(cellStart[NC]);
+	vector<int> pos(cellStart.begin(), cellStart.end() - 1);
+	for (int i = 0; i < NE; ++i)
+	{
+		const int* c = &cell[6 * i];
+		for (int z = c[2]; z <= c[5]; ++z)
+			for (int y = c[1]; y <= c[4]; ++y)
+				for (int x = c[0]; x <= c[3]; ++x) cellTets[pos[(z*ny + y)*nx + x]++] = i;
+	}
 
-		for (int j = i+1; j < NE; ++j)
+	// test all the pairs that share a cell. Each thread collects its own list.
+#pragma omp parallel
+	{
+		vector<pair<int, int> > localList;
+
+#pragma omp for schedule(dynamic, 256)
+		for (int i = 0; i < NE; ++i)
 		{
-			TET& b = tet[j];
-			if (box_test(box, b) == false)
-			{
-				if (tet_overlap(a, b))
-				{
-					pair<int, int> tetPair(i, j);
-					tetList.push_back(tetPair);
-				}
-			}
+			TET& a = tet[i];
+			const BOX& bi = box[i];
+			const int* ci = &cell[6 * i];
+			for (int z = ci[2]; z <= ci[5]; ++z)
+				for (int y = ci[1]; y <= ci[4]; ++y)
+					for (int x = ci[0]; x <= ci[3]; ++x)
+					{
+						int nc = (z*ny + y)*nx + x;
+						for (int m = cellStart[nc]; m < cellStart[nc + 1]; ++m)
+						{
+							int j = cellTets[m];
+							if (j <= i) continue;
+
+							// A pair can share several cells, but we only test it in the
+							// cell that contains the lowest corner of both cell ranges.
+							const int* cj = &cell[6 * j];
+							if ((x != (ci[0] > cj[0] ? ci[0] : cj[0])) ||
+								(y != (ci[1] > cj[1] ? ci[1] : cj[1])) ||
+								(z != (ci[2] > cj[2] ? ci[2] : cj[2]))) continue;
+
+							if (bi.Intersects(box[j]) == false) continue;
+
+							TET& b = tet[j];
+							if (box_test(box[i], b) == false)
+							{
+								if (tet_overlap(a, b))
+								{
+									localList.push_back(pair<int, int>(i, j));
+								}
+							}
+						}
+					}
 		}
+
+#pragma omp critical (TetOverlap_Apply)
+		tetList.insert(tetList.end(), localList.begin(), localList.end());
 	}
 
+	// sort the pairs, so that the list does not depend on the thread scheduling
+	sort(tetList.begin(), tetList.end());
+
 	return true;
 }
 
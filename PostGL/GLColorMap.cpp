@@ -188,8 +188,8 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 		for (int i=0; i<NE; ++i)
 		{
 			FEElement_& el = pm->ElementRef(i);
-			ELEMDATA& d0 = s0.m_ELEM[i];
-			ELEMDATA& d1 = s1.m_ELEM[i];
+			ElemDataArray::Ref d0 = s0.m_ELEM[i];
+			ElemDataArray::Ref d1 = s1.m_ELEM[i];
 			if ((d0.m_state & StatusFlags::ACTIVE) && (d1.m_state & StatusFlags::ACTIVE))
 			{
 				float f0 = d0.m_val;
@@ -206,8 +206,8 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 		for (int i = 0; i<pm->Nodes(); ++i)
 		{
 			FENode& node = pm->Node(i);
-			NODEDATA& d0 = s0.m_NODE[i];
-			NODEDATA& d1 = s1.m_NODE[i];
+			NodeDataArray::Ref d0 = s0.m_NODE[i];
+			NodeDataArray::Ref d1 = s1.m_NODE[i];
 			if ((node.IsEnabled()) && (d0.m_ntag > 0) && (d1.m_ntag > 0))
 			{
 				float f0 = d0.m_val;
@@ -230,8 +230,8 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 				{
 					int nj = face.n[j];
 					FENode& node = pm->Node(nj);
-					NODEDATA& d0 = s0.m_NODE[nj];
-					NODEDATA& d1 = s1.m_NODE[nj];
+					NodeDataArray::Ref d0 = s0.m_NODE[nj];
+					NodeDataArray::Ref d1 = s1.m_NODE[nj];
 					if ((node.IsEnabled()) && (d0.m_ntag > 0) && (d1.m_ntag > 0))
 					{
 						float f0 = d0.m_val;
@@ -250,8 +250,8 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 			{
 				int nj = (j == 0 ? de.n0 : de.n1);
 				FENode& node = pm->Node(nj);
-				NODEDATA& d0 = s0.m_NODE[nj];
-				NODEDATA& d1 = s1.m_NODE[nj];
+				NodeDataArray::Ref d0 = s0.m_NODE[nj];
+				NodeDataArray::Ref d1 = s1.m_NODE[nj];
 				if ((node.IsEnabled()) && (d0.m_ntag > 0) && (d1.m_ntag > 0))
 				{
 					float f0 = d0.m_val;
@@ -297,8 +297,8 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 			int ni = de.elem;
 			if (ni >= 0)
 			{
-				ELEMDATA& d0 = s0.m_ELEM[ni];
-				ELEMDATA& d1 = s1.m_ELEM[ni];
+				ElemDataArray::Ref d0 = s0.m_ELEM[ni];
+				ElemDataArray::Ref d1 = s1.m_ELEM[ni];
 				if ((d0.m_state & StatusFlags::ACTIVE) && (d1.m_state & StatusFlags::ACTIVE))
 				{
 					float f0 = d0.m_val;
@@ -374,7 +374,9 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 	if (min == max) max++;
 
 	float dti = 1.f / (max - min);
-	for (int i = 0; i<pm->Faces(); ++i)
+	int NF = pm->Faces();
+#pragma omp parallel for
+	for (int i = 0; i<NF; ++i)
 	{
 		FEFace& face = pm->Face(i);
 		FACEDATA& fd = s0.m_FACE[i];
@@ -392,11 +394,13 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 	}
 
 	// update element textures
-	for (int i = 0; i<pm->Elements(); ++i)
+	int NE = pm->Elements();
+#pragma omp parallel for
+	for (int i = 0; i<NE; ++i)
 	{
 		FEElement_& el = pm->ElementRef(i);
-		ELEMDATA& d0 = s0.m_ELEM[i];
-		ELEMDATA& d1 = s1.m_ELEM[i];
+		ElemDataArray::Ref d0 = s0.m_ELEM[i];
+		ElemDataArray::Ref d1 = s1.m_ELEM[i];
 		if ((d0.m_state & StatusFlags::ACTIVE) && (d1.m_state & StatusFlags::ACTIVE))
 		{
 			float f0 = d0.m_val;
@@ -439,8 +443,8 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 					face.Activate();
 					int iel = face.m_elem[0].eid;
 
-					ELEMDATA& d0 = s0.m_ELEM[iel];
-					ELEMDATA& d1 = s1.m_ELEM[iel];
+					ElemDataArray::Ref d0 = s0.m_ELEM[iel];
+					ElemDataArray::Ref d1 = s1.m_ELEM[iel];
 
 					if (((d0.m_state & StatusFlags::ACTIVE) == 0) || ((d1.m_state & StatusFlags::ACTIVE) == 0)) face.Deactivate();
 					else
@@ -456,8 +460,8 @@ void CGLColorMap::Update(int ntime, float dt, bool breset)
 						int nf = face.Nodes();
 						for (int k = 0; k < nf; ++k)
 						{
-							NODEDATA& d0 = s0.m_NODE[face.n[k]];
-							NODEDATA& d1 = s1.m_NODE[face.n[k]];
+							NodeDataArray::Ref d0 = s0.m_NODE[face.n[k]];
+							NodeDataArray::Ref d1 = s1.m_NODE[face.n[k]];
 
 							float v0 = d0.m_val;
 							float v1 = d1.m_val;
@@ -90,6 +90,9 @@ void CGLDisplacementMap::Activate(bool b)
 		FEMeshBase* pm = state->GetFEMesh();
 		for (int i = 0; i<pm->Nodes(); ++i) pm->Node(i).r = ref.m_Node[i].m_rt;
 		pm->UpdateNormals();
+
+		// the render buffers still hold the displaced positions
+		po->PositionsChanged();
 	}
 }
 
@@ -124,7 +127,9 @@ void CGLDisplacementMap::Update(int ntime, float dt, bool breset)
 		Post::FERefState& ref = *s1.m_ref;
 
 		// set the current nodal positions
-		for (int i = 0; i<pm->Nodes(); ++i)
+		int NN = pm->Nodes();
+#pragma omp parallel for
+		for (int i = 0; i<NN; ++i)
 		{
 			vec3f du = s1.m_NODE[i].m_rt - ref.m_Node[i].m_rt;
 			m_du[i] = du;
@@ -149,10 +154,10 @@ void CGLDisplacementMap::Update(int ntime, float dt, bool breset)
 		float w = dt / df;
 
 		// set the current nodal positions
-		for (int i = 0; i<pm->Nodes(); ++i)
+		int NN = pm->Nodes();
+#pragma omp parallel for
+		for (int i = 0; i<NN; ++i)
 		{
-			FENode& node = pm->Node(i);
-
 			// get nodal displacements
 			vec3f r0 = ref.m_Node[i].m_rt;
 			vec3f d1 = s1.m_NODE[i].m_rt - r0;
@@ -174,21 +179,24 @@ void CGLDisplacementMap::UpdateState(int ntime, bool breset)
 	FEMeshBase* pm = po->GetActiveMesh();
 	FEPostModel* pfem = po->GetFEModel();
 	if (pfem == nullptr) {
-		m_ntag.clear(); return;
+		m_ntag.clear(); m_nver.clear(); return;
 	}
 
 	int N = pfem->GetStates();
 
 	// TODO: This does not look right the correct place for this
-	if (breset || (N != m_ntag.size())) m_ntag.assign(N, -1);
+	if (breset || (N != m_ntag.size())) { m_ntag.assign(N, -1); m_nver.assign(N, 0); }
 
 	int nfield = pfem->GetDisplacementField();
+	if (nfield < 0) return;
 
-	if ((nfield >= 0) && (m_ntag[ntime] != nfield))
+	// The positions need to be updated when the state's data was read again,
+	// since the state's nodal positions are then reset to the reference positions.
+	FEState& s = *pfem->GetState(ntime);
+	if ((m_ntag[ntime] != nfield) || (m_nver[ntime] != s.DataVersion()))
 	{
 		m_ntag[ntime] = nfield;
-
-		FEState& s = *pfem->GetState(ntime);
+		m_nver[ntime] = s.DataVersion();
 
 		// get the reference state
 		Post::FERefState& ref = *s.m_ref;
@@ -221,7 +229,9 @@ void CGLDisplacementMap::UpdateNodes()
 
 	vec3d s = m_scl;
 
-	for (int i = 0; i < pm->Nodes(); ++i)
+	int NN = pm->Nodes();
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i)
 	{
 		FENode& node = pm->Node(i);
 		vec3d r0 = ref.m_Node[i].m_rt;
@@ -57,5 +57,6 @@ public:
 	vec3d				m_scl;		//!< displacement scale factor
 	std::vector<vec3f>	m_du;		//!< nodal displacements
 	std::vector<int>	m_ntag;
+	std::vector<unsigned int>	m_nver;	//!< data version of the states when their positions were updated
 };
 }
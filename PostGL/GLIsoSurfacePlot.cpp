@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include "GLWLib/GLWidgetManager.h"
 #include "PostLib/constants.h"
 #include "GLModel.h"
+#include <functional>
 using namespace Post;
 
 extern int LUT[256][15];
@@ -70,6 +71,8 @@ CGLIsoSurfacePlot::CGLIsoSurfacePlot(CGLModel* po) : CGLLegendPlot(po)
 	m_Col.SetDivisions(m_nslices);
 	m_Col.SetSmooth(false);
 
+	m_valRevision = 0;
+
 	GLLegendBar* bar = new GLLegendBar(&m_Col, 0, 0, 600, 100, GLLegendBar::HORIZONTAL);
 	bar->align(GLW_ALIGN_BOTTOM | GLW_ALIGN_HCENTER);
 	bar->SetType(GLLegendBar::DISCRETE);
@@ -80,6 +83,18 @@ CGLIsoSurfacePlot::CGLIsoSurfacePlot(CGLModel* po) : CGLLegendPlot(po)
 	UpdateData(false);
 }
 
+CGLIsoSurfacePlot::~CGLIsoSurfacePlot()
+{
+	ClearSlices();
+}
+
+void CGLIsoSurfacePlot::ClearSlices()
+{
+	for (size_t i = 0; i < m_slice.size(); ++i) delete m_slice[i];
+	m_slice.clear();
+	m_sliceKey.clear();
+}
+
 int CGLIsoSurfacePlot::GetSlices() 
 { 
 	return m_nslices; 
@@ -134,6 +149,19 @@ void CGLIsoSurfacePlot::Render(CGLContext& rc)
 {
 	if (m_nfield == 0) return;
 
+	// make sure we have a buffer for each slice
+	if ((int)m_slice.size() != m_nslices)
+	{
+		ClearSlices();
+		for (int i = 0; i < m_nslices; ++i)
+		{
+			m_slice.push_back(new GLVertexBuffer(GLVertexBuffer::TRIANGLES, GLVertexBuffer::NORMAL));
+			m_sliceKey.push_back(0);
+		}
+	}
+
+	size_t dataKey = SliceDataKey();
+
 	glPushAttrib(GL_ENABLE_BIT | GL_LIGHTING_BIT);
 	{
 		glColor4ub(255,255,255,255);
@@ -165,127 +193,183 @@ void CGLIsoSurfacePlot::Render(CGLContext& rc)
 			CColorMap& map = m_Col.ColorMap();
 			GLColor col = map.map(w);
 
-			RenderSlice(ref, col);
+			// rebuild the slice if anything changed
+			size_t key = dataKey;
+			hash_combine(key, std::hash<float>()(ref));
+			if (key != m_sliceKey[i])
+			{
+				BuildSlice(ref, *m_slice[i]);
+				m_sliceKey[i] = key;
+			}
+
+			glColor3ub(col.r, col.g, col.b);
+			m_slice[i]->Render();
 		}
 	}
 	glPopAttrib();
 }
 
+//-----------------------------------------------------------------------------
+size_t CGLIsoSurfacePlot::SliceDataKey()
+{
+	CGLModel* mdl = GetModel();
+	FEPostMesh* pm = mdl->GetActiveMesh();
+
+	size_t key = m_valRevision;
+	hash_combine(key, (size_t) mdl->PositionRevision());
+	hash_combine(key, (size_t) pm);
+	hash_combine(key, (size_t) m_bsmooth);
+	hash_combine(key, (size_t) m_bcut_hidden);
+
+	// the elements that are sliced depend on the visibility and the materials
+	int NE = pm->Elements();
+	for (int i = 0; i < NE; ++i)
+	{
+		hash_combine(key, (size_t)(SliceNodeTable(pm->ElementRef(i)) != nullptr));
+	}
+
+	return key;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
-void CGLIsoSurfacePlot::RenderSlice(float ref, GLColor col)
+const int* CGLIsoSurfacePlot::SliceNodeTable(FEElement_& el)
 {
-	int i, k, l;
-	int ncase, *pf;
-	float w;
+	static const int HEX_NT[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+	static const int PEN_NT[8] = {0, 1, 2, 2, 3, 4, 5, 5};
+	static const int TET_NT[8] = {0, 1, 2, 2, 3, 3, 3, 3};
 
-	float ev[8];	// element nodal values
-	vec3f ex[8];	// element nodal positions
-	vec3f en[8];	// element nodal gradients
+	// render only if the element is visible and
+	// its material is enabled
+	FEPostModel* ps = GetModel()->GetFEModel();
+	FEMaterial* pmat = ps->GetMaterial(el.m_MatID);
+	if ((pmat->benable == false) || ((el.IsVisible() == false) && (m_bcut_hidden == false)) || (el.IsSolid() == false)) return nullptr;
 
-	const int HEX_NT[8] = {0, 1, 2, 3, 4, 5, 6, 7};
-	const int PEN_NT[8] = {0, 1, 2, 2, 3, 4, 5, 5};
-	const int TET_NT[8] = {0, 1, 2, 2, 3, 3, 3, 3};
+	switch (el.Type())
+	{
+	case FE_HEX8   : return HEX_NT;
+	case FE_HEX20  : return HEX_NT;
+	case FE_HEX27  : return HEX_NT;
+	case FE_PENTA6 : return PEN_NT;
+	case FE_PENTA15: return PEN_NT;
+	case FE_TET4   : return TET_NT;
+	case FE_TET5   : return TET_NT;
+	}
+	return nullptr;
+}
 
+void CGLIsoSurfacePlot::BuildSlice(float ref, GLVertexBuffer& buf)
+{
 	CGLModel* mdl = GetModel();
-	FEPostModel* ps = mdl->GetFEModel();
 
 	// get the mesh
 	FEPostMesh* pm = mdl->GetActiveMesh();
+	int NE = pm->Elements();
 
-	const int* nt;
+	// count the triangles of each element
+	vector<int> tri(NE + 1, 0);
+#pragma omp parallel for
+	for (int i=0; i<NE; ++i)
+	{
+		FEElement_& el = pm->ElementRef(i);
+		const int* nt = SliceNodeTable(el);
+		if (nt)
+		{
+			// calculate the case of the element
+			int ncase = 0;
+			for (int k=0; k<8; ++k)
+				if (m_val[el.m_node[nt[k]]] <= ref) ncase |= (1 << k);
+
+			int* pf = LUT[ncase];
+			int l = 0;
+			while ((l < 5) && (pf[3*l] != -1)) l++;
+			tri[i + 1] = l;
+		}
+	}
+	for (int i=0; i<NE; ++i) tri[i + 1] += tri[i];
 
-	glColor3ub(col.r, col.g, col.b);
+	buf.Resize(3 * tri[NE]);
 
-	// loop over all elements
-	for (i=0; i<pm->Elements(); ++i)
+	// generate the triangles
+#pragma omp parallel for
+	for (int i=0; i<NE; ++i)
 	{
-		// render only if the element is visible and
-		// its material is enabled
+		if (tri[i + 1] == tri[i]) continue;
+
 		FEElement_& el = pm->ElementRef(i);
-		FEMaterial* pmat = ps->GetMaterial(el.m_MatID);
-		if (pmat->benable && (el.IsVisible() || m_bcut_hidden) && el.IsSolid())
+		const int* nt = SliceNodeTable(el);
+
+		float ev[8];	// element nodal values
+		vec3f ex[8];	// element nodal positions
+		vec3f en[8];	// element nodal gradients
+
+		// get the nodal values
+		for (int k=0; k<8; ++k)
 		{
-			switch (el.Type())
-			{
-			case FE_HEX8   : nt = HEX_NT; break;
-			case FE_HEX20  : nt = HEX_NT; break;
-			case FE_HEX27  : nt = HEX_NT; break;
-			case FE_PENTA6 : nt = PEN_NT; break;
-            case FE_PENTA15: nt = PEN_NT; break;
-            case FE_TET4   : nt = TET_NT; break;
-			case FE_TET5   : nt = TET_NT; break;
-			}
+			FENode& node = pm->Node(el.m_node[nt[k]]);
 
-			// get the nodal values
-			for (k=0; k<8; ++k)
-			{
-				FENode& node = pm->Node(el.m_node[nt[k]]);
+			ev[k] = m_val[el.m_node[nt[k]]];
+			ex[k] = to_vec3f(node.r);
+			if (m_bsmooth) en[k] = m_grd[el.m_node[nt[k]]];
+		}
 
-				ev[k] = m_val[el.m_node[nt[k]]];
-				ex[k] = to_vec3f(node.r);
-				en[k] = m_grd[el.m_node[nt[k]]];
-			}
+		// calculate the case of the element
+		int ncase = 0;
+		for (int k=0; k<8; ++k) 
+			if (ev[k] <= ref) ncase |= (1 << k);
 
-			// calculate the case of the element
-			ncase = 0;
-			for (k=0; k<8; ++k) 
-				if (ev[k] <= ref) ncase |= (1 << k);
+		// loop over faces
+		int* pf = LUT[ncase];
+		int nv = 3*tri[i];
+		for (int l=0; l<5; l++)
+		{
+			if (*pf == -1) break;
 
-			// loop over faces
-			pf = LUT[ncase];
-			for (l=0; l<5; l++)
+			// calculate nodal positions
+			vec3f r[3], vn[3];
+			for (int k=0; k<3; k++)
 			{
-				if (*pf == -1) break;
-
-				// calculate nodal positions
-				vec3f r[3], vn[3];
-				for (k=0; k<3; k++)
-				{
-					int n1 = ET_HEX[pf[k]][0];
-					int n2 = ET_HEX[pf[k]][1];
+				int n1 = ET_HEX[pf[k]][0];
+				int n2 = ET_HEX[pf[k]][1];
 
-					w = (ref - ev[n1]) / (ev[n2] - ev[n1]);
+				float w = (ref - ev[n1]) / (ev[n2] - ev[n1]);
 
-					r[k] = ex[n1]*(1-w) + ex[n2]*w;
-				}
+				r[k] = ex[n1]*(1-w) + ex[n2]*w;
+			}
 
-				// calculate normals
-				if (m_bsmooth)
+			// calculate normals
+			if (m_bsmooth)
+			{
+				for (int k=0; k<3; k++)
 				{
-					for (k=0; k<3; k++)
-					{
-						int n1 = ET_HEX[pf[k]][0];
-						int n2 = ET_HEX[pf[k]][1];
+					int n1 = ET_HEX[pf[k]][0];
+					int n2 = ET_HEX[pf[k]][1];
 
-						w = (ref - ev[n1]) / (ev[n2] - ev[n1]);
+					float w = (ref - ev[n1]) / (ev[n2] - ev[n1]);
 
-						vn[k] = en[n1]*(1-w) + en[n2]*w;
-						vn[k].Normalize();
-					}
+					vn[k] = en[n1]*(1-w) + en[n2]*w;
+					vn[k].Normalize();
 				}
-				else
-				{
-					for (k=0; k<3; k++)
-					{
-						int kp1 = (k+1)%3;
-						int km1 = (k+2)%3;
-						vn[k] = (r[kp1] - r[k])^(r[km1] - r[k]);
-						vn[k].Normalize();
-					}
-				}
-
-				// render the face
-				glBegin(GL_TRIANGLES);
+			}
+			else
+			{
+				for (int k=0; k<3; k++)
 				{
-					glNormal3f(vn[0].x,vn[0].y,vn[0].z); glVertex3f(r[0].x, r[0].y, r[0].z);
-					glNormal3f(vn[1].x,vn[1].y,vn[1].z); glVertex3f(r[1].x, r[1].y, r[1].z);
-					glNormal3f(vn[2].x,vn[2].y,vn[2].z); glVertex3f(r[2].x, r[2].y, r[2].z);
+					int kp1 = (k+1)%3;
+					int km1 = (k+2)%3;
+					vn[k] = (r[kp1] - r[k])^(r[km1] - r[k]);
+					vn[k].Normalize();
 				}
-				glEnd();
+			}
 
-				pf+=3;
+			// add the face
+			for (int k=0; k<3; k++, nv++)
+			{
+				buf.SetPosition(nv, r[k]);
+				buf.SetNormal(nv, vn[k]);
 			}
+
+			pf+=3;
 		}
 	}
 }
@@ -367,6 +451,7 @@ void CGLIsoSurfacePlot::Update(int ntime, float dt, bool breset)
 	// copy nodal values into current value buffer
 	m_val = m_map.State(ntime);
 	if (m_bsmooth) m_grd = m_GMap.State(ntime);
+	m_valRevision++;
 
 	// update colormap range
 	vec2f r = m_rng[ntime];
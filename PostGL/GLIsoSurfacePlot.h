@@ -27,8 +27,11 @@ SOFTWARE.*/
 #pragma once
 #include "GLPlot.h"
 #include "GLWLib/GLWidget.h"
+#include "GLLib/GLVertexBuffer.h"
 #include "PostLib/DataMap.h"
 
+class FEElement_;
+
 namespace Post {
 
 class CGLIsoSurfacePlot : public CGLLegendPlot
@@ -44,6 +47,7 @@ public:
 
 public:
 	CGLIsoSurfacePlot(CGLModel* po);
+	~CGLIsoSurfacePlot();
 
 	int GetSlices();
 	void SetSlices(int nslices);
@@ -79,7 +83,16 @@ public:
 	bool UpdateData(bool bsave = true);
 
 protected:
-	void RenderSlice(float ref, GLColor col);
+	// build the triangles of the isosurface with value ref
+	void BuildSlice(float ref, GLVertexBuffer& buf);
+
+	// return the node table of an element, or null if the element should not be sliced
+	const int* SliceNodeTable(FEElement_& el);
+
+	// key that identifies the data the isosurfaces depend on
+	size_t SliceDataKey();
+
+	void ClearSlices();
 
 protected:
 	int		m_nslices;		// nr. of iso surface slices
@@ -104,5 +117,11 @@ protected:
 
 	int		m_lastTime;
 	float	m_lastdt;
+
+	// The triangles of each slice are cached and only rebuilt when 
+	// the data, the mesh, or the isosurface value changes.
+	vector<GLVertexBuffer*>	m_slice;		// triangles of each slice
+	vector<size_t>			m_sliceKey;		// key of the data in each slice buffer
+	unsigned int			m_valRevision;	// incremented when the nodal values change
 };
 }
@@ -69,6 +69,10 @@ CGLModel::CGLModel(FEPostModel* ps)
 	m_brenderInteriorNodes = true;
 
 	m_doZSorting = true;
+	m_useVertexBuffers = true;
+	m_renderRevision = 0;
+	m_posRevision = 0;
+	m_texRevision = 0;
 
 	m_brenderPlotObjects = true;
 
@@ -127,6 +131,7 @@ CGLModel::~CGLModel(void)
 	delete m_pdis;
 	delete m_pcol;
 	ClearInternalSurfaces();
+	ClearRenderBuffers();
 }
 
 //-----------------------------------------------------------------------------
@@ -134,17 +139,18 @@ void CGLModel::SetFEModel(FEPostModel* ps)
 {
 	ClearSelectionLists();
 	ClearInternalSurfaces();
+	ClearRenderBuffers();
 	m_ps = ps;
 	if (ps) BuildInternalSurfaces();
 }
 
 //-----------------------------------------------------------------------------
-void CGLModel::ShowShell2Solid(bool b) { m_render.m_bShell2Solid = b; }
+void CGLModel::ShowShell2Solid(bool b) { m_render.m_bShell2Solid = b; m_renderRevision++; }
 bool CGLModel::ShowShell2Solid() const { return m_render.m_bShell2Solid; }
 
 //-----------------------------------------------------------------------------
 int CGLModel::ShellReferenceSurface() const { return m_render.m_nshellref; }
-void CGLModel::ShellReferenceSurface(int n) { m_render.m_nshellref = n; }
+void CGLModel::ShellReferenceSurface(int n) { m_render.m_nshellref = n; m_renderRevision++; }
 
 //-----------------------------------------------------------------------------
 Post::FEPostMesh* CGLModel::GetActiveMesh()
@@ -172,11 +178,19 @@ void CGLModel::ResetAllStates()
 	FEPostModel* fem = GetFEModel();
 	if ((fem == 0) || (fem->GetStates() == 0)) return;
 
+	// the rendered data needs to be rebuilt as well
+	m_renderRevision++;
+
 	int N = fem->GetStates();
 	for (int i=0; i<N; ++i)
 	{
-		FEState* ps = fem->GetState(i);
-		ps->m_nField = -1;
+		// no need to read states that are not loaded yet
+		if (fem->IsStateLoaded(i))
+		{
+			FEState* ps = fem->GetState(i);
+			ps->m_nField = -1;
+			ps->ClearFieldCache();
+		}
 	}
 }
 
@@ -207,6 +221,11 @@ bool CGLModel::Update(bool breset)
 	FEPostModel& fem = *m_ps;
 	if (fem.GetStates() == 0) return true;
 
+	// The displacement map and colormap change the positions and texture coordinates
+	// of the mesh. Only these need to be updated in the vertex buffers.
+	if (m_pdis && m_pdis->IsActive()) m_posRevision++;
+	if (m_pcol && m_pcol->IsActive()) m_texRevision++;
+
 	// get the time inc value
 	int ntime = fem.CurrentTimeIndex();
 	float dt = fem.CurrentTime() - fem.GetTimeValue(ntime);
@@ -241,7 +260,11 @@ bool CGLModel::Update(bool breset)
 //-----------------------------------------------------------------------------
 void CGLModel::UpdateDisplacements(int nstate, bool breset)
 {
-	if (m_pdis && m_pdis->IsActive()) m_pdis->Update(nstate, 0.f, breset);
+	if (m_pdis && m_pdis->IsActive())
+	{
+		m_pdis->Update(nstate, 0.f, breset);
+		m_posRevision++;
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -286,6 +309,7 @@ void CGLModel::SetSmoothingAngle(double w)
 
 	FEMeshBase* pm = ps->GetFEMesh(0);
 	pm->AutoSmooth(m_stol);
+	m_renderRevision++;
 }
 
 //-----------------------------------------------------------------------------
@@ -346,6 +370,7 @@ void CGLModel::ResetMesh()
 
 	// reevaluate normals
 	mesh.UpdateNormals();
+	m_renderRevision++;
 }
 
 //-----------------------------------------------------------------------------
@@ -1198,6 +1223,19 @@ void CGLModel::RenderSolidDomain(CGLContext& rc, FEDomain& dom, bool btex, bool
 
 	if (btex) glEnable(GL_TEXTURE_1D);
 
+	// The vertex buffers need to be rebuilt when the model was updated or when the
+	// faces that are drawn have changed.
+	size_t key = 0;
+	if (m_useVertexBuffers && !zsort)
+	{
+		key = m_renderRevision;
+		hash_combine(key, (size_t) pm);
+		hash_combine(key, (size_t) ndivs);
+		hash_combine(key, (size_t) m_render.m_bShell2Solid);
+		int NF = dom.Faces();
+		for (int i = 0; i < NF; ++i) hash_combine(key, (size_t) dom.Face(i).m_ntag);
+	}
+
 	// render active faces
 	if (zsort)
 	{
@@ -1233,6 +1271,10 @@ void CGLModel::RenderSolidDomain(CGLContext& rc, FEDomain& dom, bool btex, bool
 		}
 		glEnd();
 	}
+	else if (m_useVertexBuffers)
+	{
+		RenderBufferedFaces(dom, 1, key);
+	}
 	else
 	{
 		glBegin(GL_TRIANGLES);
@@ -1287,6 +1329,10 @@ void CGLModel::RenderSolidDomain(CGLContext& rc, FEDomain& dom, bool btex, bool
 		}
 		glEnd();
 	}
+	else if (m_useVertexBuffers)
+	{
+		RenderBufferedFaces(dom, 2, key);
+	}
 	else
 	{
 		glBegin(GL_TRIANGLES);
@@ -1306,6 +1352,68 @@ void CGLModel::RenderSolidDomain(CGLContext& rc, FEDomain& dom, bool btex, bool
 	if (btex) glEnable(GL_TEXTURE_1D);
 }
 
+//-----------------------------------------------------------------------------
+// Render the faces of a domain with the given tag (see RenderSolidMaterial) from a vertex buffer.
+// The buffer is only rebuilt when the key differs from the key of the buffered data.
+void CGLModel::RenderBufferedFaces(FEDomain& dom, int ntag, size_t key)
+{
+	FEPostMesh* pm = GetActiveMesh();
+
+	int nbuf = 2 * dom.GetMatID() + (ntag - 1);
+	const unsigned int used = GLVertexBuffer::POSITION | GLVertexBuffer::NORMAL | GLVertexBuffer::TEXCOORD;
+	RenderBuffer& rb = GetRenderBuffer(m_faceBuffer, nbuf, GLVertexBuffer::TRIANGLES, used & ~GLVertexBuffer::POSITION);
+
+	unsigned int attr = 0;
+	if (CheckRenderBuffer(rb, key, used, attr))
+	{
+		rb.buf.Clear();
+		rb.items.clear();
+		rb.first.clear();
+		rb.extra.clear();
+		int NF = dom.Faces();
+		for (int i = 0; i < NF; ++i)
+		{
+			FEFace& face = dom.Face(i);
+			if (face.m_ntag == ntag)
+			{
+				int nv = rb.buf.Vertices();
+				if (m_render.AddFaceToBuffer(face, pm, rb.buf))
+				{
+					rb.items.push_back(i);
+					rb.first.push_back(nv);
+				}
+				else rb.extra.push_back(i);
+			}
+		}
+	}
+	else if (attr)
+	{
+		// only update the data that changed since the buffer was last rendered
+		int N = (int)rb.items.size();
+#pragma omp parallel for
+		for (int i = 0; i < N; ++i)
+		{
+			FEFace& face = dom.Face(rb.items[i]);
+			m_render.UpdateFaceInBuffer(face, pm, rb.buf, rb.first[i], attr);
+		}
+		rb.buf.Modified(attr);
+	}
+
+	rb.buf.Render();
+
+	// render the faces that could not be buffered
+	if (rb.extra.empty() == false)
+	{
+		glBegin(GL_TRIANGLES);
+		for (int i = 0; i < (int)rb.extra.size(); ++i)
+		{
+			FEFace& face = dom.Face(rb.extra[i]);
+			m_render.RenderFace(face, pm);
+		}
+		glEnd();
+	}
+}
+
 //-----------------------------------------------------------------------------
 void CGLModel::RenderSolidPart(FEPostModel* ps, CGLContext& rc, int mat)
 {
@@ -1719,7 +1827,71 @@ void CGLModel::RenderMeshLines(FEPostModel* ps, int nmat)
 	int ndivs = GetSubDivisions();
 
 	// now loop over all faces and see which face belongs to this material
-	if (nmat < pm->Domains())
+	if ((nmat < pm->Domains()) && m_useVertexBuffers)
+	{
+		FEDomain& dom = pm->Domain(nmat);
+
+		// the buffer needs to be rebuilt when the model was updated or the visibility changed
+		size_t key = m_renderRevision;
+		hash_combine(key, (size_t) pm);
+		hash_combine(key, (size_t) ndivs);
+		hash_combine(key, (size_t) m_render.m_bShell2Solid);
+		for (int i = 0; i < dom.Faces(); ++i)
+		{
+			FEFace& face = dom.Face(i);
+			FEElement_& el = pm->ElementRef(face.m_elem[0].eid);
+			hash_combine(key, (size_t) (face.IsVisible() && el.IsVisible()));
+		}
+
+		RenderBuffer& rb = GetRenderBuffer(m_meshLineBuffer, nmat, GLVertexBuffer::LINES, 0);
+
+		unsigned int attr = 0;
+		if (CheckRenderBuffer(rb, key, GLVertexBuffer::POSITION, attr))
+		{
+			rb.buf.Clear();
+			rb.items.clear();
+			rb.first.clear();
+			rb.extra.clear();
+			for (int i = 0; i < dom.Faces(); ++i)
+			{
+				FEFace& face = dom.Face(i);
+				FEElement_& el = pm->ElementRef(face.m_elem[0].eid);
+				if (face.IsVisible() && el.IsVisible())
+				{
+					int nv = rb.buf.Vertices();
+					if (m_render.AddFaceOutlineToBuffer(face, pm, rb.buf))
+					{
+						rb.items.push_back(i);
+						rb.first.push_back(nv);
+					}
+					else rb.extra.push_back(i);
+				}
+			}
+		}
+		else if (attr)
+		{
+			int N = (int)rb.items.size();
+#pragma omp parallel for
+			for (int i = 0; i < N; ++i)
+			{
+				FEFace& face = dom.Face(rb.items[i]);
+				m_render.UpdateFaceOutlineInBuffer(face, pm, rb.buf, rb.first[i]);
+			}
+			rb.buf.Modified(attr);
+		}
+
+		glPushAttrib(GL_ENABLE_BIT);
+		glDisable(GL_TEXTURE_1D);
+		rb.buf.Render();
+		glPopAttrib();
+
+		for (int i = 0; i < (int)rb.extra.size(); ++i)
+		{
+			FEFace& face = dom.Face(rb.extra[i]);
+			m_render.RenderFaceOutline(face, pm, ndivs);
+		}
+	}
+	else if (nmat < pm->Domains())
 	{
 		FEDomain& dom = pm->Domain(nmat);
 		for (int i=0; i<dom.Faces(); ++i)
@@ -1992,35 +2164,104 @@ void CGLModel::RenderEdges(FEPostModel* ps, CGLContext& rc)
 
 	// render unselected edges
 	glColor3ub(0, 0, 255);
-	glBegin(GL_LINES);
+	if (m_useVertexBuffers)
 	{
-		for (int i = 0; i<NE; ++i)
+		// the buffer needs to be rebuilt when the model was updated or the edges that are drawn changed
+		size_t key = m_renderRevision;
+		hash_combine(key, (size_t) &mesh);
+		for (int i = 0; i < NE; ++i)
 		{
 			FEEdge& edge = mesh.Edge(i);
-			if (edge.IsVisible() && (edge.IsSelected() == false))
+			hash_combine(key, (size_t) (edge.IsVisible() && (edge.IsSelected() == false)));
+		}
+
+		RenderBuffer& rb = GetRenderBuffer(m_edgeBuffer, 0, GLVertexBuffer::LINES, 0);
+
+		unsigned int attr = 0;
+		if (CheckRenderBuffer(rb, key, GLVertexBuffer::POSITION, attr))
+		{
+			rb.buf.Clear();
+			rb.items.clear();
+			rb.first.clear();
+			for (int i = 0; i < NE; ++i)
 			{
-				switch (edge.Type())
+				FEEdge& edge = mesh.Edge(i);
+				if (edge.IsVisible() && (edge.IsSelected() == false))
 				{
-				case FE_EDGE2:
-					r[0] = mesh.Node(edge.n[0]).r;
-					r[1] = mesh.Node(edge.n[1]).r;
-					glVertex3d(r[0].x, r[0].y, r[0].z);
-					glVertex3d(r[1].x, r[1].y, r[1].z);
-					break;
-				case FE_EDGE3:
-					r[0] = mesh.Node(edge.n[0]).r;
-					r[1] = mesh.Node(edge.n[1]).r;
-					r[2] = mesh.Node(edge.n[2]).r;
-					glVertex3d(r[0].x, r[0].y, r[0].z);
-					glVertex3d(r[1].x, r[1].y, r[1].z);
-					glVertex3d(r[1].x, r[1].y, r[1].z);
-					glVertex3d(r[2].x, r[2].y, r[2].z);
-					break;
+					int nv = rb.buf.Vertices();
+					switch (edge.Type())
+					{
+					case FE_EDGE2:
+						rb.buf.AddVertex(mesh.Node(edge.n[0]).r);
+						rb.buf.AddVertex(mesh.Node(edge.n[1]).r);
+						break;
+					case FE_EDGE3:
+						rb.buf.AddVertex(mesh.Node(edge.n[0]).r);
+						rb.buf.AddVertex(mesh.Node(edge.n[1]).r);
+						rb.buf.AddVertex(mesh.Node(edge.n[1]).r);
+						rb.buf.AddVertex(mesh.Node(edge.n[2]).r);
+						break;
+					}
+					if (rb.buf.Vertices() > nv)
+					{
+						rb.items.push_back(i);
+						rb.first.push_back(nv);
+					}
 				}
 			}
 		}
+		else if (attr)
+		{
+			int N = (int)rb.items.size();
+#pragma omp parallel for
+			for (int i = 0; i < N; ++i)
+			{
+				FEEdge& edge = mesh.Edge(rb.items[i]);
+				int nv = rb.first[i];
+				rb.buf.SetPosition(nv    , mesh.Node(edge.n[0]).r);
+				rb.buf.SetPosition(nv + 1, mesh.Node(edge.n[1]).r);
+				if (edge.Type() == FE_EDGE3)
+				{
+					rb.buf.SetPosition(nv + 2, mesh.Node(edge.n[1]).r);
+					rb.buf.SetPosition(nv + 3, mesh.Node(edge.n[2]).r);
+				}
+			}
+			rb.buf.Modified(attr);
+		}
+		rb.buf.Render();
+	}
+	else
+	{
+		glBegin(GL_LINES);
+		{
+			for (int i = 0; i<NE; ++i)
+			{
+				FEEdge& edge = mesh.Edge(i);
+				if (edge.IsVisible() && (edge.IsSelected() == false))
+				{
+					switch (edge.Type())
+					{
+					case FE_EDGE2:
+						r[0] = mesh.Node(edge.n[0]).r;
+						r[1] = mesh.Node(edge.n[1]).r;
+						glVertex3d(r[0].x, r[0].y, r[0].z);
+						glVertex3d(r[1].x, r[1].y, r[1].z);
+						break;
+					case FE_EDGE3:
+						r[0] = mesh.Node(edge.n[0]).r;
+						r[1] = mesh.Node(edge.n[1]).r;
+						r[2] = mesh.Node(edge.n[2]).r;
+						glVertex3d(r[0].x, r[0].y, r[0].z);
+						glVertex3d(r[1].x, r[1].y, r[1].z);
+						glVertex3d(r[1].x, r[1].y, r[1].z);
+						glVertex3d(r[2].x, r[2].y, r[2].z);
+						break;
+					}
+				}
+			}
+		}
+		glEnd();
 	}
-	glEnd();
 
 	// render selected edges
 	if (GetSelectionMode() == SELECT_EDGES)
@@ -3269,6 +3510,54 @@ void CGLModel::ClearInternalSurfaces()
 	m_innerSurface.clear();
 }
 
+//-----------------------------------------------------------------------------
+void CGLModel::ClearRenderBuffers()
+{
+	for (int i = 0; i < (int)m_faceBuffer.size(); ++i) delete m_faceBuffer[i];
+	m_faceBuffer.clear();
+	for (int i = 0; i < (int)m_meshLineBuffer.size(); ++i) delete m_meshLineBuffer[i];
+	m_meshLineBuffer.clear();
+	for (int i = 0; i < (int)m_edgeBuffer.size(); ++i) delete m_edgeBuffer[i];
+	m_edgeBuffer.clear();
+}
+
+//-----------------------------------------------------------------------------
+CGLModel::RenderBuffer& CGLModel::GetRenderBuffer(vector<RenderBuffer*>& list, int n, GLVertexBuffer::Primitive prim, unsigned int attr)
+{
+	while ((int)list.size() <= n) list.push_back(new RenderBuffer(prim, attr));
+	return *list[n];
+}
+
+//-----------------------------------------------------------------------------
+// Checks if a render buffer needs to be rebuilt (returns true) or, if not, which of the used 
+// attributes need to be updated (returned in attr) because the state data changed.
+bool CGLModel::CheckRenderBuffer(RenderBuffer& rb, size_t key, unsigned int used, unsigned int& attr)
+{
+	attr = 0;
+	if ((rb.posRev != m_posRevision) && (used & GLVertexBuffer::POSITION)) attr |= (used & (GLVertexBuffer::POSITION | GLVertexBuffer::NORMAL));
+	if ((rb.texRev != m_texRevision) && (used & GLVertexBuffer::TEXCOORD)) attr |= GLVertexBuffer::TEXCOORD;
+	rb.posRev = m_posRevision;
+	rb.texRev = m_texRevision;
+
+	// we can only update the data that the buffer still holds in memory
+	// (an empty buffer may have been released, so it is always rebuilt)
+	if ((rb.key != key) || (rb.buf.Vertices() == 0) || ((attr & rb.buf.GetDynamic()) != attr))
+	{
+		rb.key = key;
+
+		// only keep the data in memory that is expected to change
+		unsigned int dynamic = 0;
+		if (m_pdis && m_pdis->IsActive()) dynamic |= (GLVertexBuffer::POSITION | GLVertexBuffer::NORMAL);
+		if (m_pcol && m_pcol->IsActive()) dynamic |= GLVertexBuffer::TEXCOORD;
+		rb.buf.SetDynamic(dynamic & used);
+
+		attr = 0;
+		return true;
+	}
+
+	return false;
+}
+
 //-----------------------------------------------------------------------------
 void CGLModel::BuildInternalSurfaces()
 {
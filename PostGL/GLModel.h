@@ -33,6 +33,7 @@ SOFTWARE.*/
 #include "GLPlot.h"
 #include <FSCore/FSObjectList.h>
 #include <GLLib/GLMeshRender.h>
+#include <GLLib/GLVertexBuffer.h>
 #include <MeshLib/Intersect.h>
 #include <vector>
 
@@ -149,6 +150,12 @@ public:
 	//! Toggle element visibility
 	void ToggleVisibleElements();
 
+	//! revision of the (displaced) node positions. This changes each time the node positions are updated.
+	unsigned int PositionRevision() const { return m_posRevision; }
+
+	//! call this when the node positions were changed outside of Update (e.g. when the displacement map is turned off)
+	void PositionsChanged() { m_posRevision++; }
+
 public:
 	// return internal surfaces
 	int InternalSurfaces() { return (int) m_innerSurface.size(); }
@@ -212,6 +219,7 @@ protected:
 	void RenderSolidMaterial(CGLContext& rc, FEPostModel* ps, int m);
 	void RenderTransparentMaterial(CGLContext& rc, FEPostModel* ps, int m);
 	void RenderSolidDomain(CGLContext& rc, FEDomain& dom, bool btex, bool benable, bool zsort = false);
+	void RenderBufferedFaces(FEDomain& dom, int ntag, size_t key);
 
 	void RenderInnerSurface(int m, bool btex = true);
 	void RenderInnerSurfaceOutline(int m, int ndivs);
@@ -343,6 +351,27 @@ protected:
 	void UpdateInternalSurfaces(bool eval = true);
 	void ClearInternalSurfaces();
 	void UpdateEdge();
+	void ClearRenderBuffers();
+
+protected:
+	// A vertex buffer that is only rebuilt when the key of the data it renders changes. 
+	// When only the state data changes, the positions and texture coordinates are updated.
+	class RenderBuffer
+	{
+	public:
+		RenderBuffer(GLVertexBuffer::Primitive prim, unsigned int attr) : buf(prim, attr), key(0), posRev(0), texRev(0) {}
+
+		GLVertexBuffer	buf;
+		vector<int>		items;	// items in the buffer
+		vector<int>		first;	// first vertex of each item in the buffer
+		vector<int>		extra;	// items that could not be buffered (these are rendered directly)
+		size_t			key;	// identifies the data in the buffer
+		unsigned int	posRev;	// revision of the positions in the buffer
+		unsigned int	texRev;	// revision of the texture coordinates in the buffer
+	};
+
+	RenderBuffer& GetRenderBuffer(vector<RenderBuffer*>& list, int n, GLVertexBuffer::Primitive prim, unsigned int attr);
+	bool CheckRenderBuffer(RenderBuffer& rb, size_t key, unsigned int used, unsigned int& attr);
 
 public:
 	bool		m_bnorm;		//!< calculate normals or not
@@ -361,6 +390,7 @@ public:
 
 	bool		m_bshowMesh;
 	bool		m_doZSorting;
+	bool		m_useVertexBuffers;	//!< render the surface, mesh lines and edges with vertex buffers
 
 	unsigned int	m_layer;
 
@@ -374,6 +404,14 @@ protected:
 
 	GLMeshRender	m_render;
 
+	// vertex buffers (see m_useVertexBuffers)
+	vector<RenderBuffer*>	m_faceBuffer;		// active and inactive faces of each domain
+	vector<RenderBuffer*>	m_meshLineBuffer;	// mesh lines of each domain
+	vector<RenderBuffer*>	m_edgeBuffer;		// unselected edges
+	unsigned int			m_renderRevision;	// incremented when the buffers need to be rebuilt
+	unsigned int			m_posRevision;		// incremented when the (displaced) node positions change
+	unsigned int			m_texRevision;		// incremented when the texture coordinates change
+
 	// selected items
 	vector<FENode*>		m_nodeSelection;
 	vector<FEEdge*>		m_edgeSelection;
@@ -345,9 +345,8 @@ void CGLParticleFlowPlot::UpdateParticleColors()
 	}
 }
 
-vec3f CGLParticleFlowPlot::Velocity(const vec3f& r, int ntime, float w, bool& ok)
+vec3f CGLParticleFlowPlot::Velocity(int nelem, const double* q, int ntime, float w)
 {
-	vec3f v(0.f, 0.f, 0.f);
 	vec3f ve0[FEElement::MAX_NODES];
 	vec3f ve1[FEElement::MAX_NODES];
 	FEPostMesh& mesh = *GetModel()->GetActiveMesh();
@@ -355,28 +354,19 @@ vec3f CGLParticleFlowPlot::Velocity(const vec3f& r, int ntime, float w, bool& ok
 	vector<vec3f>& val0 = m_map.State(ntime    );
 	vector<vec3f>& val1 = m_map.State(ntime + 1);
 
-	int nelem;
-	double q[3];
-	if (m_find.FindElement(r, nelem, q))
-	{
-		ok = true;
-		FEElement_& el = mesh.ElementRef(nelem);
-
-		int ne = el.Nodes();
-		for (int i = 0; i<ne; ++i)
-		{
-			ve0[i] = val0[el.m_node[i]];
-			ve1[i] = val1[el.m_node[i]];
-		}
-
-		vec3f v0 = el.eval(ve0, q[0], q[1], q[2]);
-		vec3f v1 = el.eval(ve1, q[0], q[1], q[2]);
+	FEElement_& el = mesh.ElementRef(nelem);
 
-		v = v0*(1.f - w) + v1*w;
+	int ne = el.Nodes();
+	for (int i = 0; i<ne; ++i)
+	{
+		ve0[i] = val0[el.m_node[i]];
+		ve1[i] = val1[el.m_node[i]];
 	}
-	else ok = false;
 
-	return v;
+	vec3f v0 = el.eval(ve0, q[0], q[1], q[2]);
+	vec3f v1 = el.eval(ve1, q[0], q[1], q[2]);
+
+	return v0*(1.f - w) + v1*w;
 }
 
 void CGLParticleFlowPlot::AdvanceParticles(int n0, int n1)
@@ -394,13 +384,23 @@ void CGLParticleFlowPlot::AdvanceParticles(int n0, int n1)
 	float dt = m_dt;
 	if (dt <= 0.f) return;
 
+	// The element of each particle is kept, since it is a good guess for where
+	// the particle will be after the next step.
+	int NP = (int)m_particles.size();
+	vector<int> elem(NP, -1);
+
+	// the particles that are still alive
+	vector<int> live;
+	vector<vec3f> x;
+	vector<int> xel;
+	vector<double> q;
+
 	for (int ntime=n0; ntime<n1; ++ntime)
 	{
 		float t0 = fem.GetState(ntime    )->m_time;
 		float t1 = fem.GetState(ntime + 1)->m_time;
 		if (t1 < t0) t1 = t0;
 
-		int NP = (int)m_particles.size();
 #pragma omp parallel for shared (NP)
 		for (int i = 0; i<NP; ++i)
 		{
@@ -416,30 +416,45 @@ void CGLParticleFlowPlot::AdvanceParticles(int n0, int n1)
 			if (t > t1) t = t1;
 			float w = (t - t0) / (t1 - t0);
 
-			int NP = (int) m_particles.size();
-#pragma omp parallel for shared (NP)
+			// advance the particles that are still alive
+			live.clear();
+			x.clear();
+			xel.clear();
 			for (int i=0; i<NP; ++i)
 			{
 				FlowParticle& p = m_particles[i];
-
 				if (p.m_ndeath > ntime)
 				{
 					vec3f r0 = p.m_pos[ntime + 1];
 					vec3f v0 = p.m_vel[ntime + 1];
 
-					vec3f r1 = r0 + v0*dt;
+					live.push_back(i);
+					x.push_back(r0 + v0*dt);
+					xel.push_back(elem[i]);
+				}
+			}
 
-					bool ok = true;
-					vec3f v1 = Velocity(r1, ntime, w, ok);
-					if (ok == false)
-					{
-						p.m_ndeath = ntime + 1;
-					}
-					else
-					{
-						p.m_pos[ntime + 1] = r1;
-						p.m_vel[ntime + 1] = v1;
-					}
+			int nlive = (int)live.size();
+			if (nlive == 0) continue;
+
+			// find all the new positions at once
+			q.resize(3 * nlive);
+			m_find.FindElements(nlive, &x[0], &xel[0], &q[0]);
+
+#pragma omp parallel for shared (nlive)
+			for (int n=0; n<nlive; ++n)
+			{
+				FlowParticle& p = m_particles[live[n]];
+				elem[live[n]] = xel[n];
+
+				if (xel[n] < 0)
+				{
+					p.m_ndeath = ntime + 1;
+				}
+				else
+				{
+					p.m_pos[ntime + 1] = x[n];
+					p.m_vel[ntime + 1] = Velocity(xel[n], &q[3*n], ntime, w);
 				}
 			}
 		}
@@ -107,7 +107,8 @@ protected:
 
 	void AdvanceParticles(int t0, int t1);
 
-	vec3f Velocity(const vec3f& r, int ntime, float dt, bool& ok);
+	// velocity at iso-coordinates q of element nelem, interpolated between two states
+	vec3f Velocity(int nelem, const double* q, int ntime, float w);
 
 	void UpdateParticleState(int ntime);
 
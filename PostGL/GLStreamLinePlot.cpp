@@ -255,25 +255,12 @@ void CGLStreamLinePlot::Update(int ntime, float dt, bool breset)
 	UpdateStreamLines();
 }
 
-vec3f CGLStreamLinePlot::Velocity(const vec3f& r, bool& ok)
+vec3f CGLStreamLinePlot::Velocity(const vec3f& r, int& nelem, bool& ok)
 {
+	// the previous element along the stream line usually still contains the point,
+	// so this rarely needs to search the whole mesh
 	vec3f v(0.f, 0.f, 0.f);
-	vec3f ve[FEElement::MAX_NODES];
-	FEPostMesh& mesh = *GetModel()->GetActiveMesh();
-	int nelem;
-	double q[3];
-	if (m_find.FindElement(r, nelem, q))
-	{
-		ok = true;
-		FEElement_& el = mesh.ElementRef(nelem);
-
-		int ne = el.Nodes();
-		for (int i=0; i<ne; ++i) ve[i] = m_val[el.m_node[i]];
-
-		v = el.eval(ve, q[0], q[1], q[2]);
-	}
-	else ok = false;
-
+	ok = (m_find.Interpolate(1, &r, &nelem, &m_val[0], &v) == 1);
 	return v;
 }
 
@@ -374,9 +361,9 @@ void CGLStreamLinePlot::UpdateStreamLines()
 				do
 				{
 					vec3f a = vc*dt;
-					vec3f b = Velocity(cf + a*0.5f, ok)*dt; if (ok == false) break;
-					vec3f c = Velocity(cf + b*0.5f, ok)*dt; if (ok == false) break;
-					vec3f d = Velocity(cf + c     , ok)*dt; if (ok == false) break;
+					vec3f b = Velocity(cf + a*0.5f, nelem, ok)*dt; if (ok == false) break;
+					vec3f c = Velocity(cf + b*0.5f, nelem, ok)*dt; if (ok == false) break;
+					vec3f d = Velocity(cf + c     , nelem, ok)*dt; if (ok == false) break;
 
 					dr = (a + b*2.f + c*2.f + d) / 6.0;
 					float DR = dr.Length();
@@ -394,7 +381,7 @@ void CGLStreamLinePlot::UpdateStreamLines()
 				if (l.Points() > MAX_POINTS) break;
 
 				// get velocity at new point
-				vc = Velocity(cf, ok);
+				vc = Velocity(cf, nelem, ok);
 				if (ok == false) break;
 			}
 			while (1);
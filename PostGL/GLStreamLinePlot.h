@@ -111,7 +111,8 @@ public:
 
 protected:
 
-	vec3f Velocity(const vec3f& r, bool& ok);
+	// nelem is the element of a nearby point on input (or -1) and the element of r on output
+	vec3f Velocity(const vec3f& r, int& nelem, bool& ok);
 
 private:
 	int	m_nvec;	// vector field
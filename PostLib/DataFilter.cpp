@@ -34,6 +34,9 @@ using namespace Post;
 
 bool Post::DataScale(FEPostModel& fem, int nfield, double scale)
 {
+	// the modified data must stay in memory
+	fem.LockStateCache();
+
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 	float fscale = (float) scale;
 	// loop over all states
@@ -393,6 +396,9 @@ bool Post::DataScale(FEPostModel& fem, int nfield, double scale)
 //-----------------------------------------------------------------------------
 bool Post::DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale)
 {
+	// the modified data must stay in memory
+	fem.LockStateCache();
+
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 
 	vec3f fscale = to_vec3f(scale);
@@ -696,6 +702,9 @@ bool DataSmoothStep(FEPostModel& fem, int nfield, double theta)
 // Apply a smoothing operation on data
 bool Post::DataSmooth(FEPostModel& fem, int nfield, double theta, int niters)
 {
+	// the modified data must stay in memory
+	fem.LockStateCache();
+
 	for (int n = 0; n<niters; ++n) 
 	{
 		if (DataSmoothStep(fem, nfield, theta) == false) return false;
@@ -715,6 +724,9 @@ double flt_err(double d, double s) { return fabs(d - s); }
 //-----------------------------------------------------------------------------
 bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
 {
+	// the modified data must stay in memory
+	fem.LockStateCache();
+
 	int ndst = FIELD_CODE(nfield);
 	int nsrc = FIELD_CODE(noperand);
 
@@ -912,6 +924,9 @@ bool Post::DataArithmetic(FEPostModel& fem, int nfield, int nop, int noperand)
 //-----------------------------------------------------------------------------
 bool Post::DataGradient(FEPostModel& fem, int vecField, int sclField)
 {
+	// the modified data must stay in memory
+	fem.LockStateCache();
+
 	int nvec = FIELD_CODE(vecField);
 	int nscl = FIELD_CODE(sclField);
 
@@ -1250,6 +1265,9 @@ FEDataField* Post::DataComponent(FEPostModel& fem, FEDataField* pdf, int ncomp,
 
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 
+	// the new field's data only exists in memory
+	fem.LockStateCache();
+
 	FEDataField* newField = 0;
 	if (nclass == CLASS_NODE)
 	{
@@ -1308,6 +1326,9 @@ FEDataField* Post::DataComponent(FEPostModel& fem, FEDataField* pdf, int ncomp,
 // Calculate the fractional anisotropy of a tensor field
 bool Post::DataFractionalAnsisotropy(FEPostModel& fem, int scalarField, int tensorField)
 {
+	// the modified data must stay in memory
+	fem.LockStateCache();
+
 	int ntns = FIELD_CODE(tensorField);
 	int nscl = FIELD_CODE(scalarField);
 
@@ -1369,6 +1390,9 @@ FEDataField* Post::DataConvert(FEPostModel& fem, FEDataField* dataField, int new
 
 	if (newFormat == nfmt) return nullptr;
 
+	// the new field's data only exists in memory
+	fem.LockStateCache();
+
 	Post::FEPostMesh& mesh = *fem.GetFEMesh(0);
 
 	FEDataField* newField = nullptr;
@@ -1490,6 +1514,9 @@ FEDataField* Post::DataEigenTensor(FEPostModel& fem, FEDataField* dataField, con
 	if (nclass != CLASS_ELEM) return nullptr;
 	if (nfmt != DATA_ITEM) return nullptr;
 
+	// the new field's data only exists in memory
+	fem.LockStateCache();
+
 	FEDataField* newField = new FEDataField_T<FEElementData<mat3f, DATA_ITEM> >(name);
 	fem.AddDataField(newField);
 
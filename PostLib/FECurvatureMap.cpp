@@ -100,6 +100,8 @@ void FECongruencyMap::Apply(FEPostModel& fem)
 	m_pfem = &fem;
 
 	// add a new field 
+	// (its data only exists in memory)
+	fem.LockStateCache();
 	fem.AddDataField(new FEDataField_T<FEFaceData<float, DATA_NODE> >("congruency"));
 	int NDATA = fem.GetDataManager()->DataFields()-1;
 
@@ -853,6 +853,9 @@ bool Post::AddNodeDataFromFile(CGLModel& glm, const char* szfile, const char* sz
 	FEPostModel* pm = glm.GetFEModel();
 	FEPostMesh& m = *glm.GetActiveMesh();
 
+	// the new field's data only exists in memory
+	pm->LockStateCache();
+
 	// create a new data field
 	int ND = 0;
 	switch (ntype)
@@ -973,6 +976,9 @@ bool Post::AddFaceDataFromFile(CGLModel& glm, const char* szfile, const char* sz
 	FEPostModel* pm = glm.GetFEModel();
 	FEPostMesh& m = *glm.GetActiveMesh();
 
+	// the new field's data only exists in memory
+	pm->LockStateCache();
+
 	// create a new data field
 	int ND = 0;
 	switch (ntype)
@@ -1093,6 +1099,9 @@ bool Post::AddElemDataFromFile(CGLModel& glm, const char* szfile, const char* sz
 	FEPostModel* pm = glm.GetFEModel();
 	FEPostMesh& m = *glm.GetActiveMesh();
 
+	// the new field's data only exists in memory
+	pm->LockStateCache();
+
 	// create a new data field
 	int ND = 0;
 	switch (ntype)
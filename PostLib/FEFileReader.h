@@ -46,6 +46,20 @@ typedef off_t off_type;
 namespace Post {
 
 class FEPostModel;
+class FEState;
+
+//-----------------------------------------------------------------------------
+// Base class for readers that can read the data of a state when it is needed, 
+// instead of when the file is loaded. The model takes ownership of the loader.
+class FEStateLoader
+{
+public:
+	FEStateLoader() {}
+	virtual ~FEStateLoader() {}
+
+	// Read the data of the state. The state's data is allocated by the model.
+	virtual bool LoadState(FEPostModel& fem, FEState& state) = 0;
+};
 
 //-----------------------------------------------------------------------------
 class FEFileReader : public FileReader
@@ -30,6 +30,53 @@ SOFTWARE.*/
 
 using namespace Post;
 
+//-----------------------------------------------------------------------------
+bool Post::CompileMathEquation(const std::string& eq, CMathProgram& prg)
+{
+	static const std::vector<std::string> vars = { "x", "y", "z", "t" };
+	CMathParser math;
+	return math.compile(eq.c_str(), vars, prg);
+}
+
+//-----------------------------------------------------------------------------
+// The variables of the math equations for all the nodes of a state
+class FEMathVariables
+{
+public:
+	FEMathVariables(FEPostModel& fem, FEState& state)
+	{
+		int ntime = state.GetID();
+		m_nodes = state.GetFEMesh()->Nodes();
+		for (int i = 0; i < 4; ++i) m_x[i].resize(m_nodes);
+
+		#pragma omp parallel for
+		for (int n = 0; n < m_nodes; ++n)
+		{
+			vec3f r = fem.NodePosition(n, ntime);
+			m_x[0][n] = (double)r.x;
+			m_x[1][n] = (double)r.y;
+			m_x[2][n] = (double)r.z;
+			m_x[3][n] = (double)state.m_time;
+		}
+
+		for (int i = 0; i < 4; ++i) m_px[i] = m_x[i].data();
+	}
+
+	int Nodes() const { return m_nodes; }
+
+	// evaluate a program for all the nodes
+	void eval(const CMathProgram& prg, std::vector<double>& val) const
+	{
+		val.resize(m_nodes);
+		if (m_nodes > 0) prg.eval(m_nodes, m_px, val.data());
+	}
+
+private:
+	int					m_nodes;
+	std::vector<double>	m_x[4];
+	const double*		m_px[4];
+};
+
 FEMathData::FEMathData(FEState* state, FEMathDataField* pdf) : FENodeData_T<float>(state, pdf)
 {
 	m_pdf = pdf;
@@ -40,27 +87,27 @@ void FEMathData::eval(int n, float* pv)
 {
 	FEPostModel& fem = *GetFEModel();
 
-
-	double time = m_state->m_time;
-
-	FEPostMesh& mesh = *m_state->GetFEMesh();
-
-	CMathParser math;
-	math.set_variable("t", time);
+	// the equation is compiled by the data field, so we only need to set the variables
+	vec3f r = fem.NodePosition(n, m_state->GetID());
+	double x[4] = { (double)r.x, (double)r.y, (double)r.z, (double)m_state->m_time };
 
 	int ierr;
-	FENode& node = mesh.Node(n);
+	double v = m_pdf->Program().eval(x, ierr);
 
-	vec3f r = fem.NodePosition(n, m_state->GetID());
-	math.set_variable("x", (double)r.x);
-	math.set_variable("y", (double)r.y);
-	math.set_variable("z", (double)r.z);
+	if (pv) *pv = (float) v;
+}
 
-	const std::string& eq = m_pdf->EquationString();
+// evaluate the data of all nodes
+bool FEMathData::eval_all(std::vector<float>& val)
+{
+	FEMathVariables x(*GetFEModel(), *m_state);
 
-	double v = math.eval(eq.c_str(), ierr);
+	std::vector<double> v;
+	x.eval(m_pdf->Program(), v);
+	val.resize(x.Nodes());
+	for (int n = 0; n < x.Nodes(); ++n) val[n] = (float) v[n];
 
-	if (pv) *pv = (float) v;
+	return true;
 }
 
 
@@ -76,31 +123,30 @@ void FEMathVec3Data::eval(int n, vec3f* pv)
 
 	FEState& state = *m_state;
 	int ntime = state.GetID();
-	double time = (double)state.m_time;
 
-	FEPostMesh& mesh = *state.GetFEMesh();
-
-	CMathParser math;
-	math.set_variable("t", time);
+	vec3f r = fem.NodePosition(n, ntime);
+	double x[4] = { (double)r.x, (double)r.y, (double)r.z, (double)state.m_time };
 
 	int ierr;
-	FENode& node = mesh.Node(n);
+	vec3f v;
+	v.x = (float)m_pdf->Program(0).eval(x, ierr);
+	v.y = (float)m_pdf->Program(1).eval(x, ierr);
+	v.z = (float)m_pdf->Program(2).eval(x, ierr);
 
-	vec3f r = fem.NodePosition(n, ntime);
-	math.set_variable("x", (double)r.x);
-	math.set_variable("y", (double)r.y);
-	math.set_variable("z", (double)r.z);
+	if (pv) *pv = v;
+}
 
-	const std::string& x = m_pdf->EquationString(0);
-	const std::string& y = m_pdf->EquationString(1);
-	const std::string& z = m_pdf->EquationString(2);
+// evaluate the data of all nodes
+bool FEMathVec3Data::eval_all(std::vector<vec3f>& val)
+{
+	FEMathVariables x(*GetFEModel(), *m_state);
 
-	vec3f v;
-	v.x = (float)math.eval(x.c_str(), ierr);
-	v.y = (float)math.eval(y.c_str(), ierr);
-	v.z = (float)math.eval(z.c_str(), ierr);
+	std::vector<double> v[3];
+	for (int i = 0; i < 3; ++i) x.eval(m_pdf->Program(i), v[i]);
+	val.resize(x.Nodes());
+	for (int n = 0; n < x.Nodes(); ++n) val[n] = vec3f((float)v[0][n], (float)v[1][n], (float)v[2][n]);
 
-	if (pv) *pv = v;
+	return true;
 }
 
 FEMathMat3Data::FEMathMat3Data(FEState* state, FEMathMat3DataField* pdf) : FENodeData_T<mat3f>(state, pdf)
@@ -117,27 +163,34 @@ void FEMathMat3Data::eval(int n, mat3f* pv)
 
 	FEState& state = *m_state;
 	int ntime = state.GetID();
-	double time = (double)state.m_time;
-
-	FEPostMesh& mesh = *state.GetFEMesh();
-
-	CMathParser math;
-	math.set_variable("t", time);
-
-	int ierr;
-	FENode& node = mesh.Node(n);
 
 	vec3f r = fem.NodePosition(n, ntime);
-	math.set_variable("x", (double)r.x);
-	math.set_variable("y", (double)r.y);
-	math.set_variable("z", (double)r.z);
+	double x[4] = { (double)r.x, (double)r.y, (double)r.z, (double)state.m_time };
 
+	int ierr;
 	float m[9] = { 0.f };
 	for (int i = 0; i < 9; ++i)
 	{
-		const std::string& eq = m_pdf->EquationString(i);
-		m[i] = (float) math.eval(eq.c_str(), ierr);
+		m[i] = (float) m_pdf->Program(i).eval(x, ierr);
 	}
 
 	*pv = mat3f(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8]);
 }
+
+// evaluate the data of all nodes
+bool FEMathMat3Data::eval_all(std::vector<mat3f>& val)
+{
+	FEMathVariables x(*GetFEModel(), *m_state);
+
+	std::vector<double> v[9];
+	for (int i = 0; i < 9; ++i) x.eval(m_pdf->Program(i), v[i]);
+	val.resize(x.Nodes());
+	for (int n = 0; n < x.Nodes(); ++n)
+	{
+		float m[9];
+		for (int i = 0; i < 9; ++i) m[i] = (float) v[i][n];
+		val[n] = mat3f(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8]);
+	}
+
+	return true;
+}
@@ -1190,29 +1190,16 @@ void FECurvature::level(int n, int l, set<int>& nl1)
 
 	// loop over all levels
 	vector<int> nl2; nl2.reserve(64);
+	set<int> visited;
 	for (int k=0; k<=l; ++k)
 	{
-		// reset face marks
-		set<int>::iterator it;
-		for (it = nl1.begin(); it != nl1.end(); ++it)
-		{
-			// get the node-face list
-			const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(*it);
-			int NF = nfl.size();
-
-			// add the other nodes
-			for (int i=0; i<NF; ++i)
-			{
-				if (m_face[nfl[i].fid] == 1)
-				{
-					FEFace& f = pmesh->Face(nfl[i].fid); 
-					f.m_ntag = 0;
-				}
-			}
-		}
+		// faces visited at this level (kept local so that this can be called
+		// concurrently, which would not be safe with the shared face tags)
+		visited.clear();
 
 		// loop over all nodes
 		nl2.clear();
+		set<int>::iterator it;
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
@@ -1225,11 +1212,10 @@ void FECurvature::level(int n, int l, set<int>& nl1)
 				FEFace& f = pmesh->Face(nfl[i].fid);
 				if (m_face[nfl[i].fid] == 1)
 				{
-					if (f.m_ntag == 0)
+					if (visited.insert(nfl[i].fid).second)
 					{
 						int ne = f.Nodes();
 						for (int j=0; j<ne; ++j) if (f.n[j] != *it) nl2.push_back(f.n[j]);
-						f.m_ntag = 1;
 					}
 				}
 			}
@@ -1524,29 +1510,16 @@ void FEPrincCurvatureVector::level(int n, int l, set<int>& nl1)
 
 	// loop over all levels
 	vector<int> nl2; nl2.reserve(64);
+	set<int> visited;
 	for (int k=0; k<=l; ++k)
 	{
-		// reset face marks
-		set<int>::iterator it;
-		for (it = nl1.begin(); it != nl1.end(); ++it)
-		{
-			// get the node-face list
-			const vector<NodeFaceRef>& nfl = pmesh->NodeFaceList(*it);
-			int NF = nfl.size();
-
-			// add the other nodes
-			for (int i=0; i<NF; ++i)
-			{
-				if (m_face[nfl[i].fid] == 1)
-				{
-					FEFace& f = pmesh->Face(nfl[i].fid); 
-					f.m_ntag = 0;
-				}
-			}
-		}
+		// faces visited at this level (kept local so that this can be called
+		// concurrently, which would not be safe with the shared face tags)
+		visited.clear();
 
 		// loop over all nodes
 		nl2.clear();
+		set<int>::iterator it;
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
@@ -1559,11 +1532,10 @@ void FEPrincCurvatureVector::level(int n, int l, set<int>& nl1)
 				FEFace& f = pmesh->Face(nfl[i].fid);
 				if (m_face[nfl[i].fid] == 1)
 				{
-					if (f.m_ntag == 0)
+					if (visited.insert(nfl[i].fid).second)
 					{
 						int ne = f.Nodes();
 						for (int j=0; j<ne; ++j) if (f.n[j] != *it) nl2.push_back(f.n[j]);
-						f.m_ntag = 1;
 					}
 				}
 			}
@@ -58,6 +58,10 @@ public:
 	virtual void eval(int n, T* pv) = 0;
 	virtual bool active(int n) { return true; }
 
+	// Evaluate the values of all the nodes at once. Data that can do this faster
+	// than node by node overrides this. Returns false if it is not supported.
+	virtual bool eval_all(vector<T>& val) { return false; }
+
 	static Data_Type Type  () { return FEMeshDataTraits<T>::Type  (); }
 	static Data_Format Format() { return DATA_ITEM; }
 	static Data_Class Class() { return CLASS_NODE; }
@@ -75,6 +79,7 @@ public:
 
 	int size() const { return (int) m_data.size(); }
 	T& operator [] (int n) { return m_data[n]; }
+	T* data() { return m_data.data(); }
 
 protected:
 	vector<T>	m_data;
@@ -466,6 +471,16 @@ public:
 		else assert(m == (int)m_data.size());
 		m_data.push_back(v);
 	}
+	// Add the values of several items at once. This returns a pointer to the new 
+	// (uninitialized) values, so that they can be read directly into the data.
+	T* append(const vector<int>& item)
+	{
+		int m = (int) m_data.size();
+		int n = (int) item.size();
+		for (int i=0; i<n; ++i) { assert(m_elem[item[i]] == -1); m_elem[item[i]] = m + i; }
+		m_data.resize(m + n);
+		return m_data.data() + m;
+	}
 	int size() { return (int) m_data.size(); }
 	T& operator [] (int i) { return m_data[i]; }
 
@@ -489,26 +489,16 @@ void FEPointCongruency::level(int n, int l, set<int>& nl1)
 
 	// loop over all levels
 	vector<int> nl2; nl2.reserve(64);
+	set<int> visited;
 	for (int k=0; k<=l; ++k)
 	{
-		// reset face marks
-		set<int>::iterator it;
-		for (it = nl1.begin(); it != nl1.end(); ++it)
-		{
-			// get the node-face list
-			const vector<NodeFaceRef>& nfl = m_NFL.FaceList(*it);
-			int NF = nfl.size();
-
-			// add the other nodes
-			for (int i=0; i<NF; ++i)
-			{
-				FEFace& f = pmesh->Face(nfl[i].fid); 
-				f.m_ntag = 0;
-			}
-		}
+		// faces visited at this level (kept local so that this can be called
+		// concurrently, which would not be safe with the shared face tags)
+		visited.clear();
 
 		// loop over all nodes
 		nl2.clear();
+		set<int>::iterator it;
 		for (it = nl1.begin(); it != nl1.end(); ++it)
 		{
 			// get the node-face list
@@ -519,11 +509,10 @@ void FEPointCongruency::level(int n, int l, set<int>& nl1)
 			for (int i=0; i<NF; ++i)
 			{
 				FEFace& f = pmesh->Face(nfl[i].fid);
-				if (f.m_ntag == 0)
+				if (visited.insert(nfl[i].fid).second)
 				{
 					int ne = f.Nodes();
 					for (int j=0; j<ne; ++j) if (f.n[j] != *it) nl2.push_back(f.n[j]);
-					f.m_ntag = 1;
 				}
 			}
 		}
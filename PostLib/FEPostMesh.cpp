@@ -72,6 +72,7 @@ void Post::FEPostMesh::ClearAll()
 	m_Edge.clear();
 	m_Face.clear();
 	m_Elem.clear();
+	CompactElements();
 }
 
 //-----------------------------------------------------------------------------
@@ -122,7 +123,7 @@ void Post::FEPostMesh::Create(int nodes, int elems, int faces, int edges)
 
 	if (elems)
 	{
-		m_Elem.resize(elems);
+		ResizeElems(elems);
 
 		// set default element ID's
 		for (int i=0; i<elems; i++) 
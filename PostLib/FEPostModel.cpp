@@ -33,13 +33,19 @@ SOFTWARE.*/
 #include "FEDataManager.h"
 #include "constants.h"
 #include "FEMeshData_T.h"
+#include "FEFileReader.h"
 #include <stdio.h>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 extern int ET_HEX[12][2];
 
 namespace Post {
 
 FEPostModel* FEPostModel::m_pThis = 0;
+int FEPostModel::m_evalThreads = 0;
 
 FEPostModel::PlotObject::PlotObject() 
 { 
@@ -69,6 +75,14 @@ FEPostModel::FEPostModel()
 	m_nTime = 0;
 	m_fTime = 0.f;
 
+	m_loader = nullptr;
+
+	m_cacheSize = 0;
+	m_bcacheLocked = false;
+	m_cacheClock = 0;
+	m_cacheHits = 0;
+	m_cacheMisses = 0;
+
 	m_pThis = this;
 }
 
@@ -105,10 +119,22 @@ FEPostModel* FEPostModel::GetInstance()
 	return m_pThis;
 }
 
+//-----------------------------------------------------------------------------
+void FEPostModel::SetEvalThreads(int n)
+{
+	m_evalThreads = (n < 0 ? 0 : n);
+}
+
+//-----------------------------------------------------------------------------
+int FEPostModel::GetEvalThreads()
+{
+	return m_evalThreads;
+}
+
 //-----------------------------------------------------------------------------
 FEState* FEPostModel::CurrentState()
 {
-	return m_State[m_nTime];
+	return GetState(m_nTime);
 }
 
 //-----------------------------------------------------------------------------
@@ -116,6 +142,172 @@ void FEPostModel::SetCurrentTimeIndex(int ntime)
 {
 	m_nTime = ntime;
 	m_fTime = GetTimeValue(m_nTime);
+
+	// make sure the state's data is read
+	GetState(m_nTime);
+}
+
+//-----------------------------------------------------------------------------
+FEState* FEPostModel::GetState(int nstate)
+{
+	FEState* ps = m_State[nstate];
+
+	// all states are in memory when they are not read on demand
+	// (unless reading the file failed, in which case we allocate empty data)
+	if (m_loader == nullptr)
+	{
+		if (ps->HasData() == false)
+		{
+			#pragma omp critical (FEPostModel_GetState)
+			if (ps->HasData() == false) ps->AllocateData();
+		}
+		return ps;
+	}
+
+	// Pinned states are never released, so we don't need to lock the cache when
+	// they are requested. This is the common case when a field is evaluated, which
+	// pins the state and then requests it for each item (from multiple threads).
+	// These requests are not counted as cache hits, since the state was already
+	// requested when it was pinned.
+	if (ps->m_pinCount > 0) return ps;
+
+	// states can be requested from multiple threads
+	#pragma omp critical (FEPostModel_GetState)
+	RequestState(ps);
+
+	return ps;
+}
+
+//-----------------------------------------------------------------------------
+void FEPostModel::RequestState(FEState* ps)
+{
+	if (ps->HasData())
+	{
+		m_cacheHits++;
+		ps->m_lastUsed = ++m_cacheClock;
+		return;
+	}
+
+	// The data is only marked as available after it was read, so that
+	// other threads never see a partially read state.
+	m_cacheMisses++;
+	ps->AllocateBuffers();
+	if (m_loader->LoadState(*this, *ps) == false)
+	{
+		// Discard what was read. The (empty) buffers are kept so that the
+		// state can still be used, and the read is tried again next time.
+		assert(false);
+		ps->ReleaseData();
+		ps->AllocateBuffers();
+		return;
+	}
+	ps->SetDataLoaded();
+	ps->m_lastUsed = ++m_cacheClock;
+
+	// make room for the state we just read
+	UpdateStateCache();
+}
+
+//-----------------------------------------------------------------------------
+FEState* FEPostModel::PinState(int nstate)
+{
+	FEState* ps = m_State[nstate];
+	#pragma omp critical (FEPostModel_GetState)
+	{
+		if (m_loader) RequestState(ps);
+		else if (ps->HasData() == false) ps->AllocateData();
+		ps->m_pinCount++;
+	}
+	return ps;
+}
+
+//-----------------------------------------------------------------------------
+void FEPostModel::UnpinState(int nstate)
+{
+	FEState* ps = m_State[nstate];
+	#pragma omp critical (FEPostModel_GetState)
+	{
+		assert(ps->m_pinCount > 0);
+		if (ps->m_pinCount > 0) ps->m_pinCount--;
+
+		// states that were read while this state was pinned may now be released
+		if (ps->m_pinCount == 0) UpdateStateCache();
+	}
+}
+
+//-----------------------------------------------------------------------------
+void FEPostModel::SetStateCacheSize(size_t bytes)
+{
+	m_cacheSize = bytes;
+
+	#pragma omp critical (FEPostModel_GetState)
+	UpdateStateCache();
+}
+
+//-----------------------------------------------------------------------------
+size_t FEPostModel::GetStateCacheMemory()
+{
+	size_t mem = 0;
+	for (size_t i = 0; i < m_State.size(); ++i) mem += m_State[i]->DataSize();
+	return mem;
+}
+
+//-----------------------------------------------------------------------------
+void FEPostModel::ResetStateCacheStats()
+{
+	m_cacheHits = 0;
+	m_cacheMisses = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Releases the least recently used states until the state data fits in the cache.
+// Only states that can be read again are released. Pinned states, the current state and 
+// the two most recently used states are always kept since they may still be in use.
+// States are not released from inside a parallel region, since other threads may still
+// use a state they requested without pinning it.
+void FEPostModel::UpdateStateCache()
+{
+	if ((m_loader == nullptr) || (m_cacheSize == 0) || m_bcacheLocked) return;
+#ifdef _OPENMP
+	if (omp_in_parallel()) return;
+#endif
+
+	// collect all the states that are in memory
+	vector<FEState*> states;
+	size_t mem = 0;
+	for (size_t i = 0; i < m_State.size(); ++i)
+	{
+		FEState* ps = m_State[i];
+		if (ps->HasData())
+		{
+			states.push_back(ps);
+			mem += ps->DataSize();
+		}
+	}
+	if (mem <= m_cacheSize) return;
+
+	// sort from least to most recently used
+	std::sort(states.begin(), states.end(), [](FEState* a, FEState* b) {
+		return a->m_lastUsed < b->m_lastUsed;
+	});
+
+	FEState* current = ((m_nTime >= 0) && (m_nTime < (int)m_State.size()) ? m_State[m_nTime] : nullptr);
+	for (size_t i = 0; (i + 2 < states.size()) && (mem > m_cacheSize); ++i)
+	{
+		FEState* ps = states[i];
+		if ((ps != current) && (ps->m_pinCount == 0))
+		{
+			mem -= ps->DataSize();
+			ps->ReleaseData();
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+void FEPostModel::SetStateLoader(FEStateLoader* loader)
+{
+	if (m_loader != loader) delete m_loader;
+	m_loader = loader;
 }
 
 //-----------------------------------------------------------------------------
@@ -130,15 +322,16 @@ void FEPostModel::SetTimeValue(float ftime)
 //
 int FEPostModel::GetClosestTime(double t)
 {
-	FEState& s0 = *GetState(0);
+	// Note that we don't use GetState here since we don't need the state data
+	FEState& s0 = *m_State[0];
 	if (s0.m_time >= t) return 0;
 
-	FEState& s1 = *GetState(GetStates() - 1);
+	FEState& s1 = *m_State[GetStates() - 1];
 	if (s1.m_time <= t) return GetStates() - 1;
 
 	for (int i = 1; i<GetStates(); ++i)
 	{
-		FEState& s = *GetState(i);
+		FEState& s = *m_State[i];
 		if (s.m_time >= t) return i - 1;
 	}
 	return GetStates() - 1;
@@ -148,7 +341,7 @@ int FEPostModel::GetClosestTime(double t)
 //-----------------------------------------------------------------------------
 float FEPostModel::GetTimeValue(int ntime)
 {
-	return GetState(ntime)->m_time;
+	return m_State[ntime]->m_time;
 }
 
 //-----------------------------------------------------------------------------
@@ -243,6 +436,14 @@ void FEPostModel::ClearStates()
 	for (int i=0; i<(int) m_State.size(); i++) delete m_State[i];
 	m_State.clear();
 	m_nTime = 0;
+
+	// the loader can only read the states we just deleted
+	delete m_loader;
+	m_loader = nullptr;
+
+	m_bcacheLocked = false;
+	m_cacheClock = 0;
+	ResetStateCacheStats();
 }
 
 //-----------------------------------------------------------------------------
@@ -333,6 +534,9 @@ FEDataField* FEPostModel::CopyDataField(FEDataField* pd, const char* sznewname)
 	// Clone the data field
 	FEDataField* pdcopy = pd->Clone();
 
+	// the new field's data only exists in memory
+	LockStateCache();
+
 	// create a new name
 	if (sznewname == 0)
 	{
@@ -673,6 +877,9 @@ FEDataField* FEPostModel::CreateCachedCopy(FEDataField* pd, const char* sznewnam
 	FEDataField* pdcopy = createCachedDataField(pd, sznewname);
 	if (pdcopy == 0) return 0;
 
+	// the new field's data only exists in memory
+	LockStateCache();
+
 	// Add it to the model
 	AddDataField(pdcopy);
 
@@ -805,11 +1012,17 @@ void FEPostModel::DeleteDataField(FEDataField* pd)
 	if (m == -1) { assert(false); return; }
 
 	// remove this field from all states
+	// (states that were not read yet, don't have any data)
+	// The field codes of the remaining fields may change, so the cached field values can't be used.
 	int NS = GetStates();
 	for (int i=0; i<NS; ++i)
 	{
-		FEState* ps = GetState(i);
-		ps->m_Data.erase(m);
+		FEState* ps = m_State[i];
+		if (ps->HasData())
+		{
+			ps->m_Data.erase(m);
+			ps->ClearFieldCache();
+		}
 	}
 	m_pDM->DeleteDataField(pd);
 
@@ -825,10 +1038,11 @@ void FEPostModel::AddDataField(FEDataField* pd)
 	m_pDM->AddDataField(pd);
 
 	// now add new data for each of the states
+	// (states that were not read yet, will allocate this field when they are read)
 	vector<FEState*>::iterator it;
 	for (it=m_State.begin(); it != m_State.end(); ++it)
 	{
-		(*it)->m_Data.push_back(pd->CreateData(*it));
+		if ((*it)->HasData()) (*it)->m_Data.push_back(pd->CreateData(*it));
 	}
 
 	// update all dependants
@@ -841,6 +1055,11 @@ void FEPostModel::AddDataField(FEDataField* pd, vector<int>& L)
 {
 	assert(pd->DataClass() == CLASS_FACE);
 
+	// the face list is not stored with the field, so all states need to be read
+	// before the field is added.
+	LockStateCache();
+	for (int i = 0; i < GetStates(); ++i) GetState(i);
+
 	// add the data field to the data manager
 	m_pDM->AddDataField(pd);
 
@@ -932,10 +1151,10 @@ void FEPostModel::GetElementCoords(int iel, int ntime, vec3f* r)
 {
 	FEPostMesh* mesh = GetState(ntime)->GetFEMesh();
 	FEElement_& elem = mesh->ElementRef(iel);
-	NODEDATA* pn = &m_State[ntime]->m_NODE[0];
+	const vec3f* pn = GetState(ntime)->m_NODE.m_rt.data();
 
 	for (int i=0; i<elem.Nodes(); i++)
-		r[i] = pn[ elem.m_node[i] ].m_rt;
+		r[i] = pn[ elem.m_node[i] ];
 }
 
 //-----------------------------------------------------------------------------
@@ -1034,9 +1253,9 @@ void FEPostModel::UpdateMeshState(int ntime)
 	for (int i = 0; i < NE; ++i)
 	{
 		FEElement_& el = mesh->ElementRef(i);
-		ELEMDATA& data = state.m_ELEM[i];
+		ElemDataArray::Ref data = state.m_ELEM[i];
 
-		if (el.IsShell())
+		if (el.IsShell() && data.m_h)
 		{
 			int n = el.Nodes();
 			for (int j = 0; j < n; ++j) el.m_h[j] = data.m_h[j];
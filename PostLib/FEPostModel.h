@@ -36,6 +36,8 @@ using namespace std;
 
 namespace Post {
 
+class FEStateLoader;
+
 //-----------------------------------------------------------------------------
 class MetaData
 {
@@ -168,10 +170,45 @@ public:
 	//! get the nr of states
 	int GetStates() { return (int) m_State.size(); }
 
-	//! retrieve pointer to a state
-	FEState* GetState(int nstate) { return m_State[nstate]; }
+	//! retrieve pointer to a state (reads the state's data if needed)
+	FEState* GetState(int nstate);
+
+	//! see if the data of a state is in memory
+	bool IsStateLoaded(int nstate) { return m_State[nstate]->HasData(); }
+
+	//! set the loader for reading state data on demand (model takes ownership)
+	void SetStateLoader(FEStateLoader* loader);
+
+	//! get the state loader
+	FEStateLoader* GetStateLoader() { return m_loader; }
+
+	// --- S T A T E   C A C H E ---
+	//! Set the max memory (in bytes) used by state data. When this is exceeded, the least 
+	//! recently used states that were read on demand are released (0 = no limit).
+	void SetStateCacheSize(size_t bytes);
+
+	//! get the max memory of the state cache
+	size_t GetStateCacheSize() const { return m_cacheSize; }
+
+	//! get the memory currently used by the state data
+	size_t GetStateCacheMemory();
 
-	//! Add a new data field
+	//! cache statistics (only states that are read on demand are counted)
+	unsigned int GetStateCacheHits() const { return m_cacheHits; }
+	unsigned int GetStateCacheMisses() const { return m_cacheMisses; }
+	void ResetStateCacheStats();
+
+	//! Keep the data of a state in memory while it is in use (e.g. while a field is 
+	//! evaluated from multiple threads). Pinned states are never released by the cache.
+	FEState* PinState(int nstate);
+	void UnpinState(int nstate);
+
+	//! Keep all state data in memory. This is needed when state data is modified, 
+	//! since the changes would be lost when the state is released and read again.
+	void LockStateCache() { m_bcacheLocked = true; }
+
+	//! Add a new data field. Fields that are evaluated from the state data can be 
+	//! added as is. When the caller stores data in the new field, it must lock the cache.
 	void AddDataField(FEDataField* pd);
 
 	//! add a new data field constrained to a set
@@ -255,6 +292,10 @@ public:
 	static void SetInstance(FEPostModel* fem);
 	static FEPostModel* GetInstance();
 
+	//! Set the max nr of threads used for evaluating data fields (0 = use all available threads)
+	static void SetEvalThreads(int n);
+	static int GetEvalThreads();
+
 	MetaData& GetMetaData() { return m_meta; }
 
 public:
@@ -276,6 +317,12 @@ protected:
 	void EvalNodeField(int ntime, int nfield);
 	void EvalFaceField(int ntime, int nfield);
 	void EvalElemField(int ntime, int nfield);
+
+	// release states until the state data fits in the cache
+	void UpdateStateCache();
+
+	// read a state's data if it is not in memory (must be called from the FEPostModel_GetState critical section)
+	void RequestState(FEState* ps);
 	
 protected:
 	string	m_name;		// name (as displayed in model viewer)
@@ -301,12 +348,21 @@ protected:
 
 	// --- S T A T E ---
 	vector<FEState*>	m_State;	// array of pointers to FE-state structures
+	FEStateLoader*		m_loader;	// reads state data on demand (can be null)
 	FEDataManager*		m_pDM;		// the Data Manager
 	int					m_ndisp;	// vector field defining the displacement
 
+	// --- S T A T E   C A C H E ---
+	size_t			m_cacheSize;	// max memory used by states (0 = no limit)
+	bool			m_bcacheLocked;	// don't release any states when set
+	unsigned int	m_cacheClock;	// incremented each time a state is accessed
+	unsigned int	m_cacheHits;	// nr of times a state was in memory
+	unsigned int	m_cacheMisses;	// nr of times a state had to be read
+
 	// dependants
 	vector<FEModelDependant*>	m_Dependants;
 
 	static FEPostModel*	m_pThis;
+	static int			m_evalThreads;
 };
 } // namespace Post
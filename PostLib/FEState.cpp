@@ -79,57 +79,72 @@ void ObjectData::push_back(vec3f f)
 	data[n+2] = f.z;
 }
 
-FERefState::FERefState(FEPostModel* fem)
+//-----------------------------------------------------------------------------
+void NodeDataArray::clear()
 {
+	// swap with empty containers so that the memory is actually freed
+	vector<vec3f>().swap(m_rt);
+	vector<float>().swap(m_val);
+	vector<int>().swap(m_ntag);
+}
 
+//-----------------------------------------------------------------------------
+size_t NodeDataArray::capacity() const
+{
+	return m_rt.capacity()*sizeof(vec3f) + m_val.capacity()*sizeof(float) + m_ntag.capacity()*sizeof(int);
 }
 
 //-----------------------------------------------------------------------------
-// Constructor
-FEState::FEState(float time, FEPostModel* fem, Post::FEPostMesh* pmesh) : m_fem(fem), m_mesh(pmesh)
+void ElemDataArray::resize(int n)
 {
-	m_id = -1;
-	m_ref = nullptr; // will be set by model
+	m_val.resize(n);
+	m_state.resize(n);
+	m_hoff.clear();
+	m_h.clear();
+}
 
-	Post::FEPostMesh& mesh = *m_mesh;
+//-----------------------------------------------------------------------------
+void ElemDataArray::addShell(int n, int nn)
+{
+	assert((n >= 0) && (n < size()));
+	if (m_hoff.empty()) m_hoff.assign(size(), -1);
+	if (m_hoff[n] >= 0) return;
+	m_hoff[n] = (int)m_h.size();
+	m_h.resize(m_h.size() + nn, 0.f);
+}
 
-	int nodes = mesh.Nodes();
-	int edges = mesh.Edges();
-	int elems = mesh.Elements();
-	int faces = mesh.Faces();
+//-----------------------------------------------------------------------------
+void ElemDataArray::clear()
+{
+	// swap with empty containers so that the memory is actually freed
+	vector<float>().swap(m_val);
+	vector<unsigned int>().swap(m_state);
+	vector<int>().swap(m_hoff);
+	vector<float>().swap(m_h);
+}
 
-	// allocate storage
-	m_NODE.resize(nodes);
-	m_EDGE.resize(edges);
-	m_ELEM.resize(elems);
-	m_FACE.resize(faces);
+//-----------------------------------------------------------------------------
+size_t ElemDataArray::capacity() const
+{
+	return m_val.capacity()*sizeof(float) + m_state.capacity()*sizeof(unsigned int) + m_hoff.capacity()*sizeof(int) + m_h.capacity()*sizeof(float);
+}
 
-	// allocate element data
-	for (int i=0; i<elems; ++i)
-	{
-		FEElement_& el = mesh.ElementRef(i);
-		int ne = el.Nodes();
-		m_ElemData.append(ne);
-	}
+//-----------------------------------------------------------------------------
+FERefState::FERefState(FEPostModel* fem)
+{
 
-	// allocate face data
-	for (int i=0; i<faces; ++i)
-	{
-		FEFace& face = mesh.Face(i);
-		int nf = face.Nodes();
-		m_FaceData.append(nf);
-	}
+}
 
-	// initialize data
-	for (int i=0; i<nodes; ++i) m_NODE[i].m_rt = to_vec3f(mesh.Node(i).r);
-	for (int i=0; i<elems; ++i)
-	{
-		m_ELEM[i].m_state = StatusFlags::VISIBLE;
-		m_ELEM[i].m_h[0] = 0.f;
-		m_ELEM[i].m_h[1] = 0.f;
-		m_ELEM[i].m_h[2] = 0.f;
-		m_ELEM[i].m_h[3] = 0.f;
-	}
+//-----------------------------------------------------------------------------
+// Constructor
+FEState::FEState(float time, FEPostModel* fem, Post::FEPostMesh* pmesh, bool allocData) : m_fem(fem), m_mesh(pmesh)
+{
+	m_id = -1;
+	m_ref = nullptr; // will be set by model
+	m_bdata = false;
+	m_dataVersion = 0;
+	m_lastUsed = 0;
+	m_pinCount = 0;
 
 	int ptObjs = fem->PointObjects();
 	m_objPt.resize(ptObjs);
@@ -191,8 +206,27 @@ FEState::FEState(float time, FEPostModel* fem, Post::FEPostMesh* pmesh) : m_fem(
 	m_time = time;
 	m_nField = -1;
 
+	// allocate the mesh data
+	if (allocData) AllocateData();
+}
+
+//-----------------------------------------------------------------------------
+void FEState::AllocateData()
+{
+	if (m_bdata) return;
+	AllocateBuffers();
+	m_bdata = true;
+}
+
+//-----------------------------------------------------------------------------
+void FEState::AllocateBuffers()
+{
+	// allocate the item data
+	RebuildData();
+	m_Data.clear();
+
 	// get the data manager
-	FEDataManager* pdm = fem->GetDataManager();
+	FEDataManager* pdm = m_fem->GetDataManager();
 
 	// Nodal data
 	int N = pdm->DataFields();
@@ -204,6 +238,201 @@ FEState::FEState(float time, FEPostModel* fem, Post::FEPostMesh* pmesh) : m_fem(
 	}
 }
 
+//-----------------------------------------------------------------------------
+void FEState::ReleaseData()
+{
+	// swap with empty containers so that the memory is actually freed
+	m_NODE.clear();
+	vector<EDGEDATA>().swap(m_EDGE);
+	vector<FACEDATA>().swap(m_FACE);
+	m_ELEM.clear();
+	m_ElemData = ValArray();
+	m_FaceData = ValArray();
+	m_Data.clear();
+
+	// the evaluated field is no longer valid
+	m_nField = -1;
+	ClearFieldCache();
+
+	m_bdata = false;
+	m_dataVersion++;
+}
+
+//-----------------------------------------------------------------------------
+// size (in bytes) of a single value of a data field
+static size_t dataValueSize(FEDataField& d)
+{
+	switch (d.Type())
+	{
+	case DATA_FLOAT      : return sizeof(float);
+	case DATA_VEC3F      : return sizeof(vec3f);
+	case DATA_MAT3FS     : return sizeof(mat3fs);
+	case DATA_MAT3FD     : return sizeof(mat3fd);
+	case DATA_TENS4FS    : return sizeof(tens4fs);
+	case DATA_MAT3D      : return sizeof(Mat3d);
+	case DATA_MAT3F      : return sizeof(mat3f);
+	case DATA_ARRAY      : return d.GetArraySize()*sizeof(float);
+	case DATA_ARRAY_VEC3F: return d.GetArraySize()*sizeof(vec3f);
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// This returns an estimate of the memory used by the state's data. Fields that 
+// are evaluated on the fly (e.g. strains) are counted as if they store their data.
+size_t FEState::DataSize()
+{
+	if (m_bdata == false) return 0;
+
+	size_t bytes = 0;
+	bytes += m_NODE.capacity();
+	bytes += m_EDGE.capacity()*sizeof(EDGEDATA);
+	bytes += m_FACE.capacity()*sizeof(FACEDATA);
+	bytes += m_ELEM.capacity();
+	bytes += (m_ElemData.values() + m_ELEM.size())*sizeof(float);
+	bytes += (m_FaceData.values() + m_FACE.size())*sizeof(float);
+
+	list<FEFieldValues>::iterator ic;
+	for (ic = m_fieldCache.begin(); ic != m_fieldCache.end(); ++ic) bytes += ic->DataSize();
+
+	size_t nodes = m_NODE.size();
+	size_t elems = m_ELEM.size();
+	size_t faces = m_FACE.size();
+
+	FEDataManager* pdm = m_fem->GetDataManager();
+	int N = pdm->DataFields();
+	FEDataFieldPtr it = pdm->FirstDataField();
+	for (int i = 0; i < N; ++i, ++it)
+	{
+		FEDataField& d = *(*it);
+
+		// number of values stored for this field
+		size_t n = 0;
+		switch (d.DataClass())
+		{
+		case CLASS_NODE: n = nodes; break;
+		case CLASS_ELEM:
+			switch (d.Format())
+			{
+			case DATA_NODE  : n = nodes; break;
+			case DATA_ITEM  : n = elems; break;
+			case DATA_COMP  : n = m_ElemData.values(); break;
+			case DATA_REGION: n = 1; break;
+			}
+			break;
+		case CLASS_FACE:
+			switch (d.Format())
+			{
+			case DATA_NODE  : n = nodes; break;
+			case DATA_ITEM  : n = faces; break;
+			case DATA_COMP  : n = m_FaceData.values(); break;
+			case DATA_REGION: n = 1; break;
+			}
+			break;
+		default:
+			break;
+		}
+
+		bytes += n*dataValueSize(d);
+	}
+
+	return bytes;
+}
+
+//-----------------------------------------------------------------------------
+size_t FEFieldValues::DataSize() const
+{
+	size_t bytes = 0;
+	bytes += m_nodeVal.capacity()*sizeof(float);
+	bytes += m_nodeTag.capacity()*sizeof(int);
+	bytes += m_elemVal.capacity()*sizeof(float);
+	bytes += m_elemState.capacity()*sizeof(unsigned int);
+	bytes += m_face.capacity()*sizeof(FACEDATA);
+	bytes += m_elemData.capacity()*sizeof(float);
+	bytes += m_faceData.capacity()*sizeof(float);
+	return bytes;
+}
+
+//-----------------------------------------------------------------------------
+void FEState::CacheFieldValues()
+{
+	if ((m_nField < 0) || (m_bdata == false)) return;
+
+	// remove an older copy of this field
+	list<FEFieldValues>::iterator it;
+	for (it = m_fieldCache.begin(); it != m_fieldCache.end(); ++it)
+	{
+		if (it->m_nfield == m_nField) { m_fieldCache.erase(it); break; }
+	}
+
+	// make room for the new values (reusing the memory of the oldest values)
+	if (m_fieldCache.size() >= MAX_CACHED_FIELDS)
+	{
+		m_fieldCache.splice(m_fieldCache.begin(), m_fieldCache, --m_fieldCache.end());
+	}
+	else m_fieldCache.push_front(FEFieldValues());
+
+	FEFieldValues& v = m_fieldCache.front();
+	v.m_nfield = m_nField;
+	v.m_nodeVal   = m_NODE.m_val;
+	v.m_nodeTag   = m_NODE.m_ntag;
+	v.m_elemVal   = m_ELEM.m_val;
+	v.m_elemState = m_ELEM.m_state;
+	v.m_face      = m_FACE;
+	v.m_elemData  = m_ElemData.data();
+	v.m_faceData  = m_FaceData.data();
+}
+
+//-----------------------------------------------------------------------------
+bool FEState::RestoreFieldValues(int nfield)
+{
+	list<FEFieldValues>::iterator it;
+	for (it = m_fieldCache.begin(); it != m_fieldCache.end(); ++it)
+	{
+		if (it->m_nfield == nfield) break;
+	}
+	if (it == m_fieldCache.end()) return false;
+
+	// The values are swapped in, since the current values are already cached
+	// (or are no longer needed).
+	FEFieldValues& v = *it;
+	m_NODE.m_val.swap(v.m_nodeVal);
+	m_NODE.m_ntag.swap(v.m_nodeTag);
+	m_ELEM.m_val.swap(v.m_elemVal);
+	m_FACE.swap(v.m_face);
+	m_ElemData.data().swap(v.m_elemData);
+	m_FaceData.data().swap(v.m_faceData);
+
+	// Only the active flag is set by the evaluation. The mesh' elements
+	// are (de)activated as well, like the evaluation does.
+	int NE = (int) m_ELEM.size();
+	for (int i = 0; i < NE; ++i)
+	{
+		unsigned int& state = m_ELEM.m_state[i];
+		FEElement_& el = m_mesh->ElementRef(i);
+		if (v.m_elemState[i] & StatusFlags::ACTIVE)
+		{
+			state |= StatusFlags::ACTIVE;
+			el.Activate();
+		}
+		else
+		{
+			state &= ~StatusFlags::ACTIVE;
+			el.Deactivate();
+		}
+	}
+
+	m_fieldCache.erase(it);
+	m_nField = nfield;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void FEState::ClearFieldCache()
+{
+	m_fieldCache.clear();
+}
+
 //-----------------------------------------------------------------------------
 // helper function for copying data
 template <class T> void copyData(Post::FEMeshData* dest, Post::FEMeshData* src)
@@ -240,6 +469,10 @@ FEState::FEState(float time, FEPostModel* pfem, FEState* pstate) : m_fem(pfem)
 	m_time = time;
 	m_nField = -1;
 	m_mesh = pstate->m_mesh;
+	m_bdata = true;
+	m_dataVersion = 0;
+	m_lastUsed = 0;
+	m_pinCount = 0;
 
 	RebuildData();
 
@@ -333,7 +566,10 @@ void FEState::RebuildData()
 		int ne = el.Nodes();
 		m_ElemData.append(ne);
 
-		m_ELEM[i].m_state = StatusFlags::VISIBLE;
+		m_ELEM.m_state[i] = StatusFlags::VISIBLE;
+
+		// only shells store a thickness
+		if (el.IsShell()) m_ELEM.addShell(i, ne);
 	}
 
 	// allocate face data
@@ -346,14 +582,7 @@ void FEState::RebuildData()
 	}
 
 	// initialize data
-	for (int i = 0; i < nodes; ++i) m_NODE[i].m_rt = to_vec3f(mesh.Node(i).r);
-	for (int i = 0; i < elems; ++i)
-	{
-		m_ELEM[i].m_h[0] = 0.f;
-		m_ELEM[i].m_h[1] = 0.f;
-		m_ELEM[i].m_h[2] = 0.f;
-		m_ELEM[i].m_h[3] = 0.f;
-	}
+	for (int i = 0; i < nodes; ++i) m_NODE.m_rt[i] = to_vec3f(mesh.Node(i).r);
 
 	int ptObjs = fem.PointObjects();
 	m_objPt.resize(ptObjs);
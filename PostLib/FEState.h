@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include "FEMeshData.h"
 #include <MeshLib/FEElement.h>
 #include <vector>
+#include <list>
 #include "ValArray.h"
 using namespace std;
 
@@ -63,7 +64,6 @@ struct ELEMDATA
 {
 	float			m_val;		// current element value
 	unsigned int	m_state;	// state flags
-	float			m_h[FEElement::MAX_NODES];		// shell thickness (TODO: Can we move this to the face data?)
 };
 
 struct FACEDATA
@@ -134,6 +134,117 @@ public:
 	vec3d	m_r2;
 };
 
+//-----------------------------------------------------------------------------
+// Stores the nodal data of a state. Each member of NODEDATA is stored in its own
+// array, but the data can still be accessed per node, e.g. m_NODE[i].m_val.
+class NodeDataArray
+{
+public:
+	// reference to the data of a single node
+	class Ref
+	{
+	public:
+		Ref(vec3f& rt, float& val, int& ntag) : m_rt(rt), m_val(val), m_ntag(ntag) {}
+
+		operator NODEDATA() const { NODEDATA d = { m_rt, m_val, m_ntag }; return d; }
+
+	public:
+		vec3f&	m_rt;
+		float&	m_val;
+		int&	m_ntag;
+	};
+
+public:
+	int size() const { return (int)m_val.size(); }
+	bool empty() const { return m_val.empty(); }
+
+	void resize(int n) { m_rt.resize(n); m_val.resize(n); m_ntag.resize(n); }
+
+	// clear the data and free the memory
+	void clear();
+
+	// memory (in bytes) used by the arrays
+	size_t capacity() const;
+
+	Ref operator [] (int n) { return Ref(m_rt[n], m_val[n], m_ntag[n]); }
+
+public:
+	vector<vec3f>	m_rt;	// nodal positions
+	vector<float>	m_val;	// nodal values
+	vector<int>		m_ntag;	// active flags
+};
+
+//-----------------------------------------------------------------------------
+// Stores the element data of a state. Like NodeDataArray, each member is stored
+// in its own array. Shell thicknesses are only stored for shell elements.
+class ElemDataArray
+{
+public:
+	// reference to the data of a single element
+	class Ref
+	{
+	public:
+		Ref(float& val, unsigned int& state, float* h) : m_val(val), m_state(state), m_h(h) {}
+
+		operator ELEMDATA() const { ELEMDATA d = { m_val, m_state }; return d; }
+
+	public:
+		float&			m_val;
+		unsigned int&	m_state;
+		float*			m_h;		// shell thickness (null if this is not a shell)
+	};
+
+public:
+	int size() const { return (int)m_val.size(); }
+	bool empty() const { return m_val.empty(); }
+
+	// This also removes all shell thicknesses
+	void resize(int n);
+
+	// allocate (zero) shell thicknesses for element n, which has nn nodes
+	void addShell(int n, int nn);
+
+	// clear the data and free the memory
+	void clear();
+
+	// memory (in bytes) used by the arrays
+	size_t capacity() const;
+
+	// shell thicknesses of element n (null if this is not a shell)
+	float* thickness(int n) { return (m_hoff.empty() || (m_hoff[n] < 0) ? nullptr : &m_h[m_hoff[n]]); }
+
+	Ref operator [] (int n) { return Ref(m_val[n], m_state[n], thickness(n)); }
+
+public:
+	vector<float>			m_val;		// element values
+	vector<unsigned int>	m_state;	// state flags
+
+private:
+	vector<int>		m_hoff;		// offset into m_h for each element (empty if there are no shells)
+	vector<float>	m_h;		// shell thicknesses
+};
+
+//-----------------------------------------------------------------------------
+// The values of an evaluated data field (see FEPostModel::Evaluate). A state keeps
+// the values of a few recently evaluated fields, so that switching back to one of
+// these fields only requires the values to be copied.
+class FEFieldValues
+{
+public:
+	int		m_nfield;		// field code
+
+	vector<float>			m_nodeVal;
+	vector<int>				m_nodeTag;
+	vector<float>			m_elemVal;
+	vector<unsigned int>	m_elemState;
+	vector<FACEDATA>		m_face;
+	vector<float>			m_elemData;	// values of m_ElemData
+	vector<float>			m_faceData;	// values of m_FaceData
+
+	// memory (in bytes) used by the values
+	size_t DataSize() const;
+};
+
 //-----------------------------------------------------------------------------
 // class for storing reference state
 class FERefState
@@ -151,7 +262,7 @@ public:
 class FEState
 {
 public:
-	FEState(float time, FEPostModel* fem, FEPostMesh* mesh);
+	FEState(float time, FEPostModel* fem, FEPostMesh* mesh, bool allocData = true);
 	FEState(float time, FEPostModel* fem, FEState* state);
 
 	void SetID(int n);
@@ -177,16 +288,52 @@ public:
 
 	void RebuildData();
 
+	// States that are read on demand are created without data. 
+	// The data is allocated when the state is read.
+	void AllocateData();
+	bool HasData() const { return m_bdata; }
+
+	// Allocate the data without marking it as available. This is used while a
+	// state is read, so that the data is only available once the read succeeded.
+	void AllocateBuffers();
+	void SetDataLoaded() { m_bdata = true; m_dataVersion++; }
+
+	// Release the data of a state that was read on demand. The state can
+	// be read again by reallocating the data.
+	void ReleaseData();
+
+	// This changes each time the data is read or released. Values that are derived
+	// from the data (e.g. the displaced nodal positions) must be updated when it changes.
+	unsigned int DataVersion() const { return m_dataVersion; }
+
+	// estimate of the memory (in bytes) used by the state's data
+	size_t DataSize();
+
+	// --- F I E L D   C A C H E ---
+	// max nr of evaluated fields whose values are kept
+	enum { MAX_CACHED_FIELDS = 4 };
+
+	// store the values of the evaluated field (m_nField) in the field cache
+	void CacheFieldValues();
+
+	// Restore the values of a field from the field cache. Returns false if
+	// the field is not in the cache, in which case it needs to be evaluated.
+	bool RestoreFieldValues(int nfield);
+
+	// Remove all values from the field cache. This must be called when the
+	// evaluated values are no longer valid (e.g. the data was changed).
+	void ClearFieldCache();
+
 public:
 	float	m_time;		// time value
 	int		m_nField;	// the field whos values are contained in m_pval
 	int		m_id;		// index in state array of FEPostModel
 	bool	m_bsmooth;
 
-	vector<NODEDATA>	m_NODE;		// nodal data
+	NodeDataArray		m_NODE;		// nodal data
 	vector<EDGEDATA>	m_EDGE;		// edge data
 	vector<FACEDATA>	m_FACE;		// face data
-	vector<ELEMDATA>	m_ELEM;		// element data
+	ElemDataArray		m_ELEM;		// element data
 	vector<LINEDATA>	m_Line;		// line data
 	vector<POINTDATA>	m_Point;	// point data
 
@@ -203,5 +350,14 @@ public:
 	FEPostModel*	m_fem;	//!< model this state belongs to
 	FERefState*		m_ref;	//!< the reference state for this state
 	FEPostMesh*		m_mesh;	//!< The mesh this state uses
+
+	unsigned int	m_lastUsed;	//!< last time the state was used (used by the model's state cache)
+	int				m_pinCount;	//!< number of users that need the data to stay in memory
+
+private:
+	bool			m_bdata;		//!< is the data allocated?
+	unsigned int	m_dataVersion;	//!< incremented each time the data is read or released
+
+	list<FEFieldValues>	m_fieldCache;	//!< values of previously evaluated fields (most recent first)
 };
 }
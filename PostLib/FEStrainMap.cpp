@@ -138,6 +138,8 @@ void FEStrainMap::Apply(FEPostModel& fem)
 	m_fem = &fem;
 
 	// add a new data field
+	// (its data only exists in memory)
+	fem.LockStateCache();
 	fem.AddDataField(new FEDataField_T<FEFaceData<float, DATA_NODE> >(szname, EXPORT_DATA));
 	int NDATA = fem.GetDataManager()->DataFields() - 1;
 
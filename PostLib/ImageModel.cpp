@@ -27,6 +27,7 @@ SOFTWARE.*/
 #include "stdafx.h"
 #include "ImageModel.h"
 #include <ImageLib/3DImage.h>
+#include <ImageLib/BrickedImage.h>
 #include "GLImageRenderer.h"
 #include <FSCore/FSDir.h>
 #include <assert.h>
@@ -38,8 +39,10 @@ CImageSource::CImageSource(CImageModel* imgModel)
 	AddIntParam(0, "NX")->SetState(Param_VISIBLE);
 	AddIntParam(1, "NY")->SetState(Param_VISIBLE);
 	AddIntParam(2, "NZ")->SetState(Param_VISIBLE);
+	AddIntParam(8, "bits")->SetState(Param_VISIBLE);
 
 	m_img = nullptr;
+	m_bricks = nullptr;
 	m_imgModel = imgModel;
 }
 
@@ -55,6 +58,7 @@ void CImageSource::SetImageModel(CImageModel* imgModel)
 
 CImageSource::~CImageSource()
 {
+	delete m_bricks;
 	delete m_img;
 }
 
@@ -68,16 +72,11 @@ std::string CImageSource::GetFileName() const
 	return GetStringValue(0);
 }
 
-bool CImageSource::LoadImageData(const std::string& fileName, int nx, int ny, int nz)
+bool CImageSource::LoadImageData(const std::string& fileName, int nx, int ny, int nz, int nbits)
 {
+	// the file is mapped, so the data is only read when it is accessed
 	C3DImage* im = new C3DImage;
-	if (im->Create(nx, ny, nz) == false)
-	{
-		delete im;
-		return false;
-	}
-
-	if (im->LoadFromFile(fileName.c_str(), 8) == false)
+	if (im->MapFile(fileName.c_str(), nx, ny, nz, nbits) == false)
 	{
 		delete im;
 		return false;
@@ -87,10 +86,16 @@ bool CImageSource::LoadImageData(const std::string& fileName, int nx, int ny, in
 	SetIntValue(1, nx);
 	SetIntValue(2, ny);
 	SetIntValue(3, nz);
+	SetIntValue(4, nbits);
 
+	delete m_bricks;
 	delete m_img;
 	m_img = im;
 
+	// the coarser levels are only computed when they are needed
+	m_bricks = new CBrickedImage;
+	m_bricks->Create(m_img);
+
 	return true;
 }
 
@@ -102,12 +107,13 @@ void CImageSource::Save(OArchive& ar)
 int CImageSource::Width() const { return GetIntValue(1);  }
 int CImageSource::Height() const { return GetIntValue(2); }
 int CImageSource::Depth() const { return GetIntValue(3); }
+int CImageSource::Bits() const { return GetIntValue(4); }
 
 void CImageSource::Load(IArchive& ar)
 {
 	FSObject::Load(ar);
 	string file = GetFileName();
-	LoadImageData(file, Width(), Height(), Depth());
+	LoadImageData(file, Width(), Height(), Depth(), Bits());
 }
 
 //========================================================================
@@ -121,9 +127,13 @@ CImageModel::CImageModel(CGLModel* mdl) : CGLObject(mdl)
 	AddDoubleParam(1, "x1");
 	AddDoubleParam(1, "y1");
 	AddDoubleParam(1, "z1");
+	AddDoubleParam(0, "display min");
+	AddDoubleParam(255, "display max");
 
 	m_box = BOX(0., 0., 0., 1., 1., 1.);
 	m_showBox = true;
+	m_vmin = 0.0;
+	m_vmax = 255.0;
 	m_img = nullptr;
 
 	UpdateData(false);
@@ -145,6 +155,9 @@ bool CImageModel::UpdateData(bool bsave)
 		m_box.x1 = GetFloatValue(4);
 		m_box.y1 = GetFloatValue(5);
 		m_box.z1 = GetFloatValue(6);
+		m_vmin = GetFloatValue(7);
+		m_vmax = GetFloatValue(8);
+		if (m_img && m_img->Get3DImage()) m_img->Get3DImage()->SetDisplayRange(m_vmin, m_vmax);
 		for (int i = 0; i < (int)m_render.Size(); ++i) m_render[i]->Update();
 	}
 	else
@@ -156,16 +169,18 @@ bool CImageModel::UpdateData(bool bsave)
 		SetFloatValue(4, m_box.x1);
 		SetFloatValue(5, m_box.y1);
 		SetFloatValue(6, m_box.z1);
+		SetFloatValue(7, m_vmin);
+		SetFloatValue(8, m_vmax);
 	}
 
 	return false;
 }
 
-bool CImageModel::LoadImageData(const std::string& fileName, int nx, int ny, int nz, const BOX& box)
+bool CImageModel::LoadImageData(const std::string& fileName, int nx, int ny, int nz, const BOX& box, int nbits)
 {
 	if (m_img == nullptr) m_img = new CImageSource(this);
 
-	if (m_img->LoadImageData(fileName, nx, ny, nz) == false)
+	if (m_img->LoadImageData(fileName, nx, ny, nz, nbits) == false)
 	{
 		delete m_img;
 		m_img = nullptr;
@@ -177,11 +192,23 @@ bool CImageModel::LoadImageData(const std::string& fileName, int nx, int ny, int
 	m_img->SetName(fileBase);
 
 	m_box = box;
+
+	// start with the full range of the image data
+	m_img->Get3DImage()->GetValueRange(m_vmin, m_vmax);
 	UpdateData(false);
 
 	return true;
 }
 
+void CImageModel::SetDisplayRange(double vmin, double vmax)
+{
+	m_vmin = vmin;
+	m_vmax = vmax;
+	if (m_img && m_img->Get3DImage()) m_img->Get3DImage()->SetDisplayRange(vmin, vmax);
+	UpdateData(false);
+	for (int i = 0; i < (int)m_render.Size(); ++i) m_render[i]->Update();
+}
+
 bool CImageModel::ShowBox() const
 {
 	return m_showBox;
@@ -33,6 +33,7 @@ SOFTWARE.*/
 #include "GLObject.h"
 
 class C3DImage;
+class CBrickedImage;
 
 namespace Post {
 
@@ -48,16 +49,21 @@ public:
 	void SetFileName(const std::string& fileName);
 	std::string GetFileName() const;
 
-	bool LoadImageData(const std::string& fileName, int nx, int ny, int nz);
+	// nbits = 8, 16, or 32 (float)
+	bool LoadImageData(const std::string& fileName, int nx, int ny, int nz, int nbits = 8);
 
 	C3DImage* Get3DImage() { return m_img; }
 
+	// multi-resolution access to the image data
+	CBrickedImage* GetBrickedImage() { return m_bricks; }
+
 	void Save(OArchive& ar);
 	void Load(IArchive& ar);
 
 	int Width() const;
 	int Height() const;
 	int Depth() const;
+	int Bits() const;
 
 public:
 	CImageModel* GetImageModel();
@@ -65,6 +71,7 @@ public:
 
 private:
 	C3DImage*	m_img;
+	CBrickedImage*	m_bricks;
 	CImageModel*	m_imgModel;
 };
 
@@ -74,7 +81,7 @@ public:
 	CImageModel(CGLModel* mdl);
 	~CImageModel();
 
-	bool LoadImageData(const std::string& fileName, int nx, int ny, int nz, const BOX& box);
+	bool LoadImageData(const std::string& fileName, int nx, int ny, int nz, const BOX& box, int nbits = 8);
 
 	int ImageRenderers() const { return (int)m_render.Size(); }
 	CGLImageRenderer* GetImageRenderer(int i) { return m_render[i]; }
@@ -86,6 +93,10 @@ public:
 
 	void SetBoundingBox(BOX b) { m_box = b; }
 
+	// the range of image values that is mapped to the display range
+	void GetDisplayRange(double& vmin, double& vmax) const { vmin = m_vmin; vmax = m_vmax; }
+	void SetDisplayRange(double vmin, double vmax);
+
 	bool ShowBox() const;
 
 	void ShowBox(bool b);
@@ -102,6 +113,7 @@ public:
 private:
 	BOX				m_box;						//!< physical dimensions of image
 	bool			m_showBox;					//!< show box in Graphics View
+	double			m_vmin, m_vmax;				//!< display range of image values
 	FSObjectList<CGLImageRenderer>	m_render;	//!< image renderers
 
 	CImageSource*	m_img;
@@ -37,6 +37,7 @@ SOFTWARE.*/
 #endif
 #include "ImageSlicer.h"
 #include "ImageModel.h"
+#include <ImageLib/BrickedImage.h>
 #include <assert.h>
 #include <sstream>
 using namespace Post;
@@ -88,26 +89,8 @@ bool CImageSlicer::UpdateData(bool bsave)
 
 void CImageSlicer::Create()
 {
-	CImageSource* src = GetImageModel()->GetImageSource();
-	if (src == nullptr) return;
-
-	C3DImage& im3d = *src->Get3DImage();
-
-	// get the original image dimensions
-	int w = im3d.Width();
-	int h = im3d.Height();
-	int d = im3d.Depth();
-
-	// find new image dimenions
-	int nx = closest_pow2(w);
-	int ny = closest_pow2(h);
-	int nz = closest_pow2(d);
-	m_im3d.Create(nx, ny, nz);
-
-	// resample image
-	im3d.StretchBlt(m_im3d);
-
-	// call update to initialize all other data
+	// The slice is sampled directly from the image data, so there is nothing to
+	// prepare. Call update to initialize all other data.
 	Update();
 }
 
@@ -119,18 +102,39 @@ void CImageSlicer::Update()
 
 void CImageSlicer::UpdateSlice()
 {
+	CImageSource* src = GetImageModel()->GetImageSource();
+	if ((src == nullptr) || (src->GetBrickedImage() == nullptr)) return;
+
+	CBrickedImage& bricks = *src->GetBrickedImage();
+	C3DImage& im3d = *bricks.GetImage();
+
+	// the slice is resampled to power-of-two dimensions
+	int nx = closest_pow2(im3d.Width());
+	int ny = closest_pow2(im3d.Height());
+	int nz = closest_pow2(im3d.Depth());
+
+	// Sample from the finest level that has at most twice the resolution of the
+	// slice. Only the bricks that intersect the slice are loaded.
+	int nmax = nx;
+	if (ny > nmax) nmax = ny;
+	if (nz > nmax) nmax = nz;
+	int l = bricks.FindLevel(2 * nmax);
+
 	// get the 2D image
 	CImage im2d;
 	switch (m_op)
 	{
 	case 0: // X
-		m_im3d.GetSampledSliceX(im2d, m_off);
+		im2d.Create(ny, nz);
+		bricks.GetSampledSliceX(im2d, m_off, l);
 		break;
 	case 1: // Y
-		m_im3d.GetSampledSliceY(im2d, m_off);
+		im2d.Create(nx, nz);
+		bricks.GetSampledSliceY(im2d, m_off, l);
 		break;
 	case 2: // Z
-		m_im3d.GetSampledSliceZ(im2d, m_off);
+		im2d.Create(nx, ny);
+		bricks.GetSampledSliceZ(im2d, m_off, l);
 		break;
 	default:
 		assert(false);
@@ -66,7 +66,6 @@ private:
 	void UpdateSlice();
 
 private:
-	C3DImage		m_im3d;	// resampled 3D image data
 	CRGBAImage		m_im;	// 2D image that will be displayed
 	int				m_LUTC[4][256];	// color lookup table
 	bool			m_reloadTexture;
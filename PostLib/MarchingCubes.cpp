@@ -40,6 +40,7 @@ SOFTWARE.*/
 #include "ImageModel.h"
 #include <ImageLib/3DImage.h>
 #include <ImageLib/3DGradientMap.h>
+#include <ImageLib/BrickedImage.h>
 #include <sstream>
 #include <assert.h>
 using namespace std;
@@ -56,26 +57,262 @@ TriMesh::TriMesh()
 
 void TriMesh::Clear()
 {
+	m_Node.clear();
 	m_Face.clear();
+	m_Norm.clear();
 }
 
-void TriMesh::Reserve(size_t nsize)
+void TriMesh::Resize(size_t nodes, size_t faces)
 {
-	m_Face.reserve(nsize);
+	m_Node.resize(nodes);
+	m_Face.resize(faces);
+	m_Norm.resize(faces);
 }
 
-void TriMesh::Resize(size_t nsize)
+int TriMesh::AddNode(const vec3f& r, const vec3f& n)
 {
-	m_Face.resize(nsize);
+	NODE node;
+	node.r = r;
+	node.n = n;
+	m_Node.push_back(node);
+	return (int)m_Node.size() - 1;
 }
 
-void TriMesh::Merge(TriMesh& tri, int ncount)
+void TriMesh::AddFace(int n0, int n1, int n2, const vec3f& fn)
 {
-	if (ncount < 0) ncount = tri.Faces();
-	int N = (int)m_Face.size();
-	m_Face.resize(m_Face.size() + ncount);
-	for (size_t i = 0; i < ncount; ++i)
-		m_Face[N + i] = tri.m_Face[i];
+	FACE face;
+	face.n[0] = n0;
+	face.n[1] = n1;
+	face.n[2] = n2;
+	m_Face.push_back(face);
+	m_Norm.push_back(fn);
+}
+
+void TriMesh::Merge(TriMesh& tri)
+{
+	int N0 = (int)m_Node.size();
+	m_Node.insert(m_Node.end(), tri.m_Node.begin(), tri.m_Node.end());
+
+	int F0 = (int)m_Face.size();
+	m_Face.insert(m_Face.end(), tri.m_Face.begin(), tri.m_Face.end());
+	m_Norm.insert(m_Norm.end(), tri.m_Norm.begin(), tri.m_Norm.end());
+	for (size_t i = F0; i < m_Face.size(); ++i)
+	{
+		FACE& f = m_Face[i];
+		f.n[0] += N0;
+		f.n[1] += N0;
+		f.n[2] += N0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// number of voxel layers that are processed as one unit of work
+const int SLAB_SIZE = 8;
+
+// larger images are processed at a coarser level of the bricked image
+const int MAX_GRID_SIZE = 1024;
+
+// corner offsets of a voxel (in the same order as the LUT)
+static int HEX_CORNER[8][3] = {
+	{0,0,0}, {1,0,0}, {1,1,0}, {0,1,0},
+	{0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}
+};
+
+// grid data that is shared by all the slabs
+struct MCGrid
+{
+	BOX		box;
+	float	dx, dy, dz;
+	int		NX, NY, NZ;
+	float	ref;		// iso-value (native voxel value)
+	bool	smooth;
+	bool	invert;
+};
+
+// a vertex on a slab boundary plane: (edge index in plane, local node index)
+typedef std::pair<int, int> PlaneVertex;
+
+//-----------------------------------------------------------------------------
+// Generate the iso-surface of the voxel layers [k0, k1). The image (and its
+// gradient) only needs to hold the layers that are used, starting at layer ko.
+// Vertices are shared
+// between triangles by caching the node index of each cut voxel edge. The edges
+// of two z-planes are cached (x- and y-edges), and the z-edges of two rows.
+// The vertices on the bottom and top plane are returned so that the slabs can
+// be welded together afterwards.
+static void CreateSlab(const MCGrid& g, C3DImage& im3d, C3DGradientMap& gradMap, int ko, int k0, int k1, TriMesh& mesh, vector<PlaneVertex>& bottom, vector<PlaneVertex>& top, vector<int>& cache)
+{
+	int NX = g.NX;
+	int NY = g.NY;
+	int planeSize = 2 * NX*NY;
+	int* plane[2] = { &cache[0], &cache[planeSize] };
+	int* zrow[2] = { &cache[2 * planeSize], &cache[2 * planeSize + NX] };
+
+	// for each voxel edge: grid point offset and direction
+	int edge[12][4];
+	for (int e = 0; e < 12; ++e)
+	{
+		const int* ca = HEX_CORNER[ET_HEX[e][0]];
+		const int* cb = HEX_CORNER[ET_HEX[e][1]];
+		for (int d = 0; d < 3; ++d)
+		{
+			edge[e][d] = (ca[d] < cb[d] ? ca[d] : cb[d]);
+			if (ca[d] != cb[d]) edge[e][3] = d;
+		}
+	}
+
+	const BOX& b = g.box;
+	float ref = g.ref;
+	float fref = ref;
+
+	float val[8];
+	vec3f r[8], grad[8];
+
+	std::fill(plane[0], plane[0] + planeSize, -1);
+	for (int k = k0; k < k1; ++k)
+	{
+		std::fill(plane[1], plane[1] + planeSize, -1);
+		std::fill(zrow[0], zrow[0] + NX, -1);
+		for (int j = 0; j < NY - 1; ++j)
+		{
+			std::fill(zrow[1], zrow[1] + NX, -1);
+			for (int i = 0; i < NX - 1; ++i)
+			{
+				// get the voxel's values
+				if (i == 0)
+				{
+					val[0] = im3d.voxel(i, j, k - ko);
+					val[3] = im3d.voxel(i, j + 1, k - ko);
+					val[4] = im3d.voxel(i, j, k + 1 - ko);
+					val[7] = im3d.voxel(i, j + 1, k + 1 - ko);
+				}
+
+				val[1] = im3d.voxel(i + 1, j, k - ko);
+				val[2] = im3d.voxel(i + 1, j + 1, k - ko);
+				val[5] = im3d.voxel(i + 1, j, k + 1 - ko);
+				val[6] = im3d.voxel(i + 1, j + 1, k + 1 - ko);
+
+				// calculate the case of the voxel
+				int ncase = 0;
+				if (g.invert)
+				{
+					if (val[0] < ref) ncase |= 0x01;
+					if (val[1] < ref) ncase |= 0x02;
+					if (val[2] < ref) ncase |= 0x04;
+					if (val[3] < ref) ncase |= 0x08;
+					if (val[4] < ref) ncase |= 0x10;
+					if (val[5] < ref) ncase |= 0x20;
+					if (val[6] < ref) ncase |= 0x40;
+					if (val[7] < ref) ncase |= 0x80;
+				}
+				else
+				{
+					if (val[0] > ref) ncase |= 0x01;
+					if (val[1] > ref) ncase |= 0x02;
+					if (val[2] > ref) ncase |= 0x04;
+					if (val[3] > ref) ncase |= 0x08;
+					if (val[4] > ref) ncase |= 0x10;
+					if (val[5] > ref) ncase |= 0x20;
+					if (val[6] > ref) ncase |= 0x40;
+					if (val[7] > ref) ncase |= 0x80;
+				}
+
+				// cases 0 and 255 don't generate triangles, so don't waste time on these
+				if ((ncase != 0) && (ncase != 255))
+				{
+					// get the corners
+					r[0].x = b.x0 + i      *g.dx; r[0].y = b.y0 + j      *g.dy; r[0].z = b.z0 + k      *g.dz;
+					r[1].x = b.x0 + (i + 1)*g.dx; r[1].y = b.y0 + j      *g.dy; r[1].z = b.z0 + k      *g.dz;
+					r[2].x = b.x0 + (i + 1)*g.dx; r[2].y = b.y0 + (j + 1)*g.dy; r[2].z = b.z0 + k      *g.dz;
+					r[3].x = b.x0 + i      *g.dx; r[3].y = b.y0 + (j + 1)*g.dy; r[3].z = b.z0 + k      *g.dz;
+					r[4].x = b.x0 + i      *g.dx; r[4].y = b.y0 + j      *g.dy; r[4].z = b.z0 + (k + 1)*g.dz;
+					r[5].x = b.x0 + (i + 1)*g.dx; r[5].y = b.y0 + j      *g.dy; r[5].z = b.z0 + (k + 1)*g.dz;
+					r[6].x = b.x0 + (i + 1)*g.dx; r[6].y = b.y0 + (j + 1)*g.dy; r[6].z = b.z0 + (k + 1)*g.dz;
+					r[7].x = b.x0 + i      *g.dx; r[7].y = b.y0 + (j + 1)*g.dy; r[7].z = b.z0 + (k + 1)*g.dz;
+
+					// calculate gradients
+					if (g.smooth)
+					{
+						grad[0] = gradMap.Value(i, j, k - ko);
+						grad[1] = gradMap.Value(i + 1, j, k - ko);
+						grad[2] = gradMap.Value(i + 1, j + 1, k - ko);
+						grad[3] = gradMap.Value(i, j + 1, k - ko);
+						grad[4] = gradMap.Value(i, j, k + 1 - ko);
+						grad[5] = gradMap.Value(i + 1, j, k + 1 - ko);
+						grad[6] = gradMap.Value(i + 1, j + 1, k + 1 - ko);
+						grad[7] = gradMap.Value(i, j + 1, k + 1 - ko);
+					}
+
+					// loop over faces
+					int* pf = LUT[ncase];
+					for (int l = 0; l < 5; l++)
+					{
+						if (*pf == -1) break;
+
+						int n[3];
+						for (int m = 0; m < 3; m++)
+						{
+							// find the cached vertex of this edge
+							const int* ed = edge[pf[m]];
+							int x = i + ed[0];
+							int* pn = (ed[3] == 2 ? &zrow[ed[1]][x] : &plane[ed[2]][2 * ((j + ed[1])*NX + x) + ed[3]]);
+
+							// or create a new one
+							if (*pn < 0)
+							{
+								int n1 = ET_HEX[pf[m]][0];
+								int n2 = ET_HEX[pf[m]][1];
+
+								float w = (fref - (float)val[n1]) / ((float)val[n2] - (float)val[n1]);
+								assert((w >= 0.f) && (w <= 1.f));
+
+								vec3f normal(0.f, 0.f, 0.f);
+								if (g.smooth)
+								{
+									normal = grad[n1] * (1.f - w) + grad[n2] * w;
+									normal.Normalize();
+									if (g.invert) normal = -normal;
+								}
+
+								*pn = mesh.AddNode(r[n1] * (1.f - w) + r[n2] * w, normal);
+							}
+							n[m] = *pn;
+						}
+
+						vec3f r0 = mesh.Node(n[0]).r;
+						vec3f fn = (mesh.Node(n[1]).r - r0) ^ (mesh.Node(n[2]).r - r0);
+						fn.Normalize();
+
+						mesh.AddFace(n[0], n[1], n[2], fn);
+
+						pf += 3;
+					}
+				}
+
+				// keep this for next i
+				val[0] = val[1];
+				val[4] = val[5];
+				val[3] = val[2];
+				val[7] = val[6];
+			}
+
+			std::swap(zrow[0], zrow[1]);
+		}
+
+		// collect the vertices on the slab's boundary planes
+		if (k == k0)
+		{
+			for (int n = 0; n < planeSize; ++n)
+				if (plane[0][n] >= 0) bottom.push_back(PlaneVertex(n, plane[0][n]));
+		}
+		if (k == k1 - 1)
+		{
+			for (int n = 0; n < planeSize; ++n)
+				if (plane[1][n] >= 0) top.push_back(PlaneVertex(n, plane[1][n]));
+		}
+
+		std::swap(plane[0], plane[1]);
+	}
 }
 
 CMarchingCubes::CMarchingCubes(CImageModel* img) : CGLImageRenderer(img)
@@ -94,7 +331,9 @@ CMarchingCubes::CMarchingCubes(CImageModel* img) : CGLImageRenderer(img)
 
 	m_val = 0.5f;
 	m_oldVal = -1.f;
+	m_ref = 0.f;
 	m_bsmooth = true;
+	m_bsmoothMesh = true;
 	m_bcloseSurface = true;
 	m_binvertSpace = false;
 	m_col = GLColor(200, 185, 185);
@@ -155,10 +394,29 @@ void CMarchingCubes::SetCloseSurface(bool b)
 void CMarchingCubes::Update()
 {
 	UpdateData();
-	if (m_oldVal == m_val) return;
+
+	// the surface also changes when the display range of the image changes
+	if ((m_oldVal == m_val) && (IsoReference() == m_ref)) return;
 	Create();
 }
 
+//-----------------------------------------------------------------------------
+// The iso-value is relative to the display range of the image. This returns the
+// corresponding voxel value. Integer types are truncated, so that for 8-bit images
+// this gives the same value as before.
+float CMarchingCubes::IsoReference()
+{
+	CImageSource* src = GetImageModel()->GetImageSource();
+	if ((src == nullptr) || (src->Get3DImage() == nullptr)) return 0.f;
+	C3DImage& im3d = *src->Get3DImage();
+
+	double vmin, vmax;
+	im3d.GetDisplayRange(vmin, vmax);
+	float ref = (float)(vmin + m_val*(vmax - vmin));
+	if (im3d.PixelType() != C3DImage::REAL_32) ref = floorf(ref);
+	return ref;
+}
+
 void CMarchingCubes::Create()
 {
 	UpdateData();
@@ -173,170 +431,155 @@ void CMarchingCubes::CreateSurface()
 
 	CImageModel& im = *GetImageModel();
 	CImageSource* src = im.GetImageSource();
-	if (src == nullptr) return;
-	C3DImage& im3d = *src->Get3DImage();
+	if ((src == nullptr) || (src->GetBrickedImage() == nullptr)) return;
+
+	// Coarser levels are never assembled as a whole. Each slab copies the layers
+	// it needs, and the caps read the bricks directly.
+	CBrickedImage& bricks = *src->GetBrickedImage();
+	C3DImage& im3d = *bricks.GetImage();
+	int l = bricks.FindLevel(MAX_GRID_SIZE);
+	auto voxel = [&](int i, int j, int k) { return (l == 0 ? im3d.voxel(i, j, k) : bricks.voxel(l, i, j, k)); };
 
 	BOX b = im.GetBoundingBox();
 
-	int NX = im3d.Width();
-	int NY = im3d.Height();
-	int NZ = im3d.Depth();
+	int NX = bricks.Width(l);
+	int NY = bricks.Height(l);
+	int NZ = bricks.Depth(l);
 	if ((NX == 1) || (NY == 1) || (NZ == 1)) return;
 
 	float dxi = (b.x1 - b.x0) / (NX - 1);
 	float dyi = (b.y1 - b.y0) / (NY - 1);
 	float dzi = (b.z1 - b.z0) / (NZ - 1);
 
-	Byte ref = (Byte)(m_val * 255.f);
-	float fref = (float)ref;
+	float ref = IsoReference();
 	m_ref = ref;
 
 	C3DGradientMap grad(im3d, b);
 
+	MCGrid grid;
+	grid.box = b;
+	grid.dx = dxi; grid.dy = dyi; grid.dz = dzi;
+	grid.NX = NX; grid.NY = NY; grid.NZ = NZ;
+	grid.ref = ref;
+	grid.smooth = m_bsmooth;
+	grid.invert = m_binvertSpace;
+	m_bsmoothMesh = m_bsmooth;
+
+	// process the voxel layers in slabs
+	int slabs = (NZ - 2) / SLAB_SIZE + 1;
+	vector<TriMesh> slab(slabs);
+	vector< vector<PlaneVertex> > bottom(slabs), top(slabs);
+
 	#pragma omp parallel default(shared)
 	{
-		const int MAX_FACES = 1000000;
-		TriMesh temp;
-		temp.Resize(MAX_FACES);
-		int nfaces = 0;
-		Byte val[8];
-		vec3f r[8], g[8];
-
-		#pragma omp for schedule(dynamic, 5)
-		for (int k = 0; k < NZ - 1; ++k)
+		vector<int> cache(4 * NX*NY + 2 * NX);
+		C3DImage layers;
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int n = 0; n < slabs; ++n)
 		{
-			for (int j = 0; j < NY - 1; ++j)
+			int k0 = n*SLAB_SIZE;
+			int k1 = (k0 + SLAB_SIZE < NZ - 1 ? k0 + SLAB_SIZE : NZ - 1);
+			if (l == 0) CreateSlab(grid, im3d, grad, 0, k0, k1, slab[n], bottom[n], top[n], cache);
+			else
 			{
-				for (int i = 0; i < NX - 1; ++i)
+				// the gradient needs one more layer on either side
+				int ko = (k0 > 0 ? k0 - 1 : 0);
+				int ke = (k1 + 2 < NZ ? k1 + 2 : NZ);
+				bool bok = false;
+				#pragma omp critical(MarchingCubes_bricks)
+				bok = bricks.GetLayers(l, ko, ke, layers);
+				if (bok)
 				{
-					// get the voxel's values
-					if (i == 0)
-					{
-						val[0] = im3d.value(i, j, k);
-						val[3] = im3d.value(i, j + 1, k);
-						val[4] = im3d.value(i, j, k + 1);
-						val[7] = im3d.value(i, j + 1, k + 1);
-					}
-
-					val[1] = im3d.value(i + 1, j, k);
-					val[2] = im3d.value(i + 1, j + 1, k);
-					val[5] = im3d.value(i + 1, j, k + 1);
-					val[6] = im3d.value(i + 1, j + 1, k + 1);
-
-					// calculate the case of the voxel
-					int ncase = 0;
-					if (m_binvertSpace)
-					{
-						if (val[0] < ref) ncase |= 0x01;
-						if (val[1] < ref) ncase |= 0x02;
-						if (val[2] < ref) ncase |= 0x04;
-						if (val[3] < ref) ncase |= 0x08;
-						if (val[4] < ref) ncase |= 0x10;
-						if (val[5] < ref) ncase |= 0x20;
-						if (val[6] < ref) ncase |= 0x40;
-						if (val[7] < ref) ncase |= 0x80;
-					}
-					else
-					{
-						if (val[0] > ref) ncase |= 0x01;
-						if (val[1] > ref) ncase |= 0x02;
-						if (val[2] > ref) ncase |= 0x04;
-						if (val[3] > ref) ncase |= 0x08;
-						if (val[4] > ref) ncase |= 0x10;
-						if (val[5] > ref) ncase |= 0x20;
-						if (val[6] > ref) ncase |= 0x40;
-						if (val[7] > ref) ncase |= 0x80;
-					}
-
-					// cases 0 and 255 don't generate triangles, so don't waste time on these
-					if ((ncase != 0) && (ncase != 255))
-					{
-						// get the corners
-						r[0].x = b.x0 + i      *dxi; r[0].y = b.y0 + j      *dyi; r[0].z = b.z0 + k      *dzi;
-						r[1].x = b.x0 + (i + 1)*dxi; r[1].y = b.y0 + j      *dyi; r[1].z = b.z0 + k      *dzi;
-						r[2].x = b.x0 + (i + 1)*dxi; r[2].y = b.y0 + (j + 1)*dyi; r[2].z = b.z0 + k      *dzi;
-						r[3].x = b.x0 + i      *dxi; r[3].y = b.y0 + (j + 1)*dyi; r[3].z = b.z0 + k      *dzi;
-						r[4].x = b.x0 + i      *dxi; r[4].y = b.y0 + j      *dyi; r[4].z = b.z0 + (k + 1)*dzi;
-						r[5].x = b.x0 + (i + 1)*dxi; r[5].y = b.y0 + j      *dyi; r[5].z = b.z0 + (k + 1)*dzi;
-						r[6].x = b.x0 + (i + 1)*dxi; r[6].y = b.y0 + (j + 1)*dyi; r[6].z = b.z0 + (k + 1)*dzi;
-						r[7].x = b.x0 + i      *dxi; r[7].y = b.y0 + (j + 1)*dyi; r[7].z = b.z0 + (k + 1)*dzi;
-
-						// calculate gradients
-						if (m_bsmooth)
-						{
-							g[0] = grad.Value(i, j, k);
-							g[1] = grad.Value(i + 1, j, k);
-							g[2] = grad.Value(i + 1, j + 1, k);
-							g[3] = grad.Value(i, j + 1, k);
-							g[4] = grad.Value(i, j, k + 1);
-							g[5] = grad.Value(i + 1, j, k + 1);
-							g[6] = grad.Value(i + 1, j + 1, k + 1);
-							g[7] = grad.Value(i, j + 1, k + 1);
-						}
-
-						// loop over faces
-						int* pf = LUT[ncase];
-						for (int l = 0; l < 5; l++)
-						{
-							if (*pf == -1) break;
-
-							// calculate nodal positions
-							TriMesh::TRI& tri = temp.Face(nfaces++);
-							for (int m = 0; m < 3; m++)
-							{
-								int n1 = ET_HEX[pf[m]][0];
-								int n2 = ET_HEX[pf[m]][1];
-
-								float w = (fref - (float)val[n1]) / ((float)val[n2] - (float)val[n1]);
-								assert((w >= 0.f) && (w <= 1.f));
-
-								tri.m_node[m] = r[n1] * (1.f - w) + r[n2] * w;
+					BOX lb = b;
+					lb.z0 = b.z0 + ko*dzi;
+					lb.z1 = b.z0 + (ke - 1)*dzi;
+					C3DGradientMap layerGrad(layers, lb);
+					CreateSlab(grid, layers, layerGrad, ko, k0, k1, slab[n], bottom[n], top[n], cache);
+				}
+			}
+		}
+	}
 
-								if (m_bsmooth)
-								{
-									vec3f normal = g[n1] * (1.f - w) + g[n2] * w;
-									normal.Normalize();
-									tri.m_norm[m] = (m_binvertSpace ? -normal : normal);
-								}
-							}
+	// Weld the slabs. The vertices on a slab's bottom plane are the same as the
+	// vertices on the previous slab's top plane. These are marked as -2 - m, where
+	// m is the local index in the previous slab.
+	vector< vector<int> > nodeMap(slabs);
+	vector<int> uniqueNodes(slabs, 0);
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (int n = 0; n < slabs; ++n)
+	{
+		vector<int>& map = nodeMap[n];
+		map.assign(slab[n].Nodes(), -1);
+		int ndup = 0;
+		if (n > 0)
+		{
+			vector<PlaneVertex>& bot = bottom[n];
+			vector<PlaneVertex>& prv = top[n - 1];
+			size_t a = 0, c = 0;
+			while ((a < bot.size()) && (c < prv.size()))
+			{
+				if      (bot[a].first < prv[c].first) a++;
+				else if (bot[a].first > prv[c].first) c++;
+				else
+				{
+					map[bot[a].second] = -2 - prv[c].second;
+					ndup++;
+					a++; c++;
+				}
+			}
+		}
+		uniqueNodes[n] = slab[n].Nodes() - ndup;
+	}
 
-							if (m_bsmooth == false)
-							{
-								vec3f normal = (tri.m_node[1] - tri.m_node[0]) ^ (tri.m_node[2] - tri.m_node[0]);
-								normal.Normalize();
-								tri.m_norm[0] = normal;
-								tri.m_norm[1] = normal;
-								tri.m_norm[2] = normal;
-							}
+	vector<int> nodeOffset(slabs + 1, 0), faceOffset(slabs + 1, 0);
+	for (int n = 0; n < slabs; ++n)
+	{
+		nodeOffset[n + 1] = nodeOffset[n] + uniqueNodes[n];
+		faceOffset[n + 1] = faceOffset[n] + slab[n].Faces();
+	}
 
-							pf += 3;
+	// assign the global indices of the unique vertices
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (int n = 0; n < slabs; ++n)
+	{
+		vector<int>& map = nodeMap[n];
+		int m = nodeOffset[n];
+		for (size_t i = 0; i < map.size(); ++i)
+			if (map[i] == -1) map[i] = m++;
+	}
 
-							if (nfaces == MAX_FACES)
-							{
-								#pragma omp critical
-								m_mesh.Merge(temp, nfaces);
-								nfaces = 0;
-							}
-						}
-					}
+	// resolve the duplicate vertices and copy the slabs into the mesh
+	m_mesh.Resize(nodeOffset[slabs], faceOffset[slabs]);
+	#pragma omp parallel for schedule(dynamic, 1)
+	for (int n = 0; n < slabs; ++n)
+	{
+		TriMesh& sn = slab[n];
+		vector<int>& map = nodeMap[n];
+		for (int i = 0; i < sn.Nodes(); ++i)
+		{
+			if (map[i] < -1) map[i] = nodeMap[n - 1][-2 - map[i]];
+			else m_mesh.Node(map[i]) = sn.Node(i);
+		}
 
-					// keep this for next i
-					val[0] = val[1];
-					val[4] = val[5];
-					val[3] = val[2];
-					val[7] = val[6];
-				}
-			}
+		for (int i = 0; i < sn.Faces(); ++i)
+		{
+			TriMesh::FACE& fs = sn.Face(i);
+			TriMesh::FACE& fd = m_mesh.Face(faceOffset[n] + i);
+			fd.n[0] = map[fs.n[0]];
+			fd.n[1] = map[fs.n[1]];
+			fd.n[2] = map[fs.n[2]];
+			m_mesh.FaceNormal(faceOffset[n] + i) = sn.FaceNormal(i);
 		}
 
-		#pragma omp critical
-		m_mesh.Merge(temp, nfaces);
+		sn.Clear();
 	}
 
 	// create surface meshes
 	if (m_bcloseSurface)
 	{
-		Byte val[4];
+		TriMesh caps;
+		float val[4];
 		vec3f r[4];
 
 		// X-planes
@@ -351,10 +594,10 @@ void CMarchingCubes::CreateSurface()
 				for (int j = 0; j < NY - 1; ++j)
 				{
 					// get the pixel's values
-					val[0] = im3d.value(i, j, k);
-					val[1] = im3d.value(i, j + 1, k);
-					val[2] = im3d.value(i, j + 1, k + 1);
-					val[3] = im3d.value(i, j, k + 1);
+					val[0] = voxel(i, j, k);
+					val[1] = voxel(i, j + 1, k);
+					val[2] = voxel(i, j + 1, k + 1);
+					val[3] = voxel(i, j, k + 1);
 
 					// get the corners
 					r[0].x = x; r[0].y = b.y0 + j      *dyi; r[0].z = b.z0 + k*dzi;
@@ -363,7 +606,7 @@ void CMarchingCubes::CreateSurface()
 					r[3].x = x; r[3].y = b.y0 + j      *dyi; r[3].z = b.z0 + (k + 1)*dzi;
 
 					// add the triangles
-					AddSurfaceTris(val, r, faceNormal);
+					AddSurfaceTris(caps, val, r, faceNormal);
 				}
 			}
 		}
@@ -380,10 +623,10 @@ void CMarchingCubes::CreateSurface()
 				for (int i = 0; i < NX - 1; ++i)
 				{
 					// get the pixel's values
-					val[0] = im3d.value(i  , j, k);
-					val[1] = im3d.value(i+1, j, k);
-					val[2] = im3d.value(i+1, j, k + 1);
-					val[3] = im3d.value(i  , j, k + 1);
+					val[0] = voxel(i  , j, k);
+					val[1] = voxel(i+1, j, k);
+					val[2] = voxel(i+1, j, k + 1);
+					val[3] = voxel(i  , j, k + 1);
 
 					// get the corners
 					r[0].x = b.x0 + i    *dxi; r[0].y = y; r[0].z = b.z0 + k*dzi;
@@ -392,7 +635,7 @@ void CMarchingCubes::CreateSurface()
 					r[3].x = b.x0 + i    *dxi; r[3].y = y; r[3].z = b.z0 + (k + 1)*dzi;
 
 					// add the triangles
-					AddSurfaceTris(val, r, faceNormal);
+					AddSurfaceTris(caps, val, r, faceNormal);
 				}
 			}
 		}
@@ -409,10 +652,10 @@ void CMarchingCubes::CreateSurface()
 				for (int i = 0; i < NX - 1; ++i)
 				{
 					// get the pixel's values
-					val[0] = im3d.value(i    , j    , k);
-					val[1] = im3d.value(i + 1, j    , k);
-					val[2] = im3d.value(i + 1, j + 1, k);
-					val[3] = im3d.value(i    , j + 1, k);
+					val[0] = voxel(i    , j    , k);
+					val[1] = voxel(i + 1, j    , k);
+					val[2] = voxel(i + 1, j + 1, k);
+					val[3] = voxel(i    , j + 1, k);
 
 					// get the corners
 					r[0].x = b.x0 + i      *dxi; r[0].y = b.y0 + j      *dyi; r[0].z = z;
@@ -421,14 +664,16 @@ void CMarchingCubes::CreateSurface()
 					r[3].x = b.x0 + i      *dxi; r[3].y = b.y0 + (j + 1)*dyi; r[3].z = z;
 
 					// add the triangles
-					AddSurfaceTris(val, r, faceNormal);
+					AddSurfaceTris(caps, val, r, faceNormal);
 				}
 			}
 		}
+
+		m_mesh.Merge(caps);
 	}
 }
 
-void CMarchingCubes::AddSurfaceTris(Byte val[4], vec3f r[4], const vec3f& faceNormal)
+void CMarchingCubes::AddSurfaceTris(TriMesh& mesh, float val[4], vec3f r[4], const vec3f& faceNormal)
 {
 	// calculate the case of the voxel
 	int ncase = 0;
@@ -447,7 +692,7 @@ void CMarchingCubes::AddSurfaceTris(Byte val[4], vec3f r[4], const vec3f& faceNo
 		if (val[3] > m_ref) ncase |= 0x08;
 	}
 
-	float fref = (float)m_ref;
+	float fref = m_ref;
 
 	// loop over faces
 	int* pf = LUT2D_tri[ncase];
@@ -456,13 +701,13 @@ void CMarchingCubes::AddSurfaceTris(Byte val[4], vec3f r[4], const vec3f& faceNo
 		if (*pf == -1) break;
 
 		// calculate nodal positions
-		TriMesh::TRI tri;
+		int n[3];
 		for (int m = 0; m < 3; m++)
 		{
 			int node = pf[m];
 			if (node < 4)
 			{
-				tri.m_node[m] = r[node];
+				n[m] = mesh.AddNode(r[node], faceNormal);
 			}
 			else
 			{
@@ -470,13 +715,11 @@ void CMarchingCubes::AddSurfaceTris(Byte val[4], vec3f r[4], const vec3f& faceNo
 				int n2 = ET2D[node - 4][1];
 
 				float w = (fref - (float)val[n1]) / ((float)val[n2] - (float)val[n1]);
-				tri.m_node[m] = r[n1] * (1.f - w) + r[n2] * w;
+				n[m] = mesh.AddNode(r[n1] * (1.f - w) + r[n2] * w, faceNormal);
 			}
-
-			tri.m_norm[m] = faceNormal;
 		}
 
-		m_mesh.AddFace(tri);
+		mesh.AddFace(n[0], n[1], n[2], faceNormal);
 
 		pf += 3;
 	}
@@ -489,17 +732,35 @@ void CMarchingCubes::SetIsoValue(float v)
 
 void CMarchingCubes::Render(CGLContext& rc)
 {
+	if (m_mesh.Faces() == 0) return;
+
 	glColor3ub(m_col.r, m_col.g, m_col.b);
-	glBegin(GL_TRIANGLES);
-	for (int i = 0; i < m_mesh.Faces(); ++i)
+	if (m_bsmoothMesh)
 	{
-		TriMesh::TRI& face = m_mesh.Face(i);
-		glNormal3f(face.m_norm[0].x, face.m_norm[0].y, face.m_norm[0].z);
-		glVertex3f(face.m_node[0].x, face.m_node[0].y, face.m_node[0].z);
-		glNormal3f(face.m_norm[1].x, face.m_norm[1].y, face.m_norm[1].z);
-		glVertex3f(face.m_node[1].x, face.m_node[1].y, face.m_node[1].z);
-		glNormal3f(face.m_norm[2].x, face.m_norm[2].y, face.m_norm[2].z);
-		glVertex3f(face.m_node[2].x, face.m_node[2].y, face.m_node[2].z);
+		// the vertices are shared, so we can render directly from the mesh' arrays
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glVertexPointer(3, GL_FLOAT, sizeof(TriMesh::NODE), &m_mesh.Node(0).r);
+		glNormalPointer(GL_FLOAT, sizeof(TriMesh::NODE), &m_mesh.Node(0).n);
+		glDrawElements(GL_TRIANGLES, 3 * m_mesh.Faces(), GL_UNSIGNED_INT, m_mesh.Face(0).n);
+		glDisableClientState(GL_NORMAL_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
+	}
+	else
+	{
+		glBegin(GL_TRIANGLES);
+		for (int i = 0; i < m_mesh.Faces(); ++i)
+		{
+			TriMesh::FACE& face = m_mesh.Face(i);
+			vec3f& fn = m_mesh.FaceNormal(i);
+			vec3f& r0 = m_mesh.Node(face.n[0]).r;
+			vec3f& r1 = m_mesh.Node(face.n[1]).r;
+			vec3f& r2 = m_mesh.Node(face.n[2]).r;
+			glNormal3f(fn.x, fn.y, fn.z);
+			glVertex3f(r0.x, r0.y, r0.z);
+			glVertex3f(r1.x, r1.y, r1.z);
+			glVertex3f(r2.x, r2.y, r2.z);
+		}
+		glEnd();
 	}
-	glEnd();
 }
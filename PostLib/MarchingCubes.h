@@ -34,13 +34,20 @@ namespace Post {
 
 class CImageModel;
 
+// Indexed triangle mesh. Vertices that lie on the same voxel edge are shared
+// between the triangles that use them.
 class TriMesh
 {
 public:
-	struct TRI
+	struct NODE
 	{
-		vec3f	m_node[3];
-		vec3f	m_norm[3];
+		vec3f	r;	// position
+		vec3f	n;	// normal
+	};
+
+	struct FACE
+	{
+		int		n[3];	// node indices
 	};
 
 public:
@@ -48,19 +55,28 @@ public:
 
 	void Clear();
 
-	void Merge(TriMesh& tri, int ncount = -1);
+	// append another mesh. The node indices of the merged faces are offset.
+	void Merge(TriMesh& tri);
 
-	void Reserve(size_t nsize);
+	void Resize(size_t nodes, size_t faces);
 
-	void Resize(size_t nsize);
+	int Nodes() const { return (int)m_Node.size(); }
+	NODE& Node(int i) { return m_Node[i]; }
 
-	TRI& Face(int i) { return m_Face[i]; }
 	int Faces() const { return (int)m_Face.size(); }
+	FACE& Face(int i) { return m_Face[i]; }
 
-	void AddFace(TRI& tri) { m_Face.push_back(tri); }
+	// face normal (used for flat shading)
+	vec3f& FaceNormal(int i) { return m_Norm[i]; }
+
+	int AddNode(const vec3f& r, const vec3f& n);
+
+	void AddFace(int n0, int n1, int n2, const vec3f& fn);
 
 protected:
-	std::vector<TRI>	m_Face;
+	std::vector<NODE>	m_Node;
+	std::vector<FACE>	m_Face;
+	std::vector<vec3f>	m_Norm;
 };
 
 class CMarchingCubes : public CGLImageRenderer
@@ -95,10 +111,12 @@ public:
 	bool UpdateData(bool bsave = true) override;
 
 private:
-	void AddSurfaceTris(Byte val[4], vec3f r[4], const vec3f& faceNormal);
+	void AddSurfaceTris(TriMesh& mesh, float val[4], vec3f r[4], const vec3f& faceNormal);
 
 	void CreateSurface();
 
+	float IsoReference();
+
 private:
 	float	m_val, m_oldVal;		// iso-surface value
 	bool	m_bsmooth;
@@ -106,7 +124,8 @@ private:
 	bool	m_binvertSpace;
 	GLColor	m_col;
 	TriMesh	m_mesh;
+	bool	m_bsmoothMesh;	// m_mesh was built with smooth normals
 
-	Byte m_ref;
+	float	m_ref;		// iso-value in voxel units
 };
 }
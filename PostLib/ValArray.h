@@ -37,12 +37,18 @@ public:
 
 	int itemSize(int n) const { return m_index[n + 1] - m_index[n]; }
 
+	// total number of values
+	int values() const { return (int) m_data.size(); }
+
 	// append an item with n values
 	void append(int n);
 
 	float value(int item, int index) const { return m_data[m_index[item] + index]; }
 	float& value(int item, int index) { return m_data[m_index[item] + index]; }
 
+	// all values, stored item by item
+	std::vector<float>& data() { return m_data; }
+
 protected:
 	std::vector<int>	m_index;
 	std::vector<float>	m_data;
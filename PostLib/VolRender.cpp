@@ -33,16 +33,116 @@ SOFTWARE.*/
 #include <OpenGL/gl.h>
 #endif
 #ifdef LINUX
+#define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
 #endif
 #include "VolRender.h"
 #include <GLLib/GLContext.h>
 #include "ImageModel.h"
+#include <ImageLib/BrickedImage.h>
 #include "ColorMap.h"
 #include <ImageLib/3DGradientMap.h>
 #include <sstream>
 using namespace Post;
 
+// The Windows headers only declare OpenGL 1.1, so the 3D texture renderer is only
+// available when the shader functions are declared by the system headers.
+#if defined(GL_VERSION_2_0) && !defined(WIN32)
+#define USE_3D_TEXTURE
+#endif
+
+#ifdef USE_3D_TEXTURE
+// Larger images are uploaded from a coarser level of the bricked image.
+static const int MAX_TEXTURE_SIZE_3D = 1024;
+
+// The transfer function is applied per fragment, so the image data only needs
+// to be uploaded once. The lighting is evaluated from the gradient of the volume.
+static const char* szvolVS = \
+"varying vec3 tc;\n"
+"void main()\n"
+"{\n"
+"	tc = gl_MultiTexCoord0.xyz;\n"
+"	gl_FrontColor = gl_Color;\n"
+"	gl_Position = ftransform();\n"
+"}\n";
+
+static const char* szvolFS = \
+"uniform sampler3D vol;\n"
+"uniform sampler1D tf;\n"
+"uniform int lighting;\n"
+"uniform vec3 light;\n"
+"uniform vec3 texel;\n"
+"uniform vec3 gradScale;\n"
+"uniform float shade;\n"
+"uniform vec3 amb;\n"
+"uniform vec3 spc;\n"
+"uniform vec2 window;\n"
+"varying vec3 tc;\n"
+"void main()\n"
+"{\n"
+"	float v = clamp((texture3D(vol, tc).r - window.x)*window.y, 0.0, 1.0);\n"
+"	vec4 c = texture1D(tf, v*(255.0/256.0) + 0.5/256.0);\n"
+"	if (lighting != 0)\n"
+"	{\n"
+"		vec3 g;\n"
+"		g.x = texture3D(vol, tc + vec3(texel.x, 0.0, 0.0)).r - texture3D(vol, tc - vec3(texel.x, 0.0, 0.0)).r;\n"
+"		g.y = texture3D(vol, tc + vec3(0.0, texel.y, 0.0)).r - texture3D(vol, tc - vec3(0.0, texel.y, 0.0)).r;\n"
+"		g.z = texture3D(vol, tc + vec3(0.0, 0.0, texel.z)).r - texture3D(vol, tc - vec3(0.0, 0.0, texel.z)).r;\n"
+"		g *= gradScale;\n"
+"		float L = length(g);\n"
+"		float a = (L > 0.0 ? max(dot(g, light) / L, 0.0) : 0.0);\n"
+"		float w = shade*a + (1.0 - shade);\n"
+"		float s = shade*a*a;\n"
+"		c.rgb = (c.rgb*(1.0 - s) + s*spc)*w + amb*(1.0 - w);\n"
+"	}\n"
+"	gl_FragColor = vec4(c.rgb, c.a*gl_Color.a);\n"
+"}\n";
+
+static GLuint compileShader(GLenum type, const char* szsrc)
+{
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &szsrc, 0);
+	glCompileShader(shader);
+
+	GLint status = 0;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status == 0)
+	{
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static GLuint buildVolumeProgram()
+{
+	GLuint vs = compileShader(GL_VERTEX_SHADER, szvolVS);
+	GLuint fs = compileShader(GL_FRAGMENT_SHADER, szvolFS);
+	if ((vs == 0) || (fs == 0))
+	{
+		if (vs) glDeleteShader(vs);
+		if (fs) glDeleteShader(fs);
+		return 0;
+	}
+
+	GLuint prog = glCreateProgram();
+	glAttachShader(prog, vs);
+	glAttachShader(prog, fs);
+	glLinkProgram(prog);
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+
+	GLint status = 0;
+	glGetProgramiv(prog, GL_LINK_STATUS, &status);
+	if (status == 0)
+	{
+		glDeleteProgram(prog);
+		return 0;
+	}
+	return prog;
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -67,6 +167,7 @@ CVolRender::CVolRender(CImageModel* img) : CGLImageRenderer(img)
 	AddColorParam(GLColor::White(), "Ambient color");
 	AddColorParam(GLColor::White(), "Specular color");
 	AddVecParam(vec3d(1, 1, 1), "Light direction");
+	AddBoolParam(true, "3D texture");
 
 	m_pImx = m_pImy = m_pImz = 0;
 	m_sliceX = m_sliceY = m_sliceZ = 0;
@@ -80,6 +181,18 @@ CVolRender::CVolRender(CImageModel* img) : CGLImageRenderer(img)
 
 	m_texID = 0;
 
+	m_b3DTexture = true;
+	m_tex3D = 0;
+	m_texTF = 0;
+	m_prog = 0;
+	m_bupload3D = false;
+	m_bupdateTF = false;
+	m_b3DFailed = false;
+	m_b3DResampled = false;
+	m_texScale = 1.f;
+	m_vmin = 0.0;
+	m_vmax = 255.0;
+
 	m_alpha = 0.2;
 	m_I0 = 0;
 	m_I1 = 255;
@@ -120,6 +233,15 @@ bool CVolRender::UpdateData(bool bsave)
 		m_spc = GetColorValue(SPECULAR);
 		m_light = GetVecValue(LIGHT_POS);
 
+		// switching the render mode requires different image data
+		bool b3d = GetBoolValue(TEXTURE_3D);
+		if (b3d != m_b3DTexture)
+		{
+			m_b3DTexture = b3d;
+			Create();
+			return false;
+		}
+
 		UpdateVolRender();
 	}
 	else
@@ -137,6 +259,7 @@ bool CVolRender::UpdateData(bool bsave)
 		SetColorValue(AMBIENT, m_amb);
 		SetColorValue(SPECULAR, m_spc);
 		SetVecValue(LIGHT_POS, m_light);
+		SetBoolValue(TEXTURE_3D, m_b3DTexture);
 	}
 
 	return false;
@@ -182,6 +305,30 @@ void CVolRender::Clear()
 	delete [] m_pImx; m_pImx = 0; m_nx = 0;
 	delete [] m_pImy; m_pImy = 0; m_ny = 0;
 	delete [] m_pImz; m_pImz = 0; m_nz = 0;
+
+	m_im3d.CleanUp();
+	m_imLevel.CleanUp();
+	m_att.CleanUp();
+	m_bcalc_lighting = true;
+
+	// release the OpenGL objects (they are recreated when needed)
+	if (m_texID) { glDeleteTextures(1, &m_texID); m_texID = 0; }
+	if (m_tex3D) { glDeleteTextures(1, &m_tex3D); m_tex3D = 0; }
+	if (m_texTF) { glDeleteTextures(1, &m_texTF); m_texTF = 0; }
+#ifdef USE_3D_TEXTURE
+	if (m_prog) { glDeleteProgram(m_prog); m_prog = 0; }
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// See if the volume is rendered from a single 3D texture
+bool CVolRender::Use3DTexture() const
+{
+#ifdef USE_3D_TEXTURE
+	return (m_b3DTexture && (m_b3DFailed == false));
+#else
+	return false;
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -202,14 +349,33 @@ void CVolRender::Create()
 	// clear the old data
 	Clear();
 
+	// the display range the data is prepared for
+	im3d.GetDisplayRange(m_vmin, m_vmax);
+
+	// The 3D texture is uploaded directly from the image data, so no copies are needed.
+	if (Use3DTexture())
+	{
+		m_nx = w;
+		m_ny = h;
+		m_nz = d;
+		m_ax = m_ay = m_az = 1.0;
+		m_bupload3D = true;
+		Update();
+		return;
+	}
+
 	// find new image dimenions
 	m_nx = closest_pow2(w);
 	m_ny = closest_pow2(h);
 	m_nz = closest_pow2(d);
 	m_im3d.Create(m_nx, m_ny, m_nz);
 
-	// resample image
-	im3d.StretchBlt(m_im3d);
+	// resample image (from a coarser level if the image is much larger)
+	int nmax = m_nx;
+	if (m_ny > nmax) nmax = m_ny;
+	if (m_nz > nmax) nmax = m_nz;
+	CBrickedImage& bricks = *GetImageModel()->GetImageSource()->GetBrickedImage();
+	bricks.StretchBlt(m_im3d, bricks.FindLevel(2 * nmax));
 
 	// allocate slices
 	m_sliceX = new CImage[m_nx];
@@ -286,7 +452,7 @@ void CVolRender::CalcAttenuation()
 				vec3d f = map.Value(i, j, k); f.Normalize();
 				double a = f*l;
 				if (a < 0.0) a = 0.0;
-				m_att.value(i, j, k) = (Byte)(255.0*a);
+				m_att.GetBytes()[(k*m_ny + j)*m_nx + i] = (Byte)(255.0*a);
 			}
 	}
 }
@@ -296,13 +462,38 @@ void CVolRender::CalcAttenuation()
 void CVolRender::Update()
 {
 	UpdateData();
+
+	// The 3D texture applies the display range in the shader, unless it had to be
+	// resampled. The slices always have to be rebuilt.
+	if (DisplayRangeChanged())
+	{
+		if (Use3DTexture() == false) { Create(); return; }
+		if (m_b3DResampled) m_bupload3D = true;
+	}
+
 	UpdateVolRender();
 }
 
+//-----------------------------------------------------------------------------
+// See if the display range of the image differs from the one the data was prepared for
+bool CVolRender::DisplayRangeChanged()
+{
+	CImageSource* src = GetImageModel()->GetImageSource();
+	if ((src == nullptr) || (src->Get3DImage() == nullptr)) return false;
+
+	double vmin, vmax;
+	src->Get3DImage()->GetDisplayRange(vmin, vmax);
+	if ((vmin == m_vmin) && (vmax == m_vmax)) return false;
+
+	m_vmin = vmin;
+	m_vmax = vmax;
+	return true;
+}
+
 void CVolRender::UpdateVolRender()
 {
 	// calculate attenuation factors
-	if (m_bcalc_lighting)
+	if (m_bcalc_lighting && (Use3DTexture() == false))
 	{
 		CalcAttenuation();
 		m_bcalc_lighting = false;
@@ -326,7 +517,9 @@ void CVolRender::UpdateVolRender()
 		m_LUTC[3][i] = (i == 0 ? m_Amin : (i == 255 ? m_Amax : (m_A0 + i*(m_A1 - m_A0) / 255)));
 	}
 
-	UpdateRGBImages();
+	// the 3D texture only needs the new transfer function
+	if (Use3DTexture()) m_bupdateTF = true;
+	else UpdateRGBImages();
 }
 
 void CVolRender::UpdateRGBImages()
@@ -447,6 +640,15 @@ void CVolRender::DepthCueZ(CRGBAImage& im, int n)
 //! Render textures
 void CVolRender::Render(CGLContext& rc)
 {
+	if (Use3DTexture())
+	{
+		if (Render3D(rc)) return;
+
+		// fall back to the 2D slices
+		m_b3DFailed = true;
+		Create();
+	}
+
 	if (m_texID == 0)
 	{
 		glGenTextures(1, &m_texID);
@@ -595,3 +797,234 @@ void CVolRender::RenderZ(int inc)
 		glEnd();
 	}
 }
+
+//-----------------------------------------------------------------------------
+// Render the volume from the 3D texture. Returns false if the 3D texture could
+// not be created.
+bool CVolRender::Render3D(CGLContext& rc)
+{
+#ifdef USE_3D_TEXTURE
+	if (m_prog == 0)
+	{
+		m_prog = buildVolumeProgram();
+		if (m_prog == 0) return false;
+	}
+
+	if (m_tex3D == 0)
+	{
+		glGenTextures(1, &m_tex3D);
+		glBindTexture(GL_TEXTURE_3D, m_tex3D);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+		glGenTextures(1, &m_texTF);
+		glBindTexture(GL_TEXTURE_1D, m_texTF);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_1D, 0);
+	}
+	else glBindTexture(GL_TEXTURE_3D, m_tex3D);
+
+	// upload the image data
+	if (m_bupload3D)
+	{
+		CImageSource* src = GetImageModel()->GetImageSource();
+		if ((src == nullptr) || (src->GetBrickedImage() == nullptr)) return false;
+
+		// large images are uploaded from a coarser level that fits in a texture
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+		if (maxSize > MAX_TEXTURE_SIZE_3D) maxSize = MAX_TEXTURE_SIZE_3D;
+		CBrickedImage& bricks = *src->GetBrickedImage();
+		C3DImage* im = bricks.GetImage();
+		int l = bricks.FindLevel(maxSize);
+		m_nx = bricks.Width(l);
+		m_ny = bricks.Height(l);
+		m_nz = bricks.Depth(l);
+
+		// The voxels are uploaded in their native type, so that the display range can be
+		// applied in the shader. Float images need float textures.
+		GLint ifmt = GL_LUMINANCE8;
+		GLenum fmt = GL_LUMINANCE;
+		GLenum type = GL_UNSIGNED_BYTE;
+		m_texScale = 255.f;
+		m_b3DResampled = false;
+		switch (im->PixelType())
+		{
+		case C3DImage::UINT_16: ifmt = GL_LUMINANCE16; type = GL_UNSIGNED_SHORT; m_texScale = 65535.f; break;
+		case C3DImage::REAL_32:
+#ifdef GL_R32F
+			ifmt = GL_R32F; fmt = GL_RED; type = GL_FLOAT; m_texScale = 1.f;
+#else
+			m_b3DResampled = true;
+#endif
+			break;
+		}
+
+		while (glGetError() != GL_NO_ERROR);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		if (m_b3DResampled)
+		{
+			// the resampled data is mapped to the display range
+			m_im3d.Create(m_nx, m_ny, m_nz);
+			bricks.StretchBlt(m_im3d, l);
+			glTexImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE8, m_nx, m_ny, m_nz, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, m_im3d.GetBytes());
+		}
+		else if (l == 0) glTexImage3D(GL_TEXTURE_3D, 0, ifmt, m_nx, m_ny, m_nz, 0, fmt, type, im->GetBytes());
+		else
+		{
+			// a coarser level is uploaded one layer of bricks at a time, so that it
+			// never needs to be held in memory as a whole
+			glTexImage3D(GL_TEXTURE_3D, 0, ifmt, m_nx, m_ny, m_nz, 0, fmt, type, 0);
+			int nk = bricks.BrickSize();
+			for (int k0 = 0; k0 < m_nz; k0 += nk)
+			{
+				int k1 = (k0 + nk < m_nz ? k0 + nk : m_nz);
+				if (bricks.GetLayers(l, k0, k1, m_imLevel) == false) break;
+				glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, k0, m_nx, m_ny, k1 - k0, fmt, type, m_imLevel.GetBytes());
+			}
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		if (glGetError() != GL_NO_ERROR) return false;
+
+		m_im3d.CleanUp();
+		m_imLevel.CleanUp();
+		m_bupload3D = false;
+		m_bupdateTF = true;
+	}
+
+	// upload the transfer function
+	if (m_bupdateTF)
+	{
+		Byte tf[256][4];
+		for (int i = 0; i < 256; ++i)
+		{
+			int val = m_LUT[i];
+			tf[i][0] = (Byte)m_LUTC[0][val];
+			tf[i][1] = (Byte)m_LUTC[1][val];
+			tf[i][2] = (Byte)m_LUTC[2][val];
+			tf[i][3] = (Byte)m_LUTC[3][val];
+		}
+
+		glBindTexture(GL_TEXTURE_1D, m_texTF);
+		glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, tf);
+		glBindTexture(GL_TEXTURE_1D, 0);
+		m_bupdateTF = false;
+	}
+
+	const BOX& box = GetImageModel()->GetBoundingBox();
+
+	glPushAttrib(GL_ENABLE_BIT);
+	glDisable(GL_LIGHTING);
+
+	glUseProgram(m_prog);
+	glUniform1i(glGetUniformLocation(m_prog, "vol"), 0);
+	glUniform1i(glGetUniformLocation(m_prog, "tf"), 1);
+	glUniform1i(glGetUniformLocation(m_prog, "lighting"), (m_blight ? 1 : 0));
+
+	// map the display range to [0,1]
+	float lo = 0.f, scale = 1.f;
+	if (m_b3DResampled == false)
+	{
+		lo = (float)(m_vmin / m_texScale);
+		float hi = (float)(m_vmax / m_texScale);
+		scale = (hi > lo ? 1.f / (hi - lo) : 0.f);
+	}
+	glUniform2f(glGetUniformLocation(m_prog, "window"), lo, scale);
+	if (m_blight)
+	{
+		vec3d l = m_light; l.Normalize();
+		double W = (box.Width () > 0 ? box.Width () : 1.0);
+		double H = (box.Height() > 0 ? box.Height() : 1.0);
+		double D = (box.Depth () > 0 ? box.Depth () : 1.0);
+		glUniform3f(glGetUniformLocation(m_prog, "light"), (float)l.x, (float)l.y, (float)l.z);
+		glUniform3f(glGetUniformLocation(m_prog, "texel"), 1.f / m_nx, 1.f / m_ny, 1.f / m_nz);
+		glUniform3f(glGetUniformLocation(m_prog, "gradScale"), (float)((m_nx - 1) / W), (float)((m_ny - 1) / H), (float)((m_nz - 1) / D));
+		glUniform1f(glGetUniformLocation(m_prog, "shade"), (float)m_shadeStrength);
+		glUniform3f(glGetUniformLocation(m_prog, "amb"), m_amb.r / 255.f, m_amb.g / 255.f, m_amb.b / 255.f);
+		glUniform3f(glGetUniformLocation(m_prog, "spc"), m_spc.r / 255.f, m_spc.g / 255.f, m_spc.b / 255.f);
+	}
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_1D, m_texTF);
+	glActiveTexture(GL_TEXTURE0);
+
+	vec3d r(0, 0, 1);
+	quatd q = rc.m_q;
+	q.Inverse().RotateVector(r);
+
+	double x = fabs(r.x);
+	double y = fabs(r.y);
+	double z = fabs(r.z);
+
+	if ((x > y) && (x > z)) { RenderSlices3D(0, r.x > 0 ? 1 : -1); }
+	if ((y > x) && (y > z)) { RenderSlices3D(1, r.y > 0 ? 1 : -1); }
+	if ((z > y) && (z > x)) { RenderSlices3D(2, r.z > 0 ? 1 : -1); }
+
+	glUseProgram(0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_1D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_3D, 0);
+
+	glPopAttrib();
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// Draw the slices through the 3D texture along the axis (0 = x, 1 = y, 2 = z).
+// The texture coordinates address the texel centers.
+void CVolRender::RenderSlices3D(int axis, int inc)
+{
+	int n[3] = { m_nx, m_ny, m_nz };
+	double a = m_alpha * (axis == 0 ? m_ax : (axis == 1 ? m_ay : m_az));
+	glColor4d(1, 1, 1, a);
+
+	const BOX& box = GetImageModel()->GetBoundingBox();
+	double r0[3] = { box.x0, box.y0, box.z0 };
+	double r1[3] = { box.x1, box.y1, box.z1 };
+
+	// in-plane axes
+	int a1 = (axis + 1) % 3;
+	int a2 = (axis + 2) % 3;
+	double s0 = 0.5 / n[a1], s1 = 1.0 - s0;
+	double t0 = 0.5 / n[a2], t1 = 1.0 - t0;
+
+	int N = n[axis];
+	double f = (N == 1 ? 1.0 : 1.0 / (N - 1.0));
+
+	int i0, i1;
+	if (inc == 1) { i0 = 0; i1 = N; }
+	else { i0 = N - 1; i1 = -1; }
+
+	glBegin(GL_QUADS);
+	for (int i = i0; i != i1; i += inc)
+	{
+		double tc[4][3], r[4][3];
+		for (int j = 0; j < 4; ++j)
+		{
+			tc[j][axis] = (i + 0.5) / N;
+			r[j][axis] = r0[axis] + i*(r1[axis] - r0[axis])*f;
+		}
+
+		tc[0][a1] = s0; tc[0][a2] = t0; r[0][a1] = r0[a1]; r[0][a2] = r0[a2];
+		tc[1][a1] = s1; tc[1][a2] = t0; r[1][a1] = r1[a1]; r[1][a2] = r0[a2];
+		tc[2][a1] = s1; tc[2][a2] = t1; r[2][a1] = r1[a1]; r[2][a2] = r1[a2];
+		tc[3][a1] = s0; tc[3][a2] = t1; r[3][a1] = r0[a1]; r[3][a2] = r1[a2];
+
+		for (int j = 0; j < 4; ++j)
+		{
+			glTexCoord3dv(tc[j]);
+			glVertex3dv(r[j]);
+		}
+	}
+	glEnd();
+}
@@ -37,7 +37,7 @@ class CImageModel;
 
 class CVolRender : public CGLImageRenderer
 {
-	enum { ALPHA_SCALE, MIN_INTENSITY, MAX_INTENSITY, MIN_ALPHA, MAX_ALPHA, AMIN, AMAX, COLOR_MAP, LIGHTING, LIGHTING_STRENGTH, AMBIENT, SPECULAR, LIGHT_POS };
+	enum { ALPHA_SCALE, MIN_INTENSITY, MAX_INTENSITY, MIN_ALPHA, MAX_ALPHA, AMIN, AMAX, COLOR_MAP, LIGHTING, LIGHTING_STRENGTH, AMBIENT, SPECULAR, LIGHT_POS, TEXTURE_3D };
 
 public:
 	CVolRender(CImageModel* img);
@@ -66,6 +66,11 @@ protected:
 	void RenderY(int inc);
 	void RenderZ(int inc);
 
+	// render the volume from a single 3D texture
+	bool Use3DTexture() const;
+	bool Render3D(CGLContext& rc);
+	void RenderSlices3D(int axis, int inc);
+
 	void Colorize(CRGBAImage& imd, CImage& ims);
 
 	void CalcAttenuation();
@@ -76,6 +81,8 @@ protected:
 	void UpdateVolRender();
 	void UpdateRGBImages();
 
+	bool DisplayRangeChanged();
+
 public:
 	Post::CColorTexture	m_Col;		//!< color texture
 	GLColor	m_amb;				//!< ambient color
@@ -86,9 +93,11 @@ public:
 	double	m_alpha;			// alpha scale factor
 	double	m_shadeStrength;
 	bool	m_blight;			// use lighting
+	bool	m_b3DTexture;		// use a 3D texture instead of 2D slices
 
 protected:
 	C3DImage		m_im3d;	// resampled 3D image data
+	C3DImage		m_imLevel;	// layers of a coarser level that are being uploaded
 	C3DImage		m_att;	// attenuation map (for lighting)
 
 	CImage*	m_sliceX;
@@ -100,6 +109,16 @@ protected:
 	CRGBAImage*	m_pImz;	// Image array in x-direction
 	unsigned int m_texID;
 
+	unsigned int	m_tex3D;	// 3D texture with the image data
+	unsigned int	m_texTF;	// transfer function (1D texture)
+	unsigned int	m_prog;		// shader program for the 3D texture
+	bool	m_bupload3D;		// image data needs to be uploaded
+	bool	m_bupdateTF;		// transfer function needs to be uploaded
+	bool	m_b3DFailed;		// 3D texture could not be used
+	bool	m_b3DResampled;		// the 3D texture holds the resampled 8-bit data
+	float	m_texScale;			// native voxel value of a texture value of 1
+	double	m_vmin, m_vmax;		// display range the image data was prepared for
+
 	int m_nx;	// nr of images in x-direction
 	int m_ny;	// nr of images in y-direction
 	int	m_nz;	// nr of images in z-direction
@@ -29,8 +29,23 @@ SOFTWARE.*/
 #include "FEMeshData_T.h"
 #include <MeshLib/MeshMetrics.h>
 #include <MeshLib/MeshTools.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 using namespace Post;
 
+//-----------------------------------------------------------------------------
+// nr of threads used by the field evaluation loops below
+static int evalThreads()
+{
+#ifdef _OPENMP
+	int n = FEPostModel::GetEvalThreads();
+	return (n > 0 ? n : omp_get_max_threads());
+#else
+	return 1;
+#endif
+}
+
 //-----------------------------------------------------------------------------
 // extract a component from a vector
 float component(const vec3f& v, int n)
@@ -168,7 +183,7 @@ bool FEPostModel::IsValidFieldCode(int nfield, int nstate)
 	if ((nstate < 0) || (nstate >= GetStates())) return false;
 
 	// get the state info
-	FEState& state = *m_State[nstate];
+	FEState& state = *GetState(nstate);
 
 	// get the data field
 	int ndata = FIELD_CODE(nfield);
@@ -186,25 +201,71 @@ bool FEPostModel::IsValidFieldCode(int nfield, int nstate)
 bool FEPostModel::Evaluate(int nfield, int ntime, bool breset)
 {
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FEPostMesh* mesh = state.GetFEMesh();
 	if (mesh->Nodes() == 0) return false;
 
 	// make sure that we have to reevaluate
 	if ((state.m_nField != nfield) || breset)
 	{
+		// Keep the values of the current field, in case we switch back to it.
+		// After a reset, none of the values can be reused.
+		if (breset) state.ClearFieldCache();
+		else state.CacheFieldValues();
+
+		// see if this field was evaluated before
+		if (state.RestoreFieldValues(nfield)) return true;
+
 		// store the field variable
 		state.m_nField = nfield;
 
+		// the items are evaluated from multiple threads, so the state must stay in memory
+		PinState(ntime);
 		if      (IS_NODE_FIELD(nfield)) EvalNodeField(ntime, nfield);
 		else if (IS_ELEM_FIELD(nfield)) EvalElemField(ntime, nfield);
 		else if (IS_FACE_FIELD(nfield)) EvalFaceField(ntime, nfield);
 //		else assert(false);
+		UnpinState(ntime);
 	}
 
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Evaluate a component of a nodal field for all the nodes at once. This is only
+// possible for data that supports it (e.g. math fields), otherwise it returns false.
+template <typename T> static bool evalAllNodes(Post::FEMeshData& rd, int ncomp, vector<float>& val)
+{
+	FENodeData_T<T>& df = dynamic_cast<FENodeData_T<T>&>(rd);
+	vector<T> v;
+	if (df.eval_all(v) == false) return false;
+	val.resize(v.size());
+	for (size_t i = 0; i < v.size(); ++i) val[i] = component(v[i], ncomp);
+	return true;
+}
+
+template <> bool evalAllNodes<float>(Post::FEMeshData& rd, int ncomp, vector<float>& val)
+{
+	FENodeData_T<float>& df = dynamic_cast<FENodeData_T<float>&>(rd);
+	return df.eval_all(val);
+}
+
+static bool evalAllNodes(FEState& state, int nfield, vector<float>& val)
+{
+	int ndata = FIELD_CODE(nfield);
+	if ((ndata < 0) || (ndata >= state.m_Data.size())) return false;
+
+	Post::FEMeshData& rd = state.m_Data[ndata];
+	int ncomp = FIELD_COMP(nfield);
+	switch (rd.GetType())
+	{
+	case DATA_FLOAT: return evalAllNodes<float>(rd, ncomp, val);
+	case DATA_VEC3F: return evalAllNodes<vec3f>(rd, ncomp, val);
+	case DATA_MAT3F: return evalAllNodes<mat3f>(rd, ncomp, val);
+	}
+	return false;
+}
+
 //-----------------------------------------------------------------------------
 // Evaluate a nodal field
 void FEPostModel::EvalNodeField(int ntime, int nfield)
@@ -212,23 +273,47 @@ void FEPostModel::EvalNodeField(int ntime, int nfield)
 	assert(IS_NODE_FIELD(nfield));
 
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FEPostMesh* mesh = state.GetFEMesh();
 
+	// The items are evaluated independently, so we can do this in parallel
+	int nthreads = evalThreads();
+
 	// first, we evaluate all the nodes
-	int i, j;
-	for (i=0; i<mesh->Nodes(); ++i)
+	// (some data can evaluate all nodes at once, which is much faster)
+	NodeDataArray& nodeData = state.m_NODE;
+	int NN = mesh->Nodes();
+	vector<float> allVal;
+	bool ball = evalAllNodes(state, nfield, allVal) && ((int)allVal.size() == NN);
+	#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 256)
+	for (int i=0; i<NN; ++i)
 	{
 		FENode& node = mesh->Node(i);
-		NODEDATA& d = state.m_NODE[i];
-		d.m_val = 0;
-		d.m_ntag = 0;
-		if (node.IsEnabled()) EvaluateNode(i, ntime, nfield, d);
+		nodeData.m_val[i] = 0.f;
+		nodeData.m_ntag[i] = 0;
+		if (node.IsEnabled())
+		{
+			if (ball)
+			{
+				nodeData.m_val[i] = allVal[i];
+				nodeData.m_ntag[i] = 1;
+			}
+			else
+			{
+				NODEDATA d;
+				EvaluateNode(i, ntime, nfield, d);
+				nodeData.m_val[i] = d.m_val;
+				nodeData.m_ntag[i] = d.m_ntag;
+			}
+		}
 	}
+	const float* nodeVal = nodeData.m_val.data();
 
 	// Next, we project the nodal data onto the faces
 	ValArray& faceData = state.m_FaceData;
-	for (i=0; i<mesh->Faces(); ++i)
+	int NF = mesh->Faces();
+	#pragma omp parallel for num_threads(nthreads)
+	for (int i=0; i<NF; ++i)
 	{
 		FEFace& f = mesh->Face(i);
 		FACEDATA& d = state.m_FACE[i];
@@ -237,27 +322,31 @@ void FEPostModel::EvalNodeField(int ntime, int nfield)
 		if (f.IsEnabled())
 		{
 			d.m_ntag = 1;
-			for (j=0; j<f.Nodes(); ++j) { float val = state.m_NODE[f.n[j]].m_val; faceData.value(i, j) = val; d.m_val += val; }
+			for (int j=0; j<f.Nodes(); ++j) { float val = nodeVal[f.n[j]]; faceData.value(i, j) = val; d.m_val += val; }
 			d.m_val /= (float) f.Nodes();
 		}
 	}
 
 	// Finally, we project the nodal data onto the elements
 	ValArray& elemData = state.m_ElemData;
-	for (i=0; i<mesh->Elements(); ++i)
+	ElemDataArray& elem = state.m_ELEM;
+	int NE = mesh->Elements();
+	#pragma omp parallel for num_threads(nthreads)
+	for (int i=0; i<NE; ++i)
 	{
 		FEElement_& e = mesh->ElementRef(i);
-		ELEMDATA& d = state.m_ELEM[i];
-		d.m_val = 0.f;
-		d.m_state &= ~StatusFlags::ACTIVE;
+		float val = 0.f;
+		elem.m_state[i] &= ~StatusFlags::ACTIVE;
 		e.Deactivate();
 		if (e.IsEnabled())
 		{
-			d.m_state |= StatusFlags::ACTIVE;
+			elem.m_state[i] |= StatusFlags::ACTIVE;
 			e.Activate();
-			for (j=0; j<e.Nodes(); ++j) { float val = state.m_NODE[e.m_node[j]].m_val; elemData.value(i,j) = val; d.m_val += val; }
-			d.m_val /= (float) e.Nodes();
+			int ne = e.Nodes();
+			for (int j=0; j<ne; ++j) { float vj = nodeVal[e.m_node[j]]; elemData.value(i,j) = vj; val += vj; }
+			val /= (float) ne;
 		}
+		elem.m_val[i] = val;
 	}
 }
 
@@ -268,7 +357,7 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 	assert(IS_FACE_FIELD(nfield));
 
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FEPostMesh* mesh = state.GetFEMesh();
 
 	// get the data ID
@@ -281,37 +370,38 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 	FEMeshData& rd = state.m_Data[ndata];
 	Data_Format fmt = rd.GetFormat();
 
+	// The faces are evaluated independently, so we can do this in parallel
+	int nthreads = evalThreads();
+	int NF = mesh->Faces();
+
 	// for float/node face data we evaluate the nodal values directly.
 	if ((rd.GetType() == DATA_FLOAT) && (fmt == DATA_NODE))
 	{
 		// clear node data
-		for (int i=0; i<mesh->Nodes(); ++i)
-		{
-			state.m_NODE[i].m_val = 0.f;
-			state.m_NODE[i].m_ntag = 0;
-		}
+		NodeDataArray& nodeData = state.m_NODE;
+		int NN = mesh->Nodes();
+		for (int i=0; i<NN; ++i) nodeData.m_val[i] = 0.f;
+		for (int i=0; i<NN; ++i) nodeData.m_ntag[i] = 0;
 
 		// get the data field
 		FEFaceData_T<float, DATA_NODE>& df = dynamic_cast<FEFaceData_T<float, DATA_NODE>&>(rd);
 
-		// evaluate nodes and faces
-		float tmp[FEElement::MAX_NODES] = {0.f};
-		for (int i=0; i<mesh->Faces(); ++i)
+		// evaluate faces
+		#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+		for (int i=0; i<NF; ++i)
 		{
 			FEFace& face = mesh->Face(i);
 			state.m_FACE[i].m_val = 0.f;
 			state.m_FACE[i].m_ntag = 0;
 			if (df.active(i))
 			{
+				float tmp[FEElement::MAX_NODES] = {0.f};
 				df.eval(i, tmp);
 
 				float avg = 0.f;
 				for (int j = 0; j<face.Nodes(); ++j)
 				{
 					avg += tmp[j];
-					state.m_NODE[face.n[j]].m_val = tmp[j];
-					state.m_NODE[face.n[j]].m_ntag = 1;
-
 					state.m_FaceData.value(i, j) = tmp[j];
 				}
 
@@ -319,19 +409,33 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 				state.m_FACE[i].m_ntag = 1;
 			}
 		}
+
+		// copy face values to the nodes (faces share nodes, so this is done serially)
+		for (int i=0; i<NF; ++i)
+		{
+			if (state.m_FACE[i].m_ntag == 1)
+			{
+				FEFace& face = mesh->Face(i);
+				for (int j = 0; j<face.Nodes(); ++j)
+				{
+					nodeData.m_val[face.n[j]] = state.m_FaceData.value(i, j);
+					nodeData.m_ntag[face.n[j]] = 1;
+				}
+			}
+		}
 	}
 	else
 	{
 		// first evaluate all faces
-		float data[FEFace::MAX_NODES], val;
-		int i, j;
-		for (i=0; i<mesh->Faces(); ++i)
+		#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+		for (int i=0; i<NF; ++i)
 		{
 			FEFace& f = mesh->Face(i);
 			state.m_FACE[i].m_val = 0.f;
 			state.m_FACE[i].m_ntag = 0;
 			if (f.IsEnabled()) 
 			{
+				float data[FEFace::MAX_NODES], val;
 				if (EvaluateFace(i, ntime, nfield, data, val))
 				{
 					state.m_FACE[i].m_ntag = 1;
@@ -343,38 +447,37 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 
 		// now evaluate the nodes
 		ValArray& faceData = state.m_FaceData;
-		for (i=0; i<mesh->Nodes(); ++i)
+		NodeDataArray& nodeData = state.m_NODE;
+		int NN = mesh->Nodes();
+		#pragma omp parallel for num_threads(nthreads)
+		for (int i=0; i<NN; ++i)
 		{
-			NODEDATA& node = state.m_NODE[i];
 			const vector<NodeFaceRef>& nfl = mesh->NodeFaceList(i);
-			node.m_val = 0.f; 
-			node.m_ntag = 0;
+			float val = 0.f;
 			int n = 0;
-			for (j=0; j<(int) nfl.size(); ++j)
+			for (int j=0; j<(int) nfl.size(); ++j)
 			{
 				FACEDATA& f = state.m_FACE[nfl[j].fid];
 				if (f.m_ntag > 0)
 				{
-					node.m_val += faceData.value(nfl[j].fid, nfl[j].nid);
+					val += faceData.value(nfl[j].fid, nfl[j].nid);
 					++n;
 				}
 			}
-			if (n > 0)
-			{
-				node.m_val /= (float) n;
-				node.m_ntag = 1;
-			}
+			nodeData.m_val[i] = (n > 0 ? val / (float) n : 0.f);
+			nodeData.m_ntag[i] = (n > 0 ? 1 : 0);
 		}
 	}
 
 	// evaluate the elements (to zero)
 	// Face data is not projected onto the elements
+	ElemDataArray& elem = state.m_ELEM;
 	for (int i=0; i<mesh->Elements(); ++i) 
 	{
 		FEElement_& el = mesh->ElementRef(i);
 		el.Deactivate();
-		state.m_ELEM[i].m_val = 0.f;
-		state.m_ELEM[i].m_state &= ~StatusFlags::ACTIVE;
+		elem.m_val[i] = 0.f;
+		elem.m_state[i] &= ~StatusFlags::ACTIVE;
 	}
 }
 
@@ -385,24 +488,30 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 	assert(IS_ELEM_FIELD(nfield));
 
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FEPostMesh* mesh = state.GetFEMesh();
 
+	// The elements are evaluated independently, so we can do this in parallel
+	int nthreads = evalThreads();
+
 	// first evaluate all elements
-	float data[FEElement::MAX_NODES] = {0.f};
-	float val;
-	for (int i=0; i<mesh->Elements(); ++i)
+	ElemDataArray& elem = state.m_ELEM;
+	int NE = mesh->Elements();
+	#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 64)
+	for (int i=0; i<NE; ++i)
 	{
 		FEElement_& el = mesh->ElementRef(i);
-		state.m_ELEM[i].m_val = 0.f;
-		state.m_ELEM[i].m_state &= ~StatusFlags::ACTIVE;
+		elem.m_val[i] = 0.f;
+		elem.m_state[i] &= ~StatusFlags::ACTIVE;
 		el.Deactivate();
 		if (el.IsEnabled()) 
 		{
+			float data[FEElement::MAX_NODES] = {0.f};
+			float val;
 			if (EvaluateElement(i, ntime, nfield, data, val))
 			{
-				state.m_ELEM[i].m_state |= StatusFlags::ACTIVE;
-				state.m_ELEM[i].m_val = val;
+				elem.m_state[i] |= StatusFlags::ACTIVE;
+				elem.m_val[i] = val;
 				el.Activate();
 				int ne = el.Nodes();
 				for (int j=0; j<ne; ++j) state.m_ElemData.value(i, j) = data[j];
@@ -412,11 +521,14 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 
 	// now evaluate the nodes
 	ValArray& elemData = state.m_ElemData;
-	for (int i=0; i<mesh->Nodes(); ++i)
+	NodeDataArray& nodeData = state.m_NODE;
+	int NN = mesh->Nodes();
+	#pragma omp parallel for num_threads(nthreads)
+	for (int i=0; i<NN; ++i)
 	{
 		FENode& node = mesh->Node(i);
-		state.m_NODE[i].m_val = 0.f;
-		state.m_NODE[i].m_ntag = 0;
+		nodeData.m_val[i] = 0.f;
+		nodeData.m_ntag[i] = 0;
 		if (node.IsEnabled())
 		{
 			const vector<NodeElemRef>& nel = mesh->NodeElemList(i);
@@ -424,8 +536,7 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 			float val = 0.f;
 			for (int j=0; j<m; ++j)
 			{
-				ELEMDATA& e = state.m_ELEM[nel[j].eid];
-				if (e.m_state & StatusFlags::ACTIVE)
+				if (elem.m_state[nel[j].eid] & StatusFlags::ACTIVE)
 				{
 					val += elemData.value(nel[j].eid, nel[j].nid);
 					++n;
@@ -433,15 +544,17 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 			}
 			if (n != 0) 
 			{
-				state.m_NODE[i].m_val = val / (float) n;
-				state.m_NODE[i].m_ntag = 1;
+				nodeData.m_val[i] = val / (float) n;
+				nodeData.m_ntag[i] = 1;
 			}
 		}
 	}
 
 	// evaluate faces
 	ValArray& fd = state.m_FaceData;
-	for (int i=0; i<mesh->Faces(); ++i)
+	int NF = mesh->Faces();
+	#pragma omp parallel for num_threads(nthreads)
+	for (int i=0; i<NF; ++i)
 	{
 		FEFace& f = mesh->Face(i);
 		FACEDATA& d = state.m_FACE[i];
@@ -449,7 +562,7 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 
 		int eid = f.m_elem[0].eid;
 		int lid = f.m_elem[0].lid;
-		if ((state.m_ELEM[eid].m_state & StatusFlags::ACTIVE) == 0)
+		if ((elem.m_state[eid] & StatusFlags::ACTIVE) == 0)
 		{
 			if (f.m_elem[1].eid >= 0)
 			{
@@ -458,8 +571,7 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 			}
 		}
 
-		ELEMDATA& e = state.m_ELEM[eid];
-		if (e.m_state & StatusFlags::ACTIVE)
+		if (elem.m_state[eid] & StatusFlags::ACTIVE)
 		{
 			d.m_ntag = 1;
 
@@ -850,7 +962,7 @@ bool FEPostModel::EvaluateFace(int n, int ntime, int nfield, float* data, float&
 	int ntag = 0;
 
 	// get the state
-	FEState& s = *m_State[ntime];
+	FEState& s = *GetState(ntime);
 
 
 	if (IS_FACE_FIELD(nfield))
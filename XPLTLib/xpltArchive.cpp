@@ -28,6 +28,14 @@ SOFTWARE.*/
 #include <assert.h>
 #include <FSCore/Archive.h>
 
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #ifdef WIN32
 #define ftell64(a)     _ftelli64(a)
 #define fseek64(a,b,c) _fseeki64(a,b,c)
@@ -56,6 +64,10 @@ xpltArchive::xpltArchive()
 	m_buf = 0;
 	m_pdata = 0;
 	m_bufsize = 0;
+	m_map = 0;
+	m_mapSize = 0;
+	m_mapPos = 0;
+	m_mapHandle = 0;
 	m_ncompress = 0;
 	m_pRoot = 0;
 	m_pChunk = 0;
@@ -72,17 +84,18 @@ void xpltArchive::Close()
 	if (m_bSaving)
 	{
 		if (m_pRoot) Flush();
+
+		// the file stream was created by Create or Append
+		if (m_fp) { m_fp->Close(); delete m_fp; }
 	}
 	else {
 		// clear the stack
-		while (m_Chunk.empty() == false)
-		{
-			// pop the last chunk
-			CHUNK* pc = m_Chunk.top(); m_Chunk.pop();
-			delete pc;
-		}
+		while (m_Chunk.empty() == false) m_Chunk.pop();
 	}
 
+	// release the file mapping
+	UnmapFile();
+
 	// close the file pointer
 	m_fp = 0;
 
@@ -102,9 +115,12 @@ void xpltArchive::Flush()
 {
 	if (m_fp && m_pRoot)
 	{
+		// each top-level chunk is compressed separately
+		m_fp->SetCompression(m_ncompress);
 		m_fp->BeginStreaming();
 		m_pRoot->Write(m_fp);
 		m_fp->EndStreaming();
+		m_fp->SetCompression(0);
 	}
 	delete m_pRoot;
 	m_pRoot = 0;
@@ -158,10 +174,11 @@ void xpltArchive::EndChunk()
 	}
 }
 
-bool xpltArchive::Open(IOFileStream* fp)
+bool xpltArchive::Open(IOFileStream* fp, bool bmap)
 {
-	// store a copy of the file pointer
+	// store a copy of the file pointer (the archive doesn't own it)
 	m_fp = fp;
+	m_bSaving = false;
 
 	// read the master tag
 	unsigned int ntag;
@@ -188,6 +205,9 @@ bool xpltArchive::Open(IOFileStream* fp)
 	// set the end flag to false
 	m_bend = false;
 
+	// try to map the file (we'll read the file as usual if this fails)
+	if (bmap) MapFile();
+
 	// initialize decompression stream
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
@@ -201,13 +221,13 @@ bool xpltArchive::Open(IOFileStream* fp)
 
 int xpltArchive::DecompressChunk(unsigned int& nid, unsigned int& nsize)
 {
-	const int CHUNK = 16384;
+	const int CHUNK = ZBUF_SIZE;
 	nsize = -1;
 
 	int ret;
 	unsigned have;
-	static unsigned char in[CHUNK];
-	static unsigned char out[CHUNK];
+	unsigned char* in = m_zbuf;	// (unused input is kept for the next chunk)
+	unsigned char out[CHUNK];
 
 	/* allocate inflate state */
 	ret = inflateInit(&strm);
@@ -220,13 +240,25 @@ int xpltArchive::DecompressChunk(unsigned int& nid, unsigned int& nsize)
 	do {
 		if (strm.avail_in == 0)
 		{
-			strm.avail_in = m_fp->read(in, 1, CHUNK);
-			if (ferror(m_fp->FilePtr())) {
-				(void)inflateEnd(&strm);
-				return Z_ERRNO;
+			if (m_map)
+			{
+				// we can decompress directly from the mapped file
+				off_type nleft = m_mapSize - m_mapPos;
+				const off_type nmax = 0x40000000;
+				strm.avail_in = (uInt)(nleft < nmax ? nleft : nmax);
+				strm.next_in = (Bytef*)(m_map + m_mapPos);
+				m_mapPos += strm.avail_in;
+			}
+			else
+			{
+				strm.avail_in = m_fp->read(in, 1, CHUNK);
+				if (ferror(m_fp->FilePtr())) {
+					(void)inflateEnd(&strm);
+					return Z_ERRNO;
+				}
+				strm.next_in = in;
 			}
 			if (strm.avail_in == 0) break;
-			strm.next_in = in;
 		}
 
 		/* run inflate() on input until output buffer not full */
@@ -252,6 +284,13 @@ int xpltArchive::DecompressChunk(unsigned int& nid, unsigned int& nsize)
 		/* done when inflate() says it's done */
 	} while (ret != Z_STREAM_END);
 
+	// move the read position back to the end of this chunk's stream
+	if (m_map)
+	{
+		m_mapPos -= strm.avail_in;
+		strm.avail_in = 0;
+	}
+
 	char* pbuf = buf.data();
 	if (pbuf)
 	{
@@ -290,19 +329,19 @@ int xpltArchive::OpenChunk()
 		return IO_END;
 	}
 
-	// see if we have a buffer allocated
-	if (m_buf == 0)
+	// see if we need to open a top-level chunk
+	if (m_Chunk.empty())
 	{
 		unsigned int id, nsize;
 		if (m_ncompress == 0)
 		{
 			// see if we have reached the end of the file
-			if (feof(m_fp->FilePtr()) || ferror(m_fp->FilePtr())) return IO_ERROR;
+			if (IsEOF()) return IO_ERROR;
 
 			// get the master chunk id and size
-			int nret = m_fp->read(&id, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
+			int nret = (int) ReadFile(&id, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
 			if (m_bswap) bswap(id);
-			nret = m_fp->read(&nsize, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
+			nret = (int) ReadFile(&nsize, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
 			if (m_bswap) bswap(nsize);
 
 			if (nsize == 0)
@@ -310,6 +349,13 @@ int xpltArchive::OpenChunk()
 				m_bend = true;
 				return IO_END;
 			}
+			else if (m_map)
+			{
+				// the data is read directly from the mapped file
+				if (m_mapPos + nsize > m_mapSize) return IO_ERROR;
+				m_pdata = (void*)(m_map + m_mapPos);
+				m_mapPos += nsize;
+			}
 			else
 			{
 				// allocate the buffer
@@ -331,51 +377,133 @@ int xpltArchive::OpenChunk()
 		}
 
 		// create a new chunk
-		CHUNK* pc = new CHUNK;
-		pc->id = id;
-		pc->nsize = nsize;
-		pc->pdata = m_pdata;
+		CHUNK c;
+		c.id = id;
+		c.nsize = nsize;
+		c.pdata = m_pdata;
 		// add it to the stack
-		m_Chunk.push(pc);
+		m_Chunk.push(c);
 
+		// keep the file position in sync with the mapped file, since it's used to report progress
+		if (m_map) fseek64(m_fp->FilePtr(), m_mapPos, SEEK_SET);
 	}
 	else
 	{
 		// create a new chunk
-		CHUNK* pc = new CHUNK;
+		CHUNK c;
 
 		// read the chunk ID
-		if (read(pc->id) == IO_ERROR) return IO_ERROR;
+		if (read(c.id) == IO_ERROR) return IO_ERROR;
 
 		// read the chunk size
-		if (read(pc->nsize) == IO_ERROR) return IO_ERROR;
-		if (pc->nsize == 0) m_bend = true;
+		if (read(c.nsize) == IO_ERROR) return IO_ERROR;
+		if (c.nsize == 0) m_bend = true;
 
 		// store the data pointer
-		pc->pdata = m_pdata;
+		c.pdata = m_pdata;
 
 		// add it to the stack
-		m_Chunk.push(pc);
+		m_Chunk.push(c);
+	}
+
+	return IO_OK;
+}
+
+int xpltArchive::OpenChunk(unsigned int nid, unsigned int nmax)
+{
+	// only top-level chunks of uncompressed data can be read partially
+	// (mapped files don't need this since only the data that is accessed is read)
+	if (m_bend || (m_Chunk.empty() == false) || (m_ncompress != 0) || m_map) return OpenChunk();
+
+	// see if we have reached the end of the file
+	if (feof(m_fp->FilePtr()) || ferror(m_fp->FilePtr())) return IO_ERROR;
+
+	// get the master chunk id and size
+	unsigned int id, nsize;
+	int nret = m_fp->read(&id, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
+	if (m_bswap) bswap(id);
+	nret = m_fp->read(&nsize, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
+	if (m_bswap) bswap(nsize);
+
+	if (nsize == 0)
+	{
+		m_bend = true;
+		return IO_END;
 	}
 
+	// figure out how much we need to read
+	unsigned int nread = nsize;
+	if ((id == nid) && (nmax < nsize)) nread = nmax;
+
+	// allocate the buffer
+	m_bufsize = nread;
+	m_buf = new char[m_bufsize];
+
+	// read the buffer from file
+	if (m_fp->read(m_buf, sizeof(char), nread) != nread) return IO_ERROR;
+
+	// skip the rest of the chunk
+	if (nread < nsize)
+	{
+		if (fseek64(m_fp->FilePtr(), (off_type)(nsize - nread), SEEK_CUR) != 0) return IO_ERROR;
+	}
+
+	// set the data pointer
+	m_pdata = m_buf;
+
+	// create a new chunk
+	CHUNK c;
+	c.id = id;
+	c.nsize = nsize;
+	c.pdata = m_pdata;
+	m_Chunk.push(c);
+
 	return IO_OK;
 }
 
+off_type xpltArchive::Tell()
+{
+	assert(m_Chunk.empty());
+	if (m_map) return m_mapPos;
+
+	off_type npos = ftell64(m_fp->FilePtr());
+
+	// the decompression stream may already have read past the next chunk
+	if (m_ncompress) npos -= (off_type) strm.avail_in;
+
+	return npos;
+}
+
+bool xpltArchive::Seek(off_type noff)
+{
+	assert(m_Chunk.empty());
+	if (m_map)
+	{
+		if ((noff < 0) || (noff > m_mapSize)) return false;
+		m_mapPos = noff;
+	}
+	else if (fseek64(m_fp->FilePtr(), noff, SEEK_SET) != 0) return false;
+
+	// discard any pending input of the decompression stream
+	strm.avail_in = 0;
+	strm.next_in = Z_NULL;
+
+	m_bend = false;
+	return true;
+}
+
 void xpltArchive::CloseChunk()
 {
 	// pop the last chunk
-	CHUNK* pc = m_Chunk.top(); m_Chunk.pop();
+	CHUNK c = m_Chunk.top(); m_Chunk.pop();
 
 	// calculate the offset to the end of the chunk
-	off_type noff = pc->nsize - ((char*)m_pdata - (char*)pc->pdata);
+	off_type noff = c.nsize - ((char*)m_pdata - (char*)c.pdata);
 
 	// skip any remaining part in the chunk
 	// I wonder if this can really happen
 	if (noff != 0) m_pdata = (char*)m_pdata + noff;
 
-	// delete this chunk
-	delete pc;
-
 	// take a peek at the parent
 	if (m_Chunk.empty())
 	{
@@ -390,15 +518,128 @@ void xpltArchive::CloseChunk()
 	}
 	else
 	{
-		pc = m_Chunk.top();
-		off_type noff = pc->nsize - ((char*)m_pdata - (char*)pc->pdata);
+		CHUNK& parent = m_Chunk.top();
+		off_type noff = parent.nsize - ((char*)m_pdata - (char*)parent.pdata);
 		if (noff == 0) m_bend = true;
 	}
 }
 
+const char* xpltArchive::DetachChunk(unsigned int& nsize, char*& pbuf)
+{
+	assert(m_Chunk.size() == 1);
+	const CHUNK& c = m_Chunk.top();
+	nsize = c.nsize;
+
+	// the caller now owns the buffer
+	pbuf = m_buf;
+	m_buf = 0;
+	m_bufsize = 0;
+
+	return (const char*) c.pdata;
+}
+
+void xpltArchive::AttachChunk(unsigned int id, const char* pdata, unsigned int nsize, bool bswap)
+{
+	assert(m_Chunk.empty() && (m_buf == 0));
+	m_bSaving = false;
+	m_bswap = bswap;
+	m_bend = false;
+
+	// the data is not copied, so it must remain valid until the chunk is closed
+	m_pdata = (void*) pdata;
+
+	CHUNK c;
+	c.id = id;
+	c.nsize = nsize;
+	c.pdata = m_pdata;
+	m_Chunk.push(c);
+}
+
 unsigned int xpltArchive::GetChunkID()
 {
-	CHUNK* pc = m_Chunk.top();
-	assert(pc);
-	return pc->id;
+	assert(m_Chunk.empty() == false);
+	return m_Chunk.top().id;
+}
+
+unsigned int xpltArchive::GetChunkSize()
+{
+	assert(m_Chunk.empty() == false);
+	return m_Chunk.top().nsize;
+}
+
+size_t xpltArchive::ReadFile(void* pd, size_t size, size_t count)
+{
+	if (m_map == 0) return m_fp->read(pd, size, count);
+
+	off_type nleft = m_mapSize - m_mapPos;
+	if ((off_type)(size*count) > nleft) count = (size_t)(nleft / size);
+	memcpy(pd, m_map + m_mapPos, size*count);
+	m_mapPos += size*count;
+	return count;
+}
+
+bool xpltArchive::IsEOF()
+{
+	if (m_map) return (m_mapPos >= m_mapSize);
+	return (feof(m_fp->FilePtr()) || ferror(m_fp->FilePtr()));
+}
+
+bool xpltArchive::MapFile()
+{
+	assert(m_map == 0);
+	FILE* fp = m_fp->FilePtr();
+	if (fp == 0) return false;
+
+	// the mapped file is read from the current file position
+	off_type npos = ftell64(fp);
+
+#ifdef WIN32
+	HANDLE hfile = (HANDLE) _get_osfhandle(_fileno(fp));
+	if (hfile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if ((GetFileSizeEx(hfile, &size) == FALSE) || (size.QuadPart == 0)) return false;
+
+	HANDLE hmap = CreateFileMapping(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hmap == NULL) return false;
+
+	void* pv = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0);
+	if (pv == NULL) { CloseHandle(hmap); return false; }
+
+	m_mapHandle = (void*) hmap;
+	m_mapSize = (off_type) size.QuadPart;
+#else
+	int fd = fileno(fp);
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || (st.st_size == 0)) return false;
+
+	void* pv = mmap(0, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (pv == MAP_FAILED) return false;
+
+	// we mostly read the file from front to back
+	madvise(pv, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+	m_mapSize = (off_type) st.st_size;
+#endif
+
+	m_map = (const char*) pv;
+	m_mapPos = npos;
+	return true;
+}
+
+void xpltArchive::UnmapFile()
+{
+	if (m_map == 0) return;
+
+#ifdef WIN32
+	UnmapViewOfFile(m_map);
+	CloseHandle((HANDLE) m_mapHandle);
+	m_mapHandle = 0;
+#else
+	munmap((void*) m_map, (size_t) m_mapSize);
+#endif
+
+	m_map = 0;
+	m_mapSize = 0;
+	m_mapPos = 0;
 }
@@ -115,8 +115,13 @@ public: // reading
 
 	void Flush();
 
-	// Open for reading
-	bool Open(IOFileStream* fp);
+	// Open for reading. When bmap is set, the file is memory-mapped and the data of
+	// uncompressed chunks is read directly from the mapped file instead of being copied
+	// into a buffer first. If the file cannot be mapped, it is read as usual.
+	bool Open(IOFileStream* fp, bool bmap = false);
+
+	// see if the file is memory-mapped
+	bool IsMapped() const { return (m_map != 0); }
 
 	// open for appending
 	bool Append(const char* szfile);
@@ -124,9 +129,33 @@ public: // reading
 	// Open a chunk
 	int OpenChunk();
 
+	// Open a top-level chunk. If the chunk's ID equals nid, only the first nmax bytes
+	// of the chunk are read and the rest of the chunk is skipped. (Uncompressed only)
+	int OpenChunk(unsigned int nid, unsigned int nmax);
+
+	// get the file position of the next top-level chunk
+	off_type Tell();
+
+	// move to a top-level chunk (position should be obtained with Tell)
+	bool Seek(off_type noff);
+
+	// Takes over the data of the current top-level chunk, so that it can still be read
+	// after the chunk is closed (e.g. by another archive, see AttachChunk). The caller must 
+	// delete[] the returned pbuf, which is null when the data points into the mapped file.
+	const char* DetachChunk(unsigned int& nsize, char*& pbuf);
+
+	// Open a top-level chunk from data that was already read. The data is not copied.
+	void AttachChunk(unsigned int id, const char* pdata, unsigned int nsize, bool bswap);
+
+	// see if the data needs to be byte-swapped
+	bool IsSwapped() const { return m_bswap; }
+
 	// Get the current chunk ID
 	unsigned int GetChunkID();
 
+	// Get the size (in bytes) of the current chunk's data
+	unsigned int GetChunkSize();
+
 	// Close a chunk
 	void CloseChunk();
 
@@ -162,14 +191,21 @@ public: // reading
 	IOResult read(tens4fs& a) { return read(&(a.d[0]), 21); }
 	IOResult read(mat3f&   a) { return read(&(a.m_data[0][0]), 9); }
 
-	IOResult read(vector<int    >& a) { return read(&a[0], (int) a.size()); }
-	IOResult read(vector<float  >& a) { return read(&a[0], (int) a.size()); }
-	IOResult read(vector<vec3f  >& a) { return read(&(a[0].x), 3*(int) a.size()); }
-	IOResult read(vector<mat3fs >& a) { return read(&(a[0].x), 6*(int) a.size()); }
-	IOResult read(vector<mat3fd >& a) { return read(&(a[0].x), 3*(int) a.size()); }
-	IOResult read(vector<tens4fs>& a) { return read(&(a[0].d[0]), 21*(int) a.size()); }
-	IOResult read(vector<mat3f  >& a) { return read(&(a[0].m_data[0][0]), 9*(int) a.size()); }
-	IOResult read(vector<unsigned int>& a) { return read((int*)&a[0], (int)a.size()); }
+	// read n values directly into an array (nothing is read when n is zero)
+	IOResult read(vec3f*   pa, int n) { return (n > 0 ? read(&(pa[0].x), 3*n) : IO_OK); }
+	IOResult read(mat3fs*  pa, int n) { return (n > 0 ? read(&(pa[0].x), 6*n) : IO_OK); }
+	IOResult read(mat3fd*  pa, int n) { return (n > 0 ? read(&(pa[0].x), 3*n) : IO_OK); }
+	IOResult read(tens4fs* pa, int n) { return (n > 0 ? read(&(pa[0].d[0]), 21*n) : IO_OK); }
+	IOResult read(mat3f*   pa, int n) { return (n > 0 ? read(&(pa[0].m_data[0][0]), 9*n) : IO_OK); }
+
+	IOResult read(vector<int    >& a) { return (a.empty() ? IO_OK : read(&a[0], (int) a.size())); }
+	IOResult read(vector<float  >& a) { return (a.empty() ? IO_OK : read(&a[0], (int) a.size())); }
+	IOResult read(vector<vec3f  >& a) { return read(a.data(), (int) a.size()); }
+	IOResult read(vector<mat3fs >& a) { return read(a.data(), (int) a.size()); }
+	IOResult read(vector<mat3fd >& a) { return read(a.data(), (int) a.size()); }
+	IOResult read(vector<tens4fs>& a) { return read(a.data(), (int) a.size()); }
+	IOResult read(vector<mat3f  >& a) { return read(a.data(), (int) a.size()); }
+	IOResult read(vector<unsigned int>& a) { return (a.empty() ? IO_OK : read((int*)&a[0], (int)a.size())); }
 
 	// conversion to FILE* 
 //	operator FILE* () { return m_fp; }
@@ -183,6 +219,14 @@ public: // reading
 
 	int DecompressChunk(unsigned int& nid, unsigned int& nsize);
 
+protected:
+	// helper functions for reading from the file (or the mapped file)
+	size_t ReadFile(void* pd, size_t size, size_t count);
+	bool IsEOF();
+
+	bool MapFile();
+	void UnmapFile();
+
 protected:
 	IOFileStream*	m_fp;		// the file pointer
 	bool	m_bswap;		// swap data when reading
@@ -193,13 +237,21 @@ protected:
 	unsigned int	m_nversion;	// stores the version nr of the file being loaded
 
 	// read data
-	stack<CHUNK*>	m_Chunk;
+	stack<CHUNK, vector<CHUNK> >	m_Chunk;
 
     z_stream		strm;
+	enum { ZBUF_SIZE = 16384 };
+	unsigned char	m_zbuf[ZBUF_SIZE];	// input buffer of decompression stream
 	char*			m_buf;		// data buffer
 	void*			m_pdata;	// data pointer
 	unsigned int	m_bufsize;	// size of data buffer
 
+	// memory-mapped file
+	const char*		m_map;		// start of mapped file (null if file is not mapped)
+	off_type		m_mapSize;	// size of mapped file
+	off_type		m_mapPos;	// current read position in mapped file
+	void*			m_mapHandle;	// file mapping handle (Windows only)
+
 	// write data
 	OBranch*	m_pRoot;	// chunk tree root
 	OBranch*	m_pChunk;	// current chunk
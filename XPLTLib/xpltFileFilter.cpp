@@ -0,0 +1,609 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "stdafx.h"
+#include "xpltFileFilter.h"
+using namespace Post;
+
+//=============================================================================
+// xpltFileFilter
+//=============================================================================
+
+xpltFileFilter::xpltFileFilter()
+{
+	m_stride = 1;
+	m_first = 0;
+	m_last = -1;
+	m_bkeepLast = false;
+	m_ncompress = 0;
+
+	m_pending = 0;
+	m_pendingBuf = 0;
+	m_pendingSize = 0;
+
+	m_incompress = 0;
+	m_nstates = 0;
+	m_szerr[0] = 0;
+}
+
+bool xpltFileFilter::error(const char* sz)
+{
+	strcpy(m_szerr, sz);
+	return false;
+}
+
+bool xpltFileFilter::Apply(const char* szin, const char* szout)
+{
+	m_szerr[0] = 0;
+	m_nstates = 0;
+	m_glbMap.clear();
+	m_nodeMap.clear();
+	m_elemMap.clear();
+	m_faceMap.clear();
+	m_domMap.clear();
+	m_domElems.clear();
+
+	// open the file (the file stream is closed when it goes out of scope)
+	IOFileStream fs;
+	if (fs.Open(szin) == false) return error("Failed opening file.");
+	if (m_in.Open(&fs) == false) return error("This is not a valid XPLT file.");
+
+	// the data is copied as is, so it must have the same byte order as the new file
+	if (m_in.IsSwapped())
+	{
+		m_in.Close();
+		return error("Byte-swapped files are not supported.");
+	}
+
+	if (m_out.Create(szout) == false)
+	{
+		m_in.Close();
+		return error("Failed creating archive");
+	}
+
+	bool bret = Copy();
+
+	ClearPendingState();
+	m_in.Close();
+	m_out.Close();
+
+	// don't leave an incomplete file behind
+	if (bret == false) remove(szout);
+
+	return bret;
+}
+
+//-----------------------------------------------------------------------------
+// Copies the file, one top-level section at a time. 
+bool xpltFileFilter::Copy()
+{
+	// the root section and the first mesh section are not compressed
+	m_in.SetCompression(0);
+	m_out.SetCompression(0);
+
+	// copy the root section
+	if ((m_in.OpenChunk() != xpltArchive::IO_OK) || (m_in.GetChunkID() != PLT_ROOT)) return error("Error opening root section");
+	if (CopyRoot() == false) return false;
+	m_in.CloseChunk();
+	if (m_in.OpenChunk() != xpltArchive::IO_END) return error("Error opening root section");
+
+	// copy the first mesh section
+	if ((m_in.OpenChunk() != xpltArchive::IO_OK) || (m_in.GetChunkID() != PLT_MESH)) return error("Error while reading mesh section");
+	if (CopyMesh() == false) return false;
+	m_in.CloseChunk();
+	if (m_in.OpenChunk() != xpltArchive::IO_END) return error("Error while reading mesh section");
+
+	// the state sections (and any following mesh sections) can be compressed
+	m_in.SetCompression(m_incompress);
+	m_out.SetCompression(m_ncompress);
+
+	int nstate = 0;
+	while (m_in.OpenChunk() == xpltArchive::IO_OK)
+	{
+		unsigned int nid = m_in.GetChunkID();
+		if (nid == PLT_STATE)
+		{
+			// we don't need to read any further when we're past the last state
+			if ((m_last >= 0) && (nstate > m_last))
+			{
+				m_in.CloseChunk();
+				break;
+			}
+
+			if (IsStateSelected(nstate))
+			{
+				ClearPendingState();
+				if (CopyState(m_in) == false) return false;
+			}
+			else if (m_bkeepLast && (nstate >= m_first))
+			{
+				// hold on to this state, in case it is the last one
+				ClearPendingState();
+				m_pending = m_in.DetachChunk(m_pendingSize, m_pendingBuf);
+			}
+			nstate++;
+		}
+		else if (nid == PLT_MESH)
+		{
+			// the states that follow use the new mesh
+			if (WritePendingState() == false) return false;
+			if (CopyMesh() == false) return false;
+		}
+		else return error("Error while reading state data.");
+		m_in.CloseChunk();
+
+		// clear end-flag
+		if (m_in.OpenChunk() != xpltArchive::IO_END) break;
+	}
+
+	return WritePendingState();
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::IsStateSelected(int n)
+{
+	if (n < m_first) return false;
+	if ((m_last >= 0) && (n > m_last)) return false;
+	return ((n - m_first) % m_stride == 0);
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::IsVariableSelected(const char* szname)
+{
+	if (m_var.empty()) return true;
+
+	// the name can be of the form "alias=name" (see XpltReader3::ReadDictItem)
+	const char* sz = strchr(szname, '=');
+	for (size_t i = 0; i < m_var.size(); ++i)
+	{
+		if (m_var[i] == szname) return true;
+		if (sz && (m_var[i] == sz + 1)) return true;
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::IsDomainSelected(int n)
+{
+	if (m_dom.empty()) return true;
+	for (size_t i = 0; i < m_dom.size(); ++i)
+	{
+		if (m_dom[i] == n) return true;
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+void xpltFileFilter::ReadChunk(xpltArchive& ar, vector<char>& buf)
+{
+	buf.resize(ar.GetChunkSize());
+	if (buf.empty() == false) ar.read(&buf[0], (int)buf.size());
+}
+
+//-----------------------------------------------------------------------------
+void xpltFileFilter::WriteChunk(unsigned int nid, vector<char>& buf)
+{
+	if (buf.empty())
+	{
+		m_out.BeginChunk(nid);
+		m_out.EndChunk();
+	}
+	else m_out.WriteChunk(nid, &buf[0], (int)buf.size());
+}
+
+//-----------------------------------------------------------------------------
+// Copy the current chunk as is. Note that this also works for chunks that have
+// child chunks, since the data of such a chunk is just its child chunks.
+void xpltFileFilter::CopyChunk(xpltArchive& ar)
+{
+	vector<char> buf;
+	ReadChunk(ar, buf);
+	WriteChunk(ar.GetChunkID(), buf);
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::CopyRoot()
+{
+	m_out.BeginChunk(PLT_ROOT);
+	{
+		while (m_in.OpenChunk() == xpltArchive::IO_OK)
+		{
+			switch (m_in.GetChunkID())
+			{
+			case PLT_HEADER    : if (CopyHeader    () == false) return false; break;
+			case PLT_DICTIONARY: if (CopyDictionary() == false) return false; break;
+			default:
+				CopyChunk(m_in);
+			}
+			m_in.CloseChunk();
+		}
+	}
+	m_out.EndChunk();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::CopyHeader()
+{
+	m_out.BeginChunk(PLT_HEADER);
+	{
+		while (m_in.OpenChunk() == xpltArchive::IO_OK)
+		{
+			switch (m_in.GetChunkID())
+			{
+			case PLT_HDR_VERSION:
+				{
+					unsigned int nversion = 0;
+					m_in.read(nversion);
+					if (nversion < PLT_VERSION_3) return error("Only version 3.0 (and up) files are supported.");
+					m_out.WriteChunk(PLT_HDR_VERSION, nversion);
+				}
+				break;
+			case PLT_HDR_COMPRESSION:
+				m_in.read(m_incompress);
+				m_out.WriteChunk(PLT_HDR_COMPRESSION, m_ncompress);
+				break;
+			default:
+				CopyChunk(m_in);
+			}
+			m_in.CloseChunk();
+		}
+	}
+	m_out.EndChunk();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::CopyDictionary()
+{
+	m_out.BeginChunk(PLT_DICTIONARY);
+	{
+		while (m_in.OpenChunk() == xpltArchive::IO_OK)
+		{
+			unsigned int nid = m_in.GetChunkID();
+			switch (nid)
+			{
+			case PLT_DIC_GLOBAL : if (CopyDictionaryItems(nid, m_glbMap ) == false) return false; break;
+			case PLT_DIC_NODAL  : if (CopyDictionaryItems(nid, m_nodeMap) == false) return false; break;
+			case PLT_DIC_DOMAIN : if (CopyDictionaryItems(nid, m_elemMap) == false) return false; break;
+			case PLT_DIC_SURFACE: if (CopyDictionaryItems(nid, m_faceMap) == false) return false; break;
+			default:
+				return error("Error while reading Dictionary.");
+			}
+			m_in.CloseChunk();
+		}
+	}
+	m_out.EndChunk();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Copies the selected variables of a dictionary section. The variables are 
+// renumbered, since the state data refers to the variables by their index.
+bool xpltFileFilter::CopyDictionaryItems(unsigned int nid, vector<int>& varMap)
+{
+	varMap.clear();
+
+	// the items are only written when one of them is selected
+	vector< vector<unsigned int> > ids;
+	vector< vector< vector<char> > > items;
+	while (m_in.OpenChunk() == xpltArchive::IO_OK)
+	{
+		if (m_in.GetChunkID() != PLT_DIC_ITEM) return error("Error while reading dictionary section");
+
+		vector<unsigned int> id;
+		vector< vector<char> > data;
+		char szname[DI_NAME_SIZE + 1] = { 0 };
+		while (m_in.OpenChunk() == xpltArchive::IO_OK)
+		{
+			id.push_back(m_in.GetChunkID());
+			data.push_back(vector<char>());
+			ReadChunk(m_in, data.back());
+
+			if (id.back() == PLT_DIC_ITEM_NAME)
+			{
+				vector<char>& s = data.back();
+				size_t l = (s.size() < (size_t) DI_NAME_SIZE ? s.size() : (size_t) DI_NAME_SIZE);
+				if (l > 0) strncpy(szname, &s[0], l);
+			}
+			m_in.CloseChunk();
+		}
+
+		if (IsVariableSelected(szname))
+		{
+			ids.push_back(id);
+			items.push_back(data);
+			varMap.push_back((int)items.size());
+		}
+		else varMap.push_back(0);
+
+		m_in.CloseChunk();
+	}
+
+	if (items.empty() == false)
+	{
+		m_out.BeginChunk(nid);
+		for (size_t i = 0; i < items.size(); ++i)
+		{
+			m_out.BeginChunk(PLT_DIC_ITEM);
+			for (size_t j = 0; j < items[i].size(); ++j) WriteChunk(ids[i][j], items[i][j]);
+			m_out.EndChunk();
+		}
+		m_out.EndChunk();
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::CopyMesh()
+{
+	m_out.BeginChunk(PLT_MESH);
+	{
+		while (m_in.OpenChunk() == xpltArchive::IO_OK)
+		{
+			if (m_in.GetChunkID() == PLT_DOMAIN_SECTION)
+			{
+				if (CopyDomainSection() == false) return false;
+			}
+			else CopyChunk(m_in);
+			m_in.CloseChunk();
+		}
+	}
+	m_out.EndChunk();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Copies the selected domains. Since the domains are selected by their index,
+// we know if a domain is written before it is read.
+bool xpltFileFilter::CopyDomainSection()
+{
+	m_domMap.clear();
+	m_domElems.clear();
+
+	int nd = 0, nkept = 0;
+	m_out.BeginChunk(PLT_DOMAIN_SECTION);
+	while (m_in.OpenChunk() == xpltArchive::IO_OK)
+	{
+		if (m_in.GetChunkID() != PLT_DOMAIN) return error("Error while reading Domain section");
+
+		bool bkeep = IsDomainSelected(nd);
+		m_domMap.push_back(bkeep ? ++nkept : 0);
+		m_domElems.push_back(0);
+
+		if (bkeep) m_out.BeginChunk(PLT_DOMAIN);
+		while (m_in.OpenChunk() == xpltArchive::IO_OK)
+		{
+			if (m_in.GetChunkID() == PLT_DOMAIN_HDR)
+			{
+				// we need the nr of elements for filtering the element states
+				if (bkeep) m_out.BeginChunk(PLT_DOMAIN_HDR);
+				while (m_in.OpenChunk() == xpltArchive::IO_OK)
+				{
+					if (m_in.GetChunkID() == PLT_DOM_ELEMS)
+					{
+						int ne = 0;
+						m_in.read(ne);
+						m_domElems[nd] = ne;
+						if (bkeep) m_out.WriteChunk(PLT_DOM_ELEMS, ne);
+					}
+					else if (bkeep) CopyChunk(m_in);
+					m_in.CloseChunk();
+				}
+				if (bkeep) m_out.EndChunk();
+			}
+			else if (bkeep) CopyChunk(m_in);
+			m_in.CloseChunk();
+		}
+		if (bkeep) m_out.EndChunk();
+
+		m_in.CloseChunk();
+		nd++;
+	}
+	m_out.EndChunk();
+
+	if (nkept == 0) return error("None of the selected domains were found.");
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::CopyState(xpltArchive& ar)
+{
+	m_out.BeginChunk(PLT_STATE);
+	{
+		while (ar.OpenChunk() == xpltArchive::IO_OK)
+		{
+			unsigned int nid = ar.GetChunkID();
+			if (nid == PLT_STATE_DATA)
+			{
+				if (CopyStateData(ar) == false) return false;
+			}
+			else if (nid == PLT_MESH_STATE)
+			{
+				m_out.BeginChunk(PLT_MESH_STATE);
+				while (ar.OpenChunk() == xpltArchive::IO_OK)
+				{
+					if (ar.GetChunkID() == PLT_ELEMENT_STATE)
+					{
+						if (CopyElementState(ar) == false) return false;
+					}
+					else CopyChunk(ar);
+					ar.CloseChunk();
+				}
+				m_out.EndChunk();
+			}
+			else CopyChunk(ar);
+			ar.CloseChunk();
+		}
+	}
+	m_out.EndChunk();
+
+	m_nstates++;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::CopyStateData(xpltArchive& ar)
+{
+	m_out.BeginChunk(PLT_STATE_DATA);
+	{
+		while (ar.OpenChunk() == xpltArchive::IO_OK)
+		{
+			unsigned int nid = ar.GetChunkID();
+			switch (nid)
+			{
+			case PLT_GLOBAL_DATA : if (CopyVariables(ar, nid, m_glbMap ) == false) return false; break;
+			case PLT_NODE_DATA   : if (CopyVariables(ar, nid, m_nodeMap) == false) return false; break;
+			case PLT_ELEMENT_DATA: if (CopyVariables(ar, nid, m_elemMap) == false) return false; break;
+			case PLT_FACE_DATA   : if (CopyVariables(ar, nid, m_faceMap) == false) return false; break;
+			default:
+				return error("Invalid chunk ID");
+			}
+			ar.CloseChunk();
+		}
+	}
+	m_out.EndChunk();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::CopyVariables(xpltArchive& ar, unsigned int nid, vector<int>& varMap)
+{
+	// element data is stored per domain, so it needs to be filtered when domains are selected
+	bool bdomains = ((nid == PLT_ELEMENT_DATA) && (m_dom.empty() == false));
+
+	m_out.BeginChunk(nid);
+	while (ar.OpenChunk() == xpltArchive::IO_OK)
+	{
+		if (ar.GetChunkID() != PLT_STATE_VARIABLE) return error("Error while reading state data");
+
+		int nv = 0;
+		while (ar.OpenChunk() == xpltArchive::IO_OK)
+		{
+			unsigned int cid = ar.GetChunkID();
+			if (cid == PLT_STATE_VAR_ID)
+			{
+				int n = -1;
+				ar.read(n);
+				if ((n < 1) || (n > (int)varMap.size())) return error("Failed reading all state data");
+				nv = varMap[n - 1];
+			}
+			else if ((cid == PLT_STATE_VAR_DATA) && (nv > 0))
+			{
+				m_out.BeginChunk(PLT_STATE_VARIABLE);
+				m_out.WriteChunk(PLT_STATE_VAR_ID, nv);
+				if (bdomains)
+				{
+					// the data of each domain is stored in a chunk whose ID is the domain ID
+					m_out.BeginChunk(PLT_STATE_VAR_DATA);
+					vector<char> buf;
+					while (ar.OpenChunk() == xpltArchive::IO_OK)
+					{
+						int nd = (int)ar.GetChunkID() - 1;
+						if ((nd < 0) || (nd >= (int)m_domMap.size())) return error("Failed reading all state data");
+						if (m_domMap[nd] > 0)
+						{
+							ReadChunk(ar, buf);
+							WriteChunk(m_domMap[nd], buf);
+						}
+						ar.CloseChunk();
+					}
+					m_out.EndChunk();
+				}
+				else CopyChunk(ar);
+				m_out.EndChunk();
+			}
+			ar.CloseChunk();
+		}
+		ar.CloseChunk();
+	}
+	m_out.EndChunk();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// The element states are stored for all elements, in the order of the domains
+bool xpltFileFilter::CopyElementState(xpltArchive& ar)
+{
+	if (m_dom.empty())
+	{
+		CopyChunk(ar);
+		return true;
+	}
+
+	int NE = 0;
+	for (size_t i = 0; i < m_domElems.size(); ++i) NE += m_domElems[i];
+	if (ar.GetChunkSize() != NE*sizeof(unsigned int)) return error("Error while reading element states");
+
+	vector<unsigned int> flags(NE), newFlags;
+	if (NE > 0) ar.read(flags);
+	newFlags.reserve(NE);
+
+	int n0 = 0;
+	for (size_t i = 0; i < m_domElems.size(); ++i)
+	{
+		int ne = m_domElems[i];
+		if (m_domMap[i] > 0) newFlags.insert(newFlags.end(), flags.begin() + n0, flags.begin() + n0 + ne);
+		n0 += ne;
+	}
+
+	if (newFlags.empty() == false) m_out.WriteChunk(PLT_ELEMENT_STATE, newFlags);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool xpltFileFilter::WritePendingState()
+{
+	if (m_pending == 0) return true;
+
+	xpltArchive ar;
+	ar.AttachChunk(PLT_STATE, m_pending, m_pendingSize, false);
+	bool bret = CopyState(ar);
+	ar.CloseChunk();
+
+	ClearPendingState();
+
+	return bret;
+}
+
+//-----------------------------------------------------------------------------
+void xpltFileFilter::ClearPendingState()
+{
+	delete [] m_pendingBuf;
+	m_pending = 0;
+	m_pendingBuf = 0;
+	m_pendingSize = 0;
+}
@@ -0,0 +1,165 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2020 University of Utah, The Trustees of Columbia University in 
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include "xpltArchive.h"
+#include <string>
+
+namespace Post {
+//-----------------------------------------------------------------------------
+// Class for writing a subset of an XPLT file to a new XPLT file. The file is
+// processed one section at a time, so that large files can be reduced without
+// loading them into a model. Only version 3.0 (and up) files are supported.
+class xpltFileFilter
+{
+protected:
+	// file version
+	enum { PLT_VERSION_3 = 0x0030 };
+
+	// file tags
+	enum { 
+		PLT_ROOT						= 0x01000000,
+		PLT_HEADER						= 0x01010000,
+			PLT_HDR_VERSION				= 0x01010001,
+			PLT_HDR_COMPRESSION			= 0x01010004,
+		PLT_DICTIONARY					= 0x01020000,
+			PLT_DIC_ITEM				= 0x01020001,
+			PLT_DIC_ITEM_NAME			= 0x01020004,
+			PLT_DIC_GLOBAL				= 0x01021000,
+			PLT_DIC_NODAL				= 0x01023000,
+			PLT_DIC_DOMAIN				= 0x01024000,
+			PLT_DIC_SURFACE				= 0x01025000,
+		PLT_MESH						= 0x01040000,
+			PLT_DOMAIN_SECTION			= 0x01042000,
+				PLT_DOMAIN				= 0x01042100,
+				PLT_DOMAIN_HDR			= 0x01042101,
+					PLT_DOM_ELEMS		= 0x01032104,
+		PLT_STATE						= 0x02000000,
+			PLT_STATE_DATA				= 0x02020000,
+				PLT_STATE_VARIABLE		= 0x02020001,
+				PLT_STATE_VAR_ID		= 0x02020002,
+				PLT_STATE_VAR_DATA		= 0x02020003,
+				PLT_GLOBAL_DATA			= 0x02020100,
+				PLT_NODE_DATA			= 0x02020300,
+				PLT_ELEMENT_DATA		= 0x02020400,
+				PLT_FACE_DATA			= 0x02020500,
+			PLT_MESH_STATE				= 0x02030000,
+				PLT_ELEMENT_STATE		= 0x02030001
+	};
+
+	// size of name variables
+	enum { DI_NAME_SIZE = 64 };
+
+public:
+	xpltFileFilter();
+
+	// Only write every n-th state, starting at the first state of the range (default = 1)
+	void SetStateStride(int n) { m_stride = (n < 1 ? 1 : n); }
+
+	// Only write the states in the range [first, last] (last = -1 for all remaining states)
+	void SetStateRange(int first, int last) { m_first = (first < 0 ? 0 : first); m_last = last; }
+
+	// Always write the last state of the range (and the last state before a mesh 
+	// section), even if the stride skips it
+	void SetKeepLastState(bool b) { m_bkeepLast = b; }
+
+	// Add a variable that is written. When no variables are added, all variables are written.
+	void AddVariable(const std::string& name) { m_var.push_back(name); }
+
+	// Add a domain (zero-based index) that is written. When no domains are added, all domains 
+	// are written. The index refers to the domain sections of each mesh in the file.
+	void AddDomain(int n) { m_dom.push_back(n); }
+
+	// set the compression flag of the new file
+	void SetCompression(bool b) { m_ncompress = (b ? 1 : 0); }
+
+	// Write the selected data of szin to szout
+	bool Apply(const char* szin, const char* szout);
+
+	// number of states written by the last call to Apply
+	int States() const { return m_nstates; }
+
+	// get the error message (if any)
+	const char* GetErrorMessage() const { return m_szerr; }
+
+protected:
+	bool Copy();
+	bool CopyRoot();
+	bool CopyHeader();
+	bool CopyDictionary();
+	bool CopyDictionaryItems(unsigned int nid, vector<int>& varMap);
+	bool CopyMesh();
+	bool CopyDomainSection();
+	bool CopyState(xpltArchive& ar);
+	bool CopyStateData(xpltArchive& ar);
+	bool CopyVariables(xpltArchive& ar, unsigned int nid, vector<int>& varMap);
+	bool CopyElementState(xpltArchive& ar);
+	bool WritePendingState();
+	void ClearPendingState();
+
+	bool IsVariableSelected(const char* szname);
+	bool IsDomainSelected(int n);
+	bool IsStateSelected(int n);
+
+	// copy the data of the current chunk
+	void ReadChunk(xpltArchive& ar, vector<char>& buf);
+	void WriteChunk(unsigned int nid, vector<char>& buf);
+	void CopyChunk(xpltArchive& ar);
+
+	bool error(const char* sz);
+
+private:
+	xpltArchive	m_in;		// the file that is read
+	xpltArchive	m_out;		// the file that is written
+
+	// options
+	int				m_stride;
+	int				m_first, m_last;
+	bool			m_bkeepLast;
+	vector<string>	m_var;
+	vector<int>		m_dom;
+	int				m_ncompress;
+
+	// new variable ID (one-based) of each variable in the file (0 if the variable is not written)
+	vector<int>	m_glbMap;
+	vector<int>	m_nodeMap;
+	vector<int>	m_elemMap;
+	vector<int>	m_faceMap;
+
+	// new domain ID (one-based) of each domain in the current mesh (0 if the domain is not written)
+	vector<int>	m_domMap;
+	vector<int>	m_domElems;	// nr of elements of each domain in the current mesh
+
+	// last state that was skipped (only used when the last state is kept)
+	const char*		m_pending;
+	char*			m_pendingBuf;
+	unsigned int	m_pendingSize;
+
+	int		m_incompress;	// compression flag of the file that is read
+	int		m_nstates;
+	char	m_szerr[256];
+};
+}
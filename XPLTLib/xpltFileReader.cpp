@@ -55,10 +55,14 @@ xpltFileReader::xpltFileReader(Post::FEPostModel* fem) : FEFileReader(fem)
 {
 	m_xplt = 0;
 	m_read_state_flag = XPLT_READ_ALL_STATES;
+	m_bondemand = false;
+	m_bmap = false;
+	m_bparallel = true;
 }
 
 xpltFileReader::~xpltFileReader()
 {
+	delete m_xplt;
 }
 
 bool xpltFileReader::Load(const char* szfile)
@@ -68,7 +72,7 @@ bool xpltFileReader::Load(const char* szfile)
 
 	// attach the file to the archive
 	IOFileStream fs(m_fp, false);
-	if (m_ar.Open(&fs) == false) return errf("This is not a valid XPLT file.");
+	if (m_ar.Open(&fs, m_bmap) == false) return errf("This is not a valid XPLT file.");
 
 	// open the root chunk (no compression for this sectio)
 	m_ar.SetCompression(0);
@@ -126,6 +130,28 @@ bool xpltFileReader::Load(const char* szfile)
 }
 
 
+//-----------------------------------------------------------------------------
+bool xpltFileReader::LoadState(Post::FEPostModel& fem, Post::FEState& state)
+{
+	if (m_xplt == 0) return false;
+
+	// open the file
+	if (Open(GetFileName().c_str(), "rb") == false) return errf("Failed opening file.");
+
+	// attach the file to the archive
+	IOFileStream fs(m_fp, false);
+	if (m_ar.Open(&fs, m_bmap) == false) return errf("This is not a valid XPLT file.");
+
+	// read the state
+	bool bret = m_xplt->ReadState(fem, state);
+
+	// clean up
+	m_ar.Close();
+	Close();
+
+	return bret;
+}
+
 //-----------------------------------------------------------------------------
 bool xpltFileReader::ReadHeader()
 {
@@ -51,6 +51,9 @@ public:
 
 	virtual bool Load(Post::FEPostModel& fem) = 0;
 
+	// read the data of a state that was not read during Load (only when states are read on demand)
+	virtual bool ReadState(Post::FEPostModel& fem, Post::FEState& state) { return false; }
+
 	bool errf(const char* sz);
 
 	void addWarning(int n);
@@ -63,7 +66,7 @@ protected:
 	vector<int>			m_wrng;	// warning list
 };
 
-class xpltFileReader : public Post::FEFileReader
+class xpltFileReader : public Post::FEFileReader, public Post::FEStateLoader
 {
 protected:
 	// file tags
@@ -105,6 +108,25 @@ public:
 	int GetReadStateFlag() const { return m_read_state_flag; }
 	vector<int> GetReadStates() const { return m_state_list; }
 
+	// When set, only the state headers are read during Load and the state data is read 
+	// when a state is accessed. (Only supported for version 3.0 and up)
+	void SetReadStatesOnDemand(bool b) { m_bondemand = b; }
+	bool ReadStatesOnDemand() const { return m_bondemand; }
+
+	// When set, the file is memory-mapped and uncompressed data is read directly from
+	// the mapped file. This is off by default, since a mapped file that is on a network
+	// share or that is truncated while it is read can crash the application.
+	void SetMemoryMapping(bool b) { m_bmap = b; }
+	bool MemoryMapping() const { return m_bmap; }
+
+	// When set, the state data is read in parallel. States are still added to the model
+	// in the order they appear in the file. (This is the default)
+	void SetReadStatesInParallel(bool b) { m_bparallel = b; }
+	bool ReadStatesInParallel() const { return m_bparallel; }
+
+	// read the data of a state (from FEStateLoader)
+	bool LoadState(Post::FEPostModel& fem, Post::FEState& state) override;
+
 public:
 	xpltArchive& GetArchive() { return m_ar; }
 
@@ -121,6 +143,10 @@ private:
 	// Options
 	int			m_read_state_flag;	//!< flag setting option for reading states
 	vector<int>	m_state_list;		//!< list of states to read (only when m_read_state_flag == XPLT_READ_STATES_FROM_LIST)
+	bool		m_bondemand;		//!< read state data on demand
+	bool		m_bmap;				//!< use a memory-mapped file for reading
+	bool		m_bparallel;		//!< read state data in parallel
 
 	friend class xpltParser;
+	friend class XpltReader3;
 };
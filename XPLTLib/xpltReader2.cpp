@@ -1256,12 +1256,12 @@ bool XpltReader2::ReadStateSection(FEPostModel& fem)
 		float h[FEElement::MAX_NODES] = {0.f};
 		for (int i=0; i<NE; ++i)
 		{
-			ELEMDATA& d = ps->m_ELEM[i];
-			if (df.active(i))
+			float* d = ps->m_ELEM.thickness(i);
+			if (d && df.active(i))
 			{
 				df.eval(i, h);
 				int n = mesh.ElementRef(i).Nodes();
-				for (int j=0; j<n; ++j) d.m_h[j] = h[j];
+				for (int j=0; j<n; ++j) d[j] = h[j];
 			}
 		}
 	}
@@ -32,6 +32,9 @@ SOFTWARE.*/
 #include <PostLib/FEPostMesh.h>
 #include <PostLib/FEPostModel.h>
 #include <PostLib/FEMeshData_T.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace Post;
 
@@ -59,6 +62,19 @@ template <class Type> void ReadElemData_REGION(xpltArchive& ar, XpltReader3::Dom
 	df.add(elem, a);
 }
 
+// the element values are read directly into the data field
+template <class Type> void ReadElemData_ITEMS(xpltArchive& ar, XpltReader3::Domain& dom, Post::FEMeshData& s)
+{
+	int NE = dom.ne;
+	if (NE == 0) return;
+
+	vector<int> elem(NE);
+	for (int i=0; i<NE; ++i) elem[i] = dom.elem[i].index;
+
+	Post::FEElementData<Type,DATA_ITEM>& df = dynamic_cast<Post::FEElementData<Type,DATA_ITEM>&>(s);
+	ar.read(df.append(elem), NE);
+}
+
 //=================================================================================================
 
 XpltReader3::DICT_ITEM::DICT_ITEM()
@@ -122,6 +138,7 @@ XpltReader3::XpltReader3(xpltFileReader* xplt) : xpltParser(xplt)
 {
 	m_pstate = 0;
 	m_mesh = 0;
+	m_stateMesh = 0;
 }
 
 XpltReader3::~XpltReader3()
@@ -141,6 +158,21 @@ void XpltReader3::Clear()
 	m_bHasElasticity = false;
 	m_nel = 0;
 	m_pstate = 0;
+	m_index.clear();
+	m_xmeshList.clear();
+	m_stateMesh = 0;
+}
+
+//-----------------------------------------------------------------------------
+// The number of states that are read at the same time when states are read in parallel.
+// (Each state in a batch keeps its section's data in memory until the batch is read.)
+static int stateBatchSize()
+{
+#ifdef _OPENMP
+	return 2*omp_get_max_threads();
+#else
+	return 1;
+#endif
 }
 
 //-----------------------------------------------------------------------------
@@ -175,17 +207,67 @@ bool XpltReader3::Load(FEPostModel& fem)
 	// Clear the end-flag of the mesh section
 	if (m_ar.OpenChunk() != xpltArchive::IO_END) return false;
 
+	// When reading states on demand, we only read the state headers and store 
+	// where the states are located in the file. We also need to keep the mesh 
+	// info since we'll need it when reading the state data.
+	bool bondemand = m_xplt->ReadStatesOnDemand();
+	if (bondemand) m_xmeshList.push_back(m_xmesh);
+	STATE_INDEX lastState = { 0, 0, 0, 0.f, -1 };
+
 	// read the state sections (these could be compressed)
 	const xpltFileReader::HEADER& hdr = m_xplt->GetHeader();
 	m_ar.SetCompression(hdr.ncompression);
 	int read_state_flag = m_xplt->GetReadStateFlag();
 	int nstate = 0;
+
+	// When reading states in parallel, the state sections are only read from the file here.
+	// The state data is then read in batches by ReadStateBuffers. Note that compressed state 
+	// sections still need to be decompressed here, since that's the only way to find where 
+	// the next section starts.
+	bool bparallel = (bondemand == false) && m_xplt->ReadStatesInParallel() &&
+		((read_state_flag == XPLT_READ_ALL_STATES) || (read_state_flag == XPLT_READ_STATES_FROM_LIST));
+	vector<STATE_BUFFER> batch;
+	const int batchSize = stateBatchSize();
 	try{
 		while (true)
 		{
-			if (m_ar.OpenChunk() != xpltArchive::IO_OK) break;
+			// file position of this section
+			off_type offset = (bondemand ? m_ar.Tell() : 0);
+
+			// for uncompressed files we only need to read the beginning of the state sections
+			int nret = (bondemand ? m_ar.OpenChunk(PLT_STATE, STATE_HEADER_SIZE) : m_ar.OpenChunk());
+			if (nret != xpltArchive::IO_OK) break;
 
-			if (m_ar.GetChunkID() == PLT_STATE)
+			bool bstate = false;
+			STATE_INDEX si = { 0, offset, 0, 0.f, (int)m_xmeshList.size() - 1 };
+			if ((m_ar.GetChunkID() == PLT_STATE) && bondemand)
+			{
+				if (ReadStateHeader(si.time) == false) break;
+				bstate = true;
+			}
+			else if ((m_ar.GetChunkID() == PLT_STATE) && bparallel)
+			{
+				bool badd = (read_state_flag == XPLT_READ_ALL_STATES);
+				if (read_state_flag == XPLT_READ_STATES_FROM_LIST)
+				{
+					vector<int> state_list = m_xplt->GetReadStates();
+					for (int i = 0; i < (int)state_list.size(); ++i)
+					{
+						if (state_list[i] == nstate) { badd = true; break; }
+					}
+				}
+
+				// the state is added now, but its data is read later
+				if (badd)
+				{
+					STATE_BUFFER sb;
+					sb.pstate = new FEState(0.f, &fem, GetCurrentMesh(), false);
+					sb.pdata = m_ar.DetachChunk(sb.nsize, sb.pbuf);
+					fem.AddState(sb.pstate);
+					batch.push_back(sb);
+				}
+			}
+			else if (m_ar.GetChunkID() == PLT_STATE)
 			{
 				if (m_pstate) { delete m_pstate; m_pstate = 0; }
 				if (ReadStateSection(fem) == false) break;
@@ -207,7 +289,10 @@ bool XpltReader3::Load(FEPostModel& fem)
 			}
 			else if (m_ar.GetChunkID() == PLT_MESH)
 			{
+				// the states of the previous mesh need to be read first
+				if (ReadStateBuffers(fem, batch) == false) break;
 				if (ReadMesh(fem) == false) return errf("Error while reading mesh section.");
+				if (bondemand) m_xmeshList.push_back(m_xmesh);
 			}
 			else errf("Error while reading state data.");
 			m_ar.CloseChunk();
@@ -219,20 +304,217 @@ bool XpltReader3::Load(FEPostModel& fem)
 				break;
 			}
 
+			// add the state to the index
+			if (bstate)
+			{
+				si.size = m_ar.Tell() - si.offset;
+
+				bool badd = (read_state_flag == XPLT_READ_ALL_STATES);
+				if (read_state_flag == XPLT_READ_STATES_FROM_LIST)
+				{
+					vector<int> state_list = m_xplt->GetReadStates();
+					for (int i = 0; i < (int)state_list.size(); ++i)
+					{
+						if (state_list[i] == nstate) { badd = true; break; }
+					}
+				}
+				else if (read_state_flag == XPLT_READ_LAST_STATE_ONLY) lastState = si;
+
+				if (badd)
+				{
+					si.pstate = new FEState(si.time, &fem, fem.GetFEMesh(si.mesh), false);
+					fem.AddState(si.pstate);
+					m_index.push_back(si);
+				}
+			}
+
+			// read the data of the states that we have so far
+			if ((int)batch.size() >= batchSize)
+			{
+				if (ReadStateBuffers(fem, batch) == false) break;
+			}
+
 			++nstate;
 		}
-		if (read_state_flag == XPLT_READ_LAST_STATE_ONLY) { fem.AddState(m_pstate); m_pstate = 0; }
+		if (read_state_flag == XPLT_READ_LAST_STATE_ONLY)
+		{
+			if (bondemand)
+			{
+				if (lastState.mesh >= 0)
+				{
+					lastState.pstate = new FEState(lastState.time, &fem, fem.GetFEMesh(lastState.mesh), false);
+					fem.AddState(lastState.pstate);
+					m_index.push_back(lastState);
+				}
+			}
+			else { fem.AddState(m_pstate); m_pstate = 0; }
+		}
 	}
 	catch (...)
 	{
 		errf("An unknown exception has occurred.\nNot all data was read in.");
 	}
 
+	// read the data of the remaining states
+	ReadStateBuffers(fem, batch);
+
+	// the model will need a reader to read the state data
+	if (bondemand && (m_index.empty() == false)) CreateStateLoader(fem);
+
 	Clear();
 
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Creates a reader that the model uses to read the states on demand. The reader
+// takes over the state index and the mesh info that is needed for reading states.
+void XpltReader3::CreateStateLoader(FEPostModel& fem)
+{
+	xpltFileReader* loader = new xpltFileReader(&fem);
+	loader->SetFileName(m_xplt->GetFileName());
+	loader->m_hdr = m_xplt->GetHeader();
+	loader->m_bmap = m_xplt->MemoryMapping();
+
+	XpltReader3* xplt = new XpltReader3(loader);
+	xplt->m_dic = m_dic;
+	xplt->m_bHasDispl = m_bHasDispl;
+	xplt->m_bHasStress = m_bHasStress;
+	xplt->m_bHasNodalStress = m_bHasNodalStress;
+	xplt->m_bHasShellThickness = m_bHasShellThickness;
+	xplt->m_bHasFluidPressure = m_bHasFluidPressure;
+	xplt->m_bHasElasticity = m_bHasElasticity;
+	xplt->m_index.swap(m_index);
+	xplt->m_xmeshList.swap(m_xmeshList);
+
+	// we no longer need the nodal coordinates
+	for (size_t i = 0; i < xplt->m_xmeshList.size(); ++i) xplt->m_xmeshList[i].m_Node.clear();
+
+	loader->m_xplt = xplt;
+	fem.SetStateLoader(loader);
+}
+
+//-----------------------------------------------------------------------------
+bool XpltReader3::ReadState(FEPostModel& fem, FEState& state)
+{
+	// find the state in the index
+	STATE_INDEX* si = nullptr;
+	for (size_t i = 0; i < m_index.size(); ++i)
+	{
+		if (m_index[i].pstate == &state) { si = &m_index[i]; break; }
+	}
+	if (si == nullptr) return errf("This state is not in the plot file.");
+
+	// the mesh info for this state
+	m_stateMesh = &m_xmeshList[si->mesh];
+	m_mesh = state.GetFEMesh();
+
+	// go to the state section
+	if (m_ar.Seek(si->offset) == false) return errf("Error while reading state data.");
+	m_ar.SetCompression(m_xplt->GetHeader().ncompression);
+
+	bool bret = false;
+	try {
+		if (m_ar.OpenChunk() != xpltArchive::IO_OK) return errf("Error while reading state data.");
+		if (m_ar.GetChunkID() != PLT_STATE) return errf("Error while reading state data.");
+		bret = ReadStateData(fem, &state);
+		m_ar.CloseChunk();
+	}
+	catch (...)
+	{
+		return errf("An unknown exception has occurred.\nNot all data was read in.");
+	}
+
+	return bret;
+}
+
+//-----------------------------------------------------------------------------
+// Reads the data of states whose state sections were already read from the file. The 
+// states are read in parallel, each by its own parser. If a state cannot be read, it is
+// removed from the model, together with all the states that follow it. 
+bool XpltReader3::ReadStateBuffers(FEPostModel& fem, vector<STATE_BUFFER>& states)
+{
+	int N = (int)states.size();
+	if (N == 0) return true;
+
+	vector<int> ok(N, 0);
+	vector<string> err(N);
+	vector< vector<int> > wrn(N);
+	bool bswap = m_ar.IsSwapped();
+
+#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < N; ++i)
+	{
+		STATE_BUFFER& sb = states[i];
+
+		// the state's parser reads from the state section's data
+		xpltFileReader reader(&fem);
+		reader.m_hdr = m_xplt->GetHeader();
+		XpltReader3 xplt(&reader);
+		xplt.m_dic = m_dic;
+		xplt.m_bHasShellThickness = m_bHasShellThickness;
+		xplt.m_stateMesh = &m_xmesh;
+		xplt.m_mesh = sb.pstate->GetFEMesh();
+
+		try {
+			sb.pstate->AllocateData();
+			reader.m_ar.AttachChunk(PLT_STATE, sb.pdata, sb.nsize, bswap);
+			if (xplt.ReadStateData(fem, sb.pstate))
+			{
+				reader.m_ar.CloseChunk();
+				ok[i] = 1;
+			}
+		}
+		catch (...)
+		{
+			reader.errf("An unknown exception has occurred.\nNot all data was read in.");
+		}
+
+		err[i] = reader.GetErrorMessage();
+		wrn[i] = xplt.m_wrng;
+	}
+
+	// collect errors and warnings, and clean up
+	int nfail = N;
+	for (int i = 0; i < N; ++i)
+	{
+		STATE_BUFFER& sb = states[i];
+		delete [] sb.pbuf;
+
+		if (err[i].empty() == false) errf(err[i].c_str());
+		for (int j = 0; j < (int)wrn[i].size(); ++j) addWarning(wrn[i][j]);
+
+		if ((ok[i] == 0) && (nfail == N)) nfail = i;
+	}
+
+	// remove the states that were not read
+	for (int i = N - 1; i >= nfail; --i)
+	{
+		FEState* ps = states[i].pstate;
+		fem.DeleteState(ps->GetID());
+		delete ps;
+	}
+
+	states.clear();
+
+	return (nfail == N);
+}
+
+//-----------------------------------------------------------------------------
+// Reads the state header section, which should be the first section of a state.
+bool XpltReader3::ReadStateHeader(float& time)
+{
+	if (m_ar.OpenChunk() != xpltArchive::IO_OK) return errf("Error while reading state data.");
+	if (m_ar.GetChunkID() != PLT_STATE_HEADER) return errf("Error while reading state data.");
+	while (m_ar.OpenChunk() == xpltArchive::IO_OK)
+	{
+		if (m_ar.GetChunkID() == PLT_STATE_HDR_TIME) m_ar.read(time);
+		m_ar.CloseChunk();
+	}
+	m_ar.CloseChunk();
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 bool XpltReader3::ReadRootSection(FEPostModel& fem)
 {
@@ -1312,6 +1594,15 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 		return errf("Error allocating memory for state data");
 	}
 
+	return ReadStateData(fem, ps);
+}
+
+//-----------------------------------------------------------------------------
+bool XpltReader3::ReadStateData(FEPostModel& fem, FEState* ps)
+{
+	// get the mesh
+	Post::FEPostMesh& mesh = *GetCurrentMesh();
+
 	while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 	{
 		int nid = m_ar.GetChunkID();
@@ -1426,7 +1717,7 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 
 								assert((nv >= 0) && (nv < po->m_data.size()));
 
-								ObjectData* pd = m_pstate->m_objPt[objId].data;
+								ObjectData* pd = ps->m_objPt[objId].data;
 
 								switch (po->m_data[nv]->Type())
 								{
@@ -1485,7 +1776,7 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 
 								assert((nv >= 0) && (nv < po->m_data.size()));
 
-								ObjectData* pd = m_pstate->m_objLn[objId].data;
+								ObjectData* pd = ps->m_objLn[objId].data;
 
 								switch (po->m_data[nv]->Type())
 								{
@@ -1507,22 +1798,23 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 	}
 
 	// Assign shell thicknesses
-	if (m_bHasShellThickness)
+	// When states are read on demand, the user may have deleted the field in the meantime.
+	FEDataManager& dm = *fem.GetDataManager();
+	int nshell = (m_bHasShellThickness ? dm.FindDataField("shell thickness") : -1);
+	if (nshell >= 0)
 	{
-		FEDataManager& dm = *fem.GetDataManager();
-		int n = dm.FindDataField("shell thickness");
-		Post::FEElementData<float,DATA_COMP>& df = dynamic_cast<Post::FEElementData<float,DATA_COMP>&>(ps->m_Data[n]);
+		Post::FEElementData<float,DATA_COMP>& df = dynamic_cast<Post::FEElementData<float,DATA_COMP>&>(ps->m_Data[nshell]);
 		Post::FEPostMesh& mesh = *GetCurrentMesh();
 		int NE = mesh.Elements();
 		float h[FEElement::MAX_NODES] = {0.f};
 		for (int i=0; i<NE; ++i)
 		{
-			ELEMDATA& d = ps->m_ELEM[i];
-			if (df.active(i))
+			float* d = ps->m_ELEM.thickness(i);
+			if (d && df.active(i))
 			{
 				df.eval(i, h);
 				int n = mesh.ElementRef(i).Nodes();
-				for (int j=0; j<n; ++j) d.m_h[j] = h[j];
+				for (int j=0; j<n; ++j) d[j] = h[j];
 			}
 		}
 	}
@@ -1566,47 +1858,38 @@ bool XpltReader3::ReadNodeData(FEPostModel& fem, FEState* pstate)
 					int nfield = dm.FindDataField(it.szname);
 					int ndata = 0;
 					int NN = mesh.Nodes();
-					while (m_ar.OpenChunk() == xpltArchive::IO_OK)
+
+					// the field could have been deleted when states are read on demand
+					while ((nfield >= 0) && (m_ar.OpenChunk() == xpltArchive::IO_OK))
 					{
 						int ns = m_ar.GetChunkID();
 						assert(ns == 0);
 
+						// the nodal values are read directly into the data field
 						if (it.ntype == FLOAT)
 						{
-							vector<float> a(NN);
-							m_ar.read(a);
-
 							Post::FENodeData<float>& df = dynamic_cast<Post::FENodeData<float>&>(pstate->m_Data[nfield]);
-							for (int j=0; j<NN; ++j) df[j] = a[j];
+							if (NN > 0) m_ar.read(df.data(), NN);
 						}
 						else if (it.ntype == VEC3F)
 						{
-							vector<vec3f> a(NN);
-							m_ar.read(a);
-
 							Post::FENodeData<vec3f>& dv = dynamic_cast<Post::FENodeData<vec3f>&>(pstate->m_Data[nfield]);
-							for (int j=0; j<NN; ++j) dv[j] = a[j];
+							m_ar.read(dv.data(), NN);
 						}
 						else if (it.ntype == MAT3FS)
 						{
-							vector<mat3fs> a(NN);
-							m_ar.read(a);
 							Post::FENodeData<mat3fs>& dv = dynamic_cast<Post::FENodeData<mat3fs>&>(pstate->m_Data[nfield]);
-							for (int j=0; j<NN; ++j) dv[j] = a[j];
+							m_ar.read(dv.data(), NN);
 						}
 						else if (it.ntype == TENS4FS)
 						{
-							vector<tens4fs> a(NN);
-							m_ar.read(a);
 							Post::FENodeData<tens4fs>& dv = dynamic_cast<Post::FENodeData<tens4fs>&>(pstate->m_Data[nfield]);
-							for (int j=0; j<NN; ++j) dv[j] = a[j];
+							m_ar.read(dv.data(), NN);
 						}
 						else if (it.ntype == MAT3F)
 						{
-							vector<mat3f> a(NN);
-							m_ar.read(a);
 							Post::FENodeData<mat3f>& dv = dynamic_cast<Post::FENodeData<mat3f>&>(pstate->m_Data[nfield]);
-							for (int j=0; j<NN; ++j) dv[j] = a[j];
+							m_ar.read(dv.data(), NN);
 						}
 						else if (it.ntype == ARRAY)
 						{
@@ -1647,6 +1930,7 @@ bool XpltReader3::ReadElemData(FEPostModel &fem, FEState* pstate)
 {
 	Post::FEPostMesh& mesh = *GetCurrentMesh();
 	FEDataManager& dm = *fem.GetDataManager();
+	XMesh& xmesh = StateMesh();
 	while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 	{
 		if (m_ar.GetChunkID() == PLT_STATE_VARIABLE)
@@ -1665,12 +1949,15 @@ bool XpltReader3::ReadElemData(FEPostModel &fem, FEState* pstate)
 					while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 					{
 						int nd = m_ar.GetChunkID() - 1;
-						assert((nd >= 0)&&(nd < m_xmesh.domains()));
-						if ((nd < 0) || (nd >= (int)m_xmesh.domains())) return errf("Failed reading all state data");
+						assert((nd >= 0)&&(nd < xmesh.domains()));
+						if ((nd < 0) || (nd >= (int)xmesh.domains())) return errf("Failed reading all state data");
 
 						int nfield = dm.FindDataField(it.szname);
 
-						Domain& dom = m_xmesh.domain(nd);
+						// the field could have been deleted when states are read on demand
+						if (nfield < 0) { m_ar.CloseChunk(); continue; }
+
+						Domain& dom = xmesh.domain(nd);
 						FEElemItemData& ed = dynamic_cast<FEElemItemData&>(pstate->m_Data[nfield]);
 						switch (it.nfmt)
 						{
@@ -1844,54 +2131,12 @@ bool XpltReader3::ReadElemData_ITEM(XpltReader3::Domain& dom, Post::FEMeshData&
 	int NE = dom.ne;
 	switch (ntype)
 	{
-	case FLOAT:
-		{
-			vector<float> a(NE);
-			m_ar.read(a);
-			Post::FEElementData<float,DATA_ITEM>& df = dynamic_cast<Post::FEElementData<float,DATA_ITEM>&>(s);
-			for (int i=0; i<NE; ++i) df.add(dom.elem[i].index, a[i]);
-		}
-		break;
-	case VEC3F:
-		{
-			vector<vec3f> a(NE);
-			m_ar.read(a);
-			Post::FEElementData<vec3f,DATA_ITEM>& dv = dynamic_cast<Post::FEElementData<vec3f,DATA_ITEM>&>(s);
-			for (int i=0; i<NE; ++i) dv.add(dom.elem[i].index, a[i]);
-		}
-		break;
-	case MAT3FS:
-		{
-			vector<mat3fs> a(NE);
-			m_ar.read(a);
-			Post::FEElementData<mat3fs,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<mat3fs,DATA_ITEM>&>(s);
-			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
-		}
-		break;
-	case MAT3FD:
-		{
-			vector<mat3fd> a(NE);
-			m_ar.read(a);
-			Post::FEElementData<mat3fd,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<mat3fd,DATA_ITEM>&>(s);
-			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
-		}
-		break;
-    case TENS4FS:
-		{
-			vector<tens4fs> a(NE);
-			m_ar.read(a);
-			Post::FEElementData<tens4fs,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<tens4fs,DATA_ITEM>&>(s);
-			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
-		}
-        break;
-	case MAT3F:
-		{
-			vector<mat3f> a(NE);
-			m_ar.read(a);
-			Post::FEElementData<mat3f,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<mat3f,DATA_ITEM>&>(s);
-			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
-		}
-		break;
+	case FLOAT  : ReadElemData_ITEMS<float  >(m_ar, dom, s); break;
+	case VEC3F  : ReadElemData_ITEMS<vec3f  >(m_ar, dom, s); break;
+	case MAT3FS : ReadElemData_ITEMS<mat3fs >(m_ar, dom, s); break;
+	case MAT3FD : ReadElemData_ITEMS<mat3fd >(m_ar, dom, s); break;
+	case TENS4FS: ReadElemData_ITEMS<tens4fs>(m_ar, dom, s); break;
+	case MAT3F  : ReadElemData_ITEMS<mat3f  >(m_ar, dom, s); break;
 	case ARRAY:
 	{
 		vector<float> a(NE*arrSize);
@@ -2027,6 +2272,7 @@ bool XpltReader3::ReadFaceData(FEPostModel& fem, FEState* pstate)
 {
 	Post::FEPostMesh& mesh = *GetCurrentMesh();
 	FEDataManager& dm = *fem.GetDataManager();
+	XMesh& xmesh = StateMesh();
 	while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 	{
 		if (m_ar.GetChunkID() == PLT_STATE_VARIABLE)
@@ -2045,13 +2291,15 @@ bool XpltReader3::ReadFaceData(FEPostModel& fem, FEState* pstate)
 					while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 					{
 						int ns = m_ar.GetChunkID() - 1;
-						assert((ns >= 0)&&(ns < m_xmesh.surfaces()));
-						if ((ns < 0) || (ns >= m_xmesh.surfaces())) return errf("Failed reading all state data");
+						assert((ns >= 0)&&(ns < xmesh.surfaces()));
+						if ((ns < 0) || (ns >= xmesh.surfaces())) return errf("Failed reading all state data");
+
+						int nfield = dm.FindDataField(it.szname);
 
-//						int nfield = dm.FindDataField(it.szname);
-						int nfield = it.index;
+						// the field could have been deleted when states are read on demand
+						if (nfield < 0) { m_ar.CloseChunk(); continue; }
 
-						Surface& s = m_xmesh.surface(ns);
+						Surface& s = xmesh.surface(ns);
 						switch (it.nfmt)
 						{
 						case FMT_NODE  : if (ReadFaceData_NODE  (mesh, s, pstate->m_Data[nfield], it.ntype) == false) return errf("Failed reading face data"); break;
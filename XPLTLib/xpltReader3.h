@@ -168,6 +168,9 @@ protected:
 	// size of name variables
 	enum { DI_NAME_SIZE = 64 };
 
+	// max size of a state section that needs to be read for the state header
+	enum { STATE_HEADER_SIZE = 1024 };
+
 public:
 	class DICT_ITEM
 	{
@@ -310,15 +313,41 @@ public:
 		NodeSet& nodeSet(int i) { return m_NodeSet[i]; }
 	};
 
+	// location of a state section in the file (used when states are read on demand)
+	struct STATE_INDEX
+	{
+		Post::FEState*	pstate;		// the state
+		off_type		offset;		// file offset of the state section
+		off_type		size;		// size of the state section in the file
+		float			time;		// time value of the state
+		int				mesh;		// index of the mesh (in m_xmeshList)
+	};
+
+	// data of a state section that still needs to be read (used when states are read in parallel)
+	struct STATE_BUFFER
+	{
+		Post::FEState*	pstate;		// the state
+		const char*		pdata;		// the data of the state section
+		unsigned int	nsize;		// size of the data
+		char*			pbuf;		// buffer that needs to be deleted (null for mapped files)
+	};
+
 public:
 	XpltReader3(xpltFileReader* xplt);
 	~XpltReader3();
 
 	bool Load(Post::FEPostModel& fem);
 
+	bool ReadState(Post::FEPostModel& fem, Post::FEState& state) override;
+
 protected:
 	bool ReadRootSection(Post::FEPostModel& fem);
 	bool ReadStateSection(Post::FEPostModel& fem);
+	bool ReadStateHeader(float& time);
+	bool ReadStateData(Post::FEPostModel& fem, Post::FEState* ps);
+	bool ReadStateBuffers(Post::FEPostModel& fem, vector<STATE_BUFFER>& states);
+
+	void CreateStateLoader(Post::FEPostModel& fem);
 
 	bool ReadDictionary(Post::FEPostModel& fem);
 	bool ReadMesh(Post::FEPostModel& fem);
@@ -362,6 +391,9 @@ protected:
 protected:
 	Post::FEPostMesh* GetCurrentMesh() { return m_mesh; }
 
+	// the mesh info that is used for reading state data
+	XMesh& StateMesh() { return (m_stateMesh ? *m_stateMesh : m_xmesh); }
+
 protected:
 	Dictionary			m_dic;
 	XMesh				m_xmesh;
@@ -383,4 +415,9 @@ protected:
 
 	Post::FEState*	m_pstate;	//!< last read state section
 	Post::FEPostMesh*	m_mesh;		//!< current mesh
+
+	// used when reading states on demand
+	vector<STATE_INDEX>	m_index;		//!< location of states in file
+	vector<XMesh>		m_xmeshList;	//!< the mesh info needed for reading the state data
+	XMesh*				m_stateMesh;	//!< mesh info for the state that is being read (m_xmesh if null)
 };